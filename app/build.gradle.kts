@@ -89,6 +89,11 @@ android {
             excludes += "/META-INF/DEPENDENCIES"
         }
     }
+
+    // SoundFonts are memory-mapped straight from the APK by the native engine
+    androidResources {
+        noCompress += "sf2"
+    }
 }
 
 dependencies {
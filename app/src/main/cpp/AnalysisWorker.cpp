@@ -0,0 +1,185 @@
+/**
+ * AnalysisWorker.cpp
+ *
+ * Implementation of the input analysis thread.
+ */
+
+#include "AnalysisWorker.h"
+#include "PerformanceHint.h"
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#define LOG_TAG "AnalysisWorker"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+// Poll period: several polls per hop (the shortest hop, onset, is ~5 ms)
+constexpr int POLL_INTERVAL_US = 2000;
+
+// Lowest SCHED_FIFO priority: below the audio callback, above everything else
+constexpr int REALTIME_PRIORITY = 1;
+
+// Android's THREAD_PRIORITY_AUDIO, allowed for app threads without SCHED_FIFO
+constexpr int AUDIO_NICE = -16;
+
+int64_t nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+AnalysisWorker::~AnalysisWorker() {
+    stop();
+}
+
+void AnalysisWorker::configure(YinPitchDetector::Preset primary, uint32_t extraPresets, bool polyphonic,
+                               int sampleRate) {
+    m_primary = primary;
+    m_presets = (presetBit(primary) | extraPresets) & ((1u << kPresetCount) - 1);
+    for (int i = 0; i < kPresetCount; i++) {
+        auto preset = (YinPitchDetector::Preset)i;
+        if (isPresetEnabled(preset)) {
+            m_trackers[i].configure(preset, sampleRate);
+        }
+        // Only the primary tracker scores and drives the UI
+        m_trackers[i].setUiChannel(preset == primary ? m_uiChannel : nullptr);
+        m_trackers[i].setScorer(preset == primary ? m_scorer : nullptr);
+    }
+    m_onsetDetector.configure(sampleRate);
+    m_polyphonic = polyphonic;
+    if (polyphonic) {
+        m_multiPitch.configure(sampleRate);
+    }
+    
+    m_passes.store(0, std::memory_order_relaxed);
+    m_lastBacklog.store(0, std::memory_order_relaxed);
+    m_maxBacklog.store(0, std::memory_order_relaxed);
+    m_maxPassNanos.store(0, std::memory_order_relaxed);
+}
+
+void AnalysisWorker::setUiChannel(UiStateChannel* channel) {
+    m_uiChannel = channel;
+    m_trackers[m_primary].setUiChannel(channel);
+    m_onsetDetector.setUiChannel(channel);
+}
+
+void AnalysisWorker::setScorer(NoteScorer* scorer) {
+    m_scorer = scorer;
+    m_trackers[m_primary].setScorer(scorer);
+    m_onsetDetector.setScorer(scorer);
+}
+
+int AnalysisWorker::getLongestWindow() const {
+    int longest = m_onsetDetector.getFrameSize();
+    for (int i = 0; i < kPresetCount; i++) {
+        if (isPresetEnabled((YinPitchDetector::Preset)i)) {
+            longest = std::max(longest, m_trackers[i].getWindowSize());
+        }
+    }
+    if (m_polyphonic) {
+        longest = std::max(longest, m_multiPitch.getFrameSize());
+    }
+    return longest;
+}
+
+bool AnalysisWorker::start(const InputRing* ring) {
+    stop();
+    if (!ring) {
+        return false;
+    }
+    m_ring = ring;
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&AnalysisWorker::run, this);
+    return true;
+}
+
+void AnalysisWorker::stop() {
+    m_running.store(false, std::memory_order_release);
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+AnalysisWorker::Stats AnalysisWorker::getStats() const {
+    Stats stats;
+    stats.passes = m_passes.load(std::memory_order_relaxed);
+    stats.lastBacklogFrames = m_lastBacklog.load(std::memory_order_relaxed);
+    stats.maxBacklogFrames = m_maxBacklog.load(std::memory_order_relaxed);
+    stats.maxPassNanos = m_maxPassNanos.load(std::memory_order_relaxed);
+    stats.skippedSamples = m_onsetDetector.getSkippedSampleCount();
+    for (int i = 0; i < kPresetCount; i++) {
+        if (isPresetEnabled((YinPitchDetector::Preset)i)) {
+            stats.skippedSamples = std::max(stats.skippedSamples, m_trackers[i].getSkippedSampleCount());
+        }
+    }
+    if (m_polyphonic) {
+        stats.skippedSamples = std::max(stats.skippedSamples, m_multiPitch.getSkippedSampleCount());
+    }
+    stats.realtime = m_realtime.load(std::memory_order_relaxed);
+    stats.cpuMask = m_cpuMask.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void AnalysisWorker::applyThreadPolicy() {
+    pthread_setname_np(pthread_self(), "MusiMindDsp");
+    
+    sched_param param = {};
+    param.sched_priority = REALTIME_PRIORITY;
+    bool realtime = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+    if (!realtime) {
+        // Apps are usually denied SCHED_FIFO; the audio nice level is allowed
+        setpriority(PRIO_PROCESS, gettid(), AUDIO_NICE);
+    }
+    m_realtime.store(realtime, std::memory_order_relaxed);
+    
+    uint32_t mask = PerformanceHint::fastestCpuMask();
+    if (!PerformanceHint::pinCurrentThread(mask)) {
+        mask = 0;
+    }
+    m_cpuMask.store(mask, std::memory_order_relaxed);
+    
+    LOGI("Analysis worker started: %s, cores 0x%x", realtime ? "SCHED_FIFO" : "nice", mask);
+}
+
+void AnalysisWorker::run() {
+    applyThreadPolicy();
+    
+    int64_t analyzed = m_ring->writeCount();
+    while (m_running.load(std::memory_order_acquire)) {
+        int64_t written = m_ring->writeCount();
+        if (written == analyzed) {
+            std::this_thread::sleep_for(std::chrono::microseconds(POLL_INTERVAL_US));
+            continue;
+        }
+        
+        int64_t passStart = nowNanos();
+        for (int i = 0; i < kPresetCount; i++) {
+            if (isPresetEnabled((YinPitchDetector::Preset)i)) {
+                m_trackers[i].process(*m_ring);
+            }
+        }
+        m_onsetDetector.process(*m_ring);
+        if (m_polyphonic) {
+            m_multiPitch.process(*m_ring);
+        }
+        int64_t passNanos = nowNanos() - passStart;
+        
+        int64_t backlog = written - analyzed;
+        analyzed = written;
+        m_passes.store(m_passes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_lastBacklog.store(backlog, std::memory_order_relaxed);
+        if (backlog > m_maxBacklog.load(std::memory_order_relaxed)) {
+            m_maxBacklog.store(backlog, std::memory_order_relaxed);
+        }
+        if (passNanos > m_maxPassNanos.load(std::memory_order_relaxed)) {
+            m_maxPassNanos.store(passNanos, std::memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,115 @@
+/**
+ * AnalysisWorker.h
+ *
+ * Dedicated thread for the live input analysis. The audio callback only
+ * copies input into the shared InputRing; this worker follows the ring's
+ * write count and runs the FFT/YIN stages in hops: one PitchTracker per
+ * enabled preset (voice and instrument can run side by side), the onset
+ * detector, optionally the polyphonic MultiPitchDetector for chord
+ * exercises, and through them the note scorer and the UI channel. Analysis
+ * cost and jitter therefore never eat into the output deadline.
+ *
+ * The callback never signals the worker (a wake-up is a syscall), so the
+ * worker polls the ring a few times per pitch hop. On start it asks for
+ * SCHED_FIFO just below the audio callback and falls back to the audio nice
+ * level where that is not allowed, and on big.LITTLE devices it is pinned to
+ * the fastest cluster.
+ *
+ * When analysis falls behind, the ring overwrites samples before they were
+ * read; the analyzers skip to the oldest intact sample and the loss is
+ * reported in Stats along with the backlog seen by each pass.
+ */
+
+#ifndef MUSIMIND_ANALYSIS_WORKER_H
+#define MUSIMIND_ANALYSIS_WORKER_H
+
+#include "InputRing.h"
+#include "MultiPitchDetector.h"
+#include "NoteScorer.h"
+#include "OnsetDetector.h"
+#include "PitchTracker.h"
+#include "UiStateChannel.h"
+#include "YinPitchDetector.h"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+class AnalysisWorker {
+public:
+    static constexpr int kPresetCount = 2;
+    
+    // Bit of a preset in the mask passed to configure()
+    static constexpr uint32_t presetBit(YinPitchDetector::Preset preset) { return 1u << preset; }
+    
+    struct Stats {
+        int64_t passes;            // Wake-ups that found new input
+        int64_t lastBacklogFrames; // Input that queued up between the last two passes
+        int64_t maxBacklogFrames;
+        int64_t maxPassNanos;      // Longest analysis pass
+        int64_t skippedSamples;    // Input overwritten before every analyzer read it
+        bool realtime;             // Running under SCHED_FIFO
+        uint32_t cpuMask;          // Cores the worker is pinned to, 0 = not pinned
+    };
+    
+    ~AnalysisWorker();
+    
+    // Allocate the detectors. The primary preset is always enabled and feeds
+    // the scorer and the UI channel; extraPresets (presetBit mask) adds more
+    // trackers, polyphonic the multi-pitch detector. Not real-time safe;
+    // only call while the worker is stopped.
+    void configure(YinPitchDetector::Preset primary, uint32_t extraPresets, bool polyphonic, int sampleRate);
+    
+    // Set while the worker is stopped
+    void setUiChannel(UiStateChannel* channel);
+    void setScorer(NoteScorer* scorer);
+    
+    // Start analyzing the ring on the worker thread; it stays readable until stop()
+    bool start(const InputRing* ring);
+    void stop();
+    bool isRunning() const { return m_thread.joinable(); }
+    
+    // Longest window any enabled analyzer reads
+    int getLongestWindow() const;
+    
+    YinPitchDetector::Preset getPrimaryPreset() const { return m_primary; }
+    bool isPresetEnabled(YinPitchDetector::Preset preset) const { return (m_presets & presetBit(preset)) != 0; }
+    
+    // Tracker of a preset; consumers must check isPresetEnabled first
+    PitchTracker& getPitchTracker(YinPitchDetector::Preset preset) { return m_trackers[preset]; }
+    PitchTracker& getPitchTracker() { return m_trackers[m_primary]; }
+    OnsetDetector& getOnsetDetector() { return m_onsetDetector; }
+    
+    // Note sets per hop; consumers must check isPolyphonicEnabled first
+    bool isPolyphonicEnabled() const { return m_polyphonic; }
+    MultiPitchDetector& getMultiPitchDetector() { return m_multiPitch; }
+    
+    // Any thread; fields may be torn across one pass
+    Stats getStats() const;
+    
+private:
+    void run();
+    void applyThreadPolicy();
+    
+    PitchTracker m_trackers[kPresetCount];
+    OnsetDetector m_onsetDetector;
+    MultiPitchDetector m_multiPitch;
+    bool m_polyphonic = false;
+    YinPitchDetector::Preset m_primary = YinPitchDetector::PRESET_VOICE;
+    uint32_t m_presets = 0;
+    UiStateChannel* m_uiChannel = nullptr;
+    NoteScorer* m_scorer = nullptr;
+    
+    const InputRing* m_ring = nullptr;
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    
+    // Stats (worker is the only writer)
+    std::atomic<int64_t> m_passes{0};
+    std::atomic<int64_t> m_lastBacklog{0};
+    std::atomic<int64_t> m_maxBacklog{0};
+    std::atomic<int64_t> m_maxPassNanos{0};
+    std::atomic<bool> m_realtime{false};
+    std::atomic<uint32_t> m_cpuMask{0};
+};
+
+#endif // MUSIMIND_ANALYSIS_WORKER_H
@@ -0,0 +1,101 @@
+/**
+ * AudioCommand.h
+ *
+ * Fixed-size command sent from JNI threads to the audio callback.
+ * Commands are queued by SoundFontEngine and applied by render(), either at
+ * the start of the next callback (frame == kImmediate) or on the exact frame
+ * they are stamped with.
+ */
+
+#ifndef MUSIMIND_AUDIO_COMMAND_H
+#define MUSIMIND_AUDIO_COMMAND_H
+
+#include <cstdint>
+
+struct AudioCommand {
+    enum class Type : uint8_t {
+        NoteOn,
+        NoteOff,
+        MetronomeClick,
+        SetPreset,
+        SetSampleRate,
+        MetronomeStart,
+        MetronomeStop,
+        SetChannelVolume,
+        SetChannelPan,
+        SetChannelSustain,
+        AllNotesOff,
+        SequencerPlay,
+        SequencerStop,
+        SequencerSeek,
+        SequencerTempoScale,
+        SequencerLoop,
+        PlayClip
+    };
+
+    // Frame value meaning "as soon as possible"
+    static constexpr int64_t kImmediate = -1;
+
+    Type type;
+    int32_t channel;
+    int32_t data;      // MIDI note, preset number, sample rate, sustain flag, sequencer tick/frame or clip slot
+    float value;       // Velocity, channel volume, pan or tempo scale; for MetronomeClick, 1.0 = accented
+    int64_t frame;     // Stream frame to apply on, or kImmediate
+    int32_t duration;  // NoteOn only: frames until the matching NoteOff (0 = none)
+
+    static AudioCommand noteOn(int channel, int midiNote, float velocity,
+                               int64_t frame = kImmediate, int32_t duration = 0) {
+        return { Type::NoteOn, channel, midiNote, velocity, frame, duration };
+    }
+    static AudioCommand noteOff(int channel, int midiNote, int64_t frame = kImmediate) {
+        return { Type::NoteOff, channel, midiNote, 0.0f, frame, 0 };
+    }
+    static AudioCommand metronomeClick(bool isAccented, int64_t frame = kImmediate) {
+        return { Type::MetronomeClick, 0, 0, isAccented ? 1.0f : 0.0f, frame, 0 };
+    }
+    static AudioCommand metronomeStart(int64_t frame = kImmediate) {
+        return { Type::MetronomeStart, 0, 0, 0.0f, frame, 0 };
+    }
+    static AudioCommand metronomeStop(int64_t frame = kImmediate) {
+        return { Type::MetronomeStop, 0, 0, 0.0f, frame, 0 };
+    }
+    static AudioCommand setPreset(int channel, int preset, int64_t frame = kImmediate) {
+        return { Type::SetPreset, channel, preset, 0.0f, frame, 0 };
+    }
+    static AudioCommand setChannelVolume(int channel, float volume, int64_t frame = kImmediate) {
+        return { Type::SetChannelVolume, channel, 0, volume, frame, 0 };
+    }
+    static AudioCommand setChannelPan(int channel, float pan, int64_t frame = kImmediate) {
+        return { Type::SetChannelPan, channel, 0, pan, frame, 0 };
+    }
+    static AudioCommand setChannelSustain(int channel, bool sustain, int64_t frame = kImmediate) {
+        return { Type::SetChannelSustain, channel, sustain ? 1 : 0, 0.0f, frame, 0 };
+    }
+    static AudioCommand allNotesOff() {
+        return { Type::AllNotesOff, 0, 0, 0.0f, kImmediate, 0 };
+    }
+    static AudioCommand sequencerPlay(int64_t frame = kImmediate) {
+        return { Type::SequencerPlay, 0, 0, 0.0f, frame, 0 };
+    }
+    static AudioCommand sequencerStop() {
+        return { Type::SequencerStop, 0, 0, 0.0f, kImmediate, 0 };
+    }
+    // Seek to a file tick (inFrames = false) or to a song position in output frames
+    static AudioCommand sequencerSeek(int32_t position, bool inFrames) {
+        return { Type::SequencerSeek, inFrames ? 1 : 0, position, 0.0f, kImmediate, 0 };
+    }
+    static AudioCommand sequencerTempoScale(float scale) {
+        return { Type::SequencerTempoScale, 0, 0, scale, kImmediate, 0 };
+    }
+    static AudioCommand sequencerLoop(int32_t startTick, int32_t endTick) {
+        return { Type::SequencerLoop, startTick, endTick, 0.0f, kImmediate, 0 };
+    }
+    static AudioCommand playClip(int slot, int bus, int64_t frame = kImmediate) {
+        return { Type::PlayClip, bus, slot, 0.0f, frame, 0 };
+    }
+    static AudioCommand setSampleRate(int sampleRate) {
+        return { Type::SetSampleRate, 0, sampleRate, 0.0f, kImmediate, 0 };
+    }
+};
+
+#endif // MUSIMIND_AUDIO_COMMAND_H
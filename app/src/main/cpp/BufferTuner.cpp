@@ -0,0 +1,86 @@
+/**
+ * BufferTuner.cpp
+ *
+ * Implementation of the grow-on-XRun output buffer tuner.
+ */
+
+#include "BufferTuner.h"
+#include <algorithm>
+
+void BufferTuner::reset(oboe::AudioStream* stream) {
+    int32_t burst = std::max(1, stream->getFramesPerBurst());
+    m_burstFrames.store(burst, std::memory_order_relaxed);
+    m_capacityFrames.store(stream->getBufferCapacityInFrames(), std::memory_order_relaxed);
+    m_floorFrames = burst;
+    m_quietFrames = 0;
+    m_shrinkAfterFrames = (int64_t)kShrinkQuietSeconds * stream->getSampleRate();
+    m_justShrunk = false;
+    
+    // OpenSL ES streams cannot count XRuns; leave their buffer alone
+    auto xruns = stream->getXRunCount();
+    m_tuning.store((bool)xruns, std::memory_order_relaxed);
+    m_lastXRuns = xruns ? xruns.value() : 0;
+    if (!xruns || !resize(stream, burst)) {
+        m_bufferFrames.store(stream->getBufferSizeInFrames(), std::memory_order_relaxed);
+    }
+}
+
+bool BufferTuner::resize(oboe::AudioStream* stream, int32_t frames) {
+    auto result = stream->setBufferSizeInFrames(frames);
+    if (!result) {
+        return false;
+    }
+    // The stream may round to its own granularity
+    m_bufferFrames.store(result.value(), std::memory_order_relaxed);
+    return true;
+}
+
+void BufferTuner::update(oboe::AudioStream* stream, int numFrames) {
+    if (!m_tuning.load(std::memory_order_relaxed)) {
+        return;
+    }
+    auto xruns = stream->getXRunCount();
+    if (!xruns) {
+        return;
+    }
+    int32_t burst = m_burstFrames.load(std::memory_order_relaxed);
+    int32_t size = m_bufferFrames.load(std::memory_order_relaxed);
+    
+    if (xruns.value() > m_lastXRuns) {
+        m_totalXRuns.fetch_add(xruns.value() - m_lastXRuns, std::memory_order_relaxed);
+        m_lastXRuns = xruns.value();
+        m_quietFrames = 0;
+        int32_t grown = std::min(size + burst, m_capacityFrames.load(std::memory_order_relaxed));
+        if (grown > size) {
+            resize(stream, grown);
+        }
+        // Underran right after shrinking: this is as small as the device goes
+        if (m_justShrunk) {
+            m_floorFrames = m_bufferFrames.load(std::memory_order_relaxed);
+        }
+        m_justShrunk = false;
+        return;
+    }
+    
+    if (!m_shrinkEnabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    m_quietFrames += numFrames;
+    if (m_quietFrames >= m_shrinkAfterFrames) {
+        m_quietFrames = 0;
+        m_justShrunk = false;
+        if (size - burst >= m_floorFrames) {
+            m_justShrunk = resize(stream, size - burst);
+        }
+    }
+}
+
+BufferTuner::Stats BufferTuner::getStats() const {
+    Stats stats;
+    stats.bufferFrames = m_bufferFrames.load(std::memory_order_relaxed);
+    stats.capacityFrames = m_capacityFrames.load(std::memory_order_relaxed);
+    stats.burstFrames = m_burstFrames.load(std::memory_order_relaxed);
+    stats.xruns = m_totalXRuns.load(std::memory_order_relaxed);
+    stats.tuning = m_tuning.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,65 @@
+/**
+ * BufferTuner.h
+ *
+ * Per-device latency tuning for the output stream, after Oboe's LatencyTuner:
+ * the buffer starts at one burst and grows by a burst each time the stream
+ * reports a new underrun (XRun), so every device settles at the smallest
+ * buffer it can sustain.
+ *
+ * Optionally the buffer also shrinks back by a burst after a long run
+ * without underruns (load drops once an exercise screen settles). A size
+ * that underruns again right after a shrink becomes the floor, so the
+ * tuner does not oscillate.
+ *
+ * update() runs on the audio thread; stats are atomics readable anywhere.
+ */
+
+#ifndef MUSIMIND_BUFFER_TUNER_H
+#define MUSIMIND_BUFFER_TUNER_H
+
+#include <oboe/Oboe.h>
+#include <atomic>
+#include <cstdint>
+
+class BufferTuner {
+public:
+    static constexpr int kShrinkQuietSeconds = 30;  // Underrun-free time before a shrink
+    
+    struct Stats {
+        int32_t bufferFrames;    // Current buffer size
+        int32_t capacityFrames;  // Largest size the stream allows
+        int32_t burstFrames;
+        int64_t xruns;           // Underruns across all streams since creation
+        bool tuning;             // False if the stream cannot report XRuns
+    };
+    
+    // Start a freshly opened stream at one burst. Call before it starts.
+    void reset(oboe::AudioStream* stream);
+    
+    // Allow the slow shrink (off by default)
+    void setShrinkEnabled(bool enabled) { m_shrinkEnabled.store(enabled, std::memory_order_relaxed); }
+    
+    // Audio thread, once per callback
+    void update(oboe::AudioStream* stream, int numFrames);
+    
+    Stats getStats() const;
+    
+private:
+    bool resize(oboe::AudioStream* stream, int32_t frames);
+    
+    std::atomic<bool> m_shrinkEnabled{false};
+    std::atomic<int32_t> m_bufferFrames{0};
+    std::atomic<int32_t> m_capacityFrames{0};
+    std::atomic<int32_t> m_burstFrames{0};
+    std::atomic<int64_t> m_totalXRuns{0};
+    std::atomic<bool> m_tuning{false};
+    
+    // Audio thread state, reset per stream
+    int32_t m_lastXRuns = 0;
+    int32_t m_floorFrames = 0;
+    int64_t m_quietFrames = 0;
+    int64_t m_shrinkAfterFrames = 0;
+    bool m_justShrunk = false;
+};
+
+#endif // MUSIMIND_BUFFER_TUNER_H
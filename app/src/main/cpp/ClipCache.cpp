@@ -0,0 +1,155 @@
+/**
+ * ClipCache.cpp
+ *
+ * Implementation of the pre-rendered clip cache.
+ */
+
+#include "ClipCache.h"
+#include <android/log.h>
+#include <cstring>
+
+#define LOG_TAG "ClipCache"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+bool ClipKey::operator==(const ClipKey& other) const {
+    if (program != other.program || noteCount != other.noteCount || velocity != other.velocity ||
+        durationFrames != other.durationFrames || spacingFrames != other.spacingFrames ||
+        sampleRate != other.sampleRate) {
+        return false;
+    }
+    return memcmp(notes, other.notes, noteCount * sizeof(int32_t)) == 0;
+}
+
+uint64_t ClipKey::hash() const {
+    // FNV-1a over the fields that take part in equality
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](int32_t value) {
+        for (int i = 0; i < 4; i++) {
+            h ^= (uint8_t)(value >> (i * 8));
+            h *= 1099511628211ull;
+        }
+    };
+    mix(program);
+    mix(noteCount);
+    for (int i = 0; i < noteCount; i++) {
+        mix(notes[i]);
+    }
+    mix(velocity);
+    mix(durationFrames);
+    mix(spacingFrames);
+    mix(sampleRate);
+    return h;
+}
+
+ClipCache::~ClipCache() {
+    for (int slot = 0; slot < kMaxClips; slot++) {
+        delete m_table[slot].load(std::memory_order_relaxed);
+    }
+}
+
+void ClipCache::setBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budgetBytes = bytes;
+    evictFor(0, false);
+}
+
+int ClipCache::acquire(const ClipKey& key) {
+    uint64_t hash = key.hash();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (int slot = 0; slot < kMaxClips; slot++) {
+        Clip* clip = m_table[slot].load(std::memory_order_relaxed);
+        if (clip && clip->hash == hash && clip->key == key) {
+            clip->users.fetch_add(1, std::memory_order_relaxed);
+            clip->lastUse = ++m_useClock;
+            m_hits++;
+            return slot;
+        }
+    }
+    m_misses++;
+    return -1;
+}
+
+int ClipCache::insert(const ClipKey& key, std::vector<float>&& samples) {
+    size_t bytes = samples.size() * sizeof(float);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (bytes > m_budgetBytes || !evictFor(bytes, true)) {
+        return -1;
+    }
+    int slot = 0;
+    while (m_table[slot].load(std::memory_order_relaxed)) {
+        slot++;  // evictFor guaranteed a free slot
+    }
+    
+    Clip* clip = new Clip();
+    clip->key = key;
+    clip->hash = key.hash();
+    clip->frames = samples.size() / 2;
+    clip->samples = std::move(samples);
+    clip->lastUse = ++m_useClock;
+    clip->users.store(1, std::memory_order_relaxed);
+    m_bytes += bytes;
+    m_table[slot].store(clip, std::memory_order_release);
+    return slot;
+}
+
+void ClipCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (int slot = 0; slot < kMaxClips; slot++) {
+        Clip* clip = m_table[slot].load(std::memory_order_relaxed);
+        if (clip && clip->users.load(std::memory_order_acquire) == 0) {
+            freeSlot(slot);
+        }
+    }
+}
+
+void ClipCache::release(int slot) {
+    Clip* clip = m_table[slot].load(std::memory_order_relaxed);
+    if (clip) {
+        clip->users.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+ClipCache::Stats ClipCache::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int clips = 0;
+    for (int slot = 0; slot < kMaxClips; slot++) {
+        if (m_table[slot].load(std::memory_order_relaxed)) {
+            clips++;
+        }
+    }
+    return Stats{clips, m_bytes, m_budgetBytes, m_hits, m_misses};
+}
+
+bool ClipCache::evictFor(size_t incoming, bool needSlot) {
+    for (;;) {
+        int used = 0;
+        int oldest = -1;
+        for (int slot = 0; slot < kMaxClips; slot++) {
+            Clip* clip = m_table[slot].load(std::memory_order_relaxed);
+            if (!clip) {
+                continue;
+            }
+            used++;
+            // Acquire pairs with release(): the audio thread is done with it
+            if (clip->users.load(std::memory_order_acquire) == 0 &&
+                (oldest < 0 || clip->lastUse < m_table[oldest].load(std::memory_order_relaxed)->lastUse)) {
+                oldest = slot;
+            }
+        }
+        bool fits = m_bytes + incoming <= m_budgetBytes && (!needSlot || used < kMaxClips);
+        if (fits) {
+            return true;
+        }
+        if (oldest < 0) {
+            return false;  // Everything left is playing
+        }
+        freeSlot(oldest);
+    }
+}
+
+void ClipCache::freeSlot(int slot) {
+    Clip* clip = m_table[slot].exchange(nullptr, std::memory_order_relaxed);
+    m_bytes -= clip->samples.size() * sizeof(float);
+    LOGI("Evicted clip %d (%zu frames)", slot, clip->frames);
+    delete clip;
+}
@@ -0,0 +1,102 @@
+/**
+ * ClipCache.h
+ *
+ * LRU cache of pre-rendered note clips (interval and chord prompts).
+ * Ear-training exercises replay the same few stimuli over and over; a
+ * cached clip is rendered once with the offline renderer and afterwards
+ * played by render() as a plain buffer add instead of live synthesis.
+ *
+ * Threading: lookups, inserts and eviction run on control threads under
+ * the cache mutex. Every play takes a reference on the clip before its
+ * command is queued and the audio thread drops it when the clip finishes,
+ * so eviction never frees a clip that is queued or sounding.
+ */
+
+#ifndef MUSIMIND_CLIP_CACHE_H
+#define MUSIMIND_CLIP_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Identity of a rendered clip
+struct ClipKey {
+    static constexpr int kMaxNotes = 8;
+    
+    int32_t program = 0;         // GM program on channel 0
+    int32_t noteCount = 0;
+    int32_t notes[kMaxNotes] = {};
+    int32_t velocity = 100;      // MIDI velocity 1-127 (quantized so keys compare exactly)
+    int32_t durationFrames = 0;  // Length of each note
+    int32_t spacingFrames = 0;   // 0 = notes together (harmonic); otherwise each starts this much later
+    int32_t sampleRate = 0;
+    
+    bool operator==(const ClipKey& other) const;
+    uint64_t hash() const;
+};
+
+class ClipCache {
+public:
+    static constexpr int kMaxClips = 64;
+    static constexpr size_t kDefaultBudgetBytes = 8 * 1024 * 1024;
+    
+    struct Clip {
+        ClipKey key;
+        uint64_t hash = 0;
+        std::vector<float> samples;  // Interleaved stereo
+        size_t frames = 0;
+        uint64_t lastUse = 0;        // Guarded by the cache mutex
+        std::atomic<int> users{0};   // Queued or sounding plays
+    };
+    
+    struct Stats {
+        int clips;
+        size_t bytes;
+        size_t budgetBytes;
+        uint32_t hits;
+        uint32_t misses;
+    };
+    
+    ClipCache() = default;
+    ~ClipCache();
+    ClipCache(const ClipCache&) = delete;
+    ClipCache& operator=(const ClipCache&) = delete;
+    
+    // Memory for clip samples; shrinking evicts idle clips right away
+    void setBudget(size_t bytes);
+    
+    // Slot of a cached clip with a play reference taken, or -1 on a miss
+    int acquire(const ClipKey& key);
+    
+    // Cache a rendered clip and take a play reference; evicts least recently
+    // used idle clips to stay within budget. -1 if there is no room.
+    int insert(const ClipKey& key, std::vector<float>&& samples);
+    
+    // Drop every idle clip, e.g. after the SoundFont they were rendered with is replaced
+    void clear();
+    
+    Stats getStats() const;
+    
+    // Audio thread: clip in a slot the caller holds a reference on
+    const Clip* get(int slot) const { return m_table[slot].load(std::memory_order_acquire); }
+    
+    // Any thread: drop a play reference
+    void release(int slot);
+    
+private:
+    // Free idle clips, oldest first, until `incoming` more bytes fit (m_mutex held)
+    bool evictFor(size_t incoming, bool needSlot);
+    void freeSlot(int slot);
+    
+    mutable std::mutex m_mutex;
+    std::atomic<Clip*> m_table[kMaxClips] = {};  // Written under m_mutex, read by render()
+    size_t m_budgetBytes = kDefaultBudgetBytes;
+    size_t m_bytes = 0;
+    uint64_t m_useClock = 0;
+    uint32_t m_hits = 0;
+    uint32_t m_misses = 0;
+};
+
+#endif // MUSIMIND_CLIP_CACHE_H
@@ -0,0 +1,403 @@
+/**
+ * DspKernels.cpp
+ *
+ * NEON, SSE2 and scalar implementations of the shared DSP kernels.
+ */
+
+#include "DspKernels.h"
+#include <algorithm>
+#include <cmath>
+
+// MUSIMIND_DSP_SCALAR builds the scalar paths only, as the reference the
+// host tests compare the SIMD paths with (tests/ScalarDspKernels.cpp)
+#if !defined(MUSIMIND_DSP_SCALAR) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define MUSIMIND_HAS_NEON 1
+#else
+#define MUSIMIND_HAS_NEON 0
+#endif
+
+#if !defined(MUSIMIND_DSP_SCALAR) && !MUSIMIND_HAS_NEON && defined(__SSE2__)
+#include <emmintrin.h>
+#define MUSIMIND_HAS_SSE 1
+#else
+#define MUSIMIND_HAS_SSE 0
+#endif
+
+bool DspKernels::hasSimd() {
+    return MUSIMIND_HAS_NEON != 0 || MUSIMIND_HAS_SSE != 0;
+}
+
+namespace {
+
+constexpr float INT16_SCALE = 32767.0f;
+constexpr float DITHER_SCALE = 1.0f / 65536.0f;
+
+// One xorshift32 step; the 16-bit halves of the result give two uniforms
+// whose difference is triangular dither in (-1, 1) LSB
+inline uint32_t xorshift(uint32_t x) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+inline float triangular(uint32_t x) {
+    return (float)((int32_t)(x >> 16) - (int32_t)(x & 0xFFFF)) * DITHER_SCALE;
+}
+
+} // namespace
+
+#if MUSIMIND_HAS_NEON
+// Horizontal add of a float32x4_t (vaddvq_f32 is A64-only)
+static inline float horizontalSum(float32x4_t v) {
+#if defined(__aarch64__)
+    return vaddvq_f32(v);
+#else
+    float32x2_t pair = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+}
+
+// a / b per lane (vdivq_f32 is A64-only; A32 refines the reciprocal estimate)
+static inline float32x4_t divide(float32x4_t a, float32x4_t b) {
+#if defined(__aarch64__)
+    return vdivq_f32(a, b);
+#else
+    float32x4_t r = vrecpeq_f32(b);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    return vmulq_f32(a, r);
+#endif
+}
+#endif
+
+float DspKernels::sumOfSquares(const float* x, int n) {
+    int i = 0;
+    float sum = 0.0f;
+#if MUSIMIND_HAS_NEON
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= n; i += 8) {
+        float32x4_t a = vld1q_f32(x + i);
+        float32x4_t b = vld1q_f32(x + i + 4);
+        acc0 = vmlaq_f32(acc0, a, a);
+        acc1 = vmlaq_f32(acc1, b, b);
+    }
+    sum = horizontalSum(vaddq_f32(acc0, acc1));
+#elif MUSIMIND_HAS_SSE
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        __m128 a = _mm_loadu_ps(x + i);
+        acc = _mm_add_ps(acc, _mm_mul_ps(a, a));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < n; i++) {
+        sum += x[i] * x[i];
+    }
+    return sum;
+}
+
+void DspKernels::multiply(const float* a, const float* b, float* out, int n) {
+    int i = 0;
+#if MUSIMIND_HAS_NEON
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(out + i, vmulq_f32(vld1q_f32(a + i), vld1q_f32(b + i)));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+void DspKernels::multiplyConjugate(const float* a, const float* b, float* out, int bins) {
+    int k = 0;
+#if MUSIMIND_HAS_NEON
+    for (; k + 4 <= bins; k += 4) {
+        float32x4x2_t va = vld2q_f32(a + 2 * k);
+        float32x4x2_t vb = vld2q_f32(b + 2 * k);
+        float32x4x2_t r;
+        // (ar - i*ai) * (br + i*bi) = (ar*br + ai*bi) + i(ar*bi - ai*br)
+        r.val[0] = vmlaq_f32(vmulq_f32(va.val[0], vb.val[0]), va.val[1], vb.val[1]);
+        r.val[1] = vmlsq_f32(vmulq_f32(va.val[0], vb.val[1]), va.val[1], vb.val[0]);
+        vst2q_f32(out + 2 * k, r);
+    }
+#endif
+    for (; k < bins; k++) {
+        float ar = a[2 * k], ai = a[2 * k + 1];
+        float br = b[2 * k], bi = b[2 * k + 1];
+        out[2 * k] = ar * br + ai * bi;
+        out[2 * k + 1] = ar * bi - ai * br;
+    }
+}
+
+void DspKernels::magnitude(const float* spectrum, float* out, int bins) {
+    int k = 0;
+#if MUSIMIND_HAS_NEON
+    for (; k + 4 <= bins; k += 4) {
+        float32x4x2_t z = vld2q_f32(spectrum + 2 * k);
+        float32x4_t power = vmlaq_f32(vmulq_f32(z.val[0], z.val[0]), z.val[1], z.val[1]);
+#if defined(__aarch64__)
+        vst1q_f32(out + k, vsqrtq_f32(power));
+#else
+        // sqrt(p) = p * rsqrt(p); zero power stays zero (0 * inf is masked off)
+        float32x4_t r = vrsqrteq_f32(power);
+        r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(power, r), r), r);
+        r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(power, r), r), r);
+        uint32x4_t nonZero = vmvnq_u32(vceqq_f32(power, vdupq_n_f32(0.0f)));
+        vst1q_f32(out + k, vbslq_f32(nonZero, vmulq_f32(power, r), vdupq_n_f32(0.0f)));
+#endif
+    }
+#endif
+    for (; k < bins; k++) {
+        float re = spectrum[2 * k], im = spectrum[2 * k + 1];
+        out[k] = std::sqrt(re * re + im * im);
+    }
+}
+
+float DspKernels::rectifiedDifferenceSum(const float* current, const float* previous, int n) {
+    int i = 0;
+    float sum = 0.0f;
+#if MUSIMIND_HAS_NEON
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    float32x4_t acc = zero;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t diff = vsubq_f32(vld1q_f32(current + i), vld1q_f32(previous + i));
+        acc = vaddq_f32(acc, vmaxq_f32(diff, zero));
+    }
+    sum = horizontalSum(acc);
+#endif
+    for (; i < n; i++) {
+        float diff = current[i] - previous[i];
+        sum += diff > 0.0f ? diff : 0.0f;
+    }
+    return sum;
+}
+
+void DspKernels::cumulativeMeanNormalize(float* d, int n) {
+    if (n <= 0) {
+        return;
+    }
+    d[0] = 1.0f;
+    float runningSum = 0.0f;
+    int tau = 1;
+#if MUSIMIND_HAS_NEON
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t four = vdupq_n_f32(4.0f);
+    const float laneOffsets[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+    float32x4_t taus = vaddq_f32(vdupq_n_f32(1.0f), vld1q_f32(laneOffsets));
+    for (; tau + 4 <= n; tau += 4) {
+        float32x4_t v = vld1q_f32(d + tau);
+        
+        // Inclusive prefix sum within the vector, then add the carried sum
+        float32x4_t prefix = vaddq_f32(v, vextq_f32(zero, v, 3));
+        prefix = vaddq_f32(prefix, vextq_f32(zero, prefix, 2));
+        prefix = vaddq_f32(prefix, vdupq_n_f32(runningSum));
+        runningSum = vgetq_lane_f32(prefix, 3);
+        
+        // d * tau / sum, or 1 where the sum is still zero
+        uint32x4_t nonZero = vmvnq_u32(vceqq_f32(prefix, zero));
+        float32x4_t safeSum = vbslq_f32(nonZero, prefix, one);
+        float32x4_t normalized = divide(vmulq_f32(v, taus), safeSum);
+        vst1q_f32(d + tau, vbslq_f32(nonZero, normalized, one));
+        
+        taus = vaddq_f32(taus, four);
+    }
+#endif
+    for (; tau < n; tau++) {
+        runningSum += d[tau];
+        d[tau] = runningSum != 0.0f ? d[tau] * tau / runningSum : 1.0f;
+    }
+}
+
+void DspKernels::mixAdd(float* dst, const float* src, int n) {
+    int i = 0;
+#if MUSIMIND_HAS_NEON
+    for (; i + 8 <= n; i += 8) {
+        vst1q_f32(dst + i, vaddq_f32(vld1q_f32(dst + i), vld1q_f32(src + i)));
+        vst1q_f32(dst + i + 4, vaddq_f32(vld1q_f32(dst + i + 4), vld1q_f32(src + i + 4)));
+    }
+#elif MUSIMIND_HAS_SSE
+    for (; i + 8 <= n; i += 8) {
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+        _mm_storeu_ps(dst + i + 4, _mm_add_ps(_mm_loadu_ps(dst + i + 4), _mm_loadu_ps(src + i + 4)));
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] += src[i];
+    }
+}
+
+void DspKernels::mixAddRampedStereo(float* dst, const float* src, int frames, float gainStart, float gainStep) {
+    int f = 0;
+    // Gains are computed from the frame index (not accumulated) so every path agrees
+#if MUSIMIND_HAS_NEON
+    const float laneFrames[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+    float32x4_t index = vld1q_f32(laneFrames);
+    const float32x4_t two = vdupq_n_f32(2.0f);
+    const float32x4_t start = vdupq_n_f32(gainStart);
+    const float32x4_t step = vdupq_n_f32(gainStep);
+    for (; f + 2 <= frames; f += 2) {
+        float32x4_t gain = vaddq_f32(start, vmulq_f32(step, index));
+        vst1q_f32(dst + f * 2, vaddq_f32(vld1q_f32(dst + f * 2), vmulq_f32(vld1q_f32(src + f * 2), gain)));
+        index = vaddq_f32(index, two);
+    }
+#elif MUSIMIND_HAS_SSE
+    __m128 index = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 start = _mm_set1_ps(gainStart);
+    const __m128 step = _mm_set1_ps(gainStep);
+    for (; f + 2 <= frames; f += 2) {
+        __m128 gain = _mm_add_ps(start, _mm_mul_ps(step, index));
+        _mm_storeu_ps(dst + f * 2, _mm_add_ps(_mm_loadu_ps(dst + f * 2), _mm_mul_ps(_mm_loadu_ps(src + f * 2), gain)));
+        index = _mm_add_ps(index, two);
+    }
+#endif
+    for (; f < frames; f++) {
+        float gain = gainStart + gainStep * (float)f;
+        dst[f * 2] += src[f * 2] * gain;
+        dst[f * 2 + 1] += src[f * 2 + 1] * gain;
+    }
+}
+
+void DspKernels::floatToInt16Dithered(const float* src, int16_t* dst, int n, DitherState& dither) {
+    int i = 0;
+    // Sample i always draws from lane i % 4, so the paths share one sequence
+#if MUSIMIND_HAS_NEON
+    uint32x4_t state = vld1q_u32(dither.lanes);
+    const float32x4_t scale = vdupq_n_f32(INT16_SCALE);
+    const float32x4_t ditherScale = vdupq_n_f32(DITHER_SCALE);
+    const float32x4_t low = vdupq_n_f32(-32768.0f);
+    const float32x4_t high = vdupq_n_f32(32767.0f);
+    const uint32x4_t mask = vdupq_n_u32(0xFFFF);
+    for (; i + 4 <= n; i += 4) {
+        state = veorq_u32(state, vshlq_n_u32(state, 13));
+        state = veorq_u32(state, vshrq_n_u32(state, 17));
+        state = veorq_u32(state, vshlq_n_u32(state, 5));
+        int32x4_t diff = vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(state, 16)),
+                                   vreinterpretq_s32_u32(vandq_u32(state, mask)));
+        float32x4_t v = vaddq_f32(vmulq_f32(vld1q_f32(src + i), scale),
+                                  vmulq_f32(vcvtq_f32_s32(diff), ditherScale));
+        v = vminq_f32(vmaxq_f32(v, low), high);
+#if defined(__aarch64__)
+        int32x4_t rounded = vcvtnq_s32_f32(v);
+#else
+        // Round half away from zero, then truncate
+        uint32x4_t negative = vcltq_f32(v, vdupq_n_f32(0.0f));
+        float32x4_t half = vbslq_f32(negative, vdupq_n_f32(-0.5f), vdupq_n_f32(0.5f));
+        int32x4_t rounded = vcvtq_s32_f32(vaddq_f32(v, half));
+#endif
+        vst1_s16(dst + i, vqmovn_s32(rounded));
+    }
+    vst1q_u32(dither.lanes, state);
+#elif MUSIMIND_HAS_SSE
+    __m128i state = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither.lanes));
+    const __m128 scale = _mm_set1_ps(INT16_SCALE);
+    const __m128 ditherScale = _mm_set1_ps(DITHER_SCALE);
+    const __m128 low = _mm_set1_ps(-32768.0f);
+    const __m128 high = _mm_set1_ps(32767.0f);
+    const __m128i mask = _mm_set1_epi32(0xFFFF);
+    for (; i + 4 <= n; i += 4) {
+        state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+        state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+        state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+        __m128i diff = _mm_sub_epi32(_mm_srli_epi32(state, 16), _mm_and_si128(state, mask));
+        __m128 v = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + i), scale),
+                              _mm_mul_ps(_mm_cvtepi32_ps(diff), ditherScale));
+        v = _mm_min_ps(_mm_max_ps(v, low), high);
+        __m128i rounded = _mm_cvtps_epi32(v);  // Round to nearest even, like lrintf
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(rounded, rounded));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dither.lanes), state);
+#endif
+    for (; i < n; i++) {
+        uint32_t& lane = dither.lanes[i & 3];
+        lane = xorshift(lane);
+        float v = src[i] * INT16_SCALE + triangular(lane);
+        v = std::min(std::max(v, -32768.0f), 32767.0f);
+        dst[i] = (int16_t)std::lrint(v);
+    }
+}
+
+void DspKernels::interleave(const float* left, const float* right, float* out, int frames) {
+    int f = 0;
+#if MUSIMIND_HAS_NEON
+    for (; f + 4 <= frames; f += 4) {
+        float32x4x2_t pair;
+        pair.val[0] = vld1q_f32(left + f);
+        pair.val[1] = vld1q_f32(right + f);
+        vst2q_f32(out + f * 2, pair);
+    }
+#elif MUSIMIND_HAS_SSE
+    for (; f + 4 <= frames; f += 4) {
+        __m128 l = _mm_loadu_ps(left + f);
+        __m128 r = _mm_loadu_ps(right + f);
+        _mm_storeu_ps(out + f * 2, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(out + f * 2 + 4, _mm_unpackhi_ps(l, r));
+    }
+#endif
+    for (; f < frames; f++) {
+        out[f * 2] = left[f];
+        out[f * 2 + 1] = right[f];
+    }
+}
+
+void DspKernels::deinterleave(const float* in, float* left, float* right, int frames) {
+    int f = 0;
+#if MUSIMIND_HAS_NEON
+    for (; f + 4 <= frames; f += 4) {
+        float32x4x2_t pair = vld2q_f32(in + f * 2);
+        vst1q_f32(left + f, pair.val[0]);
+        vst1q_f32(right + f, pair.val[1]);
+    }
+#elif MUSIMIND_HAS_SSE
+    for (; f + 4 <= frames; f += 4) {
+        __m128 a = _mm_loadu_ps(in + f * 2);      // L0 R0 L1 R1
+        __m128 b = _mm_loadu_ps(in + f * 2 + 4);  // L2 R2 L3 R3
+        _mm_storeu_ps(left + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(right + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#endif
+    for (; f < frames; f++) {
+        left[f] = in[f * 2];
+        right[f] = in[f * 2 + 1];
+    }
+}
+
+float DspKernels::peak(const float* x, int n) {
+    int i = 0;
+    float result = 0.0f;
+#if MUSIMIND_HAS_NEON
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (; i + 4 <= n; i += 4) {
+        acc = vmaxq_f32(acc, vabsq_f32(vld1q_f32(x + i)));
+    }
+#if defined(__aarch64__)
+    result = vmaxvq_f32(acc);
+#else
+    float32x2_t pair = vpmax_f32(vget_low_f32(acc), vget_high_f32(acc));
+    result = vget_lane_f32(vpmax_f32(pair, pair), 0);
+#endif
+#elif MUSIMIND_HAS_SSE
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm_max_ps(acc, _mm_and_ps(_mm_loadu_ps(x + i), absMask));
+    }
+    acc = _mm_max_ps(acc, _mm_shuffle_ps(acc, acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_max_ps(acc, _mm_shuffle_ps(acc, acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    result = _mm_cvtss_f32(acc);
+#endif
+    for (; i < n; i++) {
+        result = std::max(result, std::fabs(x[i]));
+    }
+    return result;
+}
+
+float DspKernels::rms(const float* x, int n) {
+    return n > 0 ? std::sqrt(sumOfSquares(x, n) / n) : 0.0f;
+}
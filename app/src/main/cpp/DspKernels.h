@@ -0,0 +1,65 @@
+/**
+ * DspKernels.h
+ *
+ * Vectorized inner loops shared by the native DSP code.
+ * Each kernel has an ARM NEON implementation and a scalar fallback; the
+ * mixing, conversion and metering kernels also have SSE2 paths for x86
+ * emulators. All paths produce the same results up to float rounding
+ * order (int16 conversion: up to 1 LSB on 32-bit ARM, which rounds ties
+ * away from zero).
+ */
+
+#ifndef MUSIMIND_DSP_KERNELS_H
+#define MUSIMIND_DSP_KERNELS_H
+
+#include <cstdint>
+
+class DspKernels {
+public:
+    // Per-lane xorshift32 generators for TPDF dither; any non-zero seeds work
+    struct DitherState {
+        uint32_t lanes[4] = { 0x9E3779B9u, 0x7F4A7C15u, 0x94D049BBu, 0x2545F491u };
+    };
+    
+    // sum(x[i]^2)
+    static float sumOfSquares(const float* x, int n);
+    
+    // out[i] = a[i] * b[i]
+    static void multiply(const float* a, const float* b, float* out, int n);
+    
+    // out[k] = conj(a[k]) * b[k] over interleaved complex bins
+    static void multiplyConjugate(const float* a, const float* b, float* out, int bins);
+    
+    // out[k] = |z[k]| over interleaved complex bins
+    static void magnitude(const float* spectrum, float* out, int bins);
+    
+    // sum(max(0, current[i] - previous[i])), the half-wave rectified spectral flux
+    static float rectifiedDifferenceSum(const float* current, const float* previous, int n);
+    
+    // YIN cumulative mean normalized difference, in place:
+    // d[0] = 1, d[tau] = d[tau] * tau / sum(d[1..tau])
+    static void cumulativeMeanNormalize(float* d, int n);
+    
+    // dst[i] += src[i]
+    static void mixAdd(float* dst, const float* src, int n);
+    
+    // Interleaved stereo: dst += src * gain, gain ramping from gainStart by
+    // gainStep per frame (both channels of a frame get the same gain)
+    static void mixAddRampedStereo(float* dst, const float* src, int frames, float gainStart, float gainStep);
+    
+    // -1..1 floats to int16 with triangular (TPDF) dither of +-1 LSB, clipped
+    static void floatToInt16Dithered(const float* src, int16_t* dst, int n, DitherState& dither);
+    
+    // Planar stereo <-> interleaved stereo
+    static void interleave(const float* left, const float* right, float* out, int frames);
+    static void deinterleave(const float* in, float* left, float* right, int frames);
+    
+    // max(|x[i]|) and sqrt(mean(x[i]^2)) for level meters
+    static float peak(const float* x, int n);
+    static float rms(const float* x, int n);
+    
+    // True when the NEON or SSE2 paths are compiled in
+    static bool hasSimd();
+};
+
+#endif // MUSIMIND_DSP_KERNELS_H
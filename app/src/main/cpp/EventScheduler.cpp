@@ -0,0 +1,83 @@
+/**
+ * EventScheduler.cpp
+ *
+ * Implementation of the sample-accurate event heap.
+ */
+
+#include "EventScheduler.h"
+#include <utility>
+
+bool EventScheduler::earlier(const Entry& a, const Entry& b) {
+    if (a.command.frame != b.command.frame) {
+        return a.command.frame < b.command.frame;
+    }
+    return a.order < b.order;
+}
+
+bool EventScheduler::schedule(const AudioCommand& command) {
+    if (m_size >= kCapacity) {
+        return false;
+    }
+    m_heap[m_size] = { command, m_nextOrder++ };
+    siftUp(m_size);
+    m_size++;
+    return true;
+}
+
+int64_t EventScheduler::nextEventFrame() const {
+    return m_size > 0 ? m_heap[0].command.frame : INT64_MAX;
+}
+
+bool EventScheduler::popDue(int64_t frame, AudioCommand& command) {
+    if (m_size == 0 || m_heap[0].command.frame > frame) {
+        return false;
+    }
+    command = m_heap[0].command;
+    m_size--;
+    if (m_size > 0) {
+        m_heap[0] = m_heap[m_size];
+        siftDown(0);
+    }
+    return true;
+}
+
+size_t EventScheduler::removeType(AudioCommand::Type type) {
+    return removeIf([type](const AudioCommand& command) { return command.type == type; });
+}
+
+void EventScheduler::heapify() {
+    // Restore the heap property bottom-up; submission order is kept by Entry::order
+    for (size_t i = m_size / 2; i-- > 0;) {
+        siftDown(i);
+    }
+}
+
+void EventScheduler::siftUp(size_t index) {
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!earlier(m_heap[index], m_heap[parent])) {
+            break;
+        }
+        std::swap(m_heap[index], m_heap[parent]);
+        index = parent;
+    }
+}
+
+void EventScheduler::siftDown(size_t index) {
+    for (;;) {
+        size_t left = index * 2 + 1;
+        size_t right = left + 1;
+        size_t smallest = index;
+        if (left < m_size && earlier(m_heap[left], m_heap[smallest])) {
+            smallest = left;
+        }
+        if (right < m_size && earlier(m_heap[right], m_heap[smallest])) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            break;
+        }
+        std::swap(m_heap[index], m_heap[smallest]);
+        index = smallest;
+    }
+}
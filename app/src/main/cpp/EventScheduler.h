@@ -0,0 +1,75 @@
+/**
+ * EventScheduler.h
+ *
+ * Sample-accurate event queue owned by the audio thread.
+ * Holds AudioCommands stamped with a stream frame position in a fixed-capacity
+ * binary min-heap, so render() can split each callback exactly at event
+ * boundaries. Never allocates after construction.
+ */
+
+#ifndef MUSIMIND_EVENT_SCHEDULER_H
+#define MUSIMIND_EVENT_SCHEDULER_H
+
+#include "AudioCommand.h"
+#include <cstddef>
+#include <cstdint>
+
+class EventScheduler {
+public:
+    static constexpr size_t kCapacity = 1024;
+    
+    // Add an event (audio thread only). Returns false if the heap is full.
+    bool schedule(const AudioCommand& command);
+    
+    // Frame of the earliest pending event, or INT64_MAX if none
+    int64_t nextEventFrame() const;
+    
+    // Remove the earliest event if it is due at or before the given frame
+    bool popDue(int64_t frame, AudioCommand& command);
+    
+    // Drop every pending event
+    void clear() { m_size = 0; }
+    
+    // Drop the pending events of one type, keeping the rest in order (audio thread only)
+    size_t removeType(AudioCommand::Type type);
+    
+    // Drop the pending events matching a predicate; it sees every event once,
+    // so it can also release what a dropped event refers to
+    template <typename Predicate>
+    size_t removeIf(Predicate matches);
+    
+    size_t size() const { return m_size; }
+    
+private:
+    struct Entry {
+        AudioCommand command;
+        uint64_t order;  // Keeps events on the same frame in submission order
+    };
+    
+    static bool earlier(const Entry& a, const Entry& b);
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+    void heapify();
+    
+    Entry m_heap[kCapacity];
+    size_t m_size = 0;
+    uint64_t m_nextOrder = 0;
+};
+
+template <typename Predicate>
+size_t EventScheduler::removeIf(Predicate matches) {
+    size_t kept = 0;
+    for (size_t i = 0; i < m_size; i++) {
+        if (!matches(m_heap[i].command)) {
+            m_heap[kept++] = m_heap[i];
+        }
+    }
+    size_t removed = m_size - kept;
+    m_size = kept;
+    if (removed > 0) {
+        heapify();
+    }
+    return removed;
+}
+
+#endif // MUSIMIND_EVENT_SCHEDULER_H
@@ -0,0 +1,70 @@
+/**
+ * InputRing.cpp
+ *
+ * Implementation of the shared input history.
+ */
+
+#include "InputRing.h"
+#include <algorithm>
+#include <cstring>
+
+void InputRing::configure(int minCapacity, int maxWriteFrames) {
+    m_guard = std::max(0, maxWriteFrames);
+    int capacity = 1;
+    while (capacity < minCapacity + m_guard) {
+        capacity <<= 1;
+    }
+    m_buffer.assign(capacity, 0.0f);
+    m_mask = capacity - 1;
+    m_writeCount.store(0, std::memory_order_relaxed);
+    m_writeClaim.store(0, std::memory_order_relaxed);
+    m_frameOffset.store(0, std::memory_order_relaxed);
+}
+
+void InputRing::write(const float* input, int numFrames, int64_t firstFrame) {
+    const int capacity = (int)m_buffer.size();
+    if (capacity == 0 || numFrames <= 0) {
+        return;
+    }
+    
+    // Single writer: its own count needs no ordering
+    int64_t writeCount = m_writeCount.load(std::memory_order_relaxed);
+    m_frameOffset.store(firstFrame - writeCount, std::memory_order_relaxed);
+    
+    // Only the newest guard's worth can be written without touching readable samples
+    const int maxWrite = m_guard > 0 ? m_guard : capacity;
+    if (numFrames > maxWrite) {
+        input += numFrames - maxWrite;
+        writeCount += numFrames - maxWrite;
+        numFrames = maxWrite;
+    }
+    
+    // Claim the block before touching it: a reader whose copy overlaps
+    // this memcpy then sees at least this claim in holds()
+    m_writeClaim.store(writeCount + numFrames, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    int start = (int)(writeCount & m_mask);
+    int first = std::min(numFrames, capacity - start);
+    memcpy(m_buffer.data() + start, input, first * sizeof(float));
+    memcpy(m_buffer.data(), input + first, (numFrames - first) * sizeof(float));
+    m_writeCount.store(writeCount + numFrames, std::memory_order_release);
+}
+
+void InputRing::read(int64_t start, float* output, int count) const {
+    const int capacity = (int)m_buffer.size();
+    int offset = (int)(start & m_mask);
+    int first = std::min(count, capacity - offset);
+    memcpy(output, m_buffer.data() + offset, first * sizeof(float));
+    memcpy(output + first, m_buffer.data(), (count - first) * sizeof(float));
+}
+
+int64_t InputRing::oldestIndex() const {
+    return std::max<int64_t>(0, writeCount() - capacity());
+}
+
+bool InputRing::holds(int64_t start) const {
+    // Keep the copy ahead of the count it is validated against (seqlock read side)
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return start >= std::max<int64_t>(0, m_writeClaim.load(std::memory_order_relaxed) - capacity());
+}
@@ -0,0 +1,69 @@
+/**
+ * InputRing.h
+ *
+ * Circular history of the mono input stream, shared by every input analyzer
+ * (pitch tracker, onset detector, latency calibrator). Samples are written
+ * once per callback and indexed by a running sample count; each analyzer
+ * keeps its own read cursor and copies the windows it needs, so they all see
+ * the same samples on the same frame clock.
+ *
+ * One writer (the audio callback) and readers on any thread. The write count
+ * is published with release semantics after the samples, so everything below
+ * writeCount() is readable. Before each copy the writer also claims the block
+ * it is about to overwrite, behind a release fence (the seqlock writer of
+ * UiStateChannel), so no sample of a block can reach a reader ahead of its
+ * claim. The writer never waits: a reader that falls a whole ring behind
+ * loses samples, which it detects by checking holds() after its copy. A
+ * guard region of one maximal write is kept out of oldestIndex(), so a write
+ * in flight never touches what readers may use.
+ */
+
+#ifndef MUSIMIND_INPUT_RING_H
+#define MUSIMIND_INPUT_RING_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+class InputRing {
+public:
+    // Allocate room for at least minCapacity readable samples plus a guard
+    // of maxWriteFrames (rounded up to a power of two) and clear the history.
+    // Not real-time safe; only call while nothing reads or writes.
+    void configure(int minCapacity, int maxWriteFrames);
+    
+    // Append input; firstFrame is the stream frame of input[0] (writer only)
+    void write(const float* input, int numFrames, int64_t firstFrame);
+    
+    // Copy count samples starting at sample index start (oldest first).
+    // The range must lie within [oldestIndex(), writeCount()); a reader on
+    // another thread confirms with holds(start) afterwards.
+    void read(int64_t start, float* output, int count) const;
+    
+    // Running index of the next sample to be written
+    int64_t writeCount() const { return m_writeCount.load(std::memory_order_acquire); }
+    
+    // Oldest sample index readers may use
+    int64_t oldestIndex() const;
+    
+    // Whether samples from start on were still intact when the last read() ended
+    bool holds(int64_t start) const;
+    
+    // Stream frame of a sample index
+    int64_t frameOf(int64_t index) const { return index + m_frameOffset.load(std::memory_order_relaxed); }
+    
+    int capacity() const { return (int)m_buffer.size() - m_guard; }
+    
+private:
+    std::vector<float> m_buffer;
+    int64_t m_mask = 0;
+    int m_guard = 0;
+    std::atomic<int64_t> m_writeCount{0};
+    std::atomic<int64_t> m_writeClaim{0};  // End of the block being written; holds() checks it
+    
+    // frame = index + offset, updated on every write. Input reads can come up
+    // short, so this follows the latest block rather than assuming continuity.
+    std::atomic<int64_t> m_frameOffset{0};
+};
+
+#endif // MUSIMIND_INPUT_RING_H
@@ -0,0 +1,237 @@
+/**
+ * LatencyCalibrator.cpp
+ *
+ * Implementation of the round-trip latency calibration.
+ */
+
+#include "LatencyCalibrator.h"
+#include "DspKernels.h"
+#include "RealFft.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#define LOG_TAG "LatencyCalibrator"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+constexpr int CHIRP_COUNT = 6;
+constexpr float CHIRP_SPACING_MS = 500.0f;
+constexpr float CHIRP_DURATION_MS = 20.0f;
+constexpr float CHIRP_START_HZ = 500.0f;
+constexpr float CHIRP_END_HZ = 5000.0f;
+constexpr float CHIRP_AMPLITUDE = 0.5f;
+constexpr float MAX_LATENCY_MS = 400.0f;   // Longest round trip searched for
+constexpr float MIN_PEAK_TO_RMS = 8.0f;    // Matched filter peak over its RMS needed to count a chirp
+constexpr float AGREEMENT_MS = 1.0f;       // Detections must agree with the median this closely
+constexpr int MIN_DETECTIONS = 3;
+
+void LatencyCalibrator::start(int sampleRate, int64_t firstChirpFrame, int32_t inputOffsetFrames) {
+    cancel();
+    
+    m_sampleRate = sampleRate;
+    m_spacingFrames = (int)(sampleRate * CHIRP_SPACING_MS / 1000.0f);
+    m_maxLagFrames = (int)(sampleRate * MAX_LATENCY_MS / 1000.0f);
+    m_firstChirpFrame = firstChirpFrame;
+    m_inputOffsetFrames = inputOffsetFrames;
+    m_captureCursor = -1;
+    m_result = {};
+    
+    // Linear sweep, Hann-tapered so it plays without clicks and has a sharp
+    // autocorrelation peak
+    int chirpFrames = (int)(sampleRate * CHIRP_DURATION_MS / 1000.0f);
+    m_chirp.resize(chirpFrames);
+    double duration = (double)chirpFrames / sampleRate;
+    double sweepRate = (CHIRP_END_HZ - CHIRP_START_HZ) / duration;
+    for (int i = 0; i < chirpFrames; i++) {
+        double t = (double)i / sampleRate;
+        double phase = 2.0 * M_PI * (CHIRP_START_HZ * t + 0.5 * sweepRate * t * t);
+        double taper = 0.5 * (1.0 - std::cos(2.0 * M_PI * i / (chirpFrames - 1)));
+        m_chirp[i] = (float)(CHIRP_AMPLITUDE * taper * std::sin(phase));
+    }
+    
+    // Room for the last chirp plus the longest round trip
+    int captureFrames = (CHIRP_COUNT - 1) * m_spacingFrames + m_maxLagFrames + chirpFrames;
+    m_capture.assign(captureFrames, 0.0f);
+    
+    m_state.store(STATE_RUNNING, std::memory_order_release);
+    LOGI("Calibration started: %d chirps from frame %lld", CHIRP_COUNT, (long long)firstChirpFrame);
+}
+
+void LatencyCalibrator::cancel() {
+    // Store then load against the callback's m_inUse store then m_state load:
+    // only sequential consistency keeps both sides from missing each other
+    // (release/acquire does not order a store before a later load)
+    m_state.store(STATE_IDLE);
+    while (m_inUse.load()) {
+        std::this_thread::yield();
+    }
+}
+
+void LatencyCalibrator::renderOutput(float* output, int numFrames, int channelCount, int64_t firstFrame) {
+    m_inUse.store(true);
+    if (m_state.load() == STATE_RUNNING) {  // seq_cst: pairs with cancel()
+        const int64_t chirpFrames = (int64_t)m_chirp.size();
+        for (int k = 0; k < CHIRP_COUNT; k++) {
+            int64_t chirpStart = m_firstChirpFrame + (int64_t)k * m_spacingFrames;
+            int64_t from = std::max(firstFrame, chirpStart);
+            int64_t to = std::min(firstFrame + numFrames, chirpStart + chirpFrames);
+            for (int64_t f = from; f < to; f++) {
+                float sample = m_chirp[f - chirpStart];
+                float* frame = output + (f - firstFrame) * channelCount;
+                for (int c = 0; c < channelCount; c++) {
+                    frame[c] += sample;
+                }
+            }
+        }
+    }
+    m_inUse.store(false);
+}
+
+void LatencyCalibrator::captureInput(const InputRing& ring) {
+    m_inUse.store(true);
+    if (m_state.load() == STATE_RUNNING) {  // seq_cst: pairs with cancel()
+        if (m_captureCursor < 0) {
+            m_captureCursor = ring.oldestIndex();
+        }
+        m_captureCursor = std::max(m_captureCursor, ring.oldestIndex());
+        
+        // Capture on the raw input clock, before the current offset was
+        // subtracted, so the lag found is the full round trip
+        const int64_t captureLength = (int64_t)m_capture.size();
+        int64_t captureIndex = ring.frameOf(m_captureCursor) + m_inputOffsetFrames - m_firstChirpFrame;
+        int64_t available = ring.writeCount() - m_captureCursor;
+        
+        int64_t skip = std::max<int64_t>(0, -captureIndex);
+        int64_t count = std::min(available, captureLength - captureIndex) - skip;
+        if (count > 0) {
+            ring.read(m_captureCursor + skip, m_capture.data() + captureIndex + skip, (int)count);
+        }
+        m_captureCursor += available;
+        
+        if (captureIndex + available >= captureLength) {
+            m_state.store(STATE_CAPTURED, std::memory_order_release);
+        }
+    }
+    m_inUse.store(false);
+}
+
+bool LatencyCalibrator::findChirp(const float* segment, int segmentLength, int& lag, float& quality) const {
+    const int chirpFrames = (int)m_chirp.size();
+    const int maxLag = segmentLength - chirpFrames;
+    if (maxLag <= 0) {
+        return false;
+    }
+    
+    int fftSize = 4;
+    while (fftSize < segmentLength) {
+        fftSize <<= 1;
+    }
+    
+    // corr[l] = sum chirp[j] * segment[j + l]; segmentLength <= fftSize, so no wrap
+    RealFft fft(fftSize);
+    std::vector<float> padded(fftSize, 0.0f);
+    std::vector<float> chirpSpectrum(fft.spectrumFloats());
+    std::vector<float> segmentSpectrum(fft.spectrumFloats());
+    std::vector<float> correlation(fftSize);
+    
+    std::copy(m_chirp.begin(), m_chirp.end(), padded.begin());
+    fft.forward(padded.data(), chirpSpectrum.data());
+    std::fill(padded.begin(), padded.end(), 0.0f);
+    std::copy(segment, segment + segmentLength, padded.begin());
+    fft.forward(padded.data(), segmentSpectrum.data());
+    DspKernels::multiplyConjugate(chirpSpectrum.data(), segmentSpectrum.data(),
+                                  segmentSpectrum.data(), fftSize / 2 + 1);
+    fft.inverse(segmentSpectrum.data(), correlation.data());
+    
+    // Matched filter peak (either polarity: some input paths invert)
+    float peak = 0.0f;
+    int peakLag = -1;
+    double correlationEnergy = 0.0;
+    for (int l = 0; l <= maxLag; l++) {
+        float magnitude = std::fabs(correlation[l]);
+        correlationEnergy += (double)magnitude * magnitude;
+        if (magnitude > peak) {
+            peak = magnitude;
+            peakLag = l;
+        }
+    }
+    
+    // Accept the peak only if it stands well above the filter's noise floor.
+    // Hum and background raise every lag equally, so this holds up where a
+    // normalized correlation would not.
+    double correlationRms = std::sqrt(correlationEnergy / (maxLag + 1));
+    if (peakLag < 0 || correlationRms <= 0.0 || peak < MIN_PEAK_TO_RMS * correlationRms) {
+        lag = peakLag;
+        quality = 0.0f;
+        return false;
+    }
+    
+    // Report the normalized correlation at the peak as the quality
+    double chirpEnergy = DspKernels::sumOfSquares(m_chirp.data(), chirpFrames);
+    double windowEnergy = DspKernels::sumOfSquares(segment + peakLag, chirpFrames);
+    lag = peakLag;
+    quality = windowEnergy > 0.0 ? (float)std::min(1.0, peak / std::sqrt(chirpEnergy * windowEnergy)) : 0.0f;
+    return true;
+}
+
+bool LatencyCalibrator::analyze(LatencyResult& result) {
+    State state = getState();
+    if (state == STATE_DONE) {
+        result = m_result;
+        return true;
+    }
+    if (state != STATE_CAPTURED) {
+        return false;
+    }
+    
+    const int segmentLength = m_maxLagFrames + (int)m_chirp.size();
+    int lags[CHIRP_COUNT];
+    float qualities[CHIRP_COUNT];
+    int found = 0;
+    for (int k = 0; k < CHIRP_COUNT; k++) {
+        int lag = -1;
+        float quality = 0.0f;
+        if (findChirp(m_capture.data() + k * m_spacingFrames, segmentLength, lag, quality)) {
+            lags[found] = lag;
+            qualities[found] = quality;
+            found++;
+        }
+        LOGI("Chirp %d: lag=%d quality=%.2f", k, lag, quality);
+    }
+    
+    if (found < MIN_DETECTIONS) {
+        LOGI("Calibration failed: %d/%d chirps detected", found, CHIRP_COUNT);
+        m_state.store(STATE_FAILED, std::memory_order_release);
+        return false;
+    }
+    
+    std::vector<int> sortedLags(lags, lags + found);
+    std::nth_element(sortedLags.begin(), sortedLags.begin() + found / 2, sortedLags.end());
+    int medianLag = sortedLags[found / 2];
+    
+    std::vector<float> sortedQualities(qualities, qualities + found);
+    std::nth_element(sortedQualities.begin(), sortedQualities.begin() + found / 2, sortedQualities.end());
+    
+    int tolerance = std::max(1, (int)(m_sampleRate * AGREEMENT_MS / 1000.0f));
+    int agreeing = 0;
+    for (int i = 0; i < found; i++) {
+        if (std::abs(lags[i] - medianLag) <= tolerance) {
+            agreeing++;
+        }
+    }
+    if (agreeing < MIN_DETECTIONS) {
+        LOGI("Calibration failed: only %d chirps agree on lag %d", agreeing, medianLag);
+        m_state.store(STATE_FAILED, std::memory_order_release);
+        return false;
+    }
+    
+    m_result.roundTripFrames = medianLag;
+    m_result.detections = agreeing;
+    m_result.quality = sortedQualities[found / 2];
+    result = m_result;
+    m_state.store(STATE_DONE, std::memory_order_release);
+    LOGI("Calibration done: roundTrip=%d frames (%.1f ms), %d chirps, quality=%.2f",
+         medianLag, medianLag * 1000.0f / m_sampleRate, agreeing, m_result.quality);
+    return true;
+}
@@ -0,0 +1,79 @@
+/**
+ * LatencyCalibrator.h
+ *
+ * Measures the output-to-input round-trip latency of the full-duplex stream.
+ * A train of short Hann-tapered chirps is mixed into the output on exact
+ * stream frames, the input is captured from the shared InputRing, and a
+ * matched filter finds each chirp in the recording. The median lag is the
+ * number of frames between a sound being written to the output and the same
+ * sound being stamped on the input, i.e. the offset input analyzers must
+ * subtract to line up with the output scheduler.
+ *
+ * start()/cancel()/analyze() run on the JNI thread; renderOutput() and
+ * captureInput() run on the audio thread and only touch the buffers while
+ * the calibrator is running.
+ */
+
+#ifndef MUSIMIND_LATENCY_CALIBRATOR_H
+#define MUSIMIND_LATENCY_CALIBRATOR_H
+
+#include "InputRing.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+struct LatencyResult {
+    int32_t roundTripFrames;  // Output write to input stamp, in frames
+    int32_t detections;       // Chirps found within tolerance of the median
+    float quality;            // Median normalized correlation peak [0, 1]
+};
+
+class LatencyCalibrator {
+public:
+    enum State {
+        STATE_IDLE = 0,
+        STATE_RUNNING = 1,
+        STATE_CAPTURED = 2,  // Recording complete, waiting for analyze()
+        STATE_DONE = 3,
+        STATE_FAILED = 4
+    };
+    
+    // Allocate the test signal and capture buffer and arm the calibrator.
+    // firstChirpFrame is the stream frame of the first chirp; inputOffsetFrames
+    // is the offset already subtracted from input stamps. Not real-time safe.
+    void start(int sampleRate, int64_t firstChirpFrame, int32_t inputOffsetFrames);
+    
+    // Abort a run and wait until the audio thread has let go of the buffers
+    void cancel();
+    
+    // Mix the chirps due in this block into interleaved output (audio thread)
+    void renderOutput(float* output, int numFrames, int channelCount, int64_t firstFrame);
+    
+    // Copy newly available input into the capture buffer (audio thread)
+    void captureInput(const InputRing& ring);
+    
+    // Locate the chirps once the capture is complete. Moves the state to
+    // STATE_DONE or STATE_FAILED. Returns true on success (caller thread).
+    bool analyze(LatencyResult& result);
+    
+    State getState() const { return (State)m_state.load(std::memory_order_acquire); }
+    
+private:
+    // Normalized cross-correlation peak of the chirp within one capture segment
+    bool findChirp(const float* segment, int segmentLength, int& lag, float& quality) const;
+    
+    std::atomic<int> m_state{STATE_IDLE};
+    std::atomic<bool> m_inUse{false};
+    
+    std::vector<float> m_chirp;
+    std::vector<float> m_capture;
+    int m_sampleRate = 48000;
+    int m_spacingFrames = 0;
+    int m_maxLagFrames = 0;
+    int64_t m_firstChirpFrame = 0;
+    int32_t m_inputOffsetFrames = 0;
+    int64_t m_captureCursor = -1;  // Ring index of the next sample to capture
+    LatencyResult m_result = {};
+};
+
+#endif // MUSIMIND_LATENCY_CALIBRATOR_H
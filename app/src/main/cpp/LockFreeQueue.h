@@ -0,0 +1,88 @@
+/**
+ * LockFreeQueue.h
+ *
+ * Bounded multi-producer / single-consumer queue used to hand fixed-size
+ * commands from JNI threads to the real-time audio callback.
+ *
+ * Producers (any thread) never block: push() fails when the queue is full.
+ * The consumer (the audio callback) never blocks and never allocates.
+ * Based on Dmitry Vyukov's bounded queue: every slot carries a sequence
+ * number, so a slot is only read once its producer has finished writing it.
+ */
+
+#ifndef MUSIMIND_LOCK_FREE_QUEUE_H
+#define MUSIMIND_LOCK_FREE_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+template <typename T, size_t Capacity>
+class LockFreeQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+public:
+    LockFreeQueue() {
+        for (size_t i = 0; i < Capacity; i++) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    // Enqueue an item (any thread). Returns false if the queue is full.
+    bool push(const T& item) {
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &m_slots[pos & kMask];
+            size_t seq = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // Full
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = item;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Dequeue an item (consumer thread only). Returns false if the queue is empty.
+    bool pop(T& item) {
+        Slot* slot = &m_slots[m_dequeuePos & kMask];
+        size_t seq = slot->sequence.load(std::memory_order_acquire);
+        if ((intptr_t)seq - (intptr_t)(m_dequeuePos + 1) < 0) {
+            return false;  // Empty, or producer still writing this slot
+        }
+        item = slot->value;
+        slot->sequence.store(m_dequeuePos + Capacity, std::memory_order_release);
+        m_dequeuePos++;
+        return true;
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    static constexpr size_t kMask = Capacity - 1;
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    // Producers and consumer live on separate cache lines to avoid false sharing
+    alignas(64) Slot m_slots[Capacity];
+    alignas(64) std::atomic<size_t> m_enqueuePos{0};
+    alignas(64) size_t m_dequeuePos = 0;
+};
+
+#endif // MUSIMIND_LOCK_FREE_QUEUE_H
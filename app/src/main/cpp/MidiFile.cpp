@@ -0,0 +1,258 @@
+/**
+ * MidiFile.cpp
+ *
+ * Implementation of the Standard MIDI File reader.
+ */
+
+#include "MidiFile.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr uint32_t DEFAULT_MICROS_PER_QUARTER = 500000;  // 120 BPM
+
+uint32_t read32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+uint16_t read16(const uint8_t* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+// Variable-length quantity; false if it runs past the end or over 4 bytes
+bool readVarLen(const uint8_t*& p, const uint8_t* end, uint32_t& value) {
+    value = 0;
+    for (int i = 0; i < 4; i++) {
+        if (p >= end) {
+            return false;
+        }
+        uint8_t byte = *p++;
+        value = (value << 7) | (byte & 0x7F);
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Order of simultaneous events: note offs first, then controllers and
+// programs, then note ons, so a repeated note is not cut by its own release
+int eventPriority(const MidiEvent& event) {
+    switch (event.status & 0xF0) {
+        case 0x80: return 0;
+        case 0x90: return 2;
+        default:   return 1;
+    }
+}
+
+} // namespace
+
+bool MidiFile::parse(const uint8_t* data, size_t size) {
+    m_events.clear();
+    m_tempo.clear();
+    m_lengthTicks = 0;
+    m_smpteSecondsPerTick = 0.0;
+    
+    if (size < 14 || memcmp(data, "MThd", 4) != 0) {
+        return false;
+    }
+    uint32_t headerSize = read32(data + 4);
+    if (headerSize < 6 || 8 + (size_t)headerSize > size) {
+        return false;
+    }
+    m_format = read16(data + 8);
+    m_trackCount = read16(data + 10);
+    uint16_t division = read16(data + 12);
+    if (m_format > 1 || m_trackCount == 0) {
+        return false;
+    }
+    
+    if (division & 0x8000) {
+        // SMPTE: frames per second (negative, two's complement) x ticks per frame
+        int framesPerSecond = -(int8_t)(division >> 8);
+        int ticksPerFrame = division & 0xFF;
+        if (framesPerSecond <= 0 || ticksPerFrame == 0) {
+            return false;
+        }
+        double fps = framesPerSecond == 29 ? 29.97 : (double)framesPerSecond;
+        m_smpteSecondsPerTick = 1.0 / (fps * ticksPerFrame);
+        m_ticksPerQuarter = 0;
+    } else {
+        if (division == 0) {
+            return false;
+        }
+        m_ticksPerQuarter = division;
+    }
+    
+    std::vector<uint32_t> tempoTicks;
+    std::vector<uint32_t> tempoValues;
+    size_t offset = 8 + headerSize;
+    int tracksRead = 0;
+    while (offset + 8 <= size && tracksRead < m_trackCount) {
+        uint32_t chunkSize = read32(data + offset + 4);
+        const uint8_t* body = data + offset + 8;
+        if ((size_t)chunkSize > size - offset - 8) {
+            return false;
+        }
+        // Unknown chunks are skipped, as the specification requires
+        if (memcmp(data + offset, "MTrk", 4) == 0) {
+            if (!parseTrack(body, chunkSize, tempoTicks, tempoValues)) {
+                return false;
+            }
+            tracksRead++;
+        }
+        offset += 8 + (size_t)chunkSize;
+    }
+    if (tracksRead == 0) {
+        return false;
+    }
+    
+    std::stable_sort(m_events.begin(), m_events.end(), [](const MidiEvent& a, const MidiEvent& b) {
+        if (a.tick != b.tick) {
+            return a.tick < b.tick;
+        }
+        return eventPriority(a) < eventPriority(b);
+    });
+    
+    // Tempo map: one segment per tempo change, later changes on the same tick win
+    std::vector<size_t> order(tempoTicks.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return tempoTicks[a] < tempoTicks[b];
+    });
+    
+    auto secondsPerTick = [this](uint32_t microsPerQuarter) {
+        return m_smpteSecondsPerTick > 0.0 ? m_smpteSecondsPerTick
+                                           : microsPerQuarter * 1e-6 / m_ticksPerQuarter;
+    };
+    m_tempo.push_back({0, 0.0, secondsPerTick(DEFAULT_MICROS_PER_QUARTER)});
+    for (size_t index : order) {
+        TempoSegment& last = m_tempo.back();
+        uint32_t tick = tempoTicks[index];
+        double spt = secondsPerTick(tempoValues[index]);
+        if (tick == last.tick) {
+            last.secondsPerTick = spt;
+        } else {
+            double seconds = last.seconds + (tick - last.tick) * last.secondsPerTick;
+            m_tempo.push_back({tick, seconds, spt});
+        }
+    }
+    
+    for (MidiEvent& event : m_events) {
+        event.seconds = tickToSeconds(event.tick);
+    }
+    return true;
+}
+
+bool MidiFile::parseTrack(const uint8_t* data, size_t size, std::vector<uint32_t>& tempoTicks,
+                          std::vector<uint32_t>& tempoValues) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    uint32_t tick = 0;
+    uint8_t runningStatus = 0;
+    
+    while (p < end) {
+        uint32_t delta;
+        if (!readVarLen(p, end, delta) || p >= end) {
+            return false;
+        }
+        tick += delta;
+        
+        uint8_t status = *p;
+        if (status & 0x80) {
+            p++;
+        } else if (runningStatus) {
+            status = runningStatus;      // Running status: data byte follows directly
+        } else {
+            return false;
+        }
+        
+        if (status == 0xFF) {
+            // Meta event
+            if (p >= end) {
+                return false;
+            }
+            uint8_t type = *p++;
+            uint32_t length;
+            if (!readVarLen(p, end, length) || length > (size_t)(end - p)) {
+                return false;
+            }
+            if (type == 0x51 && length == 3) {
+                uint32_t microsPerQuarter = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+                if (microsPerQuarter > 0) {
+                    tempoTicks.push_back(tick);
+                    tempoValues.push_back(microsPerQuarter);
+                }
+            }
+            p += length;
+            m_lengthTicks = std::max(m_lengthTicks, tick);
+            if (type == 0x2F) {
+                break;  // End of track
+            }
+            continue;
+        }
+        if (status == 0xF0 || status == 0xF7) {
+            // SysEx: skipped; cancels running status
+            uint32_t length;
+            if (!readVarLen(p, end, length) || length > (size_t)(end - p)) {
+                return false;
+            }
+            p += length;
+            runningStatus = 0;
+            continue;
+        }
+        if (status >= 0xF0) {
+            return false;  // System common/real-time messages are not valid in a file
+        }
+        
+        runningStatus = status;
+        uint8_t type = status & 0xF0;
+        int dataBytes = (type == 0xC0 || type == 0xD0) ? 1 : 2;
+        if ((size_t)(end - p) < (size_t)dataBytes) {
+            return false;
+        }
+        uint8_t data1 = p[0] & 0x7F;
+        uint8_t data2 = dataBytes == 2 ? (p[1] & 0x7F) : 0;
+        p += dataBytes;
+        m_lengthTicks = std::max(m_lengthTicks, tick);
+        
+        if (type == 0x90 && data2 == 0) {
+            status = 0x80 | (status & 0x0F);
+            type = 0x80;
+        }
+        if (type == 0x80 || type == 0x90 || type == 0xB0 || type == 0xC0) {
+            m_events.push_back({tick, status, data1, data2, 0.0});
+        }
+    }
+    return true;
+}
+
+double MidiFile::tickToSeconds(double tick) const {
+    if (m_tempo.empty()) {
+        return 0.0;
+    }
+    // Last segment starting at or before tick
+    auto it = std::upper_bound(m_tempo.begin(), m_tempo.end(), tick,
+                               [](double t, const TempoSegment& segment) { return t < segment.tick; });
+    const TempoSegment& segment = it == m_tempo.begin() ? m_tempo.front() : *(it - 1);
+    return segment.seconds + (tick - segment.tick) * segment.secondsPerTick;
+}
+
+double MidiFile::secondsToTick(double seconds) const {
+    if (m_tempo.empty()) {
+        return 0.0;
+    }
+    auto it = std::upper_bound(m_tempo.begin(), m_tempo.end(), seconds,
+                               [](double s, const TempoSegment& segment) { return s < segment.seconds; });
+    const TempoSegment& segment = it == m_tempo.begin() ? m_tempo.front() : *(it - 1);
+    return segment.tick + (seconds - segment.seconds) / segment.secondsPerTick;
+}
+
+size_t MidiFile::findEvent(double seconds) const {
+    auto it = std::lower_bound(m_events.begin(), m_events.end(), seconds,
+                               [](const MidiEvent& event, double s) { return event.seconds < s; });
+    return (size_t)(it - m_events.begin());
+}
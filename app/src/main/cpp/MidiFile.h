@@ -0,0 +1,72 @@
+/**
+ * MidiFile.h
+ *
+ * Standard MIDI File (format 0 and 1) reader.
+ * All tracks are merged into one list of channel events sorted by tick, and
+ * the tempo map is folded into a precomputed time in seconds for every event,
+ * so the sequencer can place events on the frame clock without walking the
+ * tempo map on the audio thread. Only the messages the synthesizer plays are
+ * kept: note on/off, program change and control change.
+ *
+ * Reference: Standard MIDI Files 1.0 (MIDI Manufacturers Association)
+ */
+
+#ifndef MUSIMIND_MIDI_FILE_H
+#define MUSIMIND_MIDI_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct MidiEvent {
+    uint32_t tick;
+    uint8_t status;  // Message type | channel; note on with velocity 0 is stored as note off
+    uint8_t data1;
+    uint8_t data2;
+    double seconds;  // Song time from the tempo map
+};
+
+class MidiFile {
+public:
+    // Parse an SMF image. Returns false for malformed files and format 2.
+    bool parse(const uint8_t* data, size_t size);
+    
+    int getFormat() const { return m_format; }
+    int getTrackCount() const { return m_trackCount; }
+    int getTicksPerQuarter() const { return m_ticksPerQuarter; }
+    
+    // Channel events of every track, sorted by tick
+    const std::vector<MidiEvent>& getEvents() const { return m_events; }
+    
+    // Tick of the last event of any track (end of track included)
+    uint32_t getLengthTicks() const { return m_lengthTicks; }
+    double getLengthSeconds() const { return tickToSeconds(m_lengthTicks); }
+    
+    // Conversion through the tempo map
+    double tickToSeconds(double tick) const;
+    double secondsToTick(double seconds) const;
+    
+    // Index of the first event at or after a song time
+    size_t findEvent(double seconds) const;
+    
+private:
+    struct TempoSegment {
+        uint32_t tick;
+        double seconds;        // Song time at tick
+        double secondsPerTick;
+    };
+    
+    bool parseTrack(const uint8_t* data, size_t size, std::vector<uint32_t>& tempoTicks,
+                    std::vector<uint32_t>& tempoValues);
+    
+    int m_format = 0;
+    int m_trackCount = 0;
+    int m_ticksPerQuarter = 480;
+    double m_smpteSecondsPerTick = 0.0;  // Non-zero for SMPTE time division
+    uint32_t m_lengthTicks = 0;
+    
+    std::vector<MidiEvent> m_events;
+    std::vector<TempoSegment> m_tempo;
+};
+
+#endif // MUSIMIND_MIDI_FILE_H
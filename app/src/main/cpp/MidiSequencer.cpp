@@ -0,0 +1,311 @@
+/**
+ * MidiSequencer.cpp
+ *
+ * Implementation of the frame-clock MIDI file sequencer.
+ */
+
+#include "MidiSequencer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double MIN_TEMPO_SCALE = 0.1;
+constexpr double MAX_TEMPO_SCALE = 4.0;
+constexpr double MIN_LOOP_SECONDS = 0.05;  // Shorter loops would spin inside one callback
+
+constexpr uint8_t CC_VOLUME = 7;
+constexpr uint8_t CC_PAN = 10;
+constexpr uint8_t CC_SUSTAIN = 64;
+
+// MIDI volume follows a 40 log10 curve, i.e. amplitude (v / 127)^2
+float volumeFromController(uint8_t value) {
+    float v = value / 127.0f;
+    return v * v;
+}
+
+} // namespace
+
+MidiSequencer::~MidiSequencer() {
+    delete m_file;
+    delete m_pending.exchange(nullptr);
+    reclaim();
+}
+
+void MidiSequencer::setFile(MidiFile* file) {
+    // A file still pending was never seen by the audio thread
+    delete m_pending.exchange(file, std::memory_order_acq_rel);
+    reclaim();
+}
+
+void MidiSequencer::reclaim() {
+    MidiFile* retired;
+    while (m_retired.pop(retired)) {
+        delete retired;
+    }
+}
+
+void MidiSequencer::setSampleRate(int sampleRate) {
+    m_sampleRate = sampleRate > 0 ? sampleRate : 48000;
+}
+
+double MidiSequencer::songSecondsAt(double frame) const {
+    return m_anchorSeconds + (frame - m_anchorFrame) * m_tempoScale / m_sampleRate;
+}
+
+double MidiSequencer::frameOfSeconds(double seconds) const {
+    return m_anchorFrame + (seconds - m_anchorSeconds) * m_sampleRate / m_tempoScale;
+}
+
+void MidiSequencer::anchor(double frame, double seconds) {
+    m_anchorFrame = frame;
+    m_anchorSeconds = seconds;
+}
+
+void MidiSequencer::updateLoop() {
+    if (m_file && m_loopEndTick > m_loopStartTick) {
+        m_loopStart = m_file->tickToSeconds(m_loopStartTick);
+        m_loopEnd = std::max(m_file->tickToSeconds(m_loopEndTick), m_loopStart + MIN_LOOP_SECONDS);
+    } else {
+        m_loopStart = m_loopEnd = 0.0;
+    }
+}
+
+void MidiSequencer::adoptPending(EventScheduler& out, int64_t frame) {
+    if (!m_pending.load(std::memory_order_relaxed)) {
+        return;
+    }
+    if (m_file) {
+        // Retry on the next callback if the control thread is behind on reclaiming
+        if (!m_retired.push(m_file)) {
+            return;
+        }
+        releaseNotes(frame, out);
+        m_file = nullptr;
+    }
+    
+    m_file = m_pending.exchange(nullptr, std::memory_order_acq_rel);
+    m_playing = false;
+    m_playingFlag.store(false, std::memory_order_relaxed);
+    anchor((double)frame, 0.0);
+    m_nextEvent = 0;
+    m_positionTick.store(0.0, std::memory_order_relaxed);
+    updateLoop();
+}
+
+void MidiSequencer::play(int64_t frame, EventScheduler& out) {
+    adoptPending(out, frame);
+    if (!m_file || m_playing) {
+        return;
+    }
+    // Resume from the stopped position (the start after a load or the end of the song)
+    double seconds = m_anchorSeconds >= m_file->getLengthSeconds() ? 0.0 : m_anchorSeconds;
+    anchor((double)frame, seconds);
+    m_nextEvent = m_file->findEvent(seconds);
+    chaseControllers(m_nextEvent, frame, out);
+    m_playing = true;
+    m_playingFlag.store(true, std::memory_order_relaxed);
+}
+
+void MidiSequencer::stop(int64_t frame, EventScheduler& out) {
+    if (!m_playing) {
+        return;
+    }
+    anchor((double)frame, songSecondsAt((double)frame));
+    m_playing = false;
+    m_playingFlag.store(false, std::memory_order_relaxed);
+    releaseNotes(frame, out);
+}
+
+void MidiSequencer::seekTick(double tick, int64_t frame, EventScheduler& out) {
+    if (m_file) {
+        seekSeconds(m_file->tickToSeconds(std::max(0.0, tick)), frame, out);
+    }
+}
+
+void MidiSequencer::seekSeconds(double seconds, int64_t frame, EventScheduler& out) {
+    if (!m_file) {
+        return;
+    }
+    seconds = std::min(std::max(0.0, seconds), m_file->getLengthSeconds());
+    anchor((double)frame, seconds);
+    m_nextEvent = m_file->findEvent(seconds);
+    m_positionTick.store(m_file->secondsToTick(seconds), std::memory_order_relaxed);
+    if (m_playing) {
+        releaseNotes(frame, out);
+        chaseControllers(m_nextEvent, frame, out);
+    }
+}
+
+void MidiSequencer::setTempoScale(float scale, int64_t frame) {
+    // Re-anchor first so the position so far is kept at the old rate
+    if (m_playing) {
+        anchor((double)frame, songSecondsAt((double)frame));
+    }
+    m_tempoScale = std::min(std::max((double)scale, MIN_TEMPO_SCALE), MAX_TEMPO_SCALE);
+}
+
+void MidiSequencer::setLoop(uint32_t startTick, uint32_t endTick) {
+    m_loopStartTick = startTick;
+    m_loopEndTick = endTick;
+    updateLoop();
+}
+
+int MidiSequencer::generate(int64_t now, int64_t end, EventScheduler& out) {
+    adoptPending(out, now);
+    if (!m_file || !m_playing) {
+        return 0;
+    }
+    
+    const std::vector<MidiEvent>& events = m_file->getEvents();
+    int dropped = 0;
+    for (;;) {
+        double endSeconds = songSecondsAt((double)end);
+        bool looping = m_loopEnd > m_loopStart && songSecondsAt((double)now) < m_loopEnd;
+        bool wraps = looping && m_loopEnd <= endSeconds;
+        double limit = wraps ? m_loopEnd : endSeconds;
+        
+        while (m_nextEvent < events.size() && events[m_nextEvent].seconds < limit) {
+            const MidiEvent& event = events[m_nextEvent++];
+            int64_t frame = std::max(now, (int64_t)std::llround(frameOfSeconds(event.seconds)));
+            if (!emit(event, frame, out)) {
+                dropped++;
+            }
+        }
+        
+        if (wraps) {
+            // Jump back on the loop end's exact frame
+            double jumpFrame = frameOfSeconds(m_loopEnd);
+            int64_t frame = std::max(now, (int64_t)std::llround(jumpFrame));
+            dropped += releaseNotes(frame, out);
+            anchor(jumpFrame, m_loopStart);
+            m_nextEvent = m_file->findEvent(m_loopStart);
+            dropped += chaseControllers(m_nextEvent, frame, out);
+            continue;
+        }
+        
+        if (m_nextEvent >= events.size() && endSeconds >= m_file->getLengthSeconds()) {
+            // End of song: park at the end so play() rewinds
+            anchor((double)end, m_file->getLengthSeconds());
+            m_playing = false;
+            m_playingFlag.store(false, std::memory_order_relaxed);
+            dropped += releaseNotes(end, out);
+        }
+        break;
+    }
+    
+    m_positionTick.store(m_file->secondsToTick(m_playing ? songSecondsAt((double)end) : m_anchorSeconds),
+                         std::memory_order_relaxed);
+    return dropped;
+}
+
+bool MidiSequencer::emit(const MidiEvent& event, int64_t frame, EventScheduler& out) {
+    int channel = event.status & 0x0F;
+    AudioCommand command;
+    switch (event.status & 0xF0) {
+        case 0x80: {
+            // Note-offs for notes started before a seek or loop point were already sent
+            uint64_t bit = 1ull << (event.data1 & 63);
+            if (!(m_heldNotes[channel][event.data1 >> 6] & bit)) {
+                return true;
+            }
+            m_heldNotes[channel][event.data1 >> 6] &= ~bit;
+            command = AudioCommand::noteOff(channel, event.data1, frame);
+            break;
+        }
+        case 0x90:
+            m_heldNotes[channel][event.data1 >> 6] |= 1ull << (event.data1 & 63);
+            command = AudioCommand::noteOn(channel, event.data1, event.data2 / 127.0f, frame);
+            break;
+        case 0xC0:
+            command = AudioCommand::setPreset(channel, event.data1, frame);
+            break;
+        case 0xB0:
+            if (event.data1 == CC_VOLUME) {
+                command = AudioCommand::setChannelVolume(channel, volumeFromController(event.data2), frame);
+            } else if (event.data1 == CC_PAN) {
+                command = AudioCommand::setChannelPan(channel, event.data2 / 127.0f, frame);
+            } else if (event.data1 == CC_SUSTAIN) {
+                bool down = event.data2 >= 64;
+                if (down) {
+                    m_sustainedChannels |= 1u << channel;
+                } else {
+                    m_sustainedChannels &= ~(1u << channel);
+                }
+                command = AudioCommand::setChannelSustain(channel, down, frame);
+            } else {
+                return true;  // Other controllers are not rendered
+            }
+            break;
+        default:
+            return true;
+    }
+    return out.schedule(command);
+}
+
+int MidiSequencer::releaseNotes(int64_t frame, EventScheduler& out) {
+    int dropped = 0;
+    for (int channel = 0; channel < kChannelCount; channel++) {
+        if (m_sustainedChannels & (1u << channel)) {
+            if (!out.schedule(AudioCommand::setChannelSustain(channel, false, frame))) {
+                dropped++;
+            }
+        }
+        for (int word = 0; word < 2; word++) {
+            uint64_t held = m_heldNotes[channel][word];
+            while (held) {
+                int bit = __builtin_ctzll(held);
+                held &= held - 1;
+                if (!out.schedule(AudioCommand::noteOff(channel, word * 64 + bit, frame))) {
+                    dropped++;
+                }
+            }
+            m_heldNotes[channel][word] = 0;
+        }
+    }
+    m_sustainedChannels = 0;
+    return dropped;
+}
+
+int MidiSequencer::chaseControllers(size_t index, int64_t frame, EventScheduler& out) {
+    int program[kChannelCount], volume[kChannelCount], pan[kChannelCount], sustain[kChannelCount];
+    std::fill(program, program + kChannelCount, -1);
+    std::fill(volume, volume + kChannelCount, -1);
+    std::fill(pan, pan + kChannelCount, -1);
+    std::fill(sustain, sustain + kChannelCount, -1);
+    
+    const std::vector<MidiEvent>& events = m_file->getEvents();
+    for (size_t i = 0; i < index && i < events.size(); i++) {
+        const MidiEvent& event = events[i];
+        int channel = event.status & 0x0F;
+        if ((event.status & 0xF0) == 0xC0) {
+            program[channel] = event.data1;
+        } else if ((event.status & 0xF0) == 0xB0) {
+            if (event.data1 == CC_VOLUME) volume[channel] = event.data2;
+            else if (event.data1 == CC_PAN) pan[channel] = event.data2;
+            else if (event.data1 == CC_SUSTAIN) sustain[channel] = event.data2;
+        }
+    }
+    
+    int dropped = 0;
+    for (int channel = 0; channel < kChannelCount; channel++) {
+        MidiEvent event{0, 0, 0, 0, 0.0};
+        if (program[channel] >= 0) {
+            event = {0, (uint8_t)(0xC0 | channel), (uint8_t)program[channel], 0, 0.0};
+            dropped += emit(event, frame, out) ? 0 : 1;
+        }
+        if (volume[channel] >= 0) {
+            event = {0, (uint8_t)(0xB0 | channel), CC_VOLUME, (uint8_t)volume[channel], 0.0};
+            dropped += emit(event, frame, out) ? 0 : 1;
+        }
+        if (pan[channel] >= 0) {
+            event = {0, (uint8_t)(0xB0 | channel), CC_PAN, (uint8_t)pan[channel], 0.0};
+            dropped += emit(event, frame, out) ? 0 : 1;
+        }
+        if (sustain[channel] >= 64) {
+            event = {0, (uint8_t)(0xB0 | channel), CC_SUSTAIN, (uint8_t)sustain[channel], 0.0};
+            dropped += emit(event, frame, out) ? 0 : 1;
+        }
+    }
+    return dropped;
+}
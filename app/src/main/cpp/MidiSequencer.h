@@ -0,0 +1,100 @@
+/**
+ * MidiSequencer.h
+ *
+ * Sample-accurate Standard MIDI File playback on the stream frame clock.
+ * Runs inside SoundFontEngine::render(): once per block the sequencer turns
+ * the file events that fall inside the current callback into AudioCommands
+ * and hands them to the EventScheduler, which applies them on their exact
+ * frames next to notes and metronome clicks. Nothing is timed on the JVM.
+ *
+ * Song time advances at tempoScale x the file's tempo map, so slowing down
+ * for practice only stretches event times; notes keep their pitch. A loop
+ * region jumps back on its exact frame, releasing held notes first.
+ *
+ * A parsed MidiFile is handed over through an atomic pointer; files the
+ * audio thread lets go of are deleted on the control thread.
+ */
+
+#ifndef MUSIMIND_MIDI_SEQUENCER_H
+#define MUSIMIND_MIDI_SEQUENCER_H
+
+#include "EventScheduler.h"
+#include "LockFreeQueue.h"
+#include "MidiFile.h"
+#include <atomic>
+#include <cstdint>
+
+class MidiSequencer {
+public:
+    static constexpr int kChannelCount = 16;
+    
+    ~MidiSequencer();
+    
+    // Control thread: publish a parsed file (takes ownership). Playback
+    // stops and rewinds when the audio thread picks it up.
+    void setFile(MidiFile* file);
+    
+    // Control thread: delete files the audio thread has let go of
+    void reclaim();
+    
+    // Audio thread only
+    void setSampleRate(int sampleRate);
+    void play(int64_t frame, EventScheduler& out);
+    void stop(int64_t frame, EventScheduler& out);
+    void seekTick(double tick, int64_t frame, EventScheduler& out);
+    void seekSeconds(double seconds, int64_t frame, EventScheduler& out);  // Song seconds at tempo scale 1
+    void setTempoScale(float scale, int64_t frame);
+    void setLoop(uint32_t startTick, uint32_t endTick);  // endTick <= startTick clears it
+    
+    // Queue every event due before frame `end` into the scheduler (audio thread only).
+    // Returns the number of events the scheduler could not take.
+    int generate(int64_t now, int64_t end, EventScheduler& out);
+    
+    // Any thread
+    bool isPlaying() const { return m_playingFlag.load(std::memory_order_relaxed); }
+    double getPositionTick() const { return m_positionTick.load(std::memory_order_relaxed); }
+    
+private:
+    // Adopt a newly published file (audio thread only)
+    void adoptPending(EventScheduler& out, int64_t frame);
+    
+    // Convert the loop ticks with the current file's tempo map
+    void updateLoop();
+    
+    double songSecondsAt(double frame) const;
+    double frameOfSeconds(double seconds) const;
+    void anchor(double frame, double seconds);
+    
+    // Emit one file event on a frame; keeps the held-note bitmap current
+    bool emit(const MidiEvent& event, int64_t frame, EventScheduler& out);
+    
+    // Release every note this sequencer holds
+    int releaseNotes(int64_t frame, EventScheduler& out);
+    
+    // Re-send the latest program and controllers before an event index, so a
+    // seek or loop jump lands with the right instruments and mix
+    int chaseControllers(size_t index, int64_t frame, EventScheduler& out);
+    
+    std::atomic<MidiFile*> m_pending{nullptr};
+    LockFreeQueue<MidiFile*, 8> m_retired;
+    
+    // Playback state (audio thread only)
+    MidiFile* m_file = nullptr;
+    bool m_playing = false;
+    int m_sampleRate = 48000;
+    double m_tempoScale = 1.0;
+    double m_anchorFrame = 0.0;    // Frame at which song time was m_anchorSeconds
+    double m_anchorSeconds = 0.0;
+    size_t m_nextEvent = 0;
+    uint32_t m_loopStartTick = 0;
+    uint32_t m_loopEndTick = 0;
+    double m_loopStart = 0.0;      // Song seconds; loop active when m_loopEnd > m_loopStart
+    double m_loopEnd = 0.0;
+    uint64_t m_heldNotes[kChannelCount][2] = {};  // Bitmap of sounding keys per channel
+    uint32_t m_sustainedChannels = 0;             // Bit n = sustain pedal down on channel n
+    
+    std::atomic<bool> m_playingFlag{false};
+    std::atomic<double> m_positionTick{0.0};
+};
+
+#endif // MUSIMIND_MIDI_SEQUENCER_H
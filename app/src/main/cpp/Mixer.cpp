@@ -0,0 +1,183 @@
+/**
+ * Mixer.cpp
+ *
+ * Implementation of the output mixer, ducking and look-ahead limiter.
+ */
+
+#include "Mixer.h"
+#include "DspKernels.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr float LOOKAHEAD_SECONDS = 0.001f;     // Limiter delay
+constexpr float LIMITER_RELEASE_SECONDS = 0.08f;
+constexpr float GAIN_SMOOTHING_SECONDS = 0.02f;  // Bus gain changes
+constexpr float DUCK_ATTACK_SECONDS = 0.005f;
+constexpr float DUCK_RELEASE_SECONDS = 0.12f;
+constexpr float DUCK_THRESHOLD = 0.03f;         // Metronome level that triggers full ducking (~-30 dBFS)
+
+// One-pole coefficient reaching 63% in `seconds`
+float onePole(float seconds, float samples) {
+    return 1.0f - std::exp(-samples / seconds);
+}
+
+} // namespace
+
+Mixer::Mixer() {
+    for (int i = 0; i < kBusCount; i++) {
+        m_targetGain[i].store(1.0f, std::memory_order_relaxed);
+        m_gain[i] = 1.0f;
+    }
+    setSampleRate(m_sampleRate);
+}
+
+void Mixer::setBusGain(RenderArena::Bus bus, float gain) {
+    m_targetGain[bus].store(std::max(0.0f, std::min(4.0f, gain)), std::memory_order_relaxed);
+}
+
+float Mixer::getBusGain(RenderArena::Bus bus) const {
+    return m_targetGain[bus].load(std::memory_order_relaxed);
+}
+
+void Mixer::setDuckingDepth(float depth) {
+    m_duckingDepth.store(std::max(0.0f, std::min(1.0f, depth)), std::memory_order_relaxed);
+}
+
+void Mixer::setLimiter(bool enabled, float ceilingDb) {
+    m_ceiling.store(std::pow(10.0f, std::min(0.0f, ceilingDb) / 20.0f), std::memory_order_relaxed);
+    m_limiterEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Mixer::setSampleRate(int sampleRate) {
+    m_sampleRate = sampleRate > 0 ? sampleRate : 48000;
+    m_lookahead = std::max(1, std::min(kMaxLookaheadFrames, (int)(LOOKAHEAD_SECONDS * m_sampleRate)));
+    // The limiter gain must settle within the look-ahead; a quarter of it leaves margin
+    m_limiterAttack = 1.0f - std::exp(-4.0f / m_lookahead);
+    m_limiterRelease = onePole(LIMITER_RELEASE_SECONDS, 1.0f / m_sampleRate);
+    
+    std::fill(m_delay, m_delay + kMaxLookaheadFrames * 2, 0.0f);
+    m_write = 0;
+    m_minHead = 0;
+    m_minSize = 0;
+    m_frameIndex = 0;
+    m_limiterGain = 1.0f;
+}
+
+float Mixer::takePeakReductionDb() {
+    float reduction = m_peakReduction.exchange(1.0f, std::memory_order_relaxed);
+    return 20.0f * std::log10(std::max(reduction, 1e-6f));
+}
+
+void Mixer::limitFrame(float& left, float& right) {
+    // Gain this frame needs on its own
+    float ceiling = m_ceiling.load(std::memory_order_relaxed);
+    float peak = std::max(std::fabs(left), std::fabs(right));
+    float needed = peak > ceiling ? ceiling / peak : 1.0f;
+    
+    // Sliding minimum over the look-ahead window (monotonic ring)
+    const int capacity = kMaxLookaheadFrames + 1;
+    while (m_minSize > 0) {
+        int last = (m_minHead + m_minSize - 1) % capacity;
+        if (m_minValue[last] < needed) {
+            break;
+        }
+        m_minSize--;
+    }
+    int tail = (m_minHead + m_minSize) % capacity;
+    m_minValue[tail] = needed;
+    m_minIndex[tail] = m_frameIndex;
+    m_minSize++;
+    // The window spans the frame leaving the delay line now through the newest one
+    if (m_minIndex[m_minHead] < m_frameIndex - m_lookahead) {
+        m_minHead = (m_minHead + 1) % capacity;
+        m_minSize--;
+    }
+    float target = m_minValue[m_minHead];
+    m_frameIndex++;
+    
+    // Fast attack toward the window minimum, slow release
+    m_limiterGain += (target - m_limiterGain) * (target < m_limiterGain ? m_limiterAttack : m_limiterRelease);
+    
+    // Delay the signal by the look-ahead
+    float* slot = m_delay + m_write * 2;
+    float delayedLeft = slot[0];
+    float delayedRight = slot[1];
+    slot[0] = left;
+    slot[1] = right;
+    m_write = m_write + 1 < m_lookahead ? m_write + 1 : 0;
+    
+    // The clamp only catches what the smoothed attack did not
+    left = std::max(-ceiling, std::min(ceiling, delayedLeft * m_limiterGain));
+    right = std::max(-ceiling, std::min(ceiling, delayedRight * m_limiterGain));
+    m_blockReduction = std::min(m_blockReduction, m_limiterGain);
+}
+
+void Mixer::process(float* const* buses, const bool* active, float* output, int numFrames) {
+    if (numFrames <= 0) {
+        return;
+    }
+    float blockSeconds = (float)numFrames / m_sampleRate;
+    float smoothing = onePole(GAIN_SMOOTHING_SECONDS, blockSeconds);
+    
+    // Bus gains ramp linearly across the block toward their smoothed target
+    float gainStart[kBusCount];
+    float gainStep[kBusCount];
+    for (int i = 0; i < kBusCount; i++) {
+        float end = m_gain[i] + (m_targetGain[i].load(std::memory_order_relaxed) - m_gain[i]) * smoothing;
+        gainStart[i] = m_gain[i];
+        gainStep[i] = (end - m_gain[i]) / numFrames;
+        m_gain[i] = end;
+    }
+    
+    // Sidechain: the metronome's block peak drives the ducking envelope
+    const float* metronome = active[RenderArena::BUS_METRONOME] ? buses[RenderArena::BUS_METRONOME] : nullptr;
+    float metronomePeak = metronome ? DspKernels::peak(metronome, numFrames * 2) : 0.0f;
+    float duckCoefficient = onePole(metronomePeak > m_duckEnvelope ? DUCK_ATTACK_SECONDS : DUCK_RELEASE_SECONDS,
+                                    blockSeconds);
+    m_duckEnvelope += (metronomePeak - m_duckEnvelope) * duckCoefficient;
+    float duckEnd = 1.0f - m_duckingDepth.load(std::memory_order_relaxed) *
+                           std::min(1.0f, m_duckEnvelope / DUCK_THRESHOLD);
+    float duckStart = m_duckGain;
+    m_duckGain = duckEnd;
+    
+    // Ducked buses ramp from start gain * start duck to end gain * end duck;
+    // the product of the two ramps is close enough to linear over one block
+    const bool ducked[kBusCount] = { true, false, true, false };
+    static_assert(RenderArena::BUS_INSTRUMENT == 0 && RenderArena::BUS_PROMPT == 2, "Ducked bus order");
+    
+    // Sum the buses into the output with the SIMD kernels
+    std::fill(output, output + numFrames * 2, 0.0f);
+    for (int i = 0; i < kBusCount; i++) {
+        if (!active[i]) {
+            continue;
+        }
+        float start = gainStart[i];
+        float step = gainStep[i];
+        if (ducked[i]) {
+            float end = (start + step * numFrames) * duckEnd;
+            start *= duckStart;
+            step = (end - start) / numFrames;
+        }
+        DspKernels::mixAddRampedStereo(output, buses[i], numFrames, start, step);
+    }
+    
+    if (!m_limiterDeferred.load(std::memory_order_relaxed)) {
+        limit(output, numFrames);
+    }
+}
+
+void Mixer::limit(float* output, int numFrames) {
+    // The limiter is serial (its delay line and window carry across frames)
+    m_blockReduction = 1.0f;
+    if (m_limiterEnabled.load(std::memory_order_relaxed)) {
+        for (int frame = 0; frame < numFrames; frame++) {
+            limitFrame(output[frame * 2], output[frame * 2 + 1]);
+        }
+    }
+    
+    if (m_blockReduction < m_peakReduction.load(std::memory_order_relaxed)) {
+        m_peakReduction.store(m_blockReduction, std::memory_order_relaxed);
+    }
+}
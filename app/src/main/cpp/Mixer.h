@@ -0,0 +1,91 @@
+/**
+ * Mixer.h
+ *
+ * Fixed-topology output mixer run at the end of every render block.
+ *
+ *   instrument ──┐
+ *   prompt ──────┼─ duck ─┐
+ *   sfx ─────────┘        ├─ sum ─ look-ahead limiter ─ output
+ *   metronome ─ sidechain ┘
+ *
+ * Each bus has a gain that is ramped across the block (no zipper noise).
+ * Metronome clicks duck the instrument and prompt buses a little so the
+ * beat stays audible under dense chords, and a peak limiter with a short
+ * look-ahead keeps loud chords plus accented clicks from clipping.
+ *
+ * Active buses are summed into the output with the vectorized ramped-gain
+ * kernel, then the limiter runs in place over the summed block. Settings
+ * are atomics written by JNI threads; the state lives in fixed arrays, so
+ * process() never allocates.
+ */
+
+#ifndef MUSIMIND_MIXER_H
+#define MUSIMIND_MIXER_H
+
+#include "RenderArena.h"
+#include <atomic>
+#include <cstdint>
+
+class Mixer {
+public:
+    static constexpr int kBusCount = RenderArena::BUS_COUNT;
+    static constexpr int kMaxLookaheadFrames = 256;  // ~1.3 ms at 192 kHz
+    
+    Mixer();
+    
+    // Any thread: settings picked up by the next process() call
+    void setBusGain(RenderArena::Bus bus, float gain);
+    float getBusGain(RenderArena::Bus bus) const;
+    void setDuckingDepth(float depth);       // 0 = off, 0.5 = music at half gain under clicks
+    void setLimiter(bool enabled, float ceilingDb);
+    
+    // Audio thread: derive time constants; clears the limiter's delay line
+    void setSampleRate(int sampleRate);
+    
+    // Mix the buses flagged in `active` (stereo interleaved, numFrames each)
+    // into output. Inactive buses are not read.
+    void process(float* const* buses, const bool* active, float* output, int numFrames);
+    
+    // Leave limiting to limit(), run over a final mix that other sources are
+    // added into first (OboePlayer's sessions). Any thread.
+    void setLimiterDeferred(bool deferred) { m_limiterDeferred.store(deferred, std::memory_order_relaxed); }
+    
+    // Audio thread: run the limiter in place over interleaved stereo
+    void limit(float* output, int numFrames);
+    
+    // Largest gain reduction applied by the limiter since the last call, in dB (<= 0)
+    float takePeakReductionDb();
+    
+private:
+    void limitFrame(float& left, float& right);
+    
+    std::atomic<float> m_targetGain[kBusCount];
+    std::atomic<float> m_duckingDepth{0.25f};
+    std::atomic<bool> m_limiterEnabled{true};
+    std::atomic<bool> m_limiterDeferred{false};
+    std::atomic<float> m_ceiling{0.944f};  // -0.5 dBFS
+    std::atomic<float> m_peakReduction{1.0f};
+    
+    // Audio thread state
+    int m_sampleRate = 48000;
+    float m_gain[kBusCount];
+    float m_duckEnvelope = 0.0f;
+    float m_duckGain = 1.0f;
+    
+    // Look-ahead limiter: delay line plus a sliding minimum of the gain each
+    // incoming frame needs, so the gain is down before a peak leaves the delay
+    int m_lookahead = 48;
+    int m_write = 0;
+    float m_delay[kMaxLookaheadFrames * 2] = {};
+    float m_minValue[kMaxLookaheadFrames + 1] = {};
+    int64_t m_minIndex[kMaxLookaheadFrames + 1] = {};
+    int m_minHead = 0;
+    int m_minSize = 0;
+    int64_t m_frameIndex = 0;
+    float m_limiterGain = 1.0f;
+    float m_limiterAttack = 0.0f;
+    float m_limiterRelease = 0.0f;
+    float m_blockReduction = 1.0f;
+};
+
+#endif // MUSIMIND_MIXER_H
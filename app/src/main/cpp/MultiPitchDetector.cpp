@@ -0,0 +1,223 @@
+/**
+ * MultiPitchDetector.cpp
+ *
+ * Implementation of the native polyphonic pitch detector.
+ */
+
+#include "MultiPitchDetector.h"
+#include "DspKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+constexpr int FRAME_SIZE = 4096;              // ~85ms @ 48kHz: 11.7 Hz bins
+constexpr int HOP_SIZE = 1024;                // ~21ms between note sets
+constexpr float SILENCE_RMS = 0.01f;
+constexpr float MIN_PARTIAL_HZ = 60.0f;
+constexpr float MAX_PARTIAL_HZ = 5000.0f;     // Partials above this add little but noise
+constexpr float HARMONIC_DECAY = 0.8f;        // Template weight of partial h: decay^(h-1)
+constexpr float PARTIAL_TOLERANCE = 0.015f;   // Quarter semitone either side, for inharmonicity
+constexpr float RELATIVE_SALIENCE = 0.3f;     // Later notes against the strongest one
+constexpr float FUNDAMENTAL_OVER_FLOOR = 3.0f; // Fundamental against the mean residual
+constexpr float FUNDAMENTAL_RATIO = 0.2f;     // Fundamental against the note's strongest partial
+
+void MultiPitchDetector::configure(int sampleRate) {
+    m_frameSize = FRAME_SIZE;
+    m_hopSize = HOP_SIZE;
+    m_bins = m_frameSize / 2 + 1;
+    
+    m_fft = std::make_unique<RealFft>(m_frameSize);
+    m_hannWindow.resize(m_frameSize);
+    for (int i = 0; i < m_frameSize; i++) {
+        m_hannWindow[i] = 0.5f * (1.0f - std::cos(2.0f * (float)M_PI * i / (m_frameSize - 1)));
+    }
+    m_frame.assign(m_frameSize, 0.0f);
+    m_spectrum.assign(m_fft->spectrumFloats(), 0.0f);
+    m_residual.assign(m_bins, 0.0f);
+    
+    const float binHz = (float)sampleRate / m_frameSize;
+    m_templates.resize(kNoteCount * kHarmonics);
+    for (int note = 0; note < kNoteCount; note++) {
+        float f0 = 440.0f * std::pow(2.0f, (float)(kMinNote + note - 69) / 12.0f);
+        m_templateNorm[note] = 0.0f;
+        for (int h = 0; h < kHarmonics; h++) {
+            Partial& partial = m_templates[note * kHarmonics + h];
+            float position = f0 * (h + 1) / binHz;
+            float halfWidth = std::max(0.5f, position * PARTIAL_TOLERANCE);
+            partial.firstBin = (int16_t)std::max(1, (int)std::ceil(position - halfWidth));
+            partial.lastBin = (int16_t)std::min(m_bins - 2, (int)std::floor(position + halfWidth));
+            partial.weight = std::pow(HARMONIC_DECAY, (float)h);
+            if (f0 * (h + 1) > MAX_PARTIAL_HZ) {
+                partial.lastBin = partial.firstBin - 1;
+            }
+            if (partial.lastBin >= partial.firstBin) {
+                m_templateNorm[note] += partial.weight * partial.weight;
+            }
+        }
+    }
+    
+    m_binPitchClass.assign(m_bins, -1);
+    for (int bin = 1; bin < m_bins; bin++) {
+        float frequency = bin * binHz;
+        if (frequency >= MIN_PARTIAL_HZ && frequency <= MAX_PARTIAL_HZ) {
+            int midi = (int)std::lround(69.0f + 12.0f * std::log2(frequency / 440.0f));
+            m_binPitchClass[bin] = (int8_t)(((midi % 12) + 12) % 12);
+        }
+    }
+    
+    m_nextFrameStart = 0;
+    m_skippedSamples.store(0, std::memory_order_relaxed);
+}
+
+void MultiPitchDetector::process(const InputRing& ring) {
+    if (!m_fft) {
+        return;
+    }
+    
+    skipOverwritten(ring);
+    
+    while (m_nextFrameStart + m_frameSize <= ring.writeCount()) {
+        ring.read(m_nextFrameStart, m_frame.data(), m_frameSize);
+        if (!ring.holds(m_nextFrameStart)) {
+            // The writer lapped the frame while it was copied
+            skipOverwritten(ring);
+            continue;
+        }
+        
+        PolyphonicFrame frame;
+        analyze(frame);
+        frame.framePosition = ring.frameOf(m_nextFrameStart);
+        if (!m_frames.push(frame)) {
+            m_droppedFrames.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_nextFrameStart += m_hopSize;
+    }
+}
+
+void MultiPitchDetector::analyze(PolyphonicFrame& frame) {
+    memset(&frame, 0, sizeof(frame));
+    frame.rms = std::sqrt(DspKernels::sumOfSquares(m_frame.data(), m_frameSize) / m_frameSize);
+    if (frame.rms < SILENCE_RMS) {
+        // No transform at all in silence: most of an exercise costs nothing here
+        return;
+    }
+    
+    DspKernels::multiply(m_frame.data(), m_hannWindow.data(), m_frame.data(), m_frameSize);
+    m_fft->forward(m_frame.data(), m_spectrum.data());
+    DspKernels::magnitude(m_spectrum.data(), m_residual.data(), m_bins);
+    
+    // A full-scale sine peaks near 1; the square root keeps quiet chord tones in range
+    const float scale = 4.0f / m_frameSize;
+    float floorSum = 0.0f;
+    int floorBins = 0;
+    float chromaMax = 0.0f;
+    for (int bin = 0; bin < m_bins; bin++) {
+        float magnitude = std::sqrt(scale * m_residual[bin]);
+        m_residual[bin] = magnitude;
+        int pitchClass = m_binPitchClass[bin];
+        if (pitchClass >= 0) {
+            floorSum += magnitude;
+            floorBins++;
+            frame.chroma[pitchClass] += magnitude;
+            chromaMax = std::max(chromaMax, frame.chroma[pitchClass]);
+        }
+    }
+    if (chromaMax > 0.0f) {
+        for (float& value : frame.chroma) {
+            value /= chromaMax;
+        }
+    }
+    const float noiseFloor = floorBins > 0 ? floorSum / floorBins : 0.0f;
+    
+    // Greedy picking with subtraction. A candidate without its fundamental is
+    // a subharmonic of real notes (their partials also fit its template), so
+    // it is ruled out for this frame instead of ending the search.
+    bool ruledOut[kNoteCount] = {};
+    float strongest = 0.0f;
+    while (frame.noteCount < kMaxPolyphony) {
+        int best = -1;
+        float bestSalience = 0.0f;
+        for (int note = 0; note < kNoteCount; note++) {
+            if (!ruledOut[note]) {
+                float value = salience(note);
+                if (value > bestSalience) {
+                    bestSalience = value;
+                    best = note;
+                }
+            }
+        }
+        if (best < 0 || bestSalience < RELATIVE_SALIENCE * strongest) {
+            break;
+        }
+        ruledOut[best] = true;
+        
+        const Partial* partials = &m_templates[best * kHarmonics];
+        float fundamental = partialMagnitude(partials[0]);
+        float loudest = 0.0f;
+        for (int h = 0; h < kHarmonics; h++) {
+            loudest = std::max(loudest, partialMagnitude(partials[h]));
+        }
+        if (fundamental < FUNDAMENTAL_OVER_FLOOR * noiseFloor || fundamental < FUNDAMENTAL_RATIO * loudest) {
+            continue;
+        }
+        
+        strongest = std::max(strongest, bestSalience);
+        int midiNote = kMinNote + best;
+        frame.notes[midiNote >> 6] |= 1ull << (midiNote & 63);
+        frame.noteCount++;
+        subtract(best);
+    }
+}
+
+float MultiPitchDetector::partialMagnitude(const Partial& partial) const {
+    float magnitude = 0.0f;
+    for (int bin = partial.firstBin; bin <= partial.lastBin; bin++) {
+        magnitude = std::max(magnitude, m_residual[bin]);
+    }
+    return magnitude;
+}
+
+float MultiPitchDetector::salience(int note) const {
+    const Partial* partials = &m_templates[note * kHarmonics];
+    float sum = 0.0f;
+    for (int h = 0; h < kHarmonics; h++) {
+        sum += partials[h].weight * partialMagnitude(partials[h]);
+    }
+    return sum;
+}
+
+void MultiPitchDetector::subtract(int note) {
+    const Partial* partials = &m_templates[note * kHarmonics];
+    if (m_templateNorm[note] <= 0.0f) {
+        return;
+    }
+    
+    // Least-squares gain of the template against the residual, then remove
+    // that much from each partial and the main lobe bins around it. Partials
+    // stronger than the fit (shared with another chord tone) keep the rest.
+    float projection = 0.0f;
+    for (int h = 0; h < kHarmonics; h++) {
+        projection += partials[h].weight * partialMagnitude(partials[h]);
+    }
+    float gain = projection / m_templateNorm[note];
+    for (int h = 0; h < kHarmonics; h++) {
+        const Partial& partial = partials[h];
+        if (partial.lastBin < partial.firstBin) {
+            continue;
+        }
+        float amount = gain * partial.weight;
+        int first = std::max(1, partial.firstBin - 1);
+        int last = std::min(m_bins - 1, partial.lastBin + 1);
+        for (int bin = first; bin <= last; bin++) {
+            m_residual[bin] = std::max(0.0f, m_residual[bin] - amount);
+        }
+    }
+}
+
+void MultiPitchDetector::skipOverwritten(const InputRing& ring) {
+    int64_t oldest = ring.oldestIndex();
+    if (m_nextFrameStart < oldest) {
+        m_skippedSamples.fetch_add(oldest - m_nextFrameStart, std::memory_order_relaxed);
+        m_nextFrameStart = oldest;
+    }
+}
@@ -0,0 +1,121 @@
+/**
+ * MultiPitchDetector.h
+ *
+ * Native polyphonic (multi-f0) analysis for chord exercises on piano or
+ * guitar. Reads Hann-windowed frames from the shared InputRing every hop,
+ * takes the magnitude spectrum with a reused RealFft, and scores every
+ * candidate MIDI note by a weighted harmonic sum against a precomputed
+ * template bank (partial positions and weights per note). Notes are then
+ * picked greedily: the most salient candidate is accepted, its template is
+ * fitted to the spectrum and subtracted (one NMF-style gain update), and the
+ * residual is searched again, so partials shared between chord tones are
+ * not counted twice.
+ *
+ * Each hop yields the set of active MIDI notes plus a 12-bin chroma vector,
+ * stamped on the same stream frame clock as the pitch and onset output.
+ * The onset detector's short frames cannot resolve semitones in the bass,
+ * so this runs its own longer transform, at a coarser hop and only while
+ * the input is above the silence floor.
+ *
+ * Reference: "Multiple fundamental frequency estimation by summing harmonic
+ * amplitudes", Klapuri, ISMIR 2006
+ */
+
+#ifndef MUSIMIND_MULTI_PITCH_DETECTOR_H
+#define MUSIMIND_MULTI_PITCH_DETECTOR_H
+
+#include "InputRing.h"
+#include "LockFreeQueue.h"
+#include "RealFft.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct PolyphonicFrame {
+    int64_t framePosition;  // Stream frame of the window start
+    uint64_t notes[2];      // Active MIDI notes: bit (n % 64) of notes[n / 64]
+    float chroma[12];       // Pitch-class salience (C = 0), max 1; all 0 in silence
+    float rms;
+    int32_t noteCount;
+    
+    bool hasNote(int midiNote) const {
+        return midiNote >= 0 && midiNote < 128 && ((notes[midiNote >> 6] >> (midiNote & 63)) & 1u);
+    }
+};
+
+class MultiPitchDetector {
+public:
+    // Lowest and highest candidate notes (C2 to C7)
+    static constexpr int kMinNote = 36;
+    static constexpr int kMaxNote = 96;
+    static constexpr int kMaxPolyphony = 6;
+    
+    // Allocate FFT, buffers and the template bank. Not real-time safe;
+    // only call while process() is not running.
+    void configure(int sampleRate);
+    
+    // Analyze every complete hop now available in the ring (analysis thread only)
+    void process(const InputRing& ring);
+    
+    // Consumer side (single JNI reader)
+    bool pollFrame(PolyphonicFrame& frame) { return m_frames.pop(frame); }
+    
+    bool isConfigured() const { return m_fft != nullptr; }
+    int getFrameSize() const { return m_frameSize; }
+    int getHopSize() const { return m_hopSize; }
+    uint32_t getDroppedFrameCount() const { return m_droppedFrames.load(std::memory_order_relaxed); }
+    
+    // Input samples the ring overwrote before they were analyzed
+    int64_t getSkippedSampleCount() const { return m_skippedSamples.load(std::memory_order_relaxed); }
+    
+private:
+    static constexpr int kNoteCount = kMaxNote - kMinNote + 1;
+    static constexpr int kHarmonics = 8;
+    
+    // One partial of a note's template: the bins it may land in and its weight
+    struct Partial {
+        int16_t firstBin;
+        int16_t lastBin;
+        float weight;
+    };
+    
+    // Fill frame's notes, chroma and level from m_frame
+    void analyze(PolyphonicFrame& frame);
+    
+    // Strongest residual magnitude in a partial's bins
+    float partialMagnitude(const Partial& partial) const;
+    
+    float salience(int note) const;
+    
+    // Fit the note's template to the residual and subtract it
+    void subtract(int note);
+    
+    // Move the cursor past samples the ring no longer holds
+    void skipOverwritten(const InputRing& ring);
+    
+    int m_frameSize = 0;
+    int m_hopSize = 0;
+    int m_bins = 0;
+    
+    std::unique_ptr<RealFft> m_fft;
+    std::vector<float> m_hannWindow;
+    std::vector<float> m_frame;
+    std::vector<float> m_spectrum;
+    std::vector<float> m_residual;   // Compressed magnitude, partials removed as notes are accepted
+    
+    // Template bank: kHarmonics partials per note; harmonics above the
+    // analysis band have no bins (lastBin < firstBin)
+    std::vector<Partial> m_templates;
+    float m_templateNorm[kNoteCount] = {};  // Sum of squared weights per note
+    std::vector<int8_t> m_binPitchClass;    // Chroma bin of each spectrum bin, -1 outside the band
+    
+    int64_t m_nextFrameStart = 0;    // Ring index of the next frame's first sample
+    
+    static constexpr size_t kFrameQueueSize = 64;
+    LockFreeQueue<PolyphonicFrame, kFrameQueueSize> m_frames;
+    std::atomic<uint32_t> m_droppedFrames{0};
+    std::atomic<int64_t> m_skippedSamples{0};
+};
+
+#endif // MUSIMIND_MULTI_PITCH_DETECTOR_H
@@ -0,0 +1,113 @@
+/**
+ * NativeMetronome.cpp
+ *
+ * Implementation of the sample-accurate metronome generator.
+ */
+
+#include "NativeMetronome.h"
+#include <algorithm>
+#include <cmath>
+
+// Packed layout (LSB first):
+// centi-BPM (16) | beats (8) | beat unit (8) | subdivision (8) | accents (16) | flags (8)
+constexpr float MIN_BPM = 1.0f;
+constexpr float MAX_BPM = 655.0f;
+
+MetronomeSettings MetronomeSettings::clamped() const {
+    MetronomeSettings s = *this;
+    s.bpm = std::min(std::max(bpm, MIN_BPM), MAX_BPM);
+    s.beatsPerMeasure = std::min(std::max(beatsPerMeasure, 1), kMaxBeatsPerMeasure);
+    s.beatUnit = std::min(std::max(beatUnit, 1), 255);
+    s.subdivision = std::min(std::max(subdivision, 1), kMaxSubdivision);
+    s.accentMask = accentMask & ((1u << kMaxBeatsPerMeasure) - 1);
+    return s;
+}
+
+uint64_t MetronomeSettings::pack() const {
+    MetronomeSettings s = clamped();
+    uint64_t centiBpm = (uint64_t)std::lround(s.bpm * 100.0f);
+    return (centiBpm & 0xFFFF)
+         | ((uint64_t)s.beatsPerMeasure << 16)
+         | ((uint64_t)s.beatUnit << 24)
+         | ((uint64_t)s.subdivision << 32)
+         | ((uint64_t)s.accentMask << 40)
+         | ((uint64_t)(s.muted ? 1 : 0) << 56);
+}
+
+MetronomeSettings MetronomeSettings::unpack(uint64_t packed) {
+    MetronomeSettings s;
+    s.bpm = (float)(packed & 0xFFFF) / 100.0f;
+    s.beatsPerMeasure = (int)((packed >> 16) & 0xFF);
+    s.beatUnit = (int)((packed >> 24) & 0xFF);
+    s.subdivision = (int)((packed >> 32) & 0xFF);
+    s.accentMask = (uint32_t)((packed >> 40) & 0xFFFF);
+    s.muted = ((packed >> 56) & 0x1) != 0;
+    return s;
+}
+
+NativeMetronome::NativeMetronome()
+    : m_packedSettings(MetronomeSettings().pack()) {
+}
+
+void NativeMetronome::setSettings(const MetronomeSettings& settings) {
+    m_packedSettings.store(settings.pack(), std::memory_order_release);
+}
+
+MetronomeSettings NativeMetronome::getSettings() const {
+    return MetronomeSettings::unpack(m_packedSettings.load(std::memory_order_acquire));
+}
+
+void NativeMetronome::start(int64_t frame) {
+    m_running = true;
+    m_nextClick = (double)frame;
+    m_beat = 0;
+    m_tick = 0;
+}
+
+void NativeMetronome::stop() {
+    m_running = false;
+}
+
+int64_t NativeMetronome::nextClickFrame() const {
+    return m_running ? (int64_t)std::ceil(m_nextClick) : INT64_MAX;
+}
+
+bool NativeMetronome::popClick(int64_t frame, BeatEvent& event) {
+    if (!m_running || nextClickFrame() > frame) {
+        return false;
+    }
+    
+    // Settings are read once per click, so a change never tears a click apart
+    MetronomeSettings settings = getSettings();
+    if (m_beat >= settings.beatsPerMeasure) {
+        m_beat = 0;
+    }
+    if (m_tick >= settings.subdivision) {
+        m_tick = 0;
+    }
+    
+    event.frame = nextClickFrame();
+    event.beat = m_beat;
+    event.subdivision = m_tick;
+    event.muted = settings.muted;
+    if (m_tick > 0) {
+        event.level = BeatEvent::LEVEL_SUBDIVISION;
+    } else if (settings.accentMask & (1u << m_beat)) {
+        event.level = BeatEvent::LEVEL_ACCENT;
+    } else {
+        event.level = BeatEvent::LEVEL_BEAT;
+    }
+    
+    if (!m_beats.push(event)) {
+        m_droppedBeats.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    // Advance to the next click
+    double framesPerTick = (double)m_sampleRate * 60.0 / ((double)settings.bpm * settings.subdivision);
+    m_nextClick += framesPerTick;
+    if (++m_tick >= settings.subdivision) {
+        m_tick = 0;
+        m_beat = (m_beat + 1) % settings.beatsPerMeasure;
+    }
+    return true;
+}
@@ -0,0 +1,93 @@
+/**
+ * NativeMetronome.h
+ *
+ * Sample-accurate metronome generator driven by the stream frame clock.
+ * Runs inside SoundFontEngine::render(): the engine asks for the next click
+ * frame, splits the callback there, and triggers the click on that exact sample.
+ *
+ * Settings (BPM, time signature, subdivision, accent pattern) are packed into a
+ * single 64-bit atomic so JNI threads can change them without a lock and the
+ * audio thread always sees a consistent set. Every click is reported as a
+ * BeatEvent carrying its frame timestamp through a lock-free queue.
+ */
+
+#ifndef MUSIMIND_NATIVE_METRONOME_H
+#define MUSIMIND_NATIVE_METRONOME_H
+
+#include "LockFreeQueue.h"
+#include <atomic>
+#include <cstdint>
+
+struct MetronomeSettings {
+    static constexpr int kMaxBeatsPerMeasure = 16;  // One accent bit per beat
+    static constexpr int kMaxSubdivision = 8;
+    
+    float bpm = 100.0f;
+    int beatsPerMeasure = 4;
+    int beatUnit = 4;
+    int subdivision = 1;         // Clicks per beat
+    uint32_t accentMask = 0x1;   // Bit n set = beat n (0-based) is accented
+    bool muted = false;          // Keep counting and reporting beats, but play no clicks
+    
+    // Clamp to the ranges the packed representation can hold
+    MetronomeSettings clamped() const;
+    
+    uint64_t pack() const;
+    static MetronomeSettings unpack(uint64_t packed);
+};
+
+struct BeatEvent {
+    enum Level : int32_t {
+        LEVEL_SUBDIVISION = 0,
+        LEVEL_BEAT = 1,
+        LEVEL_ACCENT = 2
+    };
+    
+    int64_t frame;        // Stream frame the click starts on
+    int32_t beat;         // Beat within the measure (0-based)
+    int32_t subdivision;  // Subdivision within the beat (0 = on the beat)
+    Level level;
+    bool muted;           // Counted and reported, but not sounded
+};
+
+class NativeMetronome {
+public:
+    NativeMetronome();
+    
+    // Any thread: new settings take effect from the next click
+    void setSettings(const MetronomeSettings& settings);
+    MetronomeSettings getSettings() const;
+    
+    // Audio thread only
+    void setSampleRate(int sampleRate) { m_sampleRate = sampleRate; }
+    void start(int64_t frame);
+    void stop();
+    bool isRunning() const { return m_running; }
+    
+    // Frame of the next click, or INT64_MAX when stopped (audio thread only)
+    int64_t nextClickFrame() const;
+    
+    // If a click is due at or before the given frame, return it and advance (audio thread only)
+    bool popClick(int64_t frame, BeatEvent& event);
+    
+    // Consumer side of the beat report queue (single JNI reader)
+    bool pollBeat(BeatEvent& event) { return m_beats.pop(event); }
+    
+    uint32_t getDroppedBeatCount() const { return m_droppedBeats.load(std::memory_order_relaxed); }
+    
+private:
+    std::atomic<uint64_t> m_packedSettings;
+    
+    // Generator state (audio thread only)
+    bool m_running = false;
+    double m_nextClick = 0.0;  // Fractional frame, so long runs never drift
+    int m_beat = 0;
+    int m_tick = 0;
+    int m_sampleRate = 48000;
+    
+    static constexpr size_t kBeatQueueSize = 256;
+    LockFreeQueue<BeatEvent, kBeatQueueSize> m_beats;
+    std::atomic<uint32_t> m_droppedBeats{0};
+};
+
+#endif // MUSIMIND_NATIVE_METRONOME_H
@@ -0,0 +1,306 @@
+/**
+ * NoteScorer.cpp
+ *
+ * Implementation of the native note scorer.
+ */
+
+#include "NoteScorer.h"
+#include "OnsetDetector.h"
+#include "YinPitchDetector.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Pitch (PitchScorer.kt): the sung MIDI note must match; cents only grade it
+constexpr float TOLERANCE_CENTS_GOOD = 30.0f;
+constexpr float TOLERANCE_CENTS_OK = 45.0f;
+constexpr float TOLERANCE_CENTS_MAX = 50.0f;
+constexpr float MIN_CORRECT_FRAMES_RATIO = 0.40f;  // Below this the wrong note was sung
+constexpr int MIN_FRAMES_FOR_EVALUATION = 3;
+constexpr float NOISE_PENALTY = 15.0f;             // Score lost when no frame is on the note
+
+// Timing (TimingScorer.kt)
+constexpr float ATTACK_TOLERANCE_EARLY_MS = 150.0f;
+constexpr float ATTACK_TOLERANCE_LATE_MS = 200.0f;
+constexpr float ATTACK_MAX_LATE_MS = 400.0f;
+constexpr float BREATHING_TOLERANCE_MS = 180.0f;
+constexpr float IDEAL_DURATION_PERCENT = 0.70f;
+
+// Unvoiced frames in a row that end a held note (~30 ms at the voice hop)
+constexpr int SILENCE_FRAMES_FOR_OFFSET = 3;
+
+// Onsets are refined with one frame of look-ahead, so they can trail the
+// pitch frames a little; notes are finalized this long after their end
+constexpr float FINISH_GRACE_MS = 100.0f;
+
+namespace {
+
+int64_t msToFrames(float ms, int sampleRate) {
+    return (int64_t)(ms * (float)sampleRate / 1000.0f);
+}
+
+float attackScore(int64_t deviation, int64_t early, int64_t late, int64_t maxLate) {
+    if (deviation >= -early && deviation <= late) {
+        return 50.0f;
+    }
+    if (deviation < -early && deviation >= -early * 2 && early > 0) {
+        // 50 down to 35 over the second early window
+        return 50.0f - (float)(-deviation - early) / (float)early * 15.0f;
+    }
+    if (deviation > late && deviation <= maxLate) {
+        // 50 down to 20 up to the latest accepted attack
+        return 50.0f - (float)(deviation - late) / (float)(maxLate - late) * 30.0f;
+    }
+    return 10.0f;
+}
+
+float durationScore(int64_t actual, int64_t expected, int64_t minimum, int64_t ideal) {
+    if (actual >= ideal) {
+        return 50.0f;
+    }
+    if (actual >= minimum) {
+        return 35.0f + (float)(actual - minimum) / (float)(ideal - minimum) * 15.0f;
+    }
+    int64_t half = (int64_t)(expected * 0.5f);
+    if (actual >= half) {
+        return 20.0f + (float)(actual - half) / (float)(minimum - half) * 15.0f;
+    }
+    if (actual >= (int64_t)(expected * 0.3f)) {
+        return 15.0f;
+    }
+    return 5.0f;
+}
+
+} // namespace
+
+void NoteScorer::load(const ScoringNote* notes, int count, int octaveOffset, int sampleRate) {
+    m_origin.store(kUnarmed, std::memory_order_relaxed);
+    m_notes.assign(notes, notes + std::max(0, count));
+    
+    NoteState empty;
+    memset(&empty, 0, sizeof(empty));
+    empty.onsetFrame = -1;
+    empty.firstVoicedFrame = -1;
+    empty.lastVoicedFrame = -1;
+    empty.offsetFrame = -1;
+    m_states.assign(m_notes.size(), empty);
+    
+    m_octaveOffset = octaveOffset;
+    m_sampleRate = sampleRate > 0 ? sampleRate : 48000;
+    m_finishGrace = msToFrames(FINISH_GRACE_MS, m_sampleRate);
+    m_nextToFinish = 0;
+    m_voiceActive = false;
+    m_silentFrames = 0;
+    m_silenceStart = 0;
+    m_currentNote.store(-1, std::memory_order_relaxed);
+    
+    // Results of the previous exercise are stale now
+    NoteScore stale;
+    while (m_scores.pop(stale)) {
+    }
+}
+
+void NoteScorer::clear() {
+    load(nullptr, 0, 0, m_sampleRate);
+}
+
+int NoteScorer::findNote(int64_t frame) const {
+    for (int i = m_nextToFinish; i < (int)m_notes.size(); i++) {
+        if (frame < m_notes[i].startFrame) {
+            break;
+        }
+        if (frame < m_notes[i].endFrame) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int NoteScorer::findOwner(int64_t frame) const {
+    int owner = -1;
+    for (int i = m_nextToFinish; i < (int)m_notes.size() && m_notes[i].startFrame <= frame; i++) {
+        owner = i;
+    }
+    return owner;
+}
+
+void NoteScorer::processPitch(const PitchFrame& frame) {
+    int64_t origin = m_origin.load(std::memory_order_acquire);
+    if (origin == kUnarmed || m_notes.empty()) {
+        return;
+    }
+    int64_t position = frame.framePosition - origin;
+    finishBefore(position);
+    
+    int index = findNote(position);
+    m_currentNote.store(index, std::memory_order_relaxed);
+    
+    if (frame.isVoiced) {
+        m_voiceActive = true;
+        m_silentFrames = 0;
+        if (index < 0) {
+            return;
+        }
+        NoteState& state = m_states[index];
+        state.voicedFrames++;
+        if (state.firstVoicedFrame < 0) {
+            state.firstVoicedFrame = position;
+        }
+        state.lastVoicedFrame = position;
+        state.offsetFrame = -1;  // A break that was picked up again is part of the hold
+        
+        int semitones = frame.midiNote - m_octaveOffset * 12 - m_notes[index].midiNote;
+        if (semitones == 0) {
+            state.correctFrames++;
+            state.centSum += frame.centDeviation;
+            state.centSquareSum += (double)frame.centDeviation * frame.centDeviation;
+        }
+        state.semitones[std::max(-12, std::min(12, semitones)) + 12]++;
+        return;
+    }
+    
+    if (!m_voiceActive) {
+        return;
+    }
+    if (m_silentFrames++ == 0) {
+        m_silenceStart = position;
+    }
+    if (m_silentFrames >= SILENCE_FRAMES_FOR_OFFSET) {
+        // The hold ended where the silence began
+        m_voiceActive = false;
+        int owner = findOwner(m_silenceStart);
+        if (owner >= 0) {
+            NoteState& state = m_states[owner];
+            int64_t attack = state.onsetFrame >= 0 ? state.onsetFrame : state.firstVoicedFrame;
+            if (attack >= 0 && m_silenceStart >= attack) {
+                state.offsetFrame = m_silenceStart;
+            }
+        }
+    }
+}
+
+void NoteScorer::processOnset(const OnsetEvent& onset) {
+    int64_t origin = m_origin.load(std::memory_order_acquire);
+    if (origin == kUnarmed) {
+        return;
+    }
+    int64_t position = onset.framePosition - origin;
+    
+    // The first note still waiting for its attack takes it, including
+    // attacks in the early window that still earns partial credit
+    int64_t earlyWindow = msToFrames(ATTACK_TOLERANCE_EARLY_MS, m_sampleRate) * 2;
+    for (int i = m_nextToFinish; i < (int)m_notes.size(); i++) {
+        if (position < m_notes[i].startFrame - earlyWindow) {
+            break;
+        }
+        if (position < m_notes[i].endFrame && m_states[i].onsetFrame < 0) {
+            m_states[i].onsetFrame = position;
+            break;
+        }
+    }
+}
+
+void NoteScorer::finishBefore(int64_t frame) {
+    while (m_nextToFinish < (int)m_notes.size()
+           && m_notes[m_nextToFinish].endFrame + m_finishGrace <= frame) {
+        finish(m_nextToFinish++);
+    }
+}
+
+void NoteScorer::finishAll() {
+    if (m_origin.load(std::memory_order_acquire) == kUnarmed) {
+        return;
+    }
+    while (m_nextToFinish < (int)m_notes.size()) {
+        finish(m_nextToFinish++);
+    }
+    m_currentNote.store(-1, std::memory_order_relaxed);
+}
+
+void NoteScorer::finish(int index) {
+    const ScoringNote& note = m_notes[index];
+    const NoteState& state = m_states[index];
+    
+    NoteScore score;
+    memset(&score, 0, sizeof(score));
+    score.noteIndex = index;
+    
+    // === Pitch ===
+    score.pitchStatus = NoteScore::PITCH_NOT_EVALUATED;
+    if (state.voicedFrames >= MIN_FRAMES_FOR_EVALUATION) {
+        score.correctRatio = (float)state.correctFrames / (float)state.voicedFrames;
+        if (score.correctRatio < MIN_CORRECT_FRAMES_RATIO) {
+            // Wrong note: report the one actually sung
+            int mostCommon = (int)(std::max_element(state.semitones, state.semitones + kSemitoneBins)
+                                   - state.semitones) - 12;
+            score.pitchStatus = mostCommon < 0 ? NoteScore::PITCH_FLAT : NoteScore::PITCH_SHARP;
+            score.averageCents = (float)(mostCommon * 100);
+        } else {
+            double mean = state.centSum / state.correctFrames;
+            double variance = state.centSquareSum / state.correctFrames - mean * mean;
+            score.averageCents = (float)mean;
+            score.centStdDev = (float)std::sqrt(std::max(0.0, variance));
+            
+            float error = std::fabs(score.averageCents);
+            float deviationScore;
+            if (error <= TOLERANCE_CENTS_GOOD) {
+                deviationScore = 100.0f;
+            } else if (error <= TOLERANCE_CENTS_OK) {
+                deviationScore = 100.0f - (error - TOLERANCE_CENTS_GOOD)
+                                 / (TOLERANCE_CENTS_OK - TOLERANCE_CENTS_GOOD) * 20.0f;
+            } else if (error <= TOLERANCE_CENTS_MAX) {
+                deviationScore = 80.0f - (error - TOLERANCE_CENTS_OK)
+                                 / (TOLERANCE_CENTS_MAX - TOLERANCE_CENTS_OK) * 20.0f;
+            } else {
+                deviationScore = 50.0f;
+            }
+            float noisePenalty = (1.0f - score.correctRatio) * NOISE_PENALTY;
+            score.pitchScore = std::max(0.0f, std::min(100.0f, deviationScore - noisePenalty));
+            
+            if (error <= TOLERANCE_CENTS_OK) {
+                score.pitchStatus = NoteScore::PITCH_CORRECT;
+            } else {
+                score.pitchStatus = score.averageCents < 0.0f ? NoteScore::PITCH_FLAT : NoteScore::PITCH_SHARP;
+            }
+        }
+    }
+    
+    // === Timing ===
+    int64_t attack = state.onsetFrame >= 0 ? state.onsetFrame : state.firstVoicedFrame;
+    if (attack < 0) {
+        score.timingStatus = NoteScore::TIMING_NOT_PLAYED;
+    } else {
+        int64_t early = msToFrames(ATTACK_TOLERANCE_EARLY_MS, m_sampleRate);
+        int64_t late = msToFrames(ATTACK_TOLERANCE_LATE_MS, m_sampleRate);
+        int64_t maxLate = msToFrames(ATTACK_MAX_LATE_MS, m_sampleRate);
+        int64_t breathing = msToFrames(BREATHING_TOLERANCE_MS, m_sampleRate);
+        
+        score.attackDeviationFrames = attack - note.startFrame;
+        score.attackScore = attackScore(score.attackDeviationFrames, early, late, maxLate);
+        
+        // Hold: until the voice stopped, or through the note if it never did
+        int64_t release = state.offsetFrame;
+        if (release < attack) {
+            release = m_voiceActive && state.lastVoicedFrame >= attack ? note.endFrame
+                      : std::max(attack, state.lastVoicedFrame);
+        }
+        int64_t expected = std::max<int64_t>(1, note.endFrame - note.startFrame);
+        int64_t held = release - attack;
+        score.durationAccuracy = std::max(0.0f, std::min(2.0f, (float)held / (float)expected));
+        score.durationScore = durationScore(held, expected, expected - breathing,
+                                            (int64_t)(expected * IDEAL_DURATION_PERCENT));
+        score.timingScore = score.attackScore + score.durationScore;
+        
+        if (score.attackDeviationFrames < -early) {
+            score.timingStatus = NoteScore::TIMING_EARLY;
+        } else if (score.attackDeviationFrames > late) {
+            score.timingStatus = NoteScore::TIMING_LATE;
+        } else {
+            score.timingStatus = NoteScore::TIMING_ON_TIME;
+        }
+    }
+    
+    if (!m_scores.push(score)) {
+        m_droppedScores.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,138 @@
+/**
+ * NoteScorer.h
+ *
+ * Native pitch and timing scoring of a sung exercise, run next to the
+ * detectors on the analysis thread. The expected notes are loaded once as a
+ * compact array of frame ranges on the engine clock (relative to an origin
+ * armed when the exercise starts). Every PitchFrame and OnsetEvent is folded
+ * into the state of the note it falls in as it arrives: voiced frames on the
+ * expected note, their cent error sums, the attack and the hold. When the
+ * analysis has moved past a note, it is finalized into a NoteScore on a
+ * lock-free queue, so the JNI side only ever sees one result per note. The
+ * notes still open when input stops or the exercise ends (at least the last
+ * one, which no later frame passes) are flushed by finishAll().
+ *
+ * The thresholds and score curves follow scoring/PitchScorer.kt and
+ * scoring/TimingScorer.kt.
+ */
+
+#ifndef MUSIMIND_NOTE_SCORER_H
+#define MUSIMIND_NOTE_SCORER_H
+
+#include "LockFreeQueue.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+struct PitchFrame;
+struct OnsetEvent;
+
+// One expected note, in frames relative to the scoring origin
+struct ScoringNote {
+    int64_t startFrame;
+    int64_t endFrame;
+    int32_t midiNote;
+};
+
+struct NoteScore {
+    // Same order as the Kotlin PitchStatus / TimingStatus enums
+    enum PitchStatus : int32_t {
+        PITCH_CORRECT = 0,
+        PITCH_FLAT = 1,
+        PITCH_SHARP = 2,
+        PITCH_NOT_EVALUATED = 3
+    };
+    enum TimingStatus : int32_t {
+        TIMING_ON_TIME = 0,
+        TIMING_EARLY = 1,
+        TIMING_LATE = 2,
+        TIMING_NOT_PLAYED = 3
+    };
+    
+    int32_t noteIndex;
+    PitchStatus pitchStatus;
+    float pitchScore;               // 0-100
+    float averageCents;             // Mean error on the expected note (100 per semitone when wrong)
+    float centStdDev;               // Stability on the expected note
+    float correctRatio;             // Voiced frames on the expected note
+    TimingStatus timingStatus;
+    float timingScore;              // 0-100: attack (0-50) + hold (0-50)
+    float attackScore;
+    float durationScore;
+    int64_t attackDeviationFrames;  // Positive = late
+    float durationAccuracy;         // Held / expected duration, [0, 2]
+};
+
+class NoteScorer {
+public:
+    // Replace the timeline (notes in start order; results carry their index).
+    // Not real-time safe; only call while no analysis runs (input stopped).
+    // Scoring stays idle until arm().
+    void load(const ScoringNote* notes, int count, int octaveOffset, int sampleRate);
+    void clear();
+    
+    // Frame that note positions are relative to (any thread)
+    void arm(int64_t originFrame) { m_origin.store(originFrame, std::memory_order_release); }
+    
+    // Analysis side (analysis thread only)
+    void processPitch(const PitchFrame& frame);
+    void processOnset(const OnsetEvent& onset);
+    
+    // Finalize every note not scored yet, as analysis has ended. Analysis
+    // thread, or while no analysis runs; a no-op until arm().
+    void finishAll();
+    
+    // Consumer side (single JNI reader)
+    bool pollScore(NoteScore& score) { return m_scores.pop(score); }
+    
+    // Note the latest pitch frame fell in, -1 outside every note
+    int32_t getCurrentNote() const { return m_currentNote.load(std::memory_order_relaxed); }
+    int getNoteCount() const { return (int)m_notes.size(); }
+    uint32_t getDroppedScoreCount() const { return m_droppedScores.load(std::memory_order_relaxed); }
+    
+private:
+    static constexpr int64_t kUnarmed = INT64_MIN;
+    static constexpr int kSemitoneBins = 25;  // Sung note relative to the expected one, +-12
+    
+    struct NoteState {
+        int32_t voicedFrames;
+        int32_t correctFrames;
+        double centSum;            // Over correct frames
+        double centSquareSum;
+        int32_t semitones[kSemitoneBins];
+        int64_t onsetFrame;        // -1 until an attack lands in the note
+        int64_t firstVoicedFrame;  // Attack fallback when no flux onset was detected
+        int64_t lastVoicedFrame;
+        int64_t offsetFrame;       // -1 until the voice stops after the attack
+    };
+    
+    // Finalize every note that ends before the given relative frame
+    void finishBefore(int64_t frame);
+    void finish(int index);
+    int findNote(int64_t frame) const;
+    
+    // Latest unfinished note started at or before the frame (a silence in
+    // the gap after a note still ends that note's hold)
+    int findOwner(int64_t frame) const;
+    
+    std::vector<ScoringNote> m_notes;
+    std::vector<NoteState> m_states;
+    int m_octaveOffset = 0;
+    int m_sampleRate = 48000;
+    int64_t m_finishGrace = 0;     // Wait this long past a note's end for late onsets
+    
+    std::atomic<int64_t> m_origin{kUnarmed};
+    std::atomic<int32_t> m_currentNote{-1};
+    
+    // Analysis state (analysis thread only)
+    int m_nextToFinish = 0;
+    bool m_voiceActive = false;
+    int m_silentFrames = 0;
+    int64_t m_silenceStart = 0;
+    
+    static constexpr size_t kScoreQueueSize = 64;
+    LockFreeQueue<NoteScore, kScoreQueueSize> m_scores;
+    std::atomic<uint32_t> m_droppedScores{0};
+};
+
+#endif // MUSIMIND_NOTE_SCORER_H
@@ -5,53 +5,146 @@
  */
 
 #include "OboePlayer.h"
+#include "RealtimeGuard.h"
+#include "DspKernels.h"
 #include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
 
 #define LOG_TAG "OboePlayer"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
+namespace {
+
+// Reopen backoff: the first attempt is immediate (a route switch usually has
+// the new device ready), then it doubles up to the cap until stop()
+constexpr int RECOVERY_FIRST_DELAY_MS = 50;
+constexpr int RECOVERY_MAX_DELAY_MS = 2000;
+
+// Input the ring keeps beyond the longest analysis window, so the analysis
+// worker can be preempted this long without losing samples
+constexpr int ANALYSIS_SLACK_MS = 250;
+
+int64_t nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
 OboePlayer::OboePlayer() {
+    // Sessions are summed into the engine's mix before its limiter runs
+    m_engine.setLimiterDeferred(true);
+    m_analysis.setScorer(&m_scorer);
+    m_recoveryThread = std::thread(&OboePlayer::recoveryLoop, this);
     LOGI("OboePlayer created");
 }
 
 OboePlayer::~OboePlayer() {
     stop();
+    {
+        std::lock_guard<std::mutex> lock(m_recoveryMutex);
+        m_recoveryExit = true;
+    }
+    m_recoveryWake.notify_all();
+    m_recoveryThread.join();
     LOGI("OboePlayer destroyed");
 }
 
+void OboePlayer::setUiChannel(UiStateChannel* channel) {
+    std::lock_guard<std::mutex> lock(m_lifecycleMutex);
+    if (m_stream) {
+        LOGE("UI channel must be set before the stream starts");
+        return;
+    }
+    if (channel) {
+        channel->reset(m_sampleRate);
+    }
+    m_uiChannel = channel;
+    m_engine.setUiChannel(channel);
+    m_analysis.setUiChannel(channel);
+}
+
 bool OboePlayer::start() {
-    if (m_isRunning) {
+    std::lock_guard<std::mutex> lock(m_lifecycleMutex);
+    int state = m_state.load();
+    if (state == STREAM_RUNNING || state == STREAM_RECOVERING) {
         return true;
     }
-    
+    if (!openStream()) {
+        return false;
+    }
+    m_state.store(STREAM_RUNNING);
+    return true;
+}
+
+bool OboePlayer::openStream() {
     oboe::AudioStreamBuilder builder;
     builder.setDirection(oboe::Direction::Output);
     builder.setPerformanceMode(oboe::PerformanceMode::LowLatency);
     builder.setSharingMode(oboe::SharingMode::Exclusive);
     builder.setFormat(oboe::AudioFormat::Float);
     builder.setChannelCount(m_channelCount);
-    builder.setSampleRate(m_sampleRate);
+    // No rate requested: the stream opens at the device's native rate and
+    // stays on the MMAP/exclusive path. Asking for the engine rate would only
+    // move the conversion into the legacy mixer; m_resampler bridges it natively.
+    builder.setSampleRateConversionQuality(oboe::SampleRateConversionQuality::None);
     builder.setDataCallback(this);
     builder.setErrorCallback(this);
     builder.setUsage(oboe::Usage::Media);
     builder.setContentType(oboe::ContentType::Music);
     
     oboe::Result result = builder.openStream(m_stream);
+    if (result != oboe::Result::OK) {
+        // Some older devices and OpenSL ES paths only open 16-bit streams
+        LOGE("Failed to open float stream: %s, retrying with I16", oboe::convertToText(result));
+        builder.setFormat(oboe::AudioFormat::I16);
+        result = builder.openStream(m_stream);
+    }
     
     if (result != oboe::Result::OK) {
         LOGE("Failed to open stream: %s", oboe::convertToText(result));
         return false;
     }
     
-    // Get actual sample rate
-    m_sampleRate = m_stream->getSampleRate();
-    m_engine.setSampleRate(m_sampleRate);
+    // The engine keeps its own rate; only the resampler follows the stream
+    m_streamSampleRate = m_stream->getSampleRate();
+    
+    // Size render scratch buffers for the largest callback the stream can request
+    int32_t maxFrames = std::max(m_stream->getBufferCapacityInFrames(),
+                                 m_stream->getFramesPerBurst());
+    m_resampler.configure(m_sampleRate, m_streamSampleRate, maxFrames);
+    int32_t maxEngineFrames = m_resampler.isPassthrough() ? maxFrames : m_resampler.getMaxInputFrames();
+    m_engine.prepare(maxEngineFrames);
+    m_sessions.prepare(maxEngineFrames);
+    m_inputBuffer.assign(maxEngineFrames, 0.0f);
     
-    LOGI("Stream opened: sampleRate=%d, channelCount=%d, framesPerBurst=%d",
+    // I16 streams render into a float buffer and are converted in the callback
+    m_outputIsInt16 = m_stream->getFormat() == oboe::AudioFormat::I16;
+    m_floatOutput.assign(m_outputIsInt16 ? (size_t)maxFrames * m_channelCount : 0, 0.0f);
+    
+    LOGI("Stream opened: sampleRate=%d (engine %d), channelCount=%d, framesPerBurst=%d, capacity=%d, format=%s",
+         m_streamSampleRate,
          m_sampleRate,
          m_stream->getChannelCount(),
-         m_stream->getFramesPerBurst());
+         m_stream->getFramesPerBurst(),
+         maxFrames,
+         oboe::convertToText(m_stream->getFormat()));
+    
+    // Lowest latency first: one burst, grown by the tuner on underruns
+    m_bufferTuner.reset(m_stream.get());
+    LOGI("Buffer starts at %d frames", m_bufferTuner.getStats().bufferFrames);
+    
+    // The hint session needs the callback's thread id, so it opens on the
+    // first callback. Oboe's hint support is left off: it needs the same
+    // API 33 calls, so it could only duplicate our session.
+    m_burstFrames = std::max(1, m_stream->getFramesPerBurst());
+    m_fastCpuMask = m_affinityFallback.load() ? PerformanceHint::fastestCpuMask() : 0;
+    m_hintMode.store(HINT_NONE);
+    m_hintPending = true;
     
     result = m_stream->requestStart();
     
@@ -62,19 +155,52 @@ bool OboePlayer::start() {
         return false;
     }
     
-    m_isRunning = true;
     LOGI("Audio stream started successfully");
     return true;
 }
 
 void OboePlayer::stop() {
+    std::lock_guard<std::mutex> lock(m_lifecycleMutex);
+    {
+        // Also ends a recovery in progress; its backoff wait wakes up early
+        std::lock_guard<std::mutex> recoveryLock(m_recoveryMutex);
+        m_state.store(STREAM_STOPPED);
+        m_recoveryPending = false;
+        m_inputRecoveryPending = false;
+    }
+    m_reopenInput = false;
+    m_recoveryWake.notify_all();
+    closeStreams();
+    
+    uint32_t allocations = RealtimeGuard::getAllocationCount();
+    if (allocations > 0) {
+        LOGE("Detected %u heap allocations (%zu bytes) inside onAudioReady",
+             allocations, RealtimeGuard::getAllocatedBytes());
+    }
+    LOGI("Audio stream stopped");
+}
+
+void OboePlayer::closeStreams() {
+    closeInput();
     if (m_stream) {
         m_stream->requestStop();
         m_stream->close();
         m_stream.reset();
     }
-    m_isRunning = false;
-    LOGI("Audio stream stopped");
+    // The callback has stopped, so the session is free to close
+    m_performanceHint.close();
+    m_hintPending = false;
+    m_hintMode.store(HINT_NONE);
+}
+
+OboePlayer::RecoveryStats OboePlayer::getRecoveryStats() const {
+    RecoveryStats stats;
+    stats.state = getStreamState();
+    stats.recoveries = m_recoveries.load();
+    stats.attempts = m_recoveryAttempts.load();
+    stats.lastOutageMillis = m_lastOutageMillis.load();
+    stats.frameAtOutage = m_frameAtOutage.load();
+    return stats;
 }
 
 oboe::DataCallbackResult OboePlayer::onAudioReady(
@@ -82,28 +208,403 @@ oboe::DataCallbackResult OboePlayer::onAudioReady(
     void* audioData,
     int32_t numFrames
 ) {
-    auto* output = static_cast<float*>(audioData);
+    // Debug builds count any heap allocation made while this guard is alive
+    RealtimeGuard guard;
+    auto callbackStart = std::chrono::steady_clock::now();
     
-    // Render audio from SoundFontEngine
-    m_engine.render(output, numFrames);
+    if (m_hintPending) {
+        m_hintPending = false;
+        startPerformanceHint();
+    }
+    
+    m_bufferTuner.update(stream, numFrames);
+    
+    bool convert = m_outputIsInt16;
+    if (convert && (size_t)numFrames * m_channelCount > m_floatOutput.size()) {
+        // Larger than the buffer capacity the scratch was sized for: should not happen
+        memset(audioData, 0, (size_t)numFrames * m_channelCount * sizeof(int16_t));
+        return oboe::DataCallbackResult::Continue;
+    }
+    auto* output = convert ? m_floatOutput.data() : static_cast<float*>(audioData);
+    
+    // Input read in this callback is stamped with the frame position at its start
+    int64_t framePosition = m_engine.getFramePosition();
+    
+    // Render at the engine rate, resampling when the stream runs at another one.
+    // Chirps and input stamps stay on the engine frame clock either way.
+    int engineFrames = numFrames;
+    if (m_resampler.isPassthrough()) {
+        renderEngines(output, numFrames, framePosition);
+        m_calibrator.renderOutput(output, numFrames, m_channelCount, framePosition);
+    } else {
+        engineFrames = m_resampler.getInputFramesNeeded(numFrames);
+        float* engineOutput = m_resampler.getInputWritePointer();
+        if (engineFrames > 0) {
+            renderEngines(engineOutput, engineFrames, framePosition);
+            m_calibrator.renderOutput(engineOutput, engineFrames, m_channelCount, framePosition);
+        }
+        m_resampler.process(engineFrames, output, numFrames);
+    }
+    
+    if (convert) {
+        DspKernels::floatToInt16Dithered(output, static_cast<int16_t*>(audioData),
+                                         numFrames * m_channelCount, m_dither);
+    }
+    
+    readInput(engineFrames, framePosition);
+    
+    if (m_uiChannel) {
+        // Meters run on the engine clock like every other published frame
+        float outputPeak = DspKernels::peak(output, numFrames * m_channelCount);
+        m_uiChannel->publishLevels(m_engine.getFramePosition(), engineFrames, m_inputPeak, outputPeak);
+    }
+    
+    // Whole-callback cost against the audio it produced
+    int64_t durationNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - callbackStart).count();
+    int64_t deadlineNanos = (int64_t)numFrames * 1000000000LL / std::max(1, m_streamSampleRate);
+    int voices = m_engine.getVoiceStats().active + m_sessions.getRenderedVoices();
+    m_perfCounters.record(durationNanos, deadlineNanos, voices);
+    
+    if (m_performanceHint.isOpen()) {
+        // The target is one burst; scale so larger callbacks count as their share
+        m_performanceHint.reportActualWork(durationNanos * m_burstFrames / std::max(1, numFrames));
+    }
     
     return oboe::DataCallbackResult::Continue;
 }
 
+void OboePlayer::renderEngines(float* output, int numFrames, int64_t framePosition) {
+    m_engine.render(output, numFrames);
+    m_sessions.mixInto(output, numFrames, framePosition);
+    m_engine.limitOutput(output, numFrames);
+}
+
+void OboePlayer::startPerformanceHint() {
+    int64_t burstNanos = (int64_t)m_burstFrames * 1000000000LL / std::max(1, m_streamSampleRate);
+    HintMode mode = HINT_NONE;
+    if (m_performanceHint.open(burstNanos)) {
+        mode = HINT_SESSION;
+    } else if (PerformanceHint::pinCurrentThread(m_fastCpuMask)) {
+        mode = HINT_AFFINITY;
+    }
+    m_hintMode.store(mode);
+}
+
+bool OboePlayer::startInput(YinPitchDetector::Preset preset, uint32_t extraPresets, bool polyphonic) {
+    std::lock_guard<std::mutex> lock(m_lifecycleMutex);
+    m_reopenInput = false;  // Replaces an input the recovery thread is reopening
+    return openInput(preset, extraPresets, polyphonic);
+}
+
+bool OboePlayer::openInput(YinPitchDetector::Preset preset, uint32_t extraPresets, bool polyphonic) {
+    if (!m_stream) {
+        LOGE("Cannot start input without an output stream");
+        return false;
+    }
+    closeInput();
+    
+    // Safe: the worker only runs while input is active, and the callback
+    // leaves the ring alone until then
+    m_inputPreset = preset;
+    m_extraPresets = extraPresets;
+    m_polyphonicInput = polyphonic;
+    m_analysis.configure(preset, extraPresets, polyphonic, m_sampleRate);
+    
+    // Room for the largest analysis window plus the worker's slack, guarded
+    // against one callback's worth of input in flight
+    int slack = m_sampleRate * ANALYSIS_SLACK_MS / 1000;
+    m_inputRing.configure(m_analysis.getLongestWindow() + slack, (int)m_inputBuffer.size());
+    
+    oboe::AudioStreamBuilder builder;
+    builder.setDirection(oboe::Direction::Input);
+    builder.setPerformanceMode(oboe::PerformanceMode::LowLatency);
+    builder.setSharingMode(oboe::SharingMode::Exclusive);
+    builder.setFormat(oboe::AudioFormat::Float);
+    builder.setChannelCount(1);
+    builder.setSampleRate(m_sampleRate);
+    builder.setSampleRateConversionQuality(oboe::SampleRateConversionQuality::Medium);
+    builder.setInputPreset(oboe::InputPreset::VoiceRecognition);
+    builder.setErrorCallback(this);  // A mic can go away while the output stays up
+    
+    oboe::Result result = builder.openStream(m_inputStream);
+    if (result != oboe::Result::OK) {
+        LOGE("Failed to open input stream: %s", oboe::convertToText(result));
+        m_inputStream.reset();
+        return false;
+    }
+    
+    result = m_inputStream->requestStart();
+    if (result != oboe::Result::OK) {
+        LOGE("Failed to start input stream: %s", oboe::convertToText(result));
+        m_inputStream->close();
+        m_inputStream.reset();
+        return false;
+    }
+    
+    LOGI("Input stream started: sampleRate=%d, framesPerBurst=%d, window=%d",
+         m_inputStream->getSampleRate(),
+         m_inputStream->getFramesPerBurst(),
+         m_analysis.getPitchTracker().getWindowSize());
+    
+    m_analysis.start(&m_inputRing);
+    
+    // The first callback discards input that queued up while starting
+    m_drainInput.store(true);
+    m_activeInput.store(m_inputStream.get());
+    return true;
+}
+
+void OboePlayer::stopInput() {
+    std::lock_guard<std::mutex> lock(m_lifecycleMutex);
+    m_reopenInput = false;
+    closeInput();
+    // No later frame will pass the last notes. Only here: a reopen or a
+    // route change recovery also closes the input, and scoring resumes
+    m_scorer.finishAll();
+}
+
+void OboePlayer::closeInput() {
+    // A calibration cannot finish without input
+    m_calibrator.cancel();
+    m_activeInput.store(nullptr);
+    while (m_inputInUse.load()) {
+        std::this_thread::yield();
+    }
+    m_analysis.stop();
+    
+    if (m_inputStream) {
+        m_inputStream->requestStop();
+        m_inputStream->close();
+        m_inputStream.reset();
+        LOGI("Input stream stopped");
+    }
+}
+
+void OboePlayer::readInput(int numFrames, int64_t framePosition) {
+    m_inputPeak = 0.0f;
+    m_inputInUse.store(true);
+    oboe::AudioStream* input = m_activeInput.load();
+    if (input) {
+        int32_t capacity = (int32_t)m_inputBuffer.size();
+        
+        // Full-duplex priming: drop stale input so both directions start aligned
+        if (m_drainInput.exchange(false)) {
+            for (int i = 0; i < 8; i++) {
+                auto drained = input->read(m_inputBuffer.data(), capacity, 0);
+                if (!drained || drained.value() < capacity) {
+                    break;
+                }
+            }
+        }
+        
+        auto result = input->read(m_inputBuffer.data(), std::min(numFrames, capacity), 0);
+        if (result && result.value() > 0) {
+            // Stamp on the output clock: an input sample is what was heard
+            // when the output frame it is stamped with played
+            int64_t inputFrame = framePosition - m_inputLatencyOffset.load(std::memory_order_relaxed);
+            m_inputRing.write(m_inputBuffer.data(), result.value(), inputFrame);
+            m_inputPeak = DspKernels::peak(m_inputBuffer.data(), result.value());
+            
+            // Analysis runs on the worker; the calibrator's capture is a plain
+            // copy and stays here, on the same thread as its chirps
+            m_calibrator.captureInput(m_inputRing);
+        }
+    }
+    m_inputInUse.store(false);
+}
+
+bool OboePlayer::loadScoringTimeline(const ScoringNote* notes, int count, int octaveOffset) {
+    std::lock_guard<std::mutex> lock(m_lifecycleMutex);
+    if (isInputActive()) {
+        LOGE("Scoring timeline must be loaded before input starts");
+        return false;
+    }
+    // Safe: the analysis worker only runs while input is active
+    m_scorer.load(notes, count, octaveOffset, m_sampleRate);
+    LOGI("Scoring timeline loaded: %d notes", count);
+    return true;
+}
+
+void OboePlayer::finishScoring() {
+    std::lock_guard<std::mutex> lock(m_lifecycleMutex);
+    // The scorer belongs to the worker while it runs; the trackers keep
+    // their read positions, so a restart picks up where they left off
+    bool analyzing = m_analysis.isRunning();
+    m_analysis.stop();
+    m_scorer.finishAll();
+    if (analyzing) {
+        m_analysis.start(&m_inputRing);
+    }
+}
+
+bool OboePlayer::startLatencyCalibration() {
+    if (!isInputActive()) {
+        LOGE("Latency calibration needs an active input stream");
+        return false;
+    }
+    
+    // Leave time for the input to settle before the first chirp
+    int64_t firstChirpFrame = m_engine.getFramePosition() + m_sampleRate / 5;
+    m_calibrator.start(m_sampleRate, firstChirpFrame, m_inputLatencyOffset.load());
+    return true;
+}
+
+double OboePlayer::getOutputLatencyMillis() {
+    if (!m_stream) {
+        return -1.0;
+    }
+    auto latency = m_stream->calculateLatencyMillis();
+    return latency ? latency.value() : -1.0;
+}
+
+double OboePlayer::getInputLatencyMillis() {
+    if (!m_inputStream || !isInputActive()) {
+        return -1.0;
+    }
+    auto latency = m_inputStream->calculateLatencyMillis();
+    return latency ? latency.value() : -1.0;
+}
+
 void OboePlayer::onErrorAfterClose(
     oboe::AudioStream* stream,
     oboe::Result error
 ) {
-    LOGE("Audio stream error: %s", oboe::convertToText(error));
+    bool isInput = stream->getDirection() == oboe::Direction::Input;
+    LOGE("Audio %s stream error: %s", isInput ? "input" : "output", oboe::convertToText(error));
+    
+    if (isInput) {
+        // Only the microphone went away; the output keeps playing and just
+        // the input is reopened. The exchange also stops the callback from
+        // reading it, and fails when stopInput() or a reopen got there first.
+        oboe::AudioStream* expectedInput = stream;
+        if (m_state.load() != STREAM_RUNNING
+            || !m_activeInput.compare_exchange_strong(expectedInput, nullptr)) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_recoveryMutex);
+            m_inputRecoveryPending = true;
+        }
+        m_recoveryWake.notify_all();
+        return;
+    }
     
-    // Try to reopen stream
-    if (m_isRunning) {
-        reopenStream();
+    // Only a running stream recovers; a stop() racing the error wins.
+    // Nothing blocking happens here: Oboe's error thread just hands off.
+    int expected = STREAM_RUNNING;
+    if (!m_state.compare_exchange_strong(expected, STREAM_RECOVERING)) {
+        return;
     }
+    m_outageStartNanos.store(nowNanos());
+    m_frameAtOutage.store(m_engine.getFramePosition());
+    m_recoveryAttempts.store(0);
+    {
+        std::lock_guard<std::mutex> lock(m_recoveryMutex);
+        m_recoveryPending = true;
+    }
+    m_recoveryWake.notify_all();
 }
 
-void OboePlayer::reopenStream() {
-    LOGI("Attempting to reopen stream...");
-    stop();
-    start();
+void OboePlayer::recoveryLoop() {
+    std::unique_lock<std::mutex> lock(m_recoveryMutex);
+    for (;;) {
+        m_recoveryWake.wait(lock, [this] {
+            return m_recoveryExit || m_recoveryPending || m_inputRecoveryPending;
+        });
+        if (m_recoveryExit) {
+            return;
+        }
+        // A full recovery reopens the input too
+        bool full = m_recoveryPending;
+        m_recoveryPending = false;
+        m_inputRecoveryPending = false;
+        lock.unlock();
+        if (full) {
+            recover();
+        } else {
+            recoverInput();
+        }
+        lock.lock();
+    }
+}
+
+void OboePlayer::recover() {
+    int delayMs = RECOVERY_FIRST_DELAY_MS;
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(m_lifecycleMutex);
+            if (m_state.load() != STREAM_RECOVERING) {
+                return;  // stop() ended the outage
+            }
+            
+            // The engine keeps its state and frame clock; only the streams are rebuilt
+            bool hadInput = m_inputStream != nullptr || m_reopenInput;
+            closeStreams();
+            if (openStream()) {
+                m_reopenInput = false;
+                if (hadInput && !openInput(m_inputPreset, m_extraPresets, m_polyphonicInput)) {
+                    LOGE("Input stream did not come back after recovery");
+                }
+                int64_t outageMillis = (nowNanos() - m_outageStartNanos.load()) / 1000000;
+                m_lastOutageMillis.store(outageMillis);
+                m_recoveries.fetch_add(1);
+                m_state.store(STREAM_RUNNING);
+                LOGI("Stream recovered after %lld ms (%d failed attempts), resuming at frame %lld",
+                     (long long)outageMillis, m_recoveryAttempts.load(),
+                     (long long)m_engine.getFramePosition());
+                return;
+            }
+            m_recoveryAttempts.fetch_add(1);
+        }
+        
+        LOGE("Reopen failed, retrying in %d ms", delayMs);
+        std::unique_lock<std::mutex> lock(m_recoveryMutex);
+        m_recoveryWake.wait_for(lock, std::chrono::milliseconds(delayMs), [this] {
+            return m_recoveryExit || m_state.load() != STREAM_RECOVERING;
+        });
+        if (m_recoveryExit) {
+            return;
+        }
+        delayMs = std::min(delayMs * 2, RECOVERY_MAX_DELAY_MS);
+    }
+}
+
+void OboePlayer::recoverInput() {
+    {
+        std::lock_guard<std::mutex> lock(m_lifecycleMutex);
+        // The dead input is still held unless stopInput() or a reopen came first
+        if (m_state.load() != STREAM_RUNNING || !m_inputStream || m_activeInput.load()) {
+            return;
+        }
+        m_reopenInput = true;
+    }
+    
+    int delayMs = RECOVERY_FIRST_DELAY_MS;
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(m_lifecycleMutex);
+            if (!m_reopenInput || m_state.load() != STREAM_RUNNING) {
+                return;  // stopInput(), startInput() or a full recovery took over
+            }
+            if (openInput(m_inputPreset, m_extraPresets, m_polyphonicInput)) {
+                m_reopenInput = false;
+                LOGI("Input stream recovered; output kept running");
+                return;
+            }
+        }
+        
+        LOGE("Input reopen failed, retrying in %d ms", delayMs);
+        std::unique_lock<std::mutex> lock(m_recoveryMutex);
+        m_recoveryWake.wait_for(lock, std::chrono::milliseconds(delayMs), [this] {
+            return m_recoveryExit || m_recoveryPending || m_state.load() != STREAM_RUNNING;
+        });
+        if (m_recoveryExit) {
+            return;
+        }
+        if (m_recoveryPending) {
+            return;  // The loop runs the full recovery next, input included
+        }
+        delayMs = std::min(delayMs * 2, RECOVERY_MAX_DELAY_MS);
+    }
 }
@@ -3,6 +3,41 @@
  * 
  * Oboe-based low-latency audio player.
  * Provides the audio callback that renders samples from SoundFontEngine.
+ * 
+ * Optionally runs full-duplex: a mono input stream is opened at the output
+ * sample rate and read non-blocking from inside the output callback (the
+ * pattern of Oboe's FullDuplexStream), so input samples are stamped on the
+ * same frame clock as the output. The callback only copies input into one
+ * InputRing; an AnalysisWorker thread runs the pitch trackers, the onset
+ * detector and the scorer from it, so analysis never delays the output.
+ *
+ * The engine always renders at SoundFontEngine::kSampleRate. The output
+ * stream requests no rate and no Oboe conversion, so it opens at the device's
+ * native rate on the low-latency path; when that rate differs, a native
+ * polyphase Resampler bridges the two in the callback. Reopening the stream at
+ * another rate only reconfigures the resampler, never the SoundFonts. The
+ * input stream uses Oboe's converter to deliver engine-rate samples.
+ *
+ * Stream lifecycle is a small state machine (StreamState). A disconnect
+ * (headphones, Bluetooth, USB) only flags the error on Oboe's callback
+ * thread; a dedicated recovery thread reopens the streams with backoff.
+ * When only the input drops (a USB or Bluetooth mic unplugged), just the
+ * input is reopened and the output plays on.
+ * The engine is left untouched while the stream is down: its frame clock
+ * simply pauses, so scheduled events and the metronome phase resume exactly
+ * where they stopped. Each outage's duration is reported so callers can
+ * shift wall-clock expectations by it.
+ *
+ * Extra engine sessions (SessionMixer) render in the same callback and are
+ * summed into the engine's mix ahead of its master limiter and before
+ * resampling, so duels and side-by-side playback never open a second stream
+ * and never clip by adding up.
+ *
+ * The callback thread reports its cost to the scheduler each callback
+ * (PerformanceHint, Android 13+) so it gets a big core or a higher clock only
+ * while the render needs it. Older devices have nothing to report to (Oboe's
+ * own hint support needs the same API 33 calls); if enabled, they pin the
+ * callback to the fastest cores instead.
  */
 
 #ifndef MUSIMIND_OBOE_PLAYER_H
@@ -10,11 +45,51 @@
 
 #include <oboe/Oboe.h>
 #include "SoundFontEngine.h"
+#include "BufferTuner.h"
+#include "PerfCounters.h"
+#include "PerformanceHint.h"
+#include "DspKernels.h"
+#include "InputRing.h"
+#include "Resampler.h"
+#include "LatencyCalibrator.h"
+#include "AnalysisWorker.h"
+#include "NoteScorer.h"
+#include "OnsetDetector.h"
+#include "PitchTracker.h"
+#include "SessionMixer.h"
+#include "UiStateChannel.h"
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 class OboePlayer : public oboe::AudioStreamDataCallback,
                    public oboe::AudioStreamErrorCallback {
 public:
+    enum StreamState {
+        STREAM_STOPPED = 0,
+        STREAM_RUNNING = 1,
+        STREAM_RECOVERING = 2,  // Disconnected; the recovery thread is reopening
+    };
+    
+    // How the callback thread's CPU demand reaches the scheduler
+    enum HintMode {
+        HINT_NONE = 0,
+        HINT_SESSION = 1,   // APerformanceHintManager session fed every callback
+        HINT_AFFINITY = 2,  // Pinned to the fastest cores (no hint API)
+    };
+    
+    // Outage history, for diagnostics and for re-aligning wall clocks
+    struct RecoveryStats {
+        StreamState state;
+        int32_t recoveries;        // Successful reopens since creation
+        int32_t attempts;          // Failed open attempts in the current/last outage
+        int64_t lastOutageMillis;  // Duration of the last completed outage
+        int64_t frameAtOutage;     // Engine frame where the last outage began
+    };
+    
     OboePlayer();
     ~OboePlayer();
     
@@ -22,12 +97,80 @@ public:
     bool start();
     void stop();
     
+    StreamState getStreamState() const { return (StreamState)m_state.load(); }
+    RecoveryStats getRecoveryStats() const;
+    
     // Get SoundFontEngine
     SoundFontEngine& getSoundFontEngine() { return m_engine; }
     
-    // Get sample rate
+    // Further engine contexts sharing the engine's banks, mixed into this stream
+    SessionMixer& getSessions() { return m_sessions; }
+    
+    // Engine sample rate: the rate of every frame position and schedule
     int getSampleRate() const { return m_sampleRate; }
     
+    // Rate the output stream actually opened at (0 before start)
+    int getStreamSampleRate() const { return m_streamSampleRate; }
+    
+    // Output buffer size tuning from observed underruns
+    BufferTuner& getBufferTuner() { return m_bufferTuner; }
+    
+    // Callback cost counters (duration histogram, deadline load, voices)
+    PerfCounters& getPerfCounters() { return m_perfCounters; }
+    
+    // Pin the callback to the fastest cores when no hint session can be
+    // opened (off by default: it trades battery for latency). Applies from
+    // the next stream open.
+    void setAffinityFallback(bool enabled) { m_affinityFallback.store(enabled); }
+    
+    // Mode chosen for the running stream (HINT_NONE until its first callback)
+    HintMode getHintMode() const { return (HintMode)m_hintMode.load(); }
+    
+    // Publish pitch, onsets, beats and levels to a shared UI channel. The
+    // channel must outlive the player; call before start().
+    void setUiChannel(UiStateChannel* channel);
+    
+    // Open the microphone alongside the output stream and run pitch tracking
+    // and onset detection on it. The primary preset feeds scoring and the UI
+    // channel; extraPresets (AnalysisWorker::presetBit mask) tracks more
+    // presets side by side, polyphonic adds chord detection. Requires
+    // RECORD_AUDIO and a started output stream.
+    bool startInput(YinPitchDetector::Preset preset, uint32_t extraPresets = 0, bool polyphonic = false);
+    void stopInput();
+    bool isInputActive() const { return m_activeInput.load() != nullptr; }
+    
+    // Analysis thread: pitch frames per preset, onsets and backpressure stats
+    AnalysisWorker& getAnalysisWorker() { return m_analysis; }
+    
+    // Pitch frames produced from the input stream by the primary preset
+    PitchTracker& getPitchTracker() { return m_analysis.getPitchTracker(); }
+    
+    // Onsets detected in the input stream
+    OnsetDetector& getOnsetDetector() { return m_analysis.getOnsetDetector(); }
+    
+    // Exercise scoring fed by the pitch tracker and onset detector. The
+    // timeline can only be replaced while input is stopped.
+    bool loadScoringTimeline(const ScoringNote* notes, int count, int octaveOffset);
+    
+    // Score the notes still open, once the exercise is over; stopInput()
+    // does the same, a reopen or a recovery does not. Pauses the analysis
+    // worker while it runs.
+    void finishScoring();
+    NoteScorer& getNoteScorer() { return m_scorer; }
+    
+    // Measure round-trip latency with a chirp train. Requires active input.
+    bool startLatencyCalibration();
+    LatencyCalibrator& getLatencyCalibrator() { return m_calibrator; }
+    
+    // Frames subtracted from input stamps so input events line up with the
+    // output frames that were heard at the same moment
+    void setInputLatencyOffset(int32_t frames) { m_inputLatencyOffset.store(frames); }
+    int32_t getInputLatencyOffset() const { return m_inputLatencyOffset.load(); }
+    
+    // Live estimates from oboe::AudioStream::calculateLatencyMillis, -1 if unavailable
+    double getOutputLatencyMillis();
+    double getInputLatencyMillis();
+    
     // Oboe callbacks
     oboe::DataCallbackResult onAudioReady(
         oboe::AudioStream* stream,
@@ -41,13 +184,91 @@ public:
     ) override;
     
 private:
-    void reopenStream();
+    // Open and start the output stream; caller holds m_lifecycleMutex
+    bool openStream();
+    void closeStreams();
+    bool openInput(YinPitchDetector::Preset preset, uint32_t extraPresets, bool polyphonic);
+    void closeInput();
+    
+    // Recovery thread: waits for a disconnect, then reopens with backoff.
+    // recoverInput() handles an input-only disconnect without touching the output.
+    void recoveryLoop();
+    void recover();
+    void recoverInput();
+    
+    // Open the hint session or apply a fallback (first callback of a stream)
+    void startPerformanceHint();
+    
+    // Render the engine and every session into output (audio thread)
+    void renderEngines(float* output, int numFrames, int64_t framePosition);
+    
+    // Pull whatever input is ready into the ring for the analysis worker (audio thread)
+    void readInput(int numFrames, int64_t framePosition);
     
     std::shared_ptr<oboe::AudioStream> m_stream;
     SoundFontEngine m_engine;
-    int m_sampleRate = 48000;
+    SessionMixer m_sessions{m_engine};  // Declared after m_engine: sessions go first
+    
+    // Full-duplex input. The callback only touches the input stream through
+    // m_activeInput, and flags m_inputInUse while doing so, so stopInput()
+    // can close the stream without racing the callback. The worker runs
+    // exactly while input is active.
+    std::shared_ptr<oboe::AudioStream> m_inputStream;
+    std::atomic<oboe::AudioStream*> m_activeInput{nullptr};
+    std::atomic<bool> m_inputInUse{false};
+    std::atomic<bool> m_drainInput{false};
+    std::vector<float> m_inputBuffer;
+    YinPitchDetector::Preset m_inputPreset = YinPitchDetector::PRESET_VOICE;
+    uint32_t m_extraPresets = 0;
+    bool m_polyphonicInput = false;
+    InputRing m_inputRing;
+    AnalysisWorker m_analysis;
+    NoteScorer m_scorer;
+    LatencyCalibrator m_calibrator;
+    std::atomic<int32_t> m_inputLatencyOffset{0};
+    float m_inputPeak = 0.0f;  // Peak of the input read in this callback (audio thread)
+    UiStateChannel* m_uiChannel = nullptr;
+    
+    // I16 fallback: the engine renders floats here, then they are dithered down
+    bool m_outputIsInt16 = false;
+    std::vector<float> m_floatOutput;
+    DspKernels::DitherState m_dither;
+    
+    // Engine rate -> stream rate, bypassed when they match
+    Resampler m_resampler;
+    BufferTuner m_bufferTuner;
+    PerfCounters m_perfCounters;
+    int m_streamSampleRate = 0;
+    
+    // CPU hints. Set up by openStream() before the callback starts, then
+    // owned by the callback thread until closeStreams().
+    PerformanceHint m_performanceHint;
+    bool m_hintPending = false;
+    int32_t m_burstFrames = 0;
+    uint32_t m_fastCpuMask = 0;
+    std::atomic<int> m_hintMode{HINT_NONE};
+    std::atomic<bool> m_affinityFallback{false};
+    
+    int m_sampleRate = SoundFontEngine::kSampleRate;
     int m_channelCount = 2;
-    bool m_isRunning = false;
+    
+    // Lifecycle: start/stop/input changes and the recovery thread serialize
+    // on m_lifecycleMutex. The Oboe error thread only touches the atomics and
+    // the wake-up below, so it never blocks behind a slow open.
+    std::atomic<int> m_state{STREAM_STOPPED};
+    std::mutex m_lifecycleMutex;
+    std::thread m_recoveryThread;
+    std::mutex m_recoveryMutex;
+    std::condition_variable m_recoveryWake;
+    bool m_recoveryPending = false;   // Guarded by m_recoveryMutex
+    bool m_recoveryExit = false;      // Guarded by m_recoveryMutex
+    bool m_inputRecoveryPending = false;  // Guarded by m_recoveryMutex
+    bool m_reopenInput = false;       // Input lost and being reopened; guarded by m_lifecycleMutex
+    std::atomic<int64_t> m_outageStartNanos{0};
+    std::atomic<int64_t> m_frameAtOutage{0};
+    std::atomic<int64_t> m_lastOutageMillis{0};
+    std::atomic<int32_t> m_recoveries{0};
+    std::atomic<int32_t> m_recoveryAttempts{0};
 };
 
 #endif // MUSIMIND_OBOE_PLAYER_H
@@ -0,0 +1,158 @@
+/**
+ * OfflineRenderer.cpp
+ *
+ * Implementation of the offline block renderer.
+ */
+
+#include "OfflineRenderer.h"
+#include "MidiFile.h"
+#include "MidiSequencer.h"
+#include "SoundFontEngine.h"
+#include "tsf.h"
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+
+#define LOG_TAG "OfflineRenderer"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr int DRUM_CHANNEL = 9;
+
+// Note-offs before note-ons on the same frame, as in live playback
+bool earlierCommand(const AudioCommand& a, const AudioCommand& b) {
+    if (a.frame != b.frame) {
+        return a.frame < b.frame;
+    }
+    return a.type == AudioCommand::Type::NoteOff && b.type != AudioCommand::Type::NoteOff;
+}
+
+} // namespace
+
+OfflineRenderer::OfflineRenderer(tsf* soundfont, int sampleRate)
+    : m_soundfont(soundfont), m_sampleRate(sampleRate > 0 ? sampleRate : 48000) {
+    tsf_set_output(m_soundfont, TSF_STEREO_INTERLEAVED, m_sampleRate, 0.0f);
+    tsf_set_max_voices(m_soundfont, kMaxVoices);
+    // Start from General MIDI defaults: program 0, drum kit on channel 10
+    for (int channel = 0; channel < MidiSequencer::kChannelCount; channel++) {
+        tsf_channel_set_presetnumber(m_soundfont, channel, 0, channel == DRUM_CHANNEL);
+    }
+}
+
+void OfflineRenderer::setProgram(int channel, int program) {
+    tsf_channel_set_presetnumber(m_soundfont, channel, program, channel == DRUM_CHANNEL);
+}
+
+void OfflineRenderer::apply(const AudioCommand& command) {
+    switch (command.type) {
+        case AudioCommand::Type::NoteOn:
+            tsf_channel_note_on(m_soundfont, command.channel, command.data, command.value);
+            break;
+        case AudioCommand::Type::NoteOff:
+            tsf_channel_note_off(m_soundfont, command.channel, command.data);
+            break;
+        case AudioCommand::Type::SetPreset:
+            tsf_channel_set_presetnumber(m_soundfont, command.channel, command.data,
+                                         command.channel == DRUM_CHANNEL);
+            break;
+        case AudioCommand::Type::SetChannelVolume:
+            tsf_channel_set_volume(m_soundfont, command.channel, command.value);
+            break;
+        case AudioCommand::Type::SetChannelPan:
+            tsf_channel_set_pan(m_soundfont, command.channel, command.value);
+            break;
+        case AudioCommand::Type::SetChannelSustain:
+            tsf_channel_set_sustain(m_soundfont, command.channel, command.data);
+            break;
+        default:
+            break;  // Stream-only commands
+    }
+}
+
+bool OfflineRenderer::render(const NoteEvent* notes, int noteCount, MidiFile* midi, std::vector<float>& out) {
+    auto started = std::chrono::steady_clock::now();
+    
+    // Loose notes become a sorted timeline; the batch can exceed the scheduler
+    std::vector<AudioCommand> timeline;
+    timeline.reserve(std::max(0, noteCount) * 2);
+    for (int i = 0; i < noteCount; i++) {
+        const NoteEvent& note = notes[i];
+        if (note.channel < 0 || note.channel >= MidiSequencer::kChannelCount) {
+            continue;
+        }
+        int64_t start = std::max(0, note.offsetFrames);
+        timeline.push_back(AudioCommand::noteOn(note.channel, note.midiNote, note.velocity, start));
+        if (note.durationFrames > 0) {
+            timeline.push_back(AudioCommand::noteOff(note.channel, note.midiNote, start + note.durationFrames));
+        }
+    }
+    std::stable_sort(timeline.begin(), timeline.end(), earlierCommand);
+    
+    MidiSequencer sequencer;
+    sequencer.setSampleRate(m_sampleRate);
+    if (midi) {
+        sequencer.setFile(midi);
+        sequencer.play(0, m_scheduler);
+    }
+    
+    const int64_t maxFrames = (int64_t)kMaxSeconds * m_sampleRate;
+    const int64_t tailFrames = (int64_t)(kMaxTailSeconds * m_sampleRate);
+    int64_t eventsEnd = -1;
+    size_t next = 0;
+    size_t base = out.size();
+    int64_t position = 0;
+    
+    while (position < maxFrames) {
+        int64_t blockEnd = position + kBlockFrames;
+        int dropped = sequencer.generate(position, blockEnd, m_scheduler);
+        if (dropped > 0) {
+            LOGE("Offline render dropped %d MIDI events", dropped);
+        }
+        out.resize(base + (size_t)blockEnd * 2);
+        
+        // Same event splitting as the stream callback, without the arena cap
+        int64_t now = position;
+        while (now < blockEnd) {
+            AudioCommand command;
+            while (next < timeline.size() && timeline[next].frame <= now) {
+                apply(timeline[next++]);
+            }
+            while (m_scheduler.popDue(now, command)) {
+                apply(command);
+            }
+            int64_t until = std::min(blockEnd, m_scheduler.nextEventFrame());
+            if (next < timeline.size()) {
+                until = std::min(until, timeline[next].frame);
+            }
+            tsf_render_float(m_soundfont, out.data() + base + now * 2, (int)(until - now), 0);
+            now = until;
+        }
+        position = blockEnd;
+        
+        bool eventsDone = next >= timeline.size() && m_scheduler.nextEventFrame() == INT64_MAX &&
+                          !sequencer.isPlaying();
+        if (eventsDone) {
+            if (eventsEnd < 0) {
+                eventsEnd = position;
+            }
+            if (tsf_active_voice_count(m_soundfont) == 0 || position - eventsEnd >= tailFrames) {
+                break;
+            }
+        }
+    }
+    
+    // Trim trailing silence to the last audible frame
+    size_t end = out.size();
+    while (end > base && out[end - 1] == 0.0f) {
+        end--;
+    }
+    out.resize(base + (end - base + 1) / 2 * 2);
+    
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    double seconds = (double)(out.size() - base) / 2 / m_sampleRate;
+    LOGI("Rendered %.2f s offline in %.3f s (%.0fx realtime)", seconds, elapsed,
+         elapsed > 0.0 ? seconds / elapsed : 0.0);
+    return true;
+}
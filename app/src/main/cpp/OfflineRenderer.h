@@ -0,0 +1,55 @@
+/**
+ * OfflineRenderer.h
+ *
+ * Faster-than-realtime rendering of notes or a MIDI file to PCM.
+ * Runs on the caller's thread with its own TinySoundFont instance (a
+ * tsf_copy of the live bank or a freshly loaded subset), so it never
+ * touches the stream or the voices of live playback. The instance stays
+ * the caller's to close: copies share the bank's non-atomic share count,
+ * so SoundFontEngine closes them under its lock. Events are timed
+ * with the same EventScheduler and MidiSequencer as live playback, so an
+ * offline render matches what the stream would play, frame for frame.
+ */
+
+#ifndef MUSIMIND_OFFLINE_RENDERER_H
+#define MUSIMIND_OFFLINE_RENDERER_H
+
+#include "EventScheduler.h"
+#include <vector>
+
+struct tsf;
+struct NoteEvent;
+class MidiFile;
+
+class OfflineRenderer {
+public:
+    static constexpr int kBlockFrames = 4096;
+    static constexpr int kMaxVoices = 256;       // No realtime budget to protect
+    static constexpr float kMaxTailSeconds = 3.0f;  // Release tails after the last event
+    static constexpr int kMaxSeconds = 15 * 60;
+    
+    // Renders with soundfont; the caller closes it once the renderer is gone
+    OfflineRenderer(tsf* soundfont, int sampleRate);
+    
+    OfflineRenderer(const OfflineRenderer&) = delete;
+    OfflineRenderer& operator=(const OfflineRenderer&) = delete;
+    
+    // Render the notes (relative to frame 0) and/or the MIDI file (takes
+    // ownership; may be null) into interleaved stereo floats. Stops once
+    // every voice has released, trimming trailing silence.
+    bool render(const NoteEvent* notes, int noteCount, MidiFile* midi, std::vector<float>& out);
+    
+    // Program for a channel before rendering starts (MIDI program changes override it)
+    void setProgram(int channel, int program);
+    
+    int getSampleRate() const { return m_sampleRate; }
+    
+private:
+    void apply(const AudioCommand& command);
+    
+    tsf* m_soundfont;
+    int m_sampleRate;
+    EventScheduler m_scheduler;
+};
+
+#endif // MUSIMIND_OFFLINE_RENDERER_H
@@ -0,0 +1,184 @@
+/**
+ * OnsetDetector.cpp
+ *
+ * Implementation of the native spectral-flux onset detector.
+ */
+
+#include "OnsetDetector.h"
+#include "DspKernels.h"
+#include <algorithm>
+#include <cmath>
+
+constexpr int FRAME_SIZE = 1024;            // ~21ms @ 48kHz
+constexpr int HOP_SIZE = 256;               // ~5ms between flux values
+constexpr int REFINE_BLOCK = 32;            // Energy block used to place the attack
+constexpr float LOG_COMPRESSION = 100.0f;   // log(1 + C * |X|)
+constexpr float THRESHOLD_MULTIPLIER = 1.5f;
+constexpr float THRESHOLD_FLOOR = 0.005f;
+constexpr float SILENCE_RMS = 0.01f;
+constexpr float MIN_ONSET_GAP_MS = 50.0f;
+constexpr float ATTACK_FRACTION = 0.1f;      // Energy rise that marks the attack
+
+void OnsetDetector::configure(int sampleRate) {
+    m_sampleRate = sampleRate;
+    m_frameSize = FRAME_SIZE;
+    m_hopSize = HOP_SIZE;
+    m_minGapFrames = (int)(sampleRate * MIN_ONSET_GAP_MS / 1000.0f);
+    
+    m_fft = std::make_unique<RealFft>(m_frameSize);
+    m_hannWindow.resize(m_frameSize);
+    for (int i = 0; i < m_frameSize; i++) {
+        m_hannWindow[i] = 0.5f * (1.0f - std::cos(2.0f * (float)M_PI * i / (m_frameSize - 1)));
+    }
+    m_frame.assign(m_frameSize, 0.0f);
+    m_spectrum.assign(m_fft->spectrumFloats(), 0.0f);
+    m_magnitude.assign(m_frameSize / 2 + 1, 0.0f);
+    m_previousMagnitude.assign(m_frameSize / 2 + 1, 0.0f);
+    m_refineBuffer.assign(m_frameSize, 0.0f);
+    
+    std::fill(m_fluxHistory, m_fluxHistory + kFluxHistory, 0.0f);
+    m_fluxIndex = 0;
+    m_fluxSum = 0.0f;
+    m_previousFlux = 0.0f;
+    m_candidateFlux = 0.0f;
+    m_candidateThreshold = 0.0f;
+    m_candidateRms = 0.0f;
+    m_candidateStart = -1;
+    m_nextFrameStart = 0;
+    m_lastOnsetFrame = INT64_MIN / 2;
+    m_framesAnalyzed = 0;
+    m_skippedSamples.store(0, std::memory_order_relaxed);
+}
+
+void OnsetDetector::process(const InputRing& ring) {
+    if (!m_fft) {
+        return;
+    }
+    
+    skipOverwritten(ring);
+    
+    while (m_nextFrameStart + m_frameSize <= ring.writeCount()) {
+        float flux = computeFlux(ring, m_nextFrameStart);
+        if (!ring.holds(m_nextFrameStart)) {
+            // The writer lapped the frame while it was copied
+            skipOverwritten(ring);
+            continue;
+        }
+        float threshold = THRESHOLD_FLOOR + THRESHOLD_MULTIPLIER * (m_fluxSum / kFluxHistory);
+        
+        // The previous frame is an onset if it is a local flux maximum above its threshold.
+        // The first frame compares against an empty spectrum and is never an onset.
+        if (m_framesAnalyzed >= 2 &&
+            m_candidateFlux > m_candidateThreshold &&
+            m_candidateFlux >= m_previousFlux &&
+            m_candidateFlux > flux &&
+            m_candidateRms >= SILENCE_RMS) {
+            int64_t onsetIndex = refineOnset(ring, m_candidateStart);
+            int64_t onsetFrame = ring.frameOf(onsetIndex);
+            if (onsetFrame - m_lastOnsetFrame >= m_minGapFrames) {
+                publish(onsetFrame, m_candidateFlux / m_candidateThreshold);
+                m_lastOnsetFrame = onsetFrame;
+            }
+        }
+        
+        m_previousFlux = m_candidateFlux;
+        m_candidateFlux = flux;
+        m_candidateThreshold = threshold;
+        m_candidateRms = m_frameRms;
+        m_candidateStart = m_nextFrameStart;
+        
+        m_fluxSum += flux - m_fluxHistory[m_fluxIndex];
+        m_fluxHistory[m_fluxIndex] = flux;
+        m_fluxIndex = (m_fluxIndex + 1) % kFluxHistory;
+        
+        m_framesAnalyzed++;
+        m_nextFrameStart += m_hopSize;
+    }
+}
+
+float OnsetDetector::computeFlux(const InputRing& ring, int64_t start) {
+    ring.read(start, m_frame.data(), m_frameSize);
+    m_frameRms = std::sqrt(DspKernels::sumOfSquares(m_frame.data(), m_frameSize) / m_frameSize);
+    
+    DspKernels::multiply(m_frame.data(), m_hannWindow.data(), m_frame.data(), m_frameSize);
+    m_fft->forward(m_frame.data(), m_spectrum.data());
+    
+    const int bins = m_frameSize / 2 + 1;
+    DspKernels::magnitude(m_spectrum.data(), m_magnitude.data(), bins);
+    
+    // Normalize so a full-scale sine peaks near 1, then compress: quiet attacks
+    // count as much as loud ones
+    const float scale = LOG_COMPRESSION * 4.0f / m_frameSize;
+    for (int k = 0; k < bins; k++) {
+        m_magnitude[k] = std::log1p(scale * m_magnitude[k]);
+    }
+    
+    float flux = DspKernels::rectifiedDifferenceSum(m_magnitude.data(), m_previousMagnitude.data(), bins) / bins;
+    m_magnitude.swap(m_previousMagnitude);
+    return flux;
+}
+
+int64_t OnsetDetector::refineOnset(const InputRing& ring, int64_t frameStart) {
+    // The flux peaks once the attack has entered the newer half of the frame.
+    // Search there, plus one hop before it, for the first energy block that
+    // rises ATTACK_FRACTION (10%) of the way from the quietest block to the
+    // loudest: the start of the rise, where the attack is heard.
+    int64_t searchStart = std::max(ring.oldestIndex(), frameStart + m_frameSize / 2 - m_hopSize);
+    int64_t searchEnd = std::min(ring.writeCount(), frameStart + m_frameSize);
+    int blocks = (int)((searchEnd - searchStart) / REFINE_BLOCK);
+    if (blocks <= 1) {
+        return frameStart + m_frameSize / 2;
+    }
+    
+    ring.read(searchStart, m_refineBuffer.data(), blocks * REFINE_BLOCK);
+    if (!ring.holds(searchStart)) {
+        return frameStart + m_frameSize / 2;
+    }
+    
+    // Reuse the buffer head for block energies; block b's energy only depends
+    // on samples at or after index b * REFINE_BLOCK
+    float minEnergy = INFINITY;
+    float maxEnergy = 0.0f;
+    int loudest = 0;
+    for (int b = 0; b < blocks; b++) {
+        float energy = DspKernels::sumOfSquares(m_refineBuffer.data() + b * REFINE_BLOCK, REFINE_BLOCK);
+        m_refineBuffer[b] = energy;
+        if (energy > maxEnergy) {
+            maxEnergy = energy;
+            loudest = b;
+        }
+    }
+    for (int b = 0; b <= loudest; b++) {
+        minEnergy = std::min(minEnergy, m_refineBuffer[b]);
+    }
+    
+    float crossing = minEnergy + ATTACK_FRACTION * (maxEnergy - minEnergy);
+    for (int b = 0; b <= loudest; b++) {
+        if (m_refineBuffer[b] >= crossing) {
+            return searchStart + (int64_t)b * REFINE_BLOCK;
+        }
+    }
+    return searchStart + (int64_t)loudest * REFINE_BLOCK;
+}
+
+void OnsetDetector::skipOverwritten(const InputRing& ring) {
+    int64_t oldest = ring.oldestIndex();
+    if (m_nextFrameStart < oldest) {
+        m_skippedSamples.fetch_add(oldest - m_nextFrameStart, std::memory_order_relaxed);
+        m_nextFrameStart = oldest;
+        m_framesAnalyzed = 0;
+    }
+}
+
+void OnsetDetector::publish(int64_t framePosition, float strength) {
+    OnsetEvent onset = { framePosition, strength };
+    if (!m_onsets.push(onset)) {
+        m_droppedOnsets.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (m_uiChannel) {
+        m_uiChannel->publishOnset(onset);
+    }
+    if (m_scorer) {
+        m_scorer->processOnset(onset);
+    }
+}
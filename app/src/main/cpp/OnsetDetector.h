@@ -0,0 +1,112 @@
+/**
+ * OnsetDetector.h
+ *
+ * Native spectral-flux onset detector for the live input stream.
+ * Reads Hann-windowed frames from the shared InputRing every hop, takes the
+ * log-compressed magnitude spectrum with a reused RealFft, and sums the
+ * positive bin-wise change against the previous frame. A flux peak above an
+ * adaptive threshold (a multiple of the recent mean flux plus a floor) is an
+ * onset; its position is then refined to a short energy block around the
+ * attack, so onsets carry stream frame positions on the same clock as the
+ * output scheduler.
+ *
+ * Reference: "A Tutorial on Onset Detection in Music Signals", Bello et al., 2005
+ */
+
+#ifndef MUSIMIND_ONSET_DETECTOR_H
+#define MUSIMIND_ONSET_DETECTOR_H
+
+#include "InputRing.h"
+#include "LockFreeQueue.h"
+#include "NoteScorer.h"
+#include "RealFft.h"
+#include "UiStateChannel.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct OnsetEvent {
+    int64_t framePosition;  // Stream frame of the attack
+    float strength;         // Flux peak over threshold, >= 1
+};
+
+class OnsetDetector {
+public:
+    // Allocate FFT and buffers for the sample rate. Not real-time safe;
+    // only call while process() is not running.
+    void configure(int sampleRate);
+    
+    // Analyze every complete hop now available in the ring (analysis thread only)
+    void process(const InputRing& ring);
+    
+    // Also publish every onset to a shared UI channel (set while process() is not running)
+    void setUiChannel(UiStateChannel* channel) { m_uiChannel = channel; }
+    
+    // Attribute every onset to the loaded exercise (set while process() is not running)
+    void setScorer(NoteScorer* scorer) { m_scorer = scorer; }
+    
+    // Consumer side (single JNI reader)
+    bool pollOnset(OnsetEvent& onset) { return m_onsets.pop(onset); }
+    
+    bool isConfigured() const { return m_fft != nullptr; }
+    int getFrameSize() const { return m_frameSize; }
+    int getHopSize() const { return m_hopSize; }
+    uint32_t getDroppedOnsetCount() const { return m_droppedOnsets.load(std::memory_order_relaxed); }
+    
+    // Input samples the ring overwrote before they were analyzed
+    int64_t getSkippedSampleCount() const { return m_skippedSamples.load(std::memory_order_relaxed); }
+    
+private:
+    // Flux between the frame at ring index start and the previous one
+    float computeFlux(const InputRing& ring, int64_t start);
+    
+    // Ring index of the energy rise around a flux peak found in the frame at start
+    int64_t refineOnset(const InputRing& ring, int64_t frameStart);
+    
+    void publish(int64_t framePosition, float strength);
+    
+    // Move the cursor past samples the ring no longer holds; the flux after
+    // a gap compares unrelated frames, so peak picking restarts
+    void skipOverwritten(const InputRing& ring);
+    
+    int m_sampleRate = 48000;
+    int m_frameSize = 0;
+    int m_hopSize = 0;
+    int m_minGapFrames = 0;
+    
+    std::unique_ptr<RealFft> m_fft;
+    std::vector<float> m_hannWindow;
+    std::vector<float> m_frame;
+    std::vector<float> m_spectrum;
+    std::vector<float> m_magnitude;
+    std::vector<float> m_previousMagnitude;
+    std::vector<float> m_refineBuffer;
+    
+    // Recent flux values for the adaptive threshold (circular)
+    static constexpr int kFluxHistory = 16;
+    float m_fluxHistory[kFluxHistory] = {};
+    int m_fluxIndex = 0;
+    float m_fluxSum = 0.0f;
+    
+    // Peak picking needs one frame of look-ahead
+    float m_previousFlux = 0.0f;
+    float m_candidateFlux = 0.0f;
+    float m_candidateThreshold = 0.0f;
+    float m_candidateRms = 0.0f;
+    int64_t m_candidateStart = -1;
+    
+    int64_t m_nextFrameStart = 0;  // Ring index of the next frame's first sample
+    int64_t m_lastOnsetFrame = INT64_MIN / 2;
+    int m_framesAnalyzed = 0;
+    float m_frameRms = 0.0f;
+    
+    static constexpr size_t kOnsetQueueSize = 64;
+    LockFreeQueue<OnsetEvent, kOnsetQueueSize> m_onsets;
+    std::atomic<uint32_t> m_droppedOnsets{0};
+    std::atomic<int64_t> m_skippedSamples{0};
+    UiStateChannel* m_uiChannel = nullptr;
+    NoteScorer* m_scorer = nullptr;
+};
+
+#endif // MUSIMIND_ONSET_DETECTOR_H
@@ -0,0 +1,77 @@
+/**
+ * PerfCounters.cpp
+ *
+ * Implementation of the audio callback cost counters.
+ */
+
+#include "PerfCounters.h"
+
+namespace {
+
+// Single-writer increment: the audio thread owns every counter
+template <typename T>
+inline void bump(std::atomic<T>& counter, T amount = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+template <typename T>
+inline void raise(std::atomic<T>& counter, T value) {
+    if (value > counter.load(std::memory_order_relaxed)) {
+        counter.store(value, std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+void PerfCounters::reset() {
+    m_callbacks.store(0, std::memory_order_relaxed);
+    m_overruns.store(0, std::memory_order_relaxed);
+    m_maxNanos.store(0, std::memory_order_relaxed);
+    m_totalNanos.store(0, std::memory_order_relaxed);
+    m_maxLoad.store(0, std::memory_order_relaxed);
+    m_totalLoad.store(0, std::memory_order_relaxed);
+    m_maxVoices.store(0, std::memory_order_relaxed);
+    for (auto& bucket : m_histogram) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void PerfCounters::record(int64_t durationNanos, int64_t deadlineNanos, int voices) {
+    if (m_resetPending.load(std::memory_order_relaxed)) {
+        m_resetPending.store(false, std::memory_order_relaxed);
+        reset();
+    }
+    
+    int bucket = 0;
+    for (int64_t edge = kFirstBucketNanos; durationNanos >= edge && bucket < kHistogramBuckets - 1; edge *= 2) {
+        bucket++;
+    }
+    bump(m_histogram[bucket]);
+    
+    int32_t load = deadlineNanos > 0 ? (int32_t)(durationNanos * 1000 / deadlineNanos) : 0;
+    bump(m_callbacks);
+    bump(m_totalNanos, durationNanos);
+    bump(m_totalLoad, (int64_t)load);
+    if (durationNanos > deadlineNanos) {
+        bump(m_overruns);
+    }
+    raise(m_maxNanos, durationNanos);
+    raise(m_maxLoad, load);
+    raise(m_maxVoices, (int32_t)voices);
+}
+
+PerfCounters::Snapshot PerfCounters::snapshot() const {
+    Snapshot snapshot;
+    int64_t callbacks = m_callbacks.load(std::memory_order_relaxed);
+    snapshot.callbacks = callbacks;
+    snapshot.overruns = m_overruns.load(std::memory_order_relaxed);
+    snapshot.maxNanos = m_maxNanos.load(std::memory_order_relaxed);
+    snapshot.meanNanos = callbacks > 0 ? m_totalNanos.load(std::memory_order_relaxed) / callbacks : 0;
+    snapshot.maxLoadPermille = m_maxLoad.load(std::memory_order_relaxed);
+    snapshot.meanLoadPermille = callbacks > 0 ? (int32_t)(m_totalLoad.load(std::memory_order_relaxed) / callbacks) : 0;
+    snapshot.maxVoices = m_maxVoices.load(std::memory_order_relaxed);
+    for (int i = 0; i < kHistogramBuckets; i++) {
+        snapshot.histogram[i] = m_histogram[i].load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
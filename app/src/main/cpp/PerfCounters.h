@@ -0,0 +1,61 @@
+/**
+ * PerfCounters.h
+ *
+ * Lock-free cost counters for the audio callback.
+ *
+ * The audio thread is the only writer: record() does plain relaxed loads and
+ * stores on atomics (no read-modify-write, no logging, no allocation), so the
+ * overhead is a few loads and stores per callback. Any thread can take a
+ * snapshot; values from one callback may be torn across fields, which is
+ * fine for analytics. A reset is requested from outside and carried out by
+ * the audio thread on its next record().
+ */
+
+#ifndef MUSIMIND_PERF_COUNTERS_H
+#define MUSIMIND_PERF_COUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+
+class PerfCounters {
+public:
+    // Callback duration buckets: [0, 64 us), [64, 128 us), ... doubling,
+    // the last one open-ended (>= 65 ms)
+    static constexpr int kHistogramBuckets = 12;
+    static constexpr int64_t kFirstBucketNanos = 64000;
+    
+    struct Snapshot {
+        int64_t callbacks;
+        int64_t overruns;          // Callbacks that took longer than their deadline
+        int64_t maxNanos;
+        int64_t meanNanos;
+        int32_t maxLoadPermille;   // Duration / deadline, in 1/1000
+        int32_t meanLoadPermille;
+        int32_t maxVoices;
+        int64_t histogram[kHistogramBuckets];
+    };
+    
+    // Audio thread, once per callback. deadlineNanos is the audio the callback
+    // produced (numFrames / sample rate): spending more than that underruns.
+    void record(int64_t durationNanos, int64_t deadlineNanos, int voices);
+    
+    Snapshot snapshot() const;
+    
+    // Any thread: zero the counters on the next record()
+    void requestReset() { m_resetPending.store(true, std::memory_order_relaxed); }
+    
+private:
+    void reset();
+    
+    std::atomic<bool> m_resetPending{false};
+    std::atomic<int64_t> m_callbacks{0};
+    std::atomic<int64_t> m_overruns{0};
+    std::atomic<int64_t> m_maxNanos{0};
+    std::atomic<int64_t> m_totalNanos{0};
+    std::atomic<int32_t> m_maxLoad{0};
+    std::atomic<int64_t> m_totalLoad{0};
+    std::atomic<int32_t> m_maxVoices{0};
+    std::atomic<int64_t> m_histogram[kHistogramBuckets] = {};
+};
+
+#endif // MUSIMIND_PERF_COUNTERS_H
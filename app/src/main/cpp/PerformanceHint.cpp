@@ -0,0 +1,145 @@
+/**
+ * PerformanceHint.cpp
+ *
+ * Implementation of the CPU performance hints.
+ */
+
+#include "PerformanceHint.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cstdio>
+#include <dlfcn.h>
+#include <mutex>
+#include <sched.h>
+#include <unistd.h>
+
+#define LOG_TAG "PerformanceHint"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr int MAX_CPUS = 32;
+
+// android/performance_hint.h, API 33
+using GetManagerFn = void* (*)();
+using CreateSessionFn = void* (*)(void* manager, const int32_t* threadIds, size_t size, int64_t targetNanos);
+using ReportActualFn = int (*)(void* session, int64_t actualNanos);
+using CloseSessionFn = void (*)(void* session);
+
+struct HintApi {
+    GetManagerFn getManager = nullptr;
+    CreateSessionFn createSession = nullptr;
+    ReportActualFn reportActual = nullptr;
+    CloseSessionFn closeSession = nullptr;
+    void* manager = nullptr;
+};
+
+HintApi g_api;
+std::once_flag g_apiOnce;
+
+const HintApi& api() {
+    std::call_once(g_apiOnce, [] {
+        // Already loaded by the process; the handle is never closed
+        void* library = dlopen("libandroid.so", RTLD_NOW | RTLD_NOLOAD);
+        if (!library) {
+            library = dlopen("libandroid.so", RTLD_NOW);
+        }
+        if (!library) {
+            return;
+        }
+        HintApi loaded;
+        loaded.getManager = (GetManagerFn)dlsym(library, "APerformanceHint_getManager");
+        loaded.createSession = (CreateSessionFn)dlsym(library, "APerformanceHint_createSession");
+        loaded.reportActual = (ReportActualFn)dlsym(library, "APerformanceHint_reportActualWorkDuration");
+        loaded.closeSession = (CloseSessionFn)dlsym(library, "APerformanceHint_closeSession");
+        if (!loaded.getManager || !loaded.createSession || !loaded.reportActual || !loaded.closeSession) {
+            LOGI("Performance hint API not available");
+            return;
+        }
+        loaded.manager = loaded.getManager();
+        if (loaded.manager) {
+            g_api = loaded;
+        }
+    });
+    return g_api;
+}
+
+} // namespace
+
+bool PerformanceHint::isSupported() {
+    return api().manager != nullptr;
+}
+
+bool PerformanceHint::open(int64_t targetNanos) {
+    close();
+    const HintApi& hint = api();
+    if (!hint.manager || targetNanos <= 0) {
+        return false;
+    }
+    int32_t tid = gettid();
+    m_session = hint.createSession(hint.manager, &tid, 1, targetNanos);
+    return m_session != nullptr;
+}
+
+void PerformanceHint::close() {
+    if (m_session) {
+        api().closeSession(m_session);
+        m_session = nullptr;
+    }
+}
+
+void PerformanceHint::reportActualWork(int64_t durationNanos) {
+    // A session implies the API was loaded, so skip api()'s once-check
+    if (m_session && durationNanos > 0) {
+        g_api.reportActual(m_session, durationNanos);
+    }
+}
+
+uint32_t PerformanceHint::fastestCpuMask() {
+    long cpus = std::min<long>(sysconf(_SC_NPROCESSORS_CONF), MAX_CPUS);
+    long frequencies[MAX_CPUS] = {};
+    long fastest = 0;
+    long slowest = 0;
+    for (long cpu = 0; cpu < cpus; cpu++) {
+        char path[96];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%ld/cpufreq/cpuinfo_max_freq", cpu);
+        FILE* file = fopen(path, "r");
+        if (!file) {
+            continue;
+        }
+        if (fscanf(file, "%ld", &frequencies[cpu]) != 1) {
+            frequencies[cpu] = 0;
+        }
+        fclose(file);
+        fastest = std::max(fastest, frequencies[cpu]);
+        if (frequencies[cpu] > 0 && (slowest == 0 || frequencies[cpu] < slowest)) {
+            slowest = frequencies[cpu];
+        }
+    }
+    if (fastest == 0 || fastest == slowest) {
+        return 0;
+    }
+    
+    uint32_t mask = 0;
+    for (long cpu = 0; cpu < cpus; cpu++) {
+        if (frequencies[cpu] == fastest) {
+            mask |= 1u << cpu;
+        }
+    }
+    return mask;
+}
+
+bool PerformanceHint::pinCurrentThread(uint32_t mask) {
+    if (mask == 0) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu = 0; cpu < MAX_CPUS; cpu++) {
+        if (mask & (1u << cpu)) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
@@ -0,0 +1,58 @@
+/**
+ * PerformanceHint.h
+ *
+ * CPU performance hints for the audio threads.
+ *
+ * On Android 13+ (API 33) an APerformanceHintManager session tells the
+ * scheduler how long each callback took against its target (the burst
+ * period), so the kernel can raise the frequency or move the thread to a
+ * bigger core just before a voice spike underruns, and let it idle on a
+ * little core otherwise. The NDK entry points are resolved at run time,
+ * since minSdk predates them.
+ *
+ * Where the hint API is missing there is no other channel (Oboe's hint
+ * support resolves the same calls); the fallback is pinning a thread to the
+ * fastest cluster, which keeps latency down at the cost of battery.
+ */
+
+#ifndef MUSIMIND_PERFORMANCE_HINT_H
+#define MUSIMIND_PERFORMANCE_HINT_H
+
+#include <cstdint>
+
+class PerformanceHint {
+public:
+    PerformanceHint() = default;
+    ~PerformanceHint() { close(); }
+    
+    PerformanceHint(const PerformanceHint&) = delete;
+    PerformanceHint& operator=(const PerformanceHint&) = delete;
+    
+    // Whether the NDK hint API is available. Resolves it on first call
+    // (dlopen); not real-time safe, call before the stream runs.
+    static bool isSupported();
+    
+    // Open a session for the calling thread. The thread id has to be the
+    // callback's own, so like Oboe's AdpfWrapper this runs once on the
+    // first callback; it is a one-off binder call, not per-callback work.
+    bool open(int64_t targetNanos);
+    
+    // Release the session; only once the thread stopped reporting
+    void close();
+    
+    bool isOpen() const { return m_session != nullptr; }
+    
+    // Session thread, once per callback
+    void reportActualWork(int64_t durationNanos);
+    
+    // Cores of the fastest cluster, 0 when all cores are alike or unknown
+    static uint32_t fastestCpuMask();
+    
+    // Restrict the calling thread to the cores in mask
+    static bool pinCurrentThread(uint32_t mask);
+    
+private:
+    void* m_session = nullptr;  // APerformanceHintSession*
+};
+
+#endif // MUSIMIND_PERFORMANCE_HINT_H
@@ -0,0 +1,54 @@
+/**
+ * PitchTracker.cpp
+ *
+ * Implementation of the live pitch tracker.
+ */
+
+#include "PitchTracker.h"
+#include <algorithm>
+
+void PitchTracker::configure(YinPitchDetector::Preset preset, int sampleRate) {
+    m_detector = std::make_unique<YinPitchDetector>(YinPitchDetector::forPreset(preset, sampleRate));
+    m_window.assign(m_detector->getWindowSize(), 0.0f);
+    m_nextWindowStart = 0;
+    m_skippedSamples.store(0, std::memory_order_relaxed);
+}
+
+void PitchTracker::process(const InputRing& ring) {
+    if (!m_detector) {
+        return;
+    }
+    
+    const int windowSize = m_detector->getWindowSize();
+    const int hopSize = m_detector->getHopSize();
+    
+    skipOverwritten(ring);
+    
+    while (m_nextWindowStart + windowSize <= ring.writeCount()) {
+        ring.read(m_nextWindowStart, m_window.data(), windowSize);
+        if (!ring.holds(m_nextWindowStart)) {
+            // The writer lapped the window while it was copied
+            skipOverwritten(ring);
+            continue;
+        }
+        PitchFrame frame = m_detector->detect(m_window.data(), ring.frameOf(m_nextWindowStart));
+        if (m_queueEnabled.load(std::memory_order_relaxed) && !m_frames.push(frame)) {
+            m_droppedFrames.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (m_uiChannel) {
+            m_uiChannel->publishPitch(frame);
+        }
+        if (m_scorer) {
+            m_scorer->processPitch(frame);
+        }
+        m_nextWindowStart += hopSize;
+    }
+}
+
+void PitchTracker::skipOverwritten(const InputRing& ring) {
+    int64_t oldest = ring.oldestIndex();
+    if (m_nextWindowStart < oldest) {
+        m_skippedSamples.fetch_add(oldest - m_nextWindowStart, std::memory_order_relaxed);
+        m_nextWindowStart = oldest;
+    }
+}
@@ -0,0 +1,69 @@
+/**
+ * PitchTracker.h
+ *
+ * Runs YinPitchDetector over the live input stream.
+ * Reads a window from the shared InputRing every hop and publishes
+ * PitchFrames stamped with stream frame positions through a lock-free queue
+ * for the JNI side to drain, and optionally to a shared UiStateChannel. When
+ * the channel is the only reader, the queue can be turned off so unread
+ * frames do not pile up as drops.
+ */
+
+#ifndef MUSIMIND_PITCH_TRACKER_H
+#define MUSIMIND_PITCH_TRACKER_H
+
+#include "InputRing.h"
+#include "LockFreeQueue.h"
+#include "NoteScorer.h"
+#include "UiStateChannel.h"
+#include "YinPitchDetector.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class PitchTracker {
+public:
+    // Allocate detector and window for a preset. Not real-time safe;
+    // only call while process() is not running.
+    void configure(YinPitchDetector::Preset preset, int sampleRate);
+    
+    // Analyze every complete hop now available in the ring (analysis thread only)
+    void process(const InputRing& ring);
+    
+    // Also publish every frame to a shared UI channel (set while process() is not running)
+    void setUiChannel(UiStateChannel* channel) { m_uiChannel = channel; }
+    
+    // Score every frame against the loaded exercise (set while process() is not running)
+    void setScorer(NoteScorer* scorer) { m_scorer = scorer; }
+    
+    // Consumer side (single JNI reader)
+    bool pollFrame(PitchFrame& frame) { return m_frames.pop(frame); }
+    
+    // Stop or resume filling the JNI queue (any thread); on by default
+    void setQueueEnabled(bool enabled) { m_queueEnabled.store(enabled, std::memory_order_relaxed); }
+    
+    bool isConfigured() const { return m_detector != nullptr; }
+    int getWindowSize() const { return m_detector ? m_detector->getWindowSize() : 0; }
+    uint32_t getDroppedFrameCount() const { return m_droppedFrames.load(std::memory_order_relaxed); }
+    
+    // Input samples the ring overwrote before they were analyzed
+    int64_t getSkippedSampleCount() const { return m_skippedSamples.load(std::memory_order_relaxed); }
+    
+private:
+    std::unique_ptr<YinPitchDetector> m_detector;
+    std::vector<float> m_window;   // Contiguous copy of the window for detect()
+    int64_t m_nextWindowStart = 0; // Ring index of the next window's first sample
+    
+    // Move the cursor past samples the ring no longer holds
+    void skipOverwritten(const InputRing& ring);
+    
+    static constexpr size_t kFrameQueueSize = 128;
+    LockFreeQueue<PitchFrame, kFrameQueueSize> m_frames;
+    std::atomic<bool> m_queueEnabled{true};
+    std::atomic<uint32_t> m_droppedFrames{0};
+    std::atomic<int64_t> m_skippedSamples{0};
+    UiStateChannel* m_uiChannel = nullptr;
+    NoteScorer* m_scorer = nullptr;
+};
+
+#endif // MUSIMIND_PITCH_TRACKER_H
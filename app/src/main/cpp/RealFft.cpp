@@ -0,0 +1,125 @@
+/**
+ * RealFft.cpp
+ *
+ * Implementation of the real-input radix-2 FFT.
+ */
+
+#include "RealFft.h"
+#include <cmath>
+#include <utility>
+
+RealFft::RealFft(int size)
+    : m_size(size),
+      m_half(size / 2),
+      m_bitReverse(size / 2),
+      m_twiddles(size / 2),
+      m_splitTwiddles((size / 2 + 1) * 2),
+      m_work(size) {
+    int bits = 0;
+    while ((1 << bits) < m_half) {
+        bits++;
+    }
+    for (int i = 0; i < m_half; i++) {
+        int reversed = 0;
+        for (int b = 0; b < bits; b++) {
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        m_bitReverse[i] = reversed;
+    }
+    
+    for (int k = 0; k < m_half / 2; k++) {
+        double angle = -2.0 * M_PI * k / m_half;
+        m_twiddles[2 * k] = (float)std::cos(angle);
+        m_twiddles[2 * k + 1] = (float)std::sin(angle);
+    }
+    
+    for (int k = 0; k <= m_half; k++) {
+        double angle = -2.0 * M_PI * k / m_size;
+        m_splitTwiddles[2 * k] = (float)std::cos(angle);
+        m_splitTwiddles[2 * k + 1] = (float)std::sin(angle);
+    }
+}
+
+void RealFft::complexFft(float* data, bool inverse) const {
+    const int n = m_half;
+    
+    for (int i = 0; i < n; i++) {
+        int j = m_bitReverse[i];
+        if (j > i) {
+            std::swap(data[2 * i], data[2 * j]);
+            std::swap(data[2 * i + 1], data[2 * j + 1]);
+        }
+    }
+    
+    const float sign = inverse ? -1.0f : 1.0f;
+    for (int length = 2; length <= n; length <<= 1) {
+        int halfLength = length >> 1;
+        int stride = n / length;
+        for (int start = 0; start < n; start += length) {
+            for (int k = 0; k < halfLength; k++) {
+                float wr = m_twiddles[2 * k * stride];
+                float wi = sign * m_twiddles[2 * k * stride + 1];
+                
+                float* a = data + 2 * (start + k);
+                float* b = data + 2 * (start + k + halfLength);
+                float tr = b[0] * wr - b[1] * wi;
+                float ti = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+
+void RealFft::forward(const float* input, float* spectrum) {
+    // Pack even samples into the real part and odd samples into the imaginary part
+    float* z = m_work.data();
+    for (int n = 0; n < m_half; n++) {
+        z[2 * n] = input[2 * n];
+        z[2 * n + 1] = input[2 * n + 1];
+    }
+    complexFft(z, false);
+    
+    // Split: X[k] = E[k] + W^k O[k], with E/O recovered from Z[k] and conj(Z[M-k])
+    for (int k = 0; k <= m_half; k++) {
+        int i = k % m_half;
+        int j = (m_half - k) % m_half;
+        float zr = z[2 * i], zi = z[2 * i + 1];
+        float cr = z[2 * j], ci = -z[2 * j + 1];
+        
+        float er = 0.5f * (zr + cr), ei = 0.5f * (zi + ci);
+        // O = (Z - conj(Z[M-k])) / 2i
+        float or_ = 0.5f * (zi - ci), oi = -0.5f * (zr - cr);
+        
+        float wr = m_splitTwiddles[2 * k], wi = m_splitTwiddles[2 * k + 1];
+        spectrum[2 * k] = er + (or_ * wr - oi * wi);
+        spectrum[2 * k + 1] = ei + (or_ * wi + oi * wr);
+    }
+}
+
+void RealFft::inverse(const float* spectrum, float* output) {
+    // Rebuild Z[k] = E[k] + i O[k] from X[k] and conj(X[M-k])
+    float* z = m_work.data();
+    for (int k = 0; k < m_half; k++) {
+        float xr = spectrum[2 * k], xi = spectrum[2 * k + 1];
+        float cr = spectrum[2 * (m_half - k)], ci = -spectrum[2 * (m_half - k) + 1];
+        
+        float er = 0.5f * (xr + cr), ei = 0.5f * (xi + ci);
+        // O = (X - conj(X[M-k])) * conj(W^k) / 2
+        float dr = 0.5f * (xr - cr), di = 0.5f * (xi - ci);
+        float wr = m_splitTwiddles[2 * k], wi = -m_splitTwiddles[2 * k + 1];
+        float or_ = dr * wr - di * wi, oi = dr * wi + di * wr;
+        
+        z[2 * k] = er - oi;
+        z[2 * k + 1] = ei + or_;
+    }
+    complexFft(z, true);
+    
+    const float scale = 1.0f / m_half;
+    for (int n = 0; n < m_half; n++) {
+        output[2 * n] = z[2 * n] * scale;
+        output[2 * n + 1] = z[2 * n + 1] * scale;
+    }
+}
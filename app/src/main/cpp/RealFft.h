@@ -0,0 +1,42 @@
+/**
+ * RealFft.h
+ *
+ * Radix-2 FFT for real signals. A length-N real transform is computed as a
+ * length-N/2 complex FFT plus a split step, with twiddles and the bit-reversal
+ * table precomputed in the constructor. forward()/inverse() never allocate.
+ *
+ * Spectra are interleaved complex (re, im) with N/2 + 1 bins, i.e. N + 2 floats.
+ */
+
+#ifndef MUSIMIND_REAL_FFT_H
+#define MUSIMIND_REAL_FFT_H
+
+#include <vector>
+
+class RealFft {
+public:
+    // size must be a power of two, >= 4
+    explicit RealFft(int size);
+    
+    // input: size real samples -> spectrum: size + 2 floats
+    void forward(const float* input, float* spectrum);
+    
+    // spectrum: size + 2 floats -> output: size real samples (scaled, so inverse(forward(x)) == x)
+    void inverse(const float* spectrum, float* output);
+    
+    int size() const { return m_size; }
+    int spectrumFloats() const { return m_size + 2; }
+    
+private:
+    // In-place complex FFT of m_half points on interleaved data
+    void complexFft(float* data, bool inverse) const;
+    
+    int m_size;
+    int m_half;
+    std::vector<int> m_bitReverse;     // m_half entries
+    std::vector<float> m_twiddles;     // m_half / 2 complex, e^{-2*pi*i*k/m_half}
+    std::vector<float> m_splitTwiddles; // m_half + 1 complex, e^{-2*pi*i*k/m_size}
+    std::vector<float> m_work;         // m_half complex
+};
+
+#endif // MUSIMIND_REAL_FFT_H
@@ -0,0 +1,97 @@
+/**
+ * RealtimeGuard.cpp
+ *
+ * Debug-build allocation hooks for the audio callback.
+ */
+
+#include "RealtimeGuard.h"
+
+#ifndef NDEBUG
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static thread_local int t_guardDepth = 0;
+static std::atomic<uint32_t> s_allocationCount{0};
+static std::atomic<size_t> s_allocatedBytes{0};
+
+RealtimeGuard::RealtimeGuard() {
+    t_guardDepth++;
+}
+
+RealtimeGuard::~RealtimeGuard() {
+    t_guardDepth--;
+}
+
+bool RealtimeGuard::isActive() {
+    return t_guardDepth > 0;
+}
+
+uint32_t RealtimeGuard::getAllocationCount() {
+    return s_allocationCount.load(std::memory_order_relaxed);
+}
+
+size_t RealtimeGuard::getAllocatedBytes() {
+    return s_allocatedBytes.load(std::memory_order_relaxed);
+}
+
+void RealtimeGuard::recordAllocation(size_t size) {
+    if (t_guardDepth > 0) {
+        // No logging here - we are on the audio thread. OboePlayer reports the counters.
+        s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+        s_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+}
+
+void* RealtimeGuard::trackedMalloc(size_t size) {
+    recordAllocation(size);
+    return malloc(size);
+}
+
+void* RealtimeGuard::trackedRealloc(void* ptr, size_t size) {
+    recordAllocation(size);
+    return realloc(ptr, size);
+}
+
+// Global operator new replacements (debug builds only)
+
+void* operator new(size_t size) {
+    RealtimeGuard::recordAllocation(size);
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    RealtimeGuard::recordAllocation(size);
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+#endif // NDEBUG
@@ -0,0 +1,47 @@
+/**
+ * RealtimeGuard.h
+ *
+ * Debug-build detector for heap allocations on the audio thread.
+ *
+ * A RealtimeGuard marks the current thread as being inside the audio callback.
+ * In debug builds the global operator new and TinySoundFont's allocator are
+ * routed through RealtimeGuard::trackedMalloc/trackedRealloc, which count every
+ * allocation made while a guard is alive. Release builds compile all of this
+ * away.
+ */
+
+#ifndef MUSIMIND_REALTIME_GUARD_H
+#define MUSIMIND_REALTIME_GUARD_H
+
+#include <cstddef>
+#include <cstdint>
+
+class RealtimeGuard {
+public:
+#ifndef NDEBUG
+    RealtimeGuard();
+    ~RealtimeGuard();
+    
+    // True while the calling thread is inside a guarded callback
+    static bool isActive();
+    
+    // Allocation counters (any thread)
+    static uint32_t getAllocationCount();
+    static size_t getAllocatedBytes();
+    
+    // Hooked allocators - count allocations made inside a guarded callback
+    static void* trackedMalloc(size_t size);
+    static void* trackedRealloc(void* ptr, size_t size);
+    static void recordAllocation(size_t size);
+#else
+    RealtimeGuard() {}
+    static bool isActive() { return false; }
+    static uint32_t getAllocationCount() { return 0; }
+    static size_t getAllocatedBytes() { return 0; }
+#endif
+    
+    RealtimeGuard(const RealtimeGuard&) = delete;
+    RealtimeGuard& operator=(const RealtimeGuard&) = delete;
+};
+
+#endif // MUSIMIND_REALTIME_GUARD_H
@@ -0,0 +1,47 @@
+/**
+ * RenderArena.cpp
+ *
+ * Implementation of the render scratch arena.
+ */
+
+#include "RenderArena.h"
+#include <android/log.h>
+#include <cstdlib>
+#include <cstring>
+
+#define LOG_TAG "RenderArena"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+void RenderArena::AlignedDeleter::operator()(float* p) const {
+    free(p);
+}
+
+void RenderArena::allocate(int maxFrames, int channelCount) {
+    if (m_storage && maxFrames <= m_maxFrames && channelCount == m_channelCount) {
+        return;
+    }
+    
+    // Round each bus up to a whole number of cache lines
+    size_t busFloats = (size_t)maxFrames * channelCount;
+    size_t floatsPerLine = kAlignment / sizeof(float);
+    busFloats = (busFloats + floatsPerLine - 1) / floatsPerLine * floatsPerLine;
+    size_t totalBytes = busFloats * BUS_COUNT * sizeof(float);
+    
+    void* memory = nullptr;
+    if (posix_memalign(&memory, kAlignment, totalBytes) != 0) {
+        LOGE("Failed to allocate render arena (%zu bytes)", totalBytes);
+        return;
+    }
+    memset(memory, 0, totalBytes);
+    
+    m_storage.reset(static_cast<float*>(memory));
+    for (int i = 0; i < BUS_COUNT; i++) {
+        m_buses[i] = m_storage.get() + busFloats * i;
+    }
+    m_maxFrames = maxFrames;
+    m_channelCount = channelCount;
+    
+    LOGI("Render arena allocated: maxFrames=%d, channels=%d, buses=%d, bytes=%zu",
+         maxFrames, channelCount, (int)BUS_COUNT, totalBytes);
+}
@@ -0,0 +1,53 @@
+/**
+ * RenderArena.h
+ *
+ * Preallocated scratch memory for the audio callback.
+ * Sized once from the stream's maximum callback size when the stream opens,
+ * so render() never touches the heap.
+ */
+
+#ifndef MUSIMIND_RENDER_ARENA_H
+#define MUSIMIND_RENDER_ARENA_H
+
+#include <cstddef>
+#include <memory>
+
+class RenderArena {
+public:
+    // Scratch buses available to the render path
+    enum Bus {
+        BUS_INSTRUMENT = 0,  // Piano and MIDI file playback
+        BUS_METRONOME,
+        BUS_PROMPT,          // Cached exercise prompts
+        BUS_SFX,             // Feedback sounds
+        BUS_COUNT
+    };
+    
+    RenderArena() = default;
+    RenderArena(const RenderArena&) = delete;
+    RenderArena& operator=(const RenderArena&) = delete;
+    
+    // Allocate (or grow) storage. Not real-time safe - call before the stream starts.
+    void allocate(int maxFrames, int channelCount);
+    
+    // Interleaved scratch buffer for a bus, holding maxFrames() frames
+    float* bus(Bus bus) const { return m_buses[bus]; }
+    
+    int maxFrames() const { return m_maxFrames; }
+    int channelCount() const { return m_channelCount; }
+    bool isAllocated() const { return m_storage != nullptr; }
+    
+private:
+    static constexpr size_t kAlignment = 64;  // Cache line
+    
+    struct AlignedDeleter {
+        void operator()(float* p) const;
+    };
+    
+    std::unique_ptr<float, AlignedDeleter> m_storage;
+    float* m_buses[BUS_COUNT] = {};
+    int m_maxFrames = 0;
+    int m_channelCount = 0;
+};
+
+#endif // MUSIMIND_RENDER_ARENA_H
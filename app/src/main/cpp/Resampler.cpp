@@ -0,0 +1,118 @@
+/**
+ * Resampler.cpp
+ *
+ * Implementation of the streaming polyphase resampler.
+ */
+
+#include "Resampler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr double KAISER_BETA = 8.0;     // ~80 dB stopband
+constexpr double CUTOFF_MARGIN = 0.92;  // Passband edge as a fraction of the lower Nyquist
+
+// Zeroth-order modified Bessel function of the first kind (series)
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    double quarter = x * x / 4.0;
+    for (int k = 1; k < 32; k++) {
+        term *= quarter / ((double)k * k);
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+} // namespace
+
+void Resampler::configure(int inputRate, int outputRate, int maxOutputFrames) {
+    m_inputRate = inputRate > 0 ? inputRate : 48000;
+    m_outputRate = outputRate > 0 ? outputRate : m_inputRate;
+    m_step = (double)m_inputRate / m_outputRate;
+    m_maxInputFrames = (int)std::ceil(std::max(1, maxOutputFrames) * m_step) + kTaps + 1;
+    
+    // Tap k of phase p sits (k - (kTaps/2 - 1) - p/kPhases) input frames from the output instant
+    double cutoff = std::min(1.0, (double)m_outputRate / m_inputRate) * CUTOFF_MARGIN;
+    double normalizer = besselI0(KAISER_BETA);
+    m_filter.assign((size_t)(kPhases + 1) * kTaps, 0.0f);
+    for (int phase = 0; phase <= kPhases; phase++) {
+        double fraction = (double)phase / kPhases;
+        double taps[kTaps];
+        double sum = 0.0;
+        for (int k = 0; k < kTaps; k++) {
+            double t = (k - (kTaps / 2 - 1)) - fraction;
+            double x = M_PI * cutoff * t;
+            double sinc = std::fabs(x) < 1e-9 ? 1.0 : std::sin(x) / x;
+            double r = t / (kTaps / 2);
+            double window = std::fabs(r) < 1.0 ? besselI0(KAISER_BETA * std::sqrt(1.0 - r * r)) / normalizer : 0.0;
+            taps[k] = sinc * window;
+            sum += taps[k];
+        }
+        // Unity DC gain for every phase, so fractional steps do not ripple
+        for (int k = 0; k < kTaps; k++) {
+            m_filter[(size_t)phase * kTaps + k] = (float)(taps[k] / sum);
+        }
+    }
+    
+    m_input.assign((size_t)(m_maxInputFrames + kTaps * 2) * 2, 0.0f);
+    reset();
+}
+
+void Resampler::reset() {
+    std::fill(m_input.begin(), m_input.end(), 0.0f);
+    // Silent history so the first output is centred on the first input frame
+    m_inputFrames = kTaps / 2 - 1;
+    m_position = 0.0;
+}
+
+int Resampler::getInputFramesNeeded(int outputFrames) const {
+    if (outputFrames <= 0) {
+        return 0;
+    }
+    double last = m_position + (outputFrames - 1) * m_step;
+    int needed = (int)last + kTaps - m_inputFrames;
+    return std::max(0, std::min(m_maxInputFrames, needed));
+}
+
+void Resampler::process(int inputFrames, float* output, int outputFrames) {
+    m_inputFrames += std::max(0, inputFrames);
+    
+    for (int frame = 0; frame < outputFrames; frame++) {
+        int index = (int)m_position;
+        if (index + kTaps > m_inputFrames) {
+            // Caller rendered less than asked for: pad with silence
+            std::fill(output + frame * 2, output + outputFrames * 2, 0.0f);
+            break;
+        }
+        double phase = (m_position - index) * kPhases;
+        int row = (int)phase;
+        float blend = (float)(phase - row);
+        const float* a = m_filter.data() + (size_t)row * kTaps;
+        const float* b = a + kTaps;
+        const float* in = m_input.data() + index * 2;
+        float left = 0.0f;
+        float right = 0.0f;
+        for (int k = 0; k < kTaps; k++) {
+            float tap = a[k] + (b[k] - a[k]) * blend;
+            left += in[k * 2] * tap;
+            right += in[k * 2 + 1] * tap;
+        }
+        output[frame * 2] = left;
+        output[frame * 2 + 1] = right;
+        m_position += m_step;
+    }
+    
+    // Slide the frames still under the filter to the front
+    int consumed = std::min((int)m_position, m_inputFrames);
+    if (consumed > 0) {
+        m_inputFrames -= consumed;
+        memmove(m_input.data(), m_input.data() + consumed * 2, (size_t)m_inputFrames * 2 * sizeof(float));
+        m_position -= consumed;
+    }
+}
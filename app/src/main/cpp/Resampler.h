@@ -0,0 +1,67 @@
+/**
+ * Resampler.h
+ *
+ * Streaming polyphase resampler for interleaved stereo, used between the
+ * engine's fixed internal rate and whatever rate the output stream opened at.
+ *
+ * The filter is a Kaiser-windowed sinc stored as kPhases sub-filters of
+ * kTaps taps; fractional positions between two phases are blended linearly,
+ * so any rate ratio works (48000 -> 44100, 96000, ...). The cutoff follows
+ * the lower of the two rates so downsampling does not alias.
+ *
+ * Pull model, one call pair per callback (audio thread, no allocation):
+ *
+ *   int needed = resampler.getInputFramesNeeded(outFrames);
+ *   engine.render(resampler.getInputWritePointer(), needed);
+ *   resampler.process(needed, output, outFrames);
+ */
+
+#ifndef MUSIMIND_RESAMPLER_H
+#define MUSIMIND_RESAMPLER_H
+
+#include <vector>
+
+class Resampler {
+public:
+    static constexpr int kTaps = 16;     // Input frames under each output frame
+    static constexpr int kPhases = 128;
+    
+    // Build the filter and size buffers for output callbacks of up to
+    // maxOutputFrames. Not real-time safe; call before the stream starts.
+    void configure(int inputRate, int outputRate, int maxOutputFrames);
+    
+    // Drop buffered input and filter history
+    void reset();
+    
+    // Largest value getInputFramesNeeded() can return for the configured size
+    int getMaxInputFrames() const { return m_maxInputFrames; }
+    
+    // Input frames to render before process() can produce outputFrames
+    int getInputFramesNeeded(int outputFrames) const;
+    
+    // Where the next input frames go; room for getMaxInputFrames()
+    float* getInputWritePointer() { return m_input.data() + m_inputFrames * 2; }
+    
+    // Take inputFrames just written at the write pointer and produce outputFrames
+    void process(int inputFrames, float* output, int outputFrames);
+    
+    bool isPassthrough() const { return m_inputRate == m_outputRate; }
+    int getInputRate() const { return m_inputRate; }
+    int getOutputRate() const { return m_outputRate; }
+    
+private:
+    int m_inputRate = 48000;
+    int m_outputRate = 48000;
+    double m_step = 1.0;        // Input frames per output frame
+    int m_maxInputFrames = 0;
+    
+    // (kPhases + 1) rows of kTaps coefficients; the extra row closes the blend
+    std::vector<float> m_filter;
+    
+    // Interleaved input: frames still under the filter, then unread frames
+    std::vector<float> m_input;
+    int m_inputFrames = 0;
+    double m_position = 0.0;    // Next output position, in frames from m_input[0]
+};
+
+#endif // MUSIMIND_RESAMPLER_H
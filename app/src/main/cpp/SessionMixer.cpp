@@ -0,0 +1,152 @@
+/**
+ * SessionMixer.cpp
+ *
+ * Implementation of the engine sessions mixed into the output stream.
+ */
+
+#include "SessionMixer.h"
+#include "DspKernels.h"
+#include <android/log.h>
+#include <algorithm>
+#include <thread>
+
+#define LOG_TAG "SessionMixer"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+int64_t SessionMixer::create(int maxVoices) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Slot* free = nullptr;
+    for (Slot& slot : m_slots) {
+        if (!slot.owned) {
+            free = &slot;
+            break;
+        }
+    }
+    if (!free) {
+        LOGE("All %d sessions are in use", kMaxSessions);
+        return 0;
+    }
+    
+    // Fully set up before the callback can see it
+    auto engine = std::make_unique<SoundFontEngine>();
+    engine->setMaxVoices(maxVoices);
+    engine->setLimiterDeferred(true);  // The player limits the summed mix once
+    engine->shareBanksFrom(&m_primary);
+    if (m_maxFrames > 0) {
+        engine->prepare(m_maxFrames);
+    }
+    // Start on the player's clock, so batches queued before the first
+    // callback resolve "now" to the current frame rather than to 0. The
+    // first callback then corrects the few frames rendered in between.
+    engine->setFramePosition(m_primary.getFramePosition());
+    
+    free->handle = m_nextHandle++;
+    free->gain.store(1.0f);
+    free->owned = std::move(engine);
+    free->joining.store(true);
+    free->engine.store(free->owned.get());
+    LOGI("Session %lld created (%d voices)", (long long)free->handle, maxVoices);
+    return free->handle;
+}
+
+bool SessionMixer::release(int64_t handle) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (Slot& slot : m_slots) {
+        if (slot.owned && slot.handle == handle) {
+            releaseSlot(slot);
+            LOGI("Session %lld released", (long long)handle);
+            return true;
+        }
+    }
+    return false;
+}
+
+void SessionMixer::releaseAll() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (Slot& slot : m_slots) {
+        if (slot.owned) {
+            releaseSlot(slot);
+        }
+    }
+}
+
+void SessionMixer::releaseSlot(Slot& slot) {
+    slot.engine.store(nullptr);
+    while (m_mixing.load()) {
+        std::this_thread::yield();
+    }
+    slot.owned.reset();
+    slot.handle = 0;
+}
+
+SoundFontEngine* SessionMixer::find(int64_t handle) {
+    if (handle <= 0) {
+        return nullptr;
+    }
+    for (Slot& slot : m_slots) {
+        if (slot.owned && slot.handle == handle) {
+            return slot.owned.get();
+        }
+    }
+    return nullptr;
+}
+
+bool SessionMixer::setGain(int64_t handle, float gain) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (Slot& slot : m_slots) {
+        if (slot.owned && slot.handle == handle) {
+            slot.gain.store(std::max(0.0f, gain), std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+int SessionMixer::getSessionCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int count = 0;
+    for (const Slot& slot : m_slots) {
+        if (slot.owned) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void SessionMixer::prepare(int maxFrames) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxFrames = maxFrames;
+    m_scratch.assign((size_t)maxFrames * 2, 0.0f);
+    for (Slot& slot : m_slots) {
+        if (slot.owned) {
+            slot.owned->prepare(maxFrames);
+        }
+    }
+}
+
+void SessionMixer::mixInto(float* output, int numFrames, int64_t framePosition) {
+    m_renderedVoices = 0;
+    if (numFrames <= 0 || (size_t)numFrames * 2 > m_scratch.size()) {
+        return;  // Larger than prepare() allowed for: should not happen
+    }
+    m_mixing.store(true);
+    for (Slot& slot : m_slots) {
+        SoundFontEngine* engine = slot.engine.load();
+        if (!engine) {
+            continue;
+        }
+        if (slot.joining.exchange(false)) {
+            engine->setFramePosition(framePosition);
+            slot.appliedGain = slot.gain.load(std::memory_order_relaxed);
+        }
+        engine->render(m_scratch.data(), numFrames);
+        
+        float target = slot.gain.load(std::memory_order_relaxed);
+        float step = (target - slot.appliedGain) / numFrames;
+        DspKernels::mixAddRampedStereo(output, m_scratch.data(), numFrames, slot.appliedGain, step);
+        slot.appliedGain = target;
+        m_renderedVoices += engine->getVoiceStats().active;
+    }
+    m_mixing.store(false);
+}
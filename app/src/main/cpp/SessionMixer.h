@@ -0,0 +1,109 @@
+/**
+ * SessionMixer.h
+ *
+ * Extra engine contexts rendered into the player's one output stream, for
+ * duels (student vs. reference voice), per-player metronomes or prompts
+ * played while the main engine records.
+ *
+ * Each session is a SoundFontEngine of its own: command queue, scheduler,
+ * metronome, clips, channel state, mixer and voice pool. Its banks are
+ * shared from the player's engine (SoundFontEngine::shareBanksFrom), so a
+ * session costs its voices and scratch buffers, not another copy of the
+ * samples. A session's clock starts at the player's current frame and is
+ * re-aligned exactly on its first callback, so frames scheduled against
+ * nativeGetFramePosition line up across all of them, including batches
+ * queued right after create().
+ *
+ * Sessions run their own bus mixer and ducking but skip its limiter: they
+ * are added, with a per-session gain, into the player's mix before its one
+ * master limiter, so several sessions playing at once cannot clip the
+ * output. Handles are never reused, so a stale handle is simply refused.
+ */
+
+#ifndef MUSIMIND_SESSION_MIXER_H
+#define MUSIMIND_SESSION_MIXER_H
+
+#include "SoundFontEngine.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class SessionMixer {
+public:
+    static constexpr int kMaxSessions = 4;
+    
+    explicit SessionMixer(SoundFontEngine& primary) : m_primary(primary) {}
+    ~SessionMixer() { releaseAll(); }
+    
+    SessionMixer(const SessionMixer&) = delete;
+    SessionMixer& operator=(const SessionMixer&) = delete;
+    
+    // Add a session sharing the primary engine's banks, with a pool of
+    // maxVoices voices. Returns its handle (> 0), or 0 when all slots are
+    // taken. Not real-time safe; any thread but the audio thread.
+    int64_t create(int maxVoices);
+    
+    // Remove a session; waits for the callback to let go of it
+    bool release(int64_t handle);
+    void releaseAll();
+    
+    // Run fn(SoundFontEngine&) on a session while it cannot be released.
+    // False if the handle is unknown.
+    template <typename Fn>
+    bool with(int64_t handle, Fn&& fn) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        SoundFontEngine* engine = find(handle);
+        if (!engine) {
+            return false;
+        }
+        fn(*engine);
+        return true;
+    }
+    
+    // Linear mix gain of a session, ramped over one callback
+    bool setGain(int64_t handle, float gain);
+    
+    int getSessionCount() const;
+    
+    // Size render scratch for callbacks of up to maxFrames engine frames,
+    // and every session with it. Only while the stream is stopped.
+    void prepare(int maxFrames);
+    
+    // Render every session and add it into output (audio thread only).
+    // framePosition is the primary engine's clock at the callback start.
+    void mixInto(float* output, int numFrames, int64_t framePosition);
+    
+    // Voices the sessions had sounding in the last mixInto (audio thread only)
+    int getRenderedVoices() const { return m_renderedVoices; }
+    
+private:
+    struct Slot {
+        std::atomic<SoundFontEngine*> engine{nullptr};  // Read by the callback
+        std::atomic<bool> joining{false};   // Clock not aligned yet
+        std::atomic<float> gain{1.0f};
+        float appliedGain = 1.0f;           // Audio thread only
+        int64_t handle = 0;                 // Guarded by m_mutex
+        std::unique_ptr<SoundFontEngine> owned;  // Guarded by m_mutex
+    };
+    
+    // Engine of a live handle (m_mutex held)
+    SoundFontEngine* find(int64_t handle);
+    
+    // Unpublish a slot and destroy its engine (m_mutex held)
+    void releaseSlot(Slot& slot);
+    
+    SoundFontEngine& m_primary;
+    Slot m_slots[kMaxSessions];
+    mutable std::mutex m_mutex;  // Session table changes; never taken by mixInto()
+    int64_t m_nextHandle = 1;    // Guarded by m_mutex
+    int m_maxFrames = 0;         // Guarded by m_mutex
+    
+    // Set while mixInto() may touch a session engine, so release() can wait
+    std::atomic<bool> m_mixing{false};
+    std::vector<float> m_scratch;
+    int m_renderedVoices = 0;
+};
+
+#endif // MUSIMIND_SESSION_MIXER_H
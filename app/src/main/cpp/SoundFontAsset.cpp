@@ -0,0 +1,137 @@
+/**
+ * SoundFontAsset.cpp
+ *
+ * Implementation of the mapped SoundFont asset.
+ */
+
+#include "SoundFontAsset.h"
+#include <android/log.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LOG_TAG "SoundFontAsset"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+SoundFontAsset::~SoundFontAsset() {
+    close();
+}
+
+bool SoundFontAsset::open(AAssetManager* assetManager, const char* path) {
+    close();
+    if (!assetManager) {
+        return openFile(path);
+    }
+    
+    AAsset* asset = AAssetManager_open(assetManager, path, AASSET_MODE_RANDOM);
+    if (!asset) {
+        LOGE("Failed to open SoundFont asset: %s", path);
+        return false;
+    }
+    
+    // Uncompressed assets can be mapped straight out of the APK
+    off64_t start = 0;
+    off64_t length = 0;
+    int fd = AAsset_openFileDescriptor64(asset, &start, &length);
+    if (fd >= 0) {
+        long pageSize = sysconf(_SC_PAGESIZE);
+        off64_t alignedStart = start & ~(off64_t)(pageSize - 1);
+        size_t delta = (size_t)(start - alignedStart);
+        size_t mappingSize = (size_t)length + delta;
+        
+        void* mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, alignedStart);
+        ::close(fd);  // The mapping keeps its own reference
+        if (mapping != MAP_FAILED) {
+            AAsset_close(asset);
+            m_mapping = mapping;
+            m_mappingSize = mappingSize;
+            m_data = static_cast<const uint8_t*>(mapping) + delta;
+            m_size = (size_t)length;
+            LOGI("Mapped SoundFont: %s (%zu bytes)", path, m_size);
+            return true;
+        }
+        LOGE("mmap failed for %s, reading instead", path);
+    }
+    
+    // Compressed (or unmappable) asset: stream it into memory
+    off64_t assetLength = AAsset_getLength64(asset);
+    if (assetLength <= 0) {
+        LOGE("Empty SoundFont asset: %s", path);
+        AAsset_close(asset);
+        return false;
+    }
+    m_buffer.resize((size_t)assetLength);
+    size_t offset = 0;
+    while (offset < m_buffer.size()) {
+        int read = AAsset_read(asset, m_buffer.data() + offset, m_buffer.size() - offset);
+        if (read <= 0) {
+            break;
+        }
+        offset += (size_t)read;
+    }
+    AAsset_close(asset);
+    
+    if (offset != m_buffer.size()) {
+        LOGE("Short read on SoundFont asset: %s", path);
+        m_buffer.clear();
+        return false;
+    }
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    LOGI("Read compressed SoundFont: %s (%zu bytes)", path, m_size);
+    return true;
+}
+
+bool SoundFontAsset::openFile(const char* path) {
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("Failed to open SoundFont file: %s", path);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        LOGE("Empty SoundFont file: %s", path);
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        LOGE("mmap failed for %s", path);
+        return false;
+    }
+    m_mapping = mapping;
+    m_mappingSize = (size_t)info.st_size;
+    m_data = static_cast<const uint8_t*>(mapping);
+    m_size = m_mappingSize;
+    LOGI("Mapped SoundFont file: %s (%zu bytes)", path, m_size);
+    return true;
+}
+
+int64_t SoundFontAsset::queryLength(AAssetManager* assetManager, const char* path) {
+    if (!assetManager) {
+        struct stat info;
+        return stat(path, &info) == 0 ? (int64_t)info.st_size : -1;
+    }
+    AAsset* asset = AAssetManager_open(assetManager, path, AASSET_MODE_UNKNOWN);
+    if (!asset) {
+        return -1;
+    }
+    int64_t length = AAsset_getLength64(asset);
+    AAsset_close(asset);
+    return length;
+}
+
+void SoundFontAsset::close() {
+    if (m_mapping) {
+        munmap(m_mapping, m_mappingSize);
+        m_mapping = nullptr;
+        m_mappingSize = 0;
+    }
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+    m_data = nullptr;
+    m_size = 0;
+}
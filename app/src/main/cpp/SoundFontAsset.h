@@ -0,0 +1,53 @@
+/**
+ * SoundFontAsset.h
+ *
+ * Read-only view of a SoundFont packaged in the APK.
+ * Uncompressed assets are mapped with AAsset_openFileDescriptor + mmap, so
+ * bytes are only paged in when they are read and the pages stay clean and
+ * reclaimable. Compressed assets fall back to streaming into a heap buffer.
+ * Keep .sf2 files uncompressed (androidResources.noCompress) to get the
+ * mapped path.
+ *
+ * With a null asset manager the path is a filesystem path, mapped the same
+ * way (native benchmarks run from adb have no APK to read from).
+ */
+
+#ifndef MUSIMIND_SOUNDFONT_ASSET_H
+#define MUSIMIND_SOUNDFONT_ASSET_H
+
+#include <android/asset_manager.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class SoundFontAsset {
+public:
+    SoundFontAsset() = default;
+    ~SoundFontAsset();
+    
+    SoundFontAsset(const SoundFontAsset&) = delete;
+    SoundFontAsset& operator=(const SoundFontAsset&) = delete;
+    
+    // Map (or read) the asset. Returns false if it cannot be opened.
+    bool open(AAssetManager* assetManager, const char* path);
+    void close();
+    
+    // Size of an asset without reading it, or -1 if it cannot be opened
+    static int64_t queryLength(AAssetManager* assetManager, const char* path);
+    
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool isMapped() const { return m_mapping != nullptr; }
+    
+private:
+    bool openFile(const char* path);
+    
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    
+    void* m_mapping = nullptr;  // Page-aligned mapping containing the asset
+    size_t m_mappingSize = 0;
+    std::vector<uint8_t> m_buffer;  // Fallback for compressed assets
+};
+
+#endif // MUSIMIND_SOUNDFONT_ASSET_H
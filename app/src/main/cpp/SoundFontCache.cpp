@@ -0,0 +1,151 @@
+/**
+ * SoundFontCache.cpp
+ *
+ * Implementation of the SoundFont subset cache.
+ */
+
+#include "SoundFontCache.h"
+#include <android/log.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LOG_TAG "SoundFontCache"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+bool writeAll(int fd, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        ssize_t written = ::write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+} // namespace
+
+SoundFontCache::~SoundFontCache() {
+    close();
+}
+
+uint32_t SoundFontCache::hashRequests(const std::vector<SoundFontPresetRequest>& requests) {
+    uint32_t hash = 2166136261u;
+    for (const SoundFontPresetRequest& request : requests) {
+        for (int32_t value : {request.presetIndex, request.keyLow, request.keyHigh}) {
+            for (int shift = 0; shift < 32; shift += 8) {
+                hash = (hash ^ (((uint32_t)value >> shift) & 0xff)) * 16777619u;
+            }
+        }
+    }
+    return hash;
+}
+
+std::string SoundFontCache::entryPath(const std::string& directory, const char* sourcePath,
+                                      const std::vector<SoundFontPresetRequest>& requests) {
+    // "soundfonts/gm.sf2" -> "<dir>/gm.sf2.1a2b3c4d.sfc"
+    const char* name = strrchr(sourcePath, '/');
+    name = name ? name + 1 : sourcePath;
+    
+    char suffix[24];
+    snprintf(suffix, sizeof(suffix), ".%08x.sfc", hashRequests(requests));
+    return directory + "/" + name + suffix;
+}
+
+bool SoundFontCache::open(const std::string& path, uint64_t sourceSize,
+                          const std::vector<SoundFontPresetRequest>& requests) {
+    close();
+    
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size <= sizeof(Header)) {
+        ::close(fd);
+        return false;
+    }
+    
+    size_t mappingSize = (size_t)info.st_size;
+    void* mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        LOGE("mmap failed for %s", path.c_str());
+        return false;
+    }
+    
+    Header header;
+    memcpy(&header, mapping, sizeof(header));
+    if (header.magic != kMagic || header.version != kVersion ||
+        header.sourceSize != sourceSize ||
+        header.requestCount != (uint32_t)requests.size() ||
+        header.requestHash != hashRequests(requests) ||
+        header.payloadSize != mappingSize - sizeof(Header)) {
+        LOGI("Stale SoundFont cache entry: %s", path.c_str());
+        munmap(mapping, mappingSize);
+        return false;
+    }
+    
+    m_mapping = mapping;
+    m_mappingSize = mappingSize;
+    m_data = static_cast<const uint8_t*>(mapping) + sizeof(Header);
+    m_size = header.payloadSize;
+    return true;
+}
+
+void SoundFontCache::close() {
+    if (m_mapping) {
+        munmap(m_mapping, m_mappingSize);
+        m_mapping = nullptr;
+        m_mappingSize = 0;
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+
+bool SoundFontCache::store(const std::string& path, uint64_t sourceSize,
+                           const std::vector<SoundFontPresetRequest>& requests,
+                           const std::vector<uint8_t>& soundFont) {
+    Header header;
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.sourceSize = sourceSize;
+    header.requestCount = (uint32_t)requests.size();
+    header.requestHash = hashRequests(requests);
+    header.payloadSize = (uint32_t)soundFont.size();
+    header.reserved = 0;
+    
+    // A torn write leaves a short temporary file, never a bad entry
+    std::string temporary = path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        LOGE("Cannot create %s: %s", temporary.c_str(), strerror(errno));
+        return false;
+    }
+    
+    bool ok = writeAll(fd, &header, sizeof(header)) &&
+              writeAll(fd, soundFont.data(), soundFont.size());
+    ok = (::close(fd) == 0) && ok;
+    if (!ok || rename(temporary.c_str(), path.c_str()) != 0) {
+        LOGE("Failed to write SoundFont cache entry %s: %s", path.c_str(), strerror(errno));
+        unlink(temporary.c_str());
+        return false;
+    }
+    
+    LOGI("Stored SoundFont cache entry: %s (%zu bytes)", path.c_str(), soundFont.size());
+    return true;
+}
@@ -0,0 +1,72 @@
+/**
+ * SoundFontCache.h
+ *
+ * On-disk cache of SoundFont subsets.
+ * The first launch builds the preset subset from the full asset (see
+ * SoundFontSubset) and stores it here; later launches map the stored subset
+ * and hand it straight to TinySoundFont, skipping the walk over the full
+ * bank. Entries live in the app's code cache directory, which Android clears
+ * on app and platform updates, and are also keyed on the source asset size
+ * and a format version.
+ */
+
+#ifndef MUSIMIND_SOUNDFONT_CACHE_H
+#define MUSIMIND_SOUNDFONT_CACHE_H
+
+#include "SoundFontSubset.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class SoundFontCache {
+public:
+    SoundFontCache() = default;
+    ~SoundFontCache();
+    
+    SoundFontCache(const SoundFontCache&) = delete;
+    SoundFontCache& operator=(const SoundFontCache&) = delete;
+    
+    // File name of the entry for this source asset and preset list inside directory
+    static std::string entryPath(const std::string& directory, const char* sourcePath,
+                                 const std::vector<SoundFontPresetRequest>& requests);
+    
+    // Map an entry. Fails if it is missing, truncated, from another format
+    // version or built from a different source or preset list.
+    bool open(const std::string& path, uint64_t sourceSize, const std::vector<SoundFontPresetRequest>& requests);
+    void close();
+    
+    // The cached SF2 image
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    
+    // Write an entry (to a temporary file, then renamed into place)
+    static bool store(const std::string& path, uint64_t sourceSize,
+                      const std::vector<SoundFontPresetRequest>& requests,
+                      const std::vector<uint8_t>& soundFont);
+    
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t sourceSize;
+        uint32_t requestCount;
+        uint32_t requestHash;
+        uint32_t payloadSize;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(Header) == 32, "cache header layout changed");
+    
+    static constexpr uint32_t kMagic = 0x4346534d;  // "MSFC"
+    static constexpr uint32_t kVersion = 2;
+    
+    // FNV-1a over the preset, key low and key high of every request
+    static uint32_t hashRequests(const std::vector<SoundFontPresetRequest>& requests);
+    
+    void* m_mapping = nullptr;
+    size_t m_mappingSize = 0;
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+#endif // MUSIMIND_SOUNDFONT_CACHE_H
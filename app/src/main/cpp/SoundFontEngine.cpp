@@ -5,13 +5,28 @@
  * Uses gm.sf2 for piano and Metronom.sf2 for metronome clicks.
  */
 
+// Debug builds route TinySoundFont's allocations through the real-time guard
+// so voice allocations inside the audio callback are flagged
+#ifndef NDEBUG
+#include "RealtimeGuard.h"
+#include <cstdlib>
+#define TSF_MALLOC  RealtimeGuard::trackedMalloc
+#define TSF_REALLOC RealtimeGuard::trackedRealloc
+#define TSF_FREE    free
+#endif
+
 // TinySoundFont - define implementation ONLY here (header-only library)
 #define TSF_IMPLEMENTATION
 #include "tsf.h"
 
 #include "SoundFontEngine.h"
+#include "SoundFontAsset.h"
+#include "SoundFontCache.h"
+#include "DspKernels.h"
 #include <android/log.h>
 #include <cmath>
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 
 #define LOG_TAG "SoundFontEngine"
@@ -25,45 +40,162 @@
 // Note: Only these two pitches produce sound!
 constexpr int METRONOME_NOTE_ACCENTED = 76;   // E5 - "tick" for downbeat
 constexpr int METRONOME_NOTE_NORMAL = 77;     // F5 - "tack" for other beats
+constexpr const char* METRONOME_SOUNDFONT_PATH = "soundfonts/Metronom.sf2";
 constexpr float METRONOME_VELOCITY = 1.0f;
+constexpr float METRONOME_VELOCITY_BEAT = 0.8f;
+constexpr float METRONOME_VELOCITY_SUBDIVISION = 0.5f;
 
 SoundFontEngine::SoundFontEngine() {
+    m_metronome.setSampleRate(m_sampleRate.load());
+    m_sequencer.setSampleRate(m_sampleRate.load());
+    m_mixer.setSampleRate(m_sampleRate.load());
     LOGI("SoundFontEngine created");
 }
 
 SoundFontEngine::~SoundFontEngine() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_tsf) {
-        tsf_close(m_tsf);
-        m_tsf = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_loaderExit = true;
+    }
+    m_loaderWake.notify_all();
+    if (m_loader.joinable()) {
+        m_loader.join();
     }
-    if (m_tsfMetronome) {
-        tsf_close(m_tsfMetronome);
-        m_tsfMetronome = nullptr;
+    
+    if (m_bankSource) {
+        std::lock_guard<std::mutex> lock(m_bankSource->m_mutex);
+        std::vector<SoundFontEngine*>& followers = m_bankSource->m_followers;
+        followers.erase(std::remove(followers.begin(), followers.end(), this), followers.end());
+        closeBanks();
+    } else {
+        closeBanks();
     }
     LOGI("SoundFontEngine destroyed");
 }
 
-tsf* SoundFontEngine::loadSoundFont(AAssetManager* assetManager, const char* path) {
-    AAsset* asset = AAssetManager_open(assetManager, path, AASSET_MODE_BUFFER);
-    if (!asset) {
+void SoundFontEngine::closeBanks() {
+    // The stream is stopped by now, so every bank can be closed here
+    for (SoundFontSlot* slot : {&m_pianoFont, &m_metronomeFont}) {
+        for (tsf* soundfont : {slot->active, slot->draining, slot->pending.exchange(nullptr)}) {
+            if (soundfont) {
+                tsf_close(soundfont);
+            }
+        }
+        slot->active = nullptr;
+        slot->draining = nullptr;
+        slot->latest = nullptr;
+    }
+    tsf* retired;
+    while (m_retired.pop(retired)) {
+        tsf_close(retired);
+    }
+}
+
+void SoundFontEngine::shareBanksFrom(SoundFontEngine* source) {
+    if (!source || source == this || m_bankSource || source->m_bankSource) {
+        LOGE("Cannot share banks from this engine");
+        return;
+    }
+    m_bankSource = source;
+    std::lock_guard<std::mutex> lock(source->m_mutex);
+    source->m_followers.push_back(this);
+    source->shareBanks(this, true, true, false);
+}
+
+void SoundFontEngine::shareBanks(SoundFontEngine* follower, bool piano, bool metronome, bool clearClips) {
+    std::lock_guard<std::mutex> lock(follower->m_mutex);
+    // Followers have no loader thread; their replaced copies are closed here
+    follower->closeRetired();
+    
+    if (metronome && m_metronomeFont.latest) {
+        tsf* copy = tsf_copy(m_metronomeFont.latest);
+        if (copy) {
+            tsf_set_max_voices(copy, kMetronomeVoices);
+            follower->publish(follower->m_metronomeFont, copy);
+        }
+    }
+    if (!piano || !m_pianoFont.latest) {
+        return;
+    }
+    tsf* copy = tsf_copy(m_pianoFont.latest);
+    if (!copy) {
+        return;
+    }
+    // A copy starts without channels or voices; size both off the audio thread
+    tsf_channel_set_presetindex(copy, kChannelCount - 1, 0);
+    tsf_set_max_voices(copy, follower->m_maxVoices.load());
+    follower->publish(follower->m_pianoFont, copy);
+    if (clearClips) {
+        follower->m_clipCache.clear();
+    }
+    follower->m_assetManager = m_assetManager;
+    follower->m_pianoPath = m_pianoPath;
+    follower->m_pianoRequests = m_pianoRequests;
+    follower->m_loadState.store(LOAD_READY, std::memory_order_release);
+}
+
+void SoundFontEngine::shareWithFollowers(bool piano, bool metronome, bool clearClips) {
+    for (SoundFontEngine* follower : m_followers) {
+        shareBanks(follower, piano, metronome, clearClips);
+    }
+}
+
+tsf* SoundFontEngine::loadSoundFont(AAssetManager* assetManager, const char* path,
+                                    const std::vector<SoundFontPresetRequest>& requests) {
+    // A cached subset from an earlier launch skips the full bank entirely
+    int64_t sourceSize = SoundFontAsset::queryLength(assetManager, path);
+    if (sourceSize <= 0) {
         LOGE("Failed to open SoundFont asset: %s", path);
         return nullptr;
     }
+    std::string cachePath;
+    if (!m_cacheDirectory.empty()) {
+        cachePath = SoundFontCache::entryPath(m_cacheDirectory, path, requests);
+        SoundFontCache cache;
+        if (cache.open(cachePath, (uint64_t)sourceSize, requests)) {
+            tsf* soundfont = tsf_load_memory(cache.data(), (int)cache.size());
+            if (soundfont) {
+                LOGI("SoundFont loaded from cache: %s (%zu bytes)", cachePath.c_str(), cache.size());
+                return soundfont;
+            }
+            LOGE("Unreadable SoundFont cache entry, rebuilding: %s", cachePath.c_str());
+        }
+    }
     
-    const void* data = AAsset_getBuffer(asset);
-    off_t dataSize = AAsset_getLength(asset);
-    
-    if (!data || dataSize <= 0) {
-        LOGE("Failed to get SoundFont data for: %s", path);
-        AAsset_close(asset);
+    SoundFontAsset asset;
+    if (!asset.open(assetManager, path)) {
+        LOGE("Failed to open SoundFont asset: %s", path);
         return nullptr;
     }
     
-    LOGI("Loading SoundFont: %s (%ld bytes)", path, (long)dataSize);
+    LOGI("Loading SoundFont: %s (%zu bytes, %s)", path, asset.size(),
+         asset.isMapped() ? "mapped" : "buffered");
+    
+    // tsf converts every sample in the file to float up front, so hand it a
+    // subset holding only what the requested presets can play
+    tsf* soundfont = nullptr;
+    SoundFontSubset subset;
+    std::vector<uint8_t> subsetData;
+    bool parsed = subset.parse(asset.data(), asset.size());
+    bool valid = parsed && !requests.empty();
+    for (const SoundFontPresetRequest& request : requests) {
+        valid = valid && request.presetIndex >= 0 && request.presetIndex < subset.getPresetCount();
+    }
+    if (valid && subset.build(requests, subsetData)) {
+        soundfont = tsf_load_memory(subsetData.data(), (int)subsetData.size());
+        if (soundfont) {
+            LOGI("SoundFont subset: %zu presets, %zu bytes, %zu sample frames",
+                 requests.size(), subsetData.size(), subset.getLastBuildSampleFrames());
+            if (!cachePath.empty()) {
+                SoundFontCache::store(cachePath, (uint64_t)sourceSize, requests, subsetData);
+            }
+        }
+    }
     
-    tsf* soundfont = tsf_load_memory(data, (int)dataSize);
-    AAsset_close(asset);
+    if (!soundfont) {
+        LOGE("Could not build a subset of %s, loading the whole file", path);
+        soundfont = tsf_load_memory(asset.data(), (int)asset.size());
+    }
     
     if (!soundfont) {
         LOGE("Failed to parse SoundFont: %s", path);
@@ -75,124 +207,981 @@ tsf* SoundFontEngine::loadSoundFont(AAssetManager* assetManager, const char* pat
 }
 
 bool SoundFontEngine::initialize(AAssetManager* assetManager, const char* pianoSfPath, const char* metronomeSfPath) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_bankSource) {
+        LOGE("Engine shares its banks; load them on the source engine");
+        return false;
+    }
+    // Channels start on preset 0 (Grand Piano), over the full keyboard;
+    // other presets are added when a channel selects them
+    LoadJob job{assetManager, pianoSfPath, {SoundFontPresetRequest{0}}, metronomeSfPath};
+    m_loadState.store(LOAD_PENDING, std::memory_order_release);
+    return runLoadJob(job);
+}
+
+void SoundFontEngine::initializeAsync(AAssetManager* assetManager, const char* pianoSfPath,
+                                      const char* metronomeSfPath) {
+    queueLoadJob(LoadJob{assetManager, pianoSfPath, {SoundFontPresetRequest{0}}, metronomeSfPath});
+}
+
+void SoundFontEngine::swapSoundFontAsync(AAssetManager* assetManager, const char* path, int presetIndex) {
+    LOGI("Swapping piano SoundFont: %s, preset %d", path, presetIndex);
+    queueLoadJob(LoadJob{assetManager, path, {SoundFontPresetRequest{presetIndex}}, std::string()});
+}
+
+void SoundFontEngine::queueLoadJob(LoadJob job) {
+    if (m_bankSource) {
+        LOGE("Engine shares its banks; load them on the source engine");
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_loadJobs.push_back(std::move(job));
+        m_loadState.store(LOAD_PENDING, std::memory_order_release);
+        if (!m_loader.joinable()) {
+            m_loader = std::thread(&SoundFontEngine::loaderLoop, this);
+        }
+    }
+    m_loaderWake.notify_one();
+}
+
+void SoundFontEngine::loaderLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_loaderExit) {
+        if (m_loadJobs.empty()) {
+            // Replaced banks are freed once render() lets go of them, which
+            // takes their release time; poll only while some are outstanding
+            if (m_unreclaimed > 0) {
+                m_loaderWake.wait_for(lock, std::chrono::milliseconds(100));
+            } else {
+                m_loaderWake.wait(lock);
+            }
+            lock.unlock();
+            reclaimRetired();
+            lock.lock();
+            continue;
+        }
+        
+        LoadJob job = std::move(m_loadJobs.front());
+        m_loadJobs.pop_front();
+        lock.unlock();
+        runLoadJob(job);
+        reclaimRetired();
+        lock.lock();
+    }
+}
+
+bool SoundFontEngine::runLoadJob(const LoadJob& job) {
+    AAssetManager* assetManager = job.assetManager;
+    std::string pianoPath = job.pianoPath;
+    std::vector<SoundFontPresetRequest> pianoRequests = job.pianoRequests;
     
-    m_assetManager = assetManager;
+    if (!job.addPresets.empty()) {
+        // Rebuild the current piano bank with the presets it is missing
+        std::vector<PresetId> missing;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            assetManager = m_assetManager;
+            pianoPath = m_pianoPath;
+            pianoRequests = m_pianoRequests;
+            for (const PresetId& preset : job.addPresets) {
+                if (!m_pianoFont.latest ||
+                    tsf_get_presetindex(m_pianoFont.latest, preset.bank, preset.program) < 0) {
+                    missing.push_back(preset);
+                }
+            }
+        }
+        if (missing.empty()) {
+            m_loadState.store(LOAD_READY, std::memory_order_release);
+            return true;
+        }
+        size_t requested = pianoRequests.size();
+        for (const PresetId& preset : missing) {
+            int presetIndex = pianoPath.empty() ? -1
+                            : findPresetIndex(assetManager, pianoPath.c_str(), preset.bank, preset.program);
+            if (presetIndex < 0) {
+                LOGE("Preset %d:%d is not in %s", preset.bank, preset.program, pianoPath.c_str());
+                continue;
+            }
+            pianoRequests.push_back(SoundFontPresetRequest{presetIndex});
+        }
+        if (pianoRequests.size() == requested) {
+            m_loadState.store(LOAD_FAILED, std::memory_order_release);
+            return false;
+        }
+    }
     
-    // Close existing instances
-    if (m_tsf) {
-        tsf_close(m_tsf);
-        m_tsf = nullptr;
+    // Loading and parsing run unlocked; only publishing takes m_mutex
+    tsf* piano = loadSoundFont(assetManager, pianoPath.c_str(), pianoRequests);
+    if (piano) {
+        // tsf grows its channel table and voice list on demand; size both
+        // here rather than on the audio thread
+        tsf_channel_set_presetindex(piano, kChannelCount - 1, 0);
+        tsf_set_max_voices(piano, m_maxVoices.load());
     }
-    if (m_tsfMetronome) {
-        tsf_close(m_tsfMetronome);
-        m_tsfMetronome = nullptr;
+    tsf* metronome = nullptr;
+    if (!job.metronomePath.empty()) {
+        // Only the two click pitches of the metronome kit are ever played
+        metronome = loadSoundFont(assetManager, job.metronomePath.c_str(),
+                                  {SoundFontPresetRequest{0, METRONOME_NOTE_ACCENTED, METRONOME_NOTE_NORMAL}});
+        if (metronome) {
+            tsf_set_max_voices(metronome, kMetronomeVoices);
+        } else {
+            LOGE("Failed to load metronome SoundFont, will use synthetic fallback");
+        }
     }
     
-    // Load piano SoundFont
-    m_tsf = loadSoundFont(assetManager, pianoSfPath);
-    if (!m_tsf) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_assetManager = assetManager;
+    if (metronome) {
+        publish(m_metronomeFont, metronome);
+        LOGI("Metronome SoundFont loaded successfully");
+    }
+    if (!piano) {
+        shareWithFollowers(false, metronome != nullptr, false);
+        m_loadState.store(LOAD_FAILED, std::memory_order_release);
         return false;
     }
-    tsf_set_output(m_tsf, TSF_STEREO_INTERLEAVED, m_sampleRate, 0.0f);
-    
-    // Load metronome SoundFont
-    m_tsfMetronome = loadSoundFont(assetManager, metronomeSfPath);
-    if (m_tsfMetronome) {
-        tsf_set_output(m_tsfMetronome, TSF_STEREO_INTERLEAVED, m_sampleRate, 0.0f);
-        LOGI("Metronome SoundFont loaded successfully");
-    } else {
-        LOGE("Failed to load metronome SoundFont, will use synthetic fallback");
+    publish(m_pianoFont, piano);
+    if (job.addPresets.empty()) {
+        // Clips rendered with the previous bank would no longer match live playback
+        m_clipCache.clear();
     }
-    
-    LOGI("SoundFontEngine initialized with piano and metronome SoundFonts");
+    m_pianoPath = pianoPath;
+    m_pianoRequests = pianoRequests;
+    shareWithFollowers(true, metronome != nullptr, job.addPresets.empty());
+    m_loadState.store(LOAD_READY, std::memory_order_release);
+    LOGI("SoundFontEngine published %s (%zu presets)", pianoPath.c_str(), pianoRequests.size());
     return true;
 }
 
+int SoundFontEngine::findPresetIndex(AAssetManager* assetManager, const char* path, int bank, int program) {
+    SoundFontAsset asset;
+    SoundFontSubset subset;
+    if (!asset.open(assetManager, path) || !subset.parse(asset.data(), asset.size())) {
+        return -1;
+    }
+    return subset.findPreset(bank, program);
+}
+
+void SoundFontEngine::publish(SoundFontSlot& slot, tsf* soundfont) {
+    tsf_set_output(soundfont, TSF_STEREO_INTERLEAVED, m_sampleRate.load(), 0.0f);
+    
+    // A bank still pending here was never seen by render(), so it can go now
+    tsf* displaced = slot.pending.exchange(soundfont, std::memory_order_acq_rel);
+    if (displaced) {
+        tsf_close(displaced);
+    } else if (slot.latest) {
+        m_unreclaimed++;
+    }
+    slot.latest = soundfont;
+    slot.loaded.store(true, std::memory_order_release);
+}
+
+void SoundFontEngine::reclaimRetired() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    closeRetired();
+}
+
+void SoundFontEngine::closeRetired() {
+    tsf* retired;
+    while (m_retired.pop(retired)) {
+        tsf_close(retired);
+        m_unreclaimed--;
+    }
+}
+
 bool SoundFontEngine::initialize(AAssetManager* assetManager, const char* sfPath) {
     // Legacy call - try to load both piano and metronome
-    return initialize(assetManager, sfPath, "soundfonts/Metronom.sf2");
+    return initialize(assetManager, sfPath, METRONOME_SOUNDFONT_PATH);
+}
+
+void SoundFontEngine::initializeAsync(AAssetManager* assetManager, const char* sfPath) {
+    initializeAsync(assetManager, sfPath, METRONOME_SOUNDFONT_PATH);
 }
 
 void SoundFontEngine::setSampleRate(int sampleRate) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_sampleRate = sampleRate;
-    if (m_tsf) {
-        tsf_set_output(m_tsf, TSF_STEREO_INTERLEAVED, sampleRate, 0.0f);
+    m_sampleRate.store(sampleRate);
+    pushCommand(AudioCommand::setSampleRate(sampleRate));
+}
+
+void SoundFontEngine::noteOn(int channel, int midiNote, float velocity) {
+    LOGI("Note ON: channel=%d, note=%d, velocity=%.2f", channel, midiNote, velocity);
+    pushCommand(AudioCommand::noteOn(channel, midiNote, velocity));
+}
+
+void SoundFontEngine::noteOff(int channel, int midiNote) {
+    pushCommand(AudioCommand::noteOff(channel, midiNote));
+}
+
+void SoundFontEngine::scheduleNote(int channel, int midiNote, float velocity,
+                                   int64_t startFrame, int32_t durationFrames) {
+    pushCommand(AudioCommand::noteOn(channel, midiNote, velocity, startFrame, durationFrames));
+}
+
+int SoundFontEngine::scheduleNotes(const NoteEvent* events, int count, int64_t startFrame) {
+    int64_t base = startFrame < 0 ? getFramePosition() : startFrame;
+    int queued = 0;
+    for (int i = 0; i < count; i++) {
+        const NoteEvent& event = events[i];
+        if (pushCommand(AudioCommand::noteOn(event.channel, event.midiNote, event.velocity,
+                                             base + std::max(0, event.offsetFrames),
+                                             std::max(0, event.durationFrames)))) {
+            queued++;
+        }
     }
-    if (m_tsfMetronome) {
-        tsf_set_output(m_tsfMetronome, TSF_STEREO_INTERLEAVED, sampleRate, 0.0f);
+    return queued;
+}
+
+void SoundFontEngine::allNotesOff() {
+    pushCommand(AudioCommand::allNotesOff());
+}
+
+void SoundFontEngine::scheduleMetronomeClick(bool isAccented, int64_t frame) {
+    pushCommand(AudioCommand::metronomeClick(isAccented, frame));
+}
+
+void SoundFontEngine::setPreset(int channel, int preset) {
+    if (channel < 0 || channel >= kChannelCount) {
+        return;
     }
+    LOGI("Set preset: channel=%d, preset=%d", channel, preset);
+    pushCommand(AudioCommand::setPreset(channel, preset));
+    
+    // The loaded bank only holds the presets in use; rebuild it with this one
+    // if needed. The channel switches over when the new bank is adopted.
+    requestPresets({PresetId{channel == kDrumChannel ? kDrumBank : 0, preset}});
 }
 
-void SoundFontEngine::noteOn(int channel, int midiNote, float velocity) {
+void SoundFontEngine::requestPresets(const std::vector<PresetId>& presets) {
+    if (m_bankSource) {
+        // The source rebuilds its bank and shares the result with every follower
+        m_bankSource->requestPresets(presets);
+        return;
+    }
+    LoadJob job{nullptr, std::string(), {}, std::string()};
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const PresetId& preset : presets) {
+            if (!m_pianoFont.latest ||
+                tsf_get_presetindex(m_pianoFont.latest, preset.bank, preset.program) < 0) {
+                job.addPresets.push_back(preset);
+            }
+        }
+    }
+    if (!job.addPresets.empty()) {
+        queueLoadJob(std::move(job));
+    }
+}
+
+void SoundFontEngine::collectPresets(const MidiFile& file, std::vector<PresetId>& presets) {
+    // Every channel that plays a note needs its programs in the bank; a
+    // channel without a program change plays program 0
+    bool used[kChannelCount] = {};
+    bool programmed[kChannelCount] = {};
+    auto addPreset = [&presets](int bank, int program) {
+        for (const PresetId& preset : presets) {
+            if (preset.bank == bank && preset.program == program) {
+                return;
+            }
+        }
+        presets.push_back(PresetId{bank, program});
+    };
+    for (const MidiEvent& event : file.getEvents()) {
+        int channel = event.status & 0x0F;
+        if ((event.status & 0xF0) == 0xC0) {
+            programmed[channel] = true;
+            addPreset(channel == kDrumChannel ? kDrumBank : 0, event.data1);
+        } else if ((event.status & 0xF0) == 0x90) {
+            used[channel] = true;
+        }
+    }
+    for (int channel = 0; channel < kChannelCount; channel++) {
+        if (used[channel] && !programmed[channel]) {
+            addPreset(channel == kDrumChannel ? kDrumBank : 0, 0);
+        }
+    }
+}
+
+bool SoundFontEngine::renderOffline(const NoteEvent* notes, int noteCount,
+                                    const uint8_t* midiData, size_t midiSize,
+                                    int sampleRate, std::vector<float>& out, int program) {
+    if (m_bankSource) {
+        // Copies of a shared bank are only made under the source's lock
+        return m_bankSource->renderOffline(notes, noteCount, midiData, midiSize, sampleRate, out, program);
+    }
+    MidiFile* midi = nullptr;
+    if (midiData && midiSize > 0) {
+        midi = new MidiFile();
+        if (!midi->parse(midiData, midiSize)) {
+            LOGE("Offline render: failed to parse MIDI file (%zu bytes)", midiSize);
+            delete midi;
+            return false;
+        }
+    }
+    
+    // Loose notes play `program` (the drum kit on channel 10)
+    std::vector<PresetId> presets;
+    if (midi) {
+        collectPresets(*midi, presets);
+    }
+    for (int i = 0; i < noteCount; i++) {
+        bool drums = notes[i].channel == kDrumChannel;
+        PresetId preset{drums ? kDrumBank : 0, drums ? 0 : program};
+        if (std::none_of(presets.begin(), presets.end(), [&preset](const PresetId& p) {
+                return p.bank == preset.bank && p.program == preset.program; })) {
+            presets.push_back(preset);
+        }
+    }
+    
+    // A copy of the live bank shares its sample data but has voices of its
+    // own. If the bank lacks a preset, load a subset with it here instead.
+    tsf* soundfont = nullptr;
+    AAssetManager* assetManager;
+    std::string pianoPath;
+    std::vector<SoundFontPresetRequest> requests;
+    std::vector<PresetId> missing;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pianoFont.latest) {
+            for (const PresetId& preset : presets) {
+                if (tsf_get_presetindex(m_pianoFont.latest, preset.bank, preset.program) < 0) {
+                    missing.push_back(preset);
+                }
+            }
+            if (missing.empty()) {
+                soundfont = tsf_copy(m_pianoFont.latest);
+            }
+        }
+        assetManager = m_assetManager;
+        pianoPath = m_pianoPath;
+        requests = m_pianoRequests;
+    }
+    if (!soundfont) {
+        if (pianoPath.empty()) {
+            LOGE("Offline render: no SoundFont loaded");
+            delete midi;
+            return false;
+        }
+        for (const PresetId& preset : missing) {
+            int presetIndex = findPresetIndex(assetManager, pianoPath.c_str(), preset.bank, preset.program);
+            if (presetIndex >= 0) {
+                requests.push_back(SoundFontPresetRequest{presetIndex});
+            }
+        }
+        soundfont = loadSoundFont(assetManager, pianoPath.c_str(), requests);
+        if (!soundfont) {
+            delete midi;
+            return false;
+        }
+    }
+    
+    bool rendered;
+    {
+        OfflineRenderer renderer(soundfont, sampleRate);
+        if (program != 0) {
+            for (int channel = 0; channel < kChannelCount; channel++) {
+                if (channel != kDrumChannel) {
+                    renderer.setProgram(channel, program);
+                }
+            }
+        }
+        rendered = renderer.render(notes, noteCount, midi, out);
+    }
+    
+    // A copy shares the live bank's share count with the loader and any
+    // followers, which copy and close it under m_mutex too
     std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_tsf) {
-        LOGI("Note ON: channel=%d, note=%d, velocity=%.2f", channel, midiNote, velocity);
-        // Use preset 0 (Grand Piano) for all notes
-        tsf_note_on(m_tsf, 0, midiNote, velocity);
+    tsf_close(soundfont);
+    return rendered;
+}
+
+int SoundFontEngine::acquireClip(ClipKey& key) {
+    key.sampleRate = m_sampleRate.load();
+    key.noteCount = std::max(0, std::min(key.noteCount, ClipKey::kMaxNotes));
+    key.velocity = std::max(1, std::min(127, key.velocity));
+    int slot = m_clipCache.acquire(key);
+    if (slot >= 0 || key.noteCount == 0) {
+        return slot;
     }
+    
+    NoteEvent notes[ClipKey::kMaxNotes];
+    for (int i = 0; i < key.noteCount; i++) {
+        notes[i] = NoteEvent{0, key.notes[i], key.velocity / 127.0f,
+                             i * std::max(0, key.spacingFrames), key.durationFrames};
+    }
+    std::vector<float> samples;
+    if (!renderOffline(notes, key.noteCount, nullptr, 0, key.sampleRate, samples, key.program)) {
+        return -1;
+    }
+    slot = m_clipCache.insert(key, std::move(samples));
+    if (slot < 0) {
+        LOGE("Clip cache has no room for a %d-note clip", key.noteCount);
+    }
+    return slot;
 }
 
-void SoundFontEngine::noteOff(int channel, int midiNote) {
+bool SoundFontEngine::playClip(ClipKey key, int64_t startFrame, RenderArena::Bus bus) {
+    if (bus != RenderArena::BUS_SFX) {
+        bus = RenderArena::BUS_PROMPT;
+    }
+    int slot = acquireClip(key);
+    if (slot < 0) {
+        return false;
+    }
+    if (!pushCommand(AudioCommand::playClip(slot, bus, startFrame))) {
+        m_clipCache.release(slot);
+        return false;
+    }
+    return true;
+}
+
+bool SoundFontEngine::prepareClip(ClipKey key) {
+    int slot = acquireClip(key);
+    if (slot < 0) {
+        return false;
+    }
+    m_clipCache.release(slot);
+    return true;
+}
+
+bool SoundFontEngine::loadMidi(const uint8_t* data, size_t size) {
+    MidiFile* file = new MidiFile();
+    if (!file->parse(data, size)) {
+        LOGE("Failed to parse MIDI file (%zu bytes)", size);
+        delete file;
+        return false;
+    }
+    
+    std::vector<PresetId> presets;
+    collectPresets(*file, presets);
+    requestPresets(presets);
+    
+    LOGI("MIDI file loaded: format %d, %d tracks, %zu events, %.1f s",
+         file->getFormat(), file->getTrackCount(), file->getEvents().size(), file->getLengthSeconds());
+    m_midiLengthTicks.store(file->getLengthTicks(), std::memory_order_relaxed);
+    m_midiTicksPerQuarter.store(file->getTicksPerQuarter(), std::memory_order_relaxed);
+    // setFile also deletes retired files, which needs a single caller at a time
     std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_tsf) {
-        tsf_note_off(m_tsf, 0, midiNote);
+    m_sequencer.setFile(file);
+    return true;
+}
+
+void SoundFontEngine::playMidi(int64_t startFrame) {
+    pushCommand(AudioCommand::sequencerPlay(startFrame));
+}
+
+void SoundFontEngine::stopMidi() {
+    pushCommand(AudioCommand::sequencerStop());
+}
+
+void SoundFontEngine::seekMidiTick(int32_t tick) {
+    pushCommand(AudioCommand::sequencerSeek(std::max(0, tick), false));
+}
+
+void SoundFontEngine::seekMidiFrame(int32_t songFrame) {
+    pushCommand(AudioCommand::sequencerSeek(std::max(0, songFrame), true));
+}
+
+void SoundFontEngine::setMidiTempoScale(float scale) {
+    pushCommand(AudioCommand::sequencerTempoScale(scale));
+}
+
+void SoundFontEngine::setMidiLoop(int32_t startTick, int32_t endTick) {
+    pushCommand(AudioCommand::sequencerLoop(std::max(0, startTick), std::max(0, endTick)));
+}
+
+SoundFontEngine::MidiState SoundFontEngine::getMidiState() const {
+    return MidiState{
+        m_sequencer.getPositionTick(),
+        m_midiLengthTicks.load(std::memory_order_relaxed),
+        m_sequencer.isPlaying(),
+        m_midiTicksPerQuarter.load(std::memory_order_relaxed)
+    };
+}
+
+void SoundFontEngine::setMaxVoices(int maxVoices) {
+    m_maxVoices.store(std::max(kNoteVoiceHeadroom, maxVoices));
+}
+
+SoundFontEngine::RenderStats SoundFontEngine::getRenderStats() const {
+    return RenderStats{
+        m_lateEvents.load(std::memory_order_relaxed),
+        m_maxLateFrames.load(std::memory_order_relaxed),
+        m_maxQueueNanos.load(std::memory_order_relaxed)
+    };
+}
+
+SoundFontEngine::VoiceStats SoundFontEngine::getVoiceStats() const {
+    return VoiceStats{
+        m_activeVoices.load(std::memory_order_relaxed),
+        m_peakVoices.load(std::memory_order_relaxed),
+        m_voiceCapacity.load(std::memory_order_relaxed),
+        m_stolenVoices.load(std::memory_order_relaxed)
+    };
+}
+
+void SoundFontEngine::setChannelVolume(int channel, float volume) {
+    if (channel >= 0 && channel < kChannelCount) {
+        pushCommand(AudioCommand::setChannelVolume(channel, std::max(0.0f, std::min(1.0f, volume))));
     }
 }
 
-void SoundFontEngine::setPreset(int channel, int preset) {
-    LOGI("Set preset: channel=%d, preset=%d", channel, preset);
+void SoundFontEngine::setChannelPan(int channel, float pan) {
+    if (channel >= 0 && channel < kChannelCount) {
+        pushCommand(AudioCommand::setChannelPan(channel, std::max(0.0f, std::min(1.0f, pan))));
+    }
+}
+
+void SoundFontEngine::setChannelSustain(int channel, bool sustain) {
+    if (channel >= 0 && channel < kChannelCount) {
+        pushCommand(AudioCommand::setChannelSustain(channel, sustain));
+    }
 }
 
 const char* SoundFontEngine::getPresetName(int preset) {
     std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_tsf) {
-        return tsf_get_presetname(m_tsf, preset);
+    if (m_pianoFont.latest) {
+        return tsf_get_presetname(m_pianoFont.latest, preset);
     }
     return "Unknown";
 }
 
 void SoundFontEngine::playMetronomeClick(bool isAccented) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
-    if (m_tsfMetronome) {
-        // Use the metronome SoundFont - trigger a note
-        int note = isAccented ? METRONOME_NOTE_ACCENTED : METRONOME_NOTE_NORMAL;
-        float velocity = isAccented ? 1.0f : 0.8f;
-        
-        // Turn off any previous note quickly and start new one
-        tsf_note_off(m_tsfMetronome, 0, METRONOME_NOTE_NORMAL);
-        tsf_note_off(m_tsfMetronome, 0, METRONOME_NOTE_ACCENTED);
-        tsf_note_on(m_tsfMetronome, 0, note, velocity);
-        
-        LOGI("Metronome click (SoundFont): note=%d, accented=%d", note, isAccented);
-    } else {
+    if (!isMetronomeLoaded()) {
         // Fallback - shouldn't happen but just in case
         LOGE("Metronome SoundFont not loaded!");
+        return;
     }
+    LOGI("Metronome click (SoundFont): accented=%d", isAccented);
+    pushCommand(AudioCommand::metronomeClick(isAccented));
+}
+
+void SoundFontEngine::startMetronome(int64_t startFrame) {
+    LOGI("Metronome start: frame=%lld", (long long)startFrame);
+    pushCommand(AudioCommand::metronomeStart(startFrame));
+}
+
+void SoundFontEngine::stopMetronome() {
+    pushCommand(AudioCommand::metronomeStop());
+}
+
+void SoundFontEngine::triggerClick(BeatEvent::Level level) {
+    tsf* metronome = m_metronomeFont.active;
+    if (!metronome) {
+        return;
+    }
+    int note = level == BeatEvent::LEVEL_ACCENT ? METRONOME_NOTE_ACCENTED : METRONOME_NOTE_NORMAL;
+    float velocity = level == BeatEvent::LEVEL_ACCENT ? METRONOME_VELOCITY
+                   : level == BeatEvent::LEVEL_BEAT ? METRONOME_VELOCITY_BEAT
+                   : METRONOME_VELOCITY_SUBDIVISION;
+    
+    // Turn off any previous note quickly and start new one
+    tsf_note_off(metronome, 0, METRONOME_NOTE_NORMAL);
+    tsf_note_off(metronome, 0, METRONOME_NOTE_ACCENTED);
+    tsf_note_on(metronome, 0, note, velocity);
+}
+
+bool SoundFontEngine::pushCommand(const AudioCommand& command) {
+    if (!m_commands.push(command)) {
+        m_droppedCommands.fetch_add(1, std::memory_order_relaxed);
+        LOGE("Audio command queue full, dropping command type=%d", (int)command.type);
+        return false;
+    }
+    return true;
+}
+
+void SoundFontEngine::applyCommand(const AudioCommand& command, int64_t frame) {
+    switch (command.type) {
+        case AudioCommand::Type::NoteOn:
+            if (m_pianoFont.active && command.channel >= 0 && command.channel < kChannelCount) {
+                reserveVoices(m_pianoFont.active);
+                tsf_channel_note_on(m_pianoFont.active, command.channel, command.data, command.value);
+            }
+            if (command.duration > 0 &&
+                !m_scheduler.schedule(AudioCommand::noteOff(command.channel, command.data,
+                                                            frame + command.duration))) {
+                m_droppedCommands.fetch_add(1, std::memory_order_relaxed);
+            }
+            break;
+            
+        case AudioCommand::Type::NoteOff:
+            if (m_pianoFont.active && command.channel >= 0 && command.channel < kChannelCount) {
+                tsf_channel_note_off(m_pianoFont.active, command.channel, command.data);
+            }
+            break;
+            
+        case AudioCommand::Type::MetronomeClick:
+            triggerClick(command.value > 0.5f ? BeatEvent::LEVEL_ACCENT : BeatEvent::LEVEL_BEAT);
+            break;
+            
+        case AudioCommand::Type::MetronomeStart:
+            m_metronome.start(frame);
+            break;
+            
+        case AudioCommand::Type::MetronomeStop:
+            m_metronome.stop();
+            break;
+            
+        case AudioCommand::Type::SetPreset:
+            m_channels[command.channel].program = command.data;
+            if (m_pianoFont.active) {
+                applyChannelState(m_pianoFont.active, command.channel);
+            }
+            break;
+            
+        case AudioCommand::Type::SetChannelVolume:
+            m_channels[command.channel].volume = command.value;
+            if (m_pianoFont.active) {
+                tsf_channel_set_volume(m_pianoFont.active, command.channel, command.value);
+            }
+            break;
+            
+        case AudioCommand::Type::SetChannelPan:
+            m_channels[command.channel].pan = command.value;
+            if (m_pianoFont.active) {
+                tsf_channel_set_pan(m_pianoFont.active, command.channel, command.value);
+            }
+            break;
+            
+        case AudioCommand::Type::SetChannelSustain:
+            m_channels[command.channel].sustain = command.data != 0;
+            if (m_pianoFont.active) {
+                tsf_channel_set_sustain(m_pianoFont.active, command.channel, command.data);
+            }
+            break;
+            
+        case AudioCommand::Type::AllNotesOff:
+            m_sequencer.stop(frame, m_scheduler);
+            m_scheduler.removeIf([this](const AudioCommand& pending) {
+                if (pending.type == AudioCommand::Type::PlayClip) {
+                    m_clipCache.release(pending.data);
+                    return true;
+                }
+                return pending.type == AudioCommand::Type::NoteOn || pending.type == AudioCommand::Type::NoteOff;
+            });
+            stopClips();
+            if (m_pianoFont.active) {
+                tsf_note_off_all(m_pianoFont.active);
+            }
+            break;
+            
+        case AudioCommand::Type::SetSampleRate:
+            for (SoundFontSlot* slot : {&m_pianoFont, &m_metronomeFont}) {
+                if (slot->active) {
+                    tsf_set_output(slot->active, TSF_STEREO_INTERLEAVED, command.data, 0.0f);
+                }
+                if (slot->draining) {
+                    tsf_set_output(slot->draining, TSF_STEREO_INTERLEAVED, command.data, 0.0f);
+                }
+            }
+            m_metronome.setSampleRate(command.data);
+            m_sequencer.setSampleRate(command.data);
+            m_mixer.setSampleRate(command.data);
+            break;
+            
+        // Sequencer changes inside a callback refill the rest of it right away
+        case AudioCommand::Type::SequencerPlay:
+            m_sequencer.play(frame, m_scheduler);
+            generateSequencer(frame);
+            break;
+            
+        case AudioCommand::Type::SequencerStop:
+            m_sequencer.stop(frame, m_scheduler);
+            break;
+            
+        case AudioCommand::Type::SequencerSeek:
+            if (command.channel) {
+                m_sequencer.seekSeconds((double)command.data / m_sampleRate.load(std::memory_order_relaxed),
+                                        frame, m_scheduler);
+            } else {
+                m_sequencer.seekTick(command.data, frame, m_scheduler);
+            }
+            generateSequencer(frame);
+            break;
+            
+        case AudioCommand::Type::SequencerTempoScale:
+            m_sequencer.setTempoScale(command.value, frame);
+            break;
+            
+        case AudioCommand::Type::SequencerLoop:
+            m_sequencer.setLoop((uint32_t)command.channel, (uint32_t)command.data);
+            break;
+            
+        case AudioCommand::Type::PlayClip:
+            startClip(command.data, (RenderArena::Bus)command.channel);
+            break;
+    }
+}
+
+void SoundFontEngine::prepare(int maxFrames) {
+    m_arena.allocate(maxFrames, 2);
 }
 
 void SoundFontEngine::render(float* output, int numFrames) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    int64_t blockStart = m_framePosition.load(std::memory_order_relaxed);
+    m_callbackEnd = blockStart + numFrames;
+    
+    // Swap in banks published by the loader since the last callback
+    adoptPending(m_pianoFont);
+    adoptPending(m_metronomeFont);
+    
+    if (m_renderStatsReset.load(std::memory_order_relaxed)) {
+        m_renderStatsReset.store(false, std::memory_order_relaxed);
+        m_lateEvents.store(0, std::memory_order_relaxed);
+        m_maxLateFrames.store(0, std::memory_order_relaxed);
+        m_maxQueueNanos.store(0, std::memory_order_relaxed);
+    }
+    auto queueStart = std::chrono::steady_clock::now();
+    
+    // Take everything queued since the last callback - no lock taken.
+    // Immediate and late commands apply now, future ones go to the scheduler.
+    AudioCommand command;
+    while (m_commands.pop(command)) {
+        if (command.frame <= blockStart) {
+            if (command.frame != AudioCommand::kImmediate && command.frame < blockStart) {
+                int32_t late = (int32_t)std::min<int64_t>(blockStart - command.frame, INT32_MAX);
+                m_lateEvents.store(m_lateEvents.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                if (late > m_maxLateFrames.load(std::memory_order_relaxed)) {
+                    m_maxLateFrames.store(late, std::memory_order_relaxed);
+                }
+            }
+            applyCommand(command, blockStart);
+        } else if (!m_scheduler.schedule(command)) {
+            if (command.type == AudioCommand::Type::PlayClip) {
+                m_clipCache.release(command.data);
+            }
+            m_droppedCommands.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
     
-    // Clear output buffer
-    memset(output, 0, numFrames * 2 * sizeof(float));
+    // File events due in this callback join the scheduled notes
+    generateSequencer(blockStart);
     
-    // Render piano SoundFont
-    if (m_tsf) {
-        tsf_render_float(m_tsf, output, numFrames, 0);
+    int64_t queueNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - queueStart).count();
+    if (queueNanos > m_maxQueueNanos.load(std::memory_order_relaxed)) {
+        m_maxQueueNanos.store(queueNanos, std::memory_order_relaxed);
     }
     
-    // Mix in metronome SoundFont
-    if (m_tsfMetronome) {
-        // Render metronome to temp buffer and mix
-        std::vector<float> metronomeBuffer(numFrames * 2, 0.0f);
-        tsf_render_float(m_tsfMetronome, metronomeBuffer.data(), numFrames, 0);
+    // Split the callback at event boundaries so every event lands on its exact
+    // frame. Blocks are also capped at the arena size.
+    int maxBlockFrames = m_arena.isAllocated() ? m_arena.maxFrames() : numFrames;
+    int offset = 0;
+    while (offset < numFrames) {
+        int64_t now = blockStart + offset;
+        while (m_scheduler.popDue(now, command)) {
+            applyCommand(command, now);
+        }
+        BeatEvent beat;
+        while (m_metronome.popClick(now, beat)) {
+            if (m_uiChannel) {
+                m_uiChannel->publishBeat(beat);
+            }
+            if (!beat.muted) {
+                triggerClick(beat.level);
+            }
+        }
         
-        // Mix metronome into output
-        for (int i = 0; i < numFrames * 2; i++) {
-            output[i] += metronomeBuffer[i];
+        int frames = std::min(maxBlockFrames, numFrames - offset);
+        int64_t nextEvent = std::min(m_scheduler.nextEventFrame(), m_metronome.nextClickFrame());
+        if (nextEvent < now + frames) {
+            frames = (int)(nextEvent - now);
         }
+        
+        renderBlock(output + offset * 2, frames);
+        offset += frames;
+    }
+    
+    int voices = 0;
+    if (m_pianoFont.active) {
+        voices += tsf_active_voice_count(m_pianoFont.active);
+    }
+    if (m_pianoFont.draining) {
+        voices += tsf_active_voice_count(m_pianoFont.draining);
+    }
+    m_activeVoices.store(voices, std::memory_order_relaxed);
+    if (voices > m_peakVoices.load(std::memory_order_relaxed)) {
+        m_peakVoices.store(voices, std::memory_order_relaxed);
     }
+    
+    m_framePosition.store(blockStart + numFrames, std::memory_order_release);
+}
+
+void SoundFontEngine::generateSequencer(int64_t now) {
+    int dropped = m_sequencer.generate(now, m_callbackEnd, m_scheduler);
+    if (dropped > 0) {
+        m_droppedCommands.fetch_add((uint32_t)dropped, std::memory_order_relaxed);
+    }
+}
+
+void SoundFontEngine::adoptPending(SoundFontSlot& slot) {
+    // The replaced bank has finished its release tails: hand it back
+    if (slot.draining && tsf_active_voice_count(slot.draining) == 0 && m_retired.push(slot.draining)) {
+        slot.draining = nullptr;
+    }
+    
+    if (!slot.pending.load(std::memory_order_relaxed)) {
+        return;
+    }
+    // A second swap before the first one finished releasing cuts the oldest bank short
+    if (slot.draining) {
+        if (!m_retired.push(slot.draining)) {
+            return;  // Retry on the next callback
+        }
+        slot.draining = nullptr;
+    }
+    
+    tsf* next = slot.pending.exchange(nullptr, std::memory_order_acq_rel);
+    tsf_set_output(next, TSF_STEREO_INTERLEAVED, m_sampleRate.load(std::memory_order_relaxed), 0.0f);
+    if (&slot == &m_pianoFont) {
+        for (int channel = 0; channel < kChannelCount; channel++) {
+            applyChannelState(next, channel);
+        }
+    }
+    if (slot.active) {
+        tsf_note_off_all(slot.active);
+        slot.draining = slot.active;
+    }
+    slot.active = next;
+    if (&slot == &m_pianoFont) {
+        m_voiceCapacity.store(next->maxVoiceNum, std::memory_order_relaxed);
+    }
+}
+
+void SoundFontEngine::reserveVoices(tsf* soundfont) {
+    // With a fixed pool tsf itself only reuses voices in their release and
+    // drops the note when there are none, so make room here first
+    if (soundfont->maxVoiceNum == 0) {
+        return;  // Unbounded pool (tsf_set_max_voices failed)
+    }
+    
+    int freeVoices = 0;
+    for (int i = 0; i < soundfont->voiceNum; i++) {
+        if (soundfont->voices[i].playingPreset == -1) {
+            freeVoices++;
+        }
+    }
+    
+    while (freeVoices < kNoteVoiceHeadroom) {
+        // Oldest released voice first, then the quietest one
+        struct tsf_voice* victim = nullptr;
+        bool victimReleased = false;
+        float victimLevel = 0.0f;
+        for (int i = 0; i < soundfont->voiceNum; i++) {
+            struct tsf_voice* voice = &soundfont->voices[i];
+            if (voice->playingPreset == -1) {
+                continue;
+            }
+            bool released = voice->ampenv.segment == TSF_SEGMENT_RELEASE;
+            float level = voice->ampenv.level * tsf_decibelsToGain(voice->noteGainDB);
+            bool better;
+            if (!victim || released != victimReleased) {
+                better = !victim || released;
+            } else {
+                better = released ? voice->playIndex < victim->playIndex : level < victimLevel;
+            }
+            if (better) {
+                victim = voice;
+                victimReleased = released;
+                victimLevel = level;
+            }
+        }
+        if (!victim) {
+            break;
+        }
+        tsf_voice_kill(victim);
+        freeVoices++;
+        m_stolenVoices.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void SoundFontEngine::applyChannelState(tsf* soundfont, int channel) {
+    const ChannelState& state = m_channels[channel];
+    // A preset missing from this bank leaves the channel on its current one
+    tsf_channel_set_presetnumber(soundfont, channel, state.program, channel == kDrumChannel);
+    tsf_channel_set_volume(soundfont, channel, state.volume);
+    tsf_channel_set_pan(soundfont, channel, state.pan);
+    tsf_channel_set_sustain(soundfont, channel, state.sustain ? 1 : 0);
+}
+
+void SoundFontEngine::startClip(int slot, RenderArena::Bus bus) {
+    for (ClipVoice& voice : m_clipVoices) {
+        if (!voice.clip) {
+            voice.clip = m_clipCache.get(slot);
+            voice.slot = slot;
+            voice.position = 0;
+            voice.bus = bus;
+            return;
+        }
+    }
+    // All clip voices busy: drop the new one rather than cut a prompt short
+    m_clipCache.release(slot);
+    m_droppedCommands.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool SoundFontEngine::mixClips(RenderArena::Bus bus, float* buffer, int numFrames, bool mixing) {
+    bool wrote = false;
+    for (ClipVoice& voice : m_clipVoices) {
+        if (!voice.clip || voice.bus != bus) {
+            continue;
+        }
+        if (!wrote && !mixing) {
+            memset(buffer, 0, numFrames * 2 * sizeof(float));
+        }
+        wrote = true;
+        size_t frames = std::min((size_t)numFrames, voice.clip->frames - voice.position);
+        const float* samples = voice.clip->samples.data() + voice.position * 2;
+        DspKernels::mixAdd(buffer, samples, (int)frames * 2);
+        voice.position += frames;
+        if (voice.position >= voice.clip->frames) {
+            m_clipCache.release(voice.slot);
+            voice = ClipVoice();
+        }
+    }
+    return wrote;
+}
+
+void SoundFontEngine::stopClips() {
+    for (ClipVoice& voice : m_clipVoices) {
+        if (voice.clip) {
+            m_clipCache.release(voice.slot);
+            voice = ClipVoice();
+        }
+    }
+}
+
+bool SoundFontEngine::renderSlot(SoundFontSlot& slot, float* buffer, int numFrames, bool mixing) {
+    bool wrote = false;
+    for (tsf* soundfont : {slot.active, slot.draining}) {
+        if (soundfont) {
+            tsf_render_float(soundfont, buffer, numFrames, mixing || wrote ? 1 : 0);
+            wrote = true;
+        }
+    }
+    return wrote;
+}
+
+void SoundFontEngine::renderBlock(float* output, int numFrames) {
+    float* buses[RenderArena::BUS_COUNT];
+    for (int i = 0; i < RenderArena::BUS_COUNT; i++) {
+        buses[i] = m_arena.bus((RenderArena::Bus)i);
+    }
+    if (!buses[RenderArena::BUS_INSTRUMENT]) {
+        // No arena yet - mix everything straight into the output, unprocessed
+        memset(output, 0, numFrames * 2 * sizeof(float));
+        renderSlot(m_pianoFont, output, numFrames, true);
+        renderSlot(m_metronomeFont, output, numFrames, true);
+        mixClips(RenderArena::BUS_PROMPT, output, numFrames, true);
+        mixClips(RenderArena::BUS_SFX, output, numFrames, true);
+        return;
+    }
+    
+    // Each source renders into its own cache-resident bus; the mixer sums,
+    // ducks and limits them in one pass into the output
+    bool active[RenderArena::BUS_COUNT];
+    active[RenderArena::BUS_INSTRUMENT] = renderSlot(m_pianoFont, buses[RenderArena::BUS_INSTRUMENT], numFrames, false);
+    active[RenderArena::BUS_METRONOME] = renderSlot(m_metronomeFont, buses[RenderArena::BUS_METRONOME], numFrames, false);
+    active[RenderArena::BUS_PROMPT] = mixClips(RenderArena::BUS_PROMPT, buses[RenderArena::BUS_PROMPT], numFrames, false);
+    active[RenderArena::BUS_SFX] = mixClips(RenderArena::BUS_SFX, buses[RenderArena::BUS_SFX], numFrames, false);
+    m_mixer.process(buses, active, output, numFrames);
 }
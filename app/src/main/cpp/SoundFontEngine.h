@@ -9,61 +9,418 @@
 #define MUSIMIND_SOUNDFONT_ENGINE_H
 
 #include <android/asset_manager.h>
+#include "AudioCommand.h"
+#include "ClipCache.h"
+#include "EventScheduler.h"
+#include "LockFreeQueue.h"
+#include "Mixer.h"
+#include "MidiSequencer.h"
+#include "NativeMetronome.h"
+#include "OfflineRenderer.h"
+#include "RenderArena.h"
+#include "SoundFontSubset.h"
+#include "UiStateChannel.h"
 #include <string>
 #include <vector>
+#include <deque>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
 #include <atomic>
 
 // Forward declare tsf type (implementation in .cpp)
 struct tsf;
 
+// One note of a batch for SoundFontEngine::scheduleNotes. The layout matches
+// the five ints per event packed by NativeAudioBridge (velocity as float bits).
+struct NoteEvent {
+    int32_t channel;
+    int32_t midiNote;
+    float velocity;
+    int32_t offsetFrames;    // From the batch start frame
+    int32_t durationFrames;  // Until the note off (0 = no note off)
+};
+static_assert(sizeof(NoteEvent) == 5 * sizeof(int32_t), "NoteEvent must stay five packed ints");
+
 class SoundFontEngine {
 public:
+    // State of the most recent load request (see getLoadState)
+    enum LoadState {
+        LOAD_IDLE = 0,
+        LOAD_PENDING = 1,
+        LOAD_READY = 2,
+        LOAD_FAILED = 3
+    };
+    
+    // Internal render rate. The engine frame clock, banks and schedules all
+    // run at this rate; OboePlayer resamples to whatever the device opens at.
+    static constexpr int kSampleRate = 48000;
+    
     SoundFontEngine();
     ~SoundFontEngine();
     
-    // Initialize with Android asset manager - loads both SoundFonts
+    // Initialize with Android asset manager - loads both SoundFonts on the
+    // calling thread. The stream picks them up on its next callback.
     bool initialize(AAssetManager* assetManager, const char* pianoSfPath, const char* metronomeSfPath);
     
     // Legacy single-file initialize (for backwards compatibility)
     bool initialize(AAssetManager* assetManager, const char* sfPath);
     
-    // Play a MIDI note (piano)
+    // Load both SoundFonts on the loader thread and return immediately.
+    // A running stream renders silence until the banks are published.
+    void initializeAsync(AAssetManager* assetManager, const char* pianoSfPath, const char* metronomeSfPath);
+    void initializeAsync(AAssetManager* assetManager, const char* sfPath);
+    
+    // Replace the piano bank at runtime without restarting the stream.
+    // Sounding notes release on the old bank while new notes use the new one.
+    void swapSoundFontAsync(AAssetManager* assetManager, const char* path, int presetIndex);
+    
+    LoadState getLoadState() const { return (LoadState)m_loadState.load(std::memory_order_acquire); }
+    
+    // Play another engine's banks instead of loading any (a SessionMixer
+    // session). Every bank the source publishes - first load, swap, added
+    // presets - is shared as a tsf copy: same sample data, but a voice pool
+    // of this engine's setMaxVoices size. Preset requests and offline
+    // renders go to the source, and loading or swapping here is refused.
+    // Call once, before rendering; the source must outlive this engine.
+    void shareBanksFrom(SoundFontEngine* source);
+    
+    // Piano voice pool size for banks loaded after this call. The pool is
+    // allocated up front; when it is full a new note steals the oldest
+    // released voice, then the quietest one.
+    void setMaxVoices(int maxVoices);
+    
+    // Live piano voice usage
+    struct VoiceStats {
+        int active;       // Voices sounding in the last callback
+        int peak;         // Most voices sounding in any callback
+        int capacity;     // Pool size of the bank being rendered
+        uint32_t stolen;  // Voices cut to make room for new notes
+    };
+    VoiceStats getVoiceStats() const;
+    
+    // Directory for preset-subset cache files (see SoundFontCache).
+    // Set before initialize(); empty disables the cache.
+    void setCacheDirectory(const char* directory) { m_cacheDirectory = directory ? directory : ""; }
+    
+    // Play a MIDI note (piano). Queued; applied on the next render() call.
     void noteOn(int channel, int midiNote, float velocity);
     void noteOff(int channel, int midiNote);
     
-    // Render audio samples (called by Oboe callback)
+    // Schedule a note on the stream frame clock. startFrame == AudioCommand::kImmediate
+    // starts it on the next callback; the note-off lands exactly durationFrames later.
+    void scheduleNote(int channel, int midiNote, float velocity, int64_t startFrame, int32_t durationFrames);
+    
+    // Schedule a batch of notes relative to startFrame (kImmediate = the
+    // current frame position). Returns the number of events queued.
+    int scheduleNotes(const NoteEvent* events, int count, int64_t startFrame);
+    
+    // Release every sounding piano note and cancel the notes still scheduled
+    void allNotesOff();
+    
+    // Schedule a metronome click on an exact stream frame
+    void scheduleMetronomeClick(bool isAccented, int64_t frame);
+    
+    // Frames rendered since the engine was created (the stream frame clock)
+    int64_t getFramePosition() const { return m_framePosition.load(std::memory_order_acquire); }
+    
+    // Start the frame clock at frame instead of 0, so an engine added to a
+    // running stream shares its clock. Only before the first render().
+    void setFramePosition(int64_t frame) { m_framePosition.store(frame, std::memory_order_release); }
+    
+    // Preallocate scratch buffers for callbacks of up to maxFrames frames.
+    // Call after the stream is opened and before it starts.
+    void prepare(int maxFrames);
+    
+    // Render audio samples (called by Oboe callback). Lock-free and allocation-free.
     void render(float* output, int numFrames);
     
-    // Set output sample rate
+    // Set output sample rate. Queued; applied on the next render() call.
+    // Re-targets every bank, so the player does not use it on stream changes.
     void setSampleRate(int sampleRate);
+    int getSampleRate() const { return m_sampleRate.load(std::memory_order_relaxed); }
     
     // Get preset name
     const char* getPresetName(int preset);
     
-    // Set preset (instrument)
+    // Select a GM program on a channel (0-15; channel 9 uses the drum bank).
+    // Programs missing from the loaded bank are added on the loader thread
+    // and the channel switches when the rebuilt bank is swapped in.
     void setPreset(int channel, int preset);
     
-    // Play metronome click using Metronom.sf2
+    // Per-channel mix state, kept across bank swaps. Volume and pan are 0..1 (pan 0.5 = center).
+    void setChannelVolume(int channel, float volume);
+    void setChannelPan(int channel, float pan);
+    void setChannelSustain(int channel, bool sustain);
+    
+    // Standard MIDI File playback on the stream clock (see MidiSequencer).
+    // loadMidi parses on the calling thread and queues the programs the file
+    // uses for loading; playback stops when the new file is picked up.
+    bool loadMidi(const uint8_t* data, size_t size);
+    void playMidi(int64_t startFrame);  // kImmediate = next callback
+    void stopMidi();
+    void seekMidiTick(int32_t tick);
+    void seekMidiFrame(int32_t songFrame);  // Song position in output frames at tempo scale 1
+    void setMidiTempoScale(float scale);    // 0.5 = half speed; pitch is unchanged
+    void setMidiLoop(int32_t startTick, int32_t endTick);  // endTick <= startTick clears it
+    
+    struct MidiState {
+        double positionTick;
+        uint32_t lengthTicks;
+        bool playing;
+        int ticksPerQuarter;
+    };
+    MidiState getMidiState() const;
+    
+    // Render notes (offsets from frame 0) and/or a MIDI file to interleaved
+    // stereo floats on the calling thread, as fast as the CPU allows. Uses a
+    // private copy of the piano bank, so live playback is never disturbed.
+    // Notes off the drum channel start on `program`.
+    bool renderOffline(const NoteEvent* notes, int noteCount, const uint8_t* midiData, size_t midiSize,
+                       int sampleRate, std::vector<float>& out, int program = 0);
+    
+    // Play a prompt from the clip cache. A clip not cached yet is rendered
+    // offline first on the calling thread; after that a replay is a buffer
+    // add in render(). The key's sample rate is set to the stream rate.
+    // Clips ignore live channel state (program, volume, pan). `bus` is
+    // RenderArena::BUS_PROMPT or BUS_SFX.
+    bool playClip(ClipKey key, int64_t startFrame, RenderArena::Bus bus = RenderArena::BUS_PROMPT);
+    
+    // Render and cache a clip ahead of time without playing it
+    bool prepareClip(ClipKey key);
+    
+    void setClipCacheBudget(size_t bytes) { m_clipCache.setBudget(bytes); }
+    ClipCache::Stats getClipCacheStats() const { return m_clipCache.getStats(); }
+    
+    // Output mix (see Mixer): per-bus gain, metronome ducking, master limiter
+    void setBusGain(RenderArena::Bus bus, float gain) { m_mixer.setBusGain(bus, gain); }
+    void setDuckingDepth(float depth) { m_mixer.setDuckingDepth(depth); }
+    void setLimiter(bool enabled, float ceilingDb) { m_mixer.setLimiter(enabled, ceilingDb); }
+    
+    // Skip the limiter in render() so other engines can be summed in first,
+    // then limit the whole mix with limitOutput() (audio thread)
+    void setLimiterDeferred(bool deferred) { m_mixer.setLimiterDeferred(deferred); }
+    void limitOutput(float* output, int numFrames) { m_mixer.limit(output, numFrames); }
+    float takeLimiterReductionDb() { return m_mixer.takePeakReductionDb(); }
+    
+    // Play a one-shot metronome click using Metronom.sf2. Queued; applied on the next render() call.
     void playMetronomeClick(bool isAccented);
     
+    // Continuous metronome generated inside render(). Settings apply from the next click.
+    void setMetronomeSettings(const MetronomeSettings& settings) { m_metronome.setSettings(settings); }
+    MetronomeSettings getMetronomeSettings() const { return m_metronome.getSettings(); }
+    void startMetronome(int64_t startFrame);
+    void stopMetronome();
+    
+    // Next click reported by the metronome, with its exact frame (single reader)
+    bool pollMetronomeBeat(BeatEvent& event) { return m_metronome.pollBeat(event); }
+    
+    // Also publish every click to a shared UI channel (set before rendering starts)
+    void setUiChannel(UiStateChannel* channel) { m_uiChannel = channel; }
+    
+    // Number of commands dropped because the queue was full
+    uint32_t getDroppedCommandCount() const { return m_droppedCommands.load(std::memory_order_relaxed); }
+    
+    // Render-side costs since the last reset. render() takes no locks, so the
+    // queue time is what draining the command queue (and refilling from the
+    // sequencer) costs per callback.
+    struct RenderStats {
+        int64_t lateEvents;     // Timed commands that arrived after their frame
+        int32_t maxLateFrames;  // Worst such lateness
+        int64_t maxQueueNanos;
+    };
+    RenderStats getRenderStats() const;
+    void resetRenderStats() { m_renderStatsReset.store(true, std::memory_order_relaxed); }
+    
     // Check if loaded
-    bool isLoaded() const { return m_tsf != nullptr; }
-    bool isMetronomeLoaded() const { return m_tsfMetronome != nullptr; }
+    bool isLoaded() const { return m_pianoFont.loaded.load(std::memory_order_acquire); }
+    bool isMetronomeLoaded() const { return m_metronomeFont.loaded.load(std::memory_order_acquire); }
     
 private:
-    // Load a SoundFont from assets
-    tsf* loadSoundFont(AAssetManager* assetManager, const char* path);
+    // One SoundFont role (piano or metronome). A loaded bank is published
+    // through `pending` and adopted by render(); the bank it replaces keeps
+    // rendering until its voices have released, then goes to m_retired to
+    // be closed off the audio thread.
+    struct SoundFontSlot {
+        std::atomic<tsf*> pending{nullptr};  // Published, not yet adopted by render()
+        std::atomic<bool> loaded{false};
+        tsf* active = nullptr;    // Audio thread only
+        tsf* draining = nullptr;  // Audio thread only
+        tsf* latest = nullptr;    // Most recently published bank; guarded by m_mutex
+    };
+    
+    struct PresetId {
+        int bank;
+        int program;
+    };
+    
+    // Work for the loader thread. An empty metronomePath keeps the current metronome.
+    struct LoadJob {
+        AAssetManager* assetManager;
+        std::string pianoPath;
+        std::vector<SoundFontPresetRequest> pianoRequests;
+        std::string metronomePath;
+        std::vector<PresetId> addPresets = {};  // If set: add these to the current piano
+                                                // bank instead of loading pianoPath
+    };
     
-    tsf* m_tsf = nullptr;           // Piano SoundFont
-    tsf* m_tsfMetronome = nullptr;  // Metronome SoundFont
+    static constexpr int kDefaultMaxVoices = 32;
+    static constexpr int kMetronomeVoices = 4;
+    static constexpr int kNoteVoiceHeadroom = 2;  // A stereo zone takes two voices
+    
+    static constexpr int kChannelCount = 16;
+    static constexpr int kDrumChannel = 9;  // GM percussion channel
+    static constexpr int kDrumBank = 128;
+    
+    // Channel state mirrored on the audio thread and reapplied to every adopted bank
+    struct ChannelState {
+        int program = 0;
+        float volume = 1.0f;
+        float pan = 0.5f;
+        bool sustain = false;
+    };
+    
+    // Load a job's banks and publish them (any thread except the audio thread)
+    bool runLoadJob(const LoadJob& job);
+    void queueLoadJob(LoadJob job);
+    
+    // Queue a rebuild of the piano bank for presets it does not hold yet
+    void requestPresets(const std::vector<PresetId>& presets);
+    
+    // Bank/program pairs a MIDI file plays
+    static void collectPresets(const MidiFile& file, std::vector<PresetId>& presets);
+    void loaderLoop();
+    
+    // Hand a bank to render() (m_mutex held)
+    void publish(SoundFontSlot& slot, tsf* soundfont);
+    
+    // Close banks the audio thread has let go of
+    void reclaimRetired();
+    void closeRetired();  // m_mutex held
+    
+    // Close every bank this engine holds (rendering stopped)
+    void closeBanks();
+    
+    // Publish copies of the latest banks to one follower or all of them.
+    // m_mutex held; takes the follower's. tsf's share count is a plain int,
+    // so shared banks are only copied and closed under the source's m_mutex.
+    void shareBanks(SoundFontEngine* follower, bool piano, bool metronome, bool clearClips);
+    void shareWithFollowers(bool piano, bool metronome, bool clearClips);
+    
+    // Pick up a newly published bank (audio thread only)
+    void adoptPending(SoundFontSlot& slot);
+    
+    // Free pool voices for a new note by stealing (audio thread only)
+    void reserveVoices(tsf* soundfont);
+    
+    // Push a channel's mirrored state into a bank (audio thread only)
+    void applyChannelState(tsf* soundfont, int channel);
+    
+    // Cached clip slot for key with a play reference taken, rendering it if needed
+    int acquireClip(ClipKey& key);
+    
+    // Start a clip voice (audio thread only)
+    void startClip(int slot, RenderArena::Bus bus);
+    
+    // Add the clips sounding on a bus into buffer; false if there were none (audio thread only)
+    bool mixClips(RenderArena::Bus bus, float* buffer, int numFrames, bool mixing);
+    
+    // Stop every clip voice (audio thread only)
+    void stopClips();
+    
+    // Render a slot's active and draining banks into buffer; false if it has none
+    bool renderSlot(SoundFontSlot& slot, float* buffer, int numFrames, bool mixing);
+    
+    // Load a SoundFont from assets, keeping only the requested presets and key ranges
+    tsf* loadSoundFont(AAssetManager* assetManager, const char* path,
+                       const std::vector<SoundFontPresetRequest>& requests);
+    
+    // Index in file order of a bank/program in a SoundFont asset, or -1
+    static int findPresetIndex(AAssetManager* assetManager, const char* path, int bank, int program);
+    
+    // Queue a command for the audio thread (never blocks)
+    bool pushCommand(const AudioCommand& command);
+    
+    // Apply a command on the given stream frame (audio thread only)
+    void applyCommand(const AudioCommand& command, int64_t frame);
+    
+    // Queue the sequencer's events from now to the end of the callback (audio thread only)
+    void generateSequencer(int64_t now);
+    
+    // Start a metronome click voice (audio thread only)
+    void triggerClick(BeatEvent::Level level);
+    
+    // Render and mix one block of at most m_arena.maxFrames() frames
+    void renderBlock(float* output, int numFrames);
+    
+    SoundFontSlot m_pianoFont;
+    SoundFontSlot m_metronomeFont;
     AAssetManager* m_assetManager = nullptr;
-    std::mutex m_mutex;
-    int m_sampleRate = 44100;
+    std::string m_cacheDirectory;
+    std::mutex m_mutex;  // Guards SoundFont loading and MIDI file handoff; never taken by render()
+    std::atomic<int> m_loadState{LOAD_IDLE};
+    std::string m_pianoPath;                           // Guarded by m_mutex
+    std::vector<SoundFontPresetRequest> m_pianoRequests;  // Presets in the latest piano bank
+    
+    // Bank sharing (see shareBanksFrom). Lock order: source, then follower.
+    SoundFontEngine* m_bankSource = nullptr;
+    std::vector<SoundFontEngine*> m_followers;  // Guarded by m_mutex
+    
+    ChannelState m_channels[kChannelCount];  // Audio thread only
+    
+    std::atomic<int> m_maxVoices{kDefaultMaxVoices};
+    std::atomic<int> m_activeVoices{0};
+    std::atomic<int> m_peakVoices{0};
+    std::atomic<int> m_voiceCapacity{0};
+    std::atomic<uint32_t> m_stolenVoices{0};
+    
+    // Banks released by render(), closed by reclaimRetired()
+    LockFreeQueue<tsf*, 8> m_retired;
+    int m_unreclaimed = 0;  // Replaced banks not closed yet; guarded by m_mutex
+    
+    // Loader thread, started by the first async request
+    std::thread m_loader;
+    std::condition_variable m_loaderWake;
+    std::deque<LoadJob> m_loadJobs;  // Guarded by m_mutex
+    bool m_loaderExit = false;       // Guarded by m_mutex
+    std::atomic<int> m_sampleRate{kSampleRate};
+    
+    // Commands from JNI threads, drained at the start of each render() call
+    // Sized for whole batches (a melody or chord progression) in one callback period
+    static constexpr size_t kCommandQueueSize = 1024;
+    LockFreeQueue<AudioCommand, kCommandQueueSize> m_commands;
+    std::atomic<uint32_t> m_droppedCommands{0};
+    
+    // Written by render() only; reset there when m_renderStatsReset is set
+    std::atomic<bool> m_renderStatsReset{false};
+    std::atomic<int64_t> m_lateEvents{0};
+    std::atomic<int32_t> m_maxLateFrames{0};
+    std::atomic<int64_t> m_maxQueueNanos{0};
+    
+    // Future events, ordered by frame (audio thread only)
+    EventScheduler m_scheduler;
+    MidiSequencer m_sequencer;
+    int64_t m_callbackEnd = 0;  // First frame after the callback being rendered (audio thread only)
+    std::atomic<uint32_t> m_midiLengthTicks{0};
+    std::atomic<int> m_midiTicksPerQuarter{0};
+    NativeMetronome m_metronome;
+    UiStateChannel* m_uiChannel = nullptr;
+    std::atomic<int64_t> m_framePosition{0};
+    
+    // Pre-rendered prompts and the clips playing from it (audio thread only)
+    static constexpr int kMaxClipVoices = 8;
+    struct ClipVoice {
+        const ClipCache::Clip* clip = nullptr;
+        int slot = -1;
+        size_t position = 0;
+        RenderArena::Bus bus = RenderArena::BUS_PROMPT;
+    };
+    ClipCache m_clipCache;
+    ClipVoice m_clipVoices[kMaxClipVoices];
     
-    // Metronome state
-    std::atomic<bool> m_metronomeClick{false};
-    std::atomic<bool> m_metronomeAccented{false};
+    // Scratch buffers used by render(); sized by prepare()
+    RenderArena m_arena;
+    Mixer m_mixer;
 };
 
 #endif // MUSIMIND_SOUNDFONT_ENGINE_H
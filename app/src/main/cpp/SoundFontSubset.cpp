@@ -0,0 +1,481 @@
+/**
+ * SoundFontSubset.cpp
+ *
+ * Implementation of the SF2 hydra reader and subset builder.
+ */
+
+#include "SoundFontSubset.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cstring>
+
+#define LOG_TAG "SoundFontSubset"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+// Record sizes (SF2 spec section 7)
+constexpr uint32_t PHDR_SIZE = 38;
+constexpr uint32_t BAG_SIZE = 4;
+constexpr uint32_t MOD_SIZE = 10;
+constexpr uint32_t GEN_SIZE = 4;
+constexpr uint32_t INST_SIZE = 22;
+constexpr uint32_t SHDR_SIZE = 46;
+
+// Field offsets
+constexpr uint32_t PHDR_BAG_INDEX = 24;
+constexpr uint32_t INST_BAG_INDEX = 20;
+constexpr uint32_t SHDR_START = 20;
+constexpr uint32_t SHDR_END = 24;
+constexpr uint32_t SHDR_LOOP_START = 28;
+constexpr uint32_t SHDR_LOOP_END = 32;
+constexpr uint32_t SHDR_LINK = 42;
+
+// Generator operators
+constexpr uint16_t GEN_INSTRUMENT = 41;
+constexpr uint16_t GEN_KEY_RANGE = 43;
+constexpr uint16_t GEN_SAMPLE_ID = 53;
+
+// Zero samples the spec requires after every sample
+constexpr uint32_t SAMPLE_GUARD_FRAMES = 46;
+
+static inline uint16_t read16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t read32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void write16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void write32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void appendBytes(std::vector<uint8_t>& out, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+static void appendChunk(std::vector<uint8_t>& out, const char* id, const std::vector<uint8_t>& body) {
+    uint8_t header[8];
+    memcpy(header, id, 4);
+    write32(header + 4, (uint32_t)body.size());
+    appendBytes(out, header, 8);
+    appendBytes(out, body.data(), body.size());
+    if (body.size() & 1) {
+        out.push_back(0);
+    }
+}
+
+static void appendList(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& body) {
+    std::vector<uint8_t> list(type, type + 4);
+    appendBytes(list, body.data(), body.size());
+    appendChunk(out, "LIST", list);
+}
+
+bool SoundFontSubset::readTable(const uint8_t* chunk, uint32_t size, uint32_t recordSize, Table& table) {
+    if (size % recordSize != 0 || size < recordSize) {
+        return false;
+    }
+    table.data = chunk;
+    table.count = size / recordSize;
+    return true;
+}
+
+bool SoundFontSubset::parse(const uint8_t* data, size_t size) {
+    m_data = data;
+    m_size = size;
+    m_samples = nullptr;
+    m_sampleFrames = 0;
+    m_phdr = m_pbag = m_pmod = m_pgen = Table();
+    m_inst = m_ibag = m_imod = m_igen = Table();
+    m_shdr = Table();
+    
+    if (size < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "sfbk", 4) != 0) {
+        LOGE("Not an SF2 file");
+        return false;
+    }
+    
+    size_t riffEnd = std::min(size, (size_t)read32(data + 4) + 8);
+    size_t pos = 12;
+    bool valid = true;
+    while (valid && pos + 8 <= riffEnd) {
+        uint32_t chunkSize = read32(data + pos + 4);
+        size_t chunkEnd = pos + 8 + (size_t)chunkSize;
+        if (chunkEnd > riffEnd) {
+            LOGE("Truncated RIFF chunk");
+            return false;
+        }
+        
+        if (memcmp(data + pos, "LIST", 4) == 0 && chunkSize >= 4) {
+            const uint8_t* type = data + pos + 8;
+            size_t sub = pos + 12;
+            while (valid && sub + 8 <= chunkEnd) {
+                const uint8_t* id = data + sub;
+                uint32_t subSize = read32(data + sub + 4);
+                const uint8_t* body = data + sub + 8;
+                if (sub + 8 + (size_t)subSize > chunkEnd) {
+                    LOGE("Truncated sub-chunk");
+                    return false;
+                }
+                
+                if (memcmp(type, "sdta", 4) == 0 && memcmp(id, "smpl", 4) == 0) {
+                    m_samples = body;
+                    m_sampleFrames = subSize / 2;
+                } else if (memcmp(type, "pdta", 4) == 0) {
+                    if (memcmp(id, "phdr", 4) == 0) valid = readTable(body, subSize, PHDR_SIZE, m_phdr);
+                    else if (memcmp(id, "pbag", 4) == 0) valid = readTable(body, subSize, BAG_SIZE, m_pbag);
+                    else if (memcmp(id, "pmod", 4) == 0) valid = readTable(body, subSize, MOD_SIZE, m_pmod);
+                    else if (memcmp(id, "pgen", 4) == 0) valid = readTable(body, subSize, GEN_SIZE, m_pgen);
+                    else if (memcmp(id, "inst", 4) == 0) valid = readTable(body, subSize, INST_SIZE, m_inst);
+                    else if (memcmp(id, "ibag", 4) == 0) valid = readTable(body, subSize, BAG_SIZE, m_ibag);
+                    else if (memcmp(id, "imod", 4) == 0) valid = readTable(body, subSize, MOD_SIZE, m_imod);
+                    else if (memcmp(id, "igen", 4) == 0) valid = readTable(body, subSize, GEN_SIZE, m_igen);
+                    else if (memcmp(id, "shdr", 4) == 0) valid = readTable(body, subSize, SHDR_SIZE, m_shdr);
+                }
+                sub += 8 + subSize + (subSize & 1);
+            }
+        }
+        pos = chunkEnd + (chunkSize & 1);
+    }
+    
+    if (!valid || !m_samples || m_phdr.count < 2 || !m_pbag.data || !m_pmod.data || !m_pgen.data ||
+        !m_inst.data || !m_ibag.data || !m_imod.data || !m_igen.data || !m_shdr.data) {
+        LOGE("Incomplete SF2 hydra");
+        return false;
+    }
+    return true;
+}
+
+int SoundFontSubset::findPreset(int bank, int preset) const {
+    for (int i = 0; i < getPresetCount(); i++) {
+        const uint8_t* record = m_phdr.data + i * PHDR_SIZE;
+        if (read16(record + 20) == preset && read16(record + 22) == bank) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Key range of a zone's generator list, [0, 127] if it has none
+static void zoneKeyRange(const uint8_t* gens, uint32_t first, uint32_t last, int& low, int& high) {
+    low = 0;
+    high = 127;
+    for (uint32_t g = first; g < last; g++) {
+        const uint8_t* gen = gens + g * GEN_SIZE;
+        if (read16(gen) == GEN_KEY_RANGE) {
+            low = gen[2];
+            high = gen[3];
+            return;
+        }
+    }
+}
+
+// Index of the generator with this operator in a zone, or -1
+static int findGenerator(const uint8_t* gens, uint32_t first, uint32_t last, uint16_t oper) {
+    for (uint32_t g = first; g < last; g++) {
+        if (read16(gens + g * GEN_SIZE) == oper) {
+            return (int)g;
+        }
+    }
+    return -1;
+}
+
+bool SoundFontSubset::build(const std::vector<SoundFontPresetRequest>& requests, std::vector<uint8_t>& out) const {
+    if (!m_data || requests.empty()) {
+        return false;
+    }
+    
+    // Zone ranges for an index into a bag table
+    auto bagGens = [](const Table& bags, uint32_t b, uint32_t& first, uint32_t& last) {
+        first = read16(bags.data + b * BAG_SIZE);
+        last = read16(bags.data + (b + 1) * BAG_SIZE);
+    };
+    auto bagMods = [](const Table& bags, uint32_t b, uint32_t& first, uint32_t& last) {
+        first = read16(bags.data + b * BAG_SIZE + 2);
+        last = read16(bags.data + (b + 1) * BAG_SIZE + 2);
+    };
+    
+    // 1. Presets: keep zones that overlap the requested keys, collect instruments
+    struct InstrumentUse {
+        int newIndex = -1;
+        uint64_t keys[2] = { 0, 0 };  // Union of keys the presets can reach it with
+    };
+    std::vector<InstrumentUse> instruments(m_inst.count);
+    std::vector<int> instrumentOrder;
+    std::vector<std::vector<uint32_t>> presetBags(requests.size());
+    
+    for (size_t r = 0; r < requests.size(); r++) {
+        const SoundFontPresetRequest& request = requests[r];
+        if (request.presetIndex < 0 || request.presetIndex >= getPresetCount()) {
+            LOGE("Preset index %d out of range", request.presetIndex);
+            return false;
+        }
+        uint32_t bagFirst = read16(m_phdr.data + request.presetIndex * PHDR_SIZE + PHDR_BAG_INDEX);
+        uint32_t bagLast = read16(m_phdr.data + (request.presetIndex + 1) * PHDR_SIZE + PHDR_BAG_INDEX);
+        if (bagFirst > bagLast || bagLast >= m_pbag.count) {
+            return false;
+        }
+        
+        for (uint32_t b = bagFirst; b < bagLast; b++) {
+            uint32_t genFirst, genLast;
+            bagGens(m_pbag, b, genFirst, genLast);
+            if (genFirst > genLast || genLast >= m_pgen.count) {
+                return false;
+            }
+            
+            int instrumentGen = findGenerator(m_pgen.data, genFirst, genLast, GEN_INSTRUMENT);
+            if (instrumentGen < 0) {
+                presetBags[r].push_back(b);  // Global zone
+                continue;
+            }
+            
+            int low, high;
+            zoneKeyRange(m_pgen.data, genFirst, genLast, low, high);
+            low = std::max(low, request.keyLow);
+            high = std::min(high, request.keyHigh);
+            if (low > high) {
+                continue;
+            }
+            
+            uint16_t instrument = read16(m_pgen.data + instrumentGen * GEN_SIZE + 2);
+            if (instrument + 1u >= m_inst.count) {
+                return false;
+            }
+            InstrumentUse& use = instruments[instrument];
+            if (use.newIndex < 0) {
+                use.newIndex = (int)instrumentOrder.size();
+                instrumentOrder.push_back(instrument);
+            }
+            for (int key = low; key <= high; key++) {
+                use.keys[key >> 6] |= 1ull << (key & 63);
+            }
+            presetBags[r].push_back(b);
+        }
+    }
+    
+    // 2. Instruments: keep zones reachable through those keys, collect samples
+    std::vector<int> sampleMap(m_shdr.count, -1);
+    std::vector<int> sampleOrder;
+    std::vector<std::vector<uint32_t>> instrumentBags(instrumentOrder.size());
+    
+    for (size_t i = 0; i < instrumentOrder.size(); i++) {
+        int instrument = instrumentOrder[i];
+        const InstrumentUse& use = instruments[instrument];
+        uint32_t bagFirst = read16(m_inst.data + instrument * INST_SIZE + INST_BAG_INDEX);
+        uint32_t bagLast = read16(m_inst.data + (instrument + 1) * INST_SIZE + INST_BAG_INDEX);
+        if (bagFirst > bagLast || bagLast >= m_ibag.count) {
+            return false;
+        }
+        
+        for (uint32_t b = bagFirst; b < bagLast; b++) {
+            uint32_t genFirst, genLast;
+            bagGens(m_ibag, b, genFirst, genLast);
+            if (genFirst > genLast || genLast >= m_igen.count) {
+                return false;
+            }
+            
+            int sampleGen = findGenerator(m_igen.data, genFirst, genLast, GEN_SAMPLE_ID);
+            if (sampleGen < 0) {
+                instrumentBags[i].push_back(b);  // Global zone
+                continue;
+            }
+            
+            int low, high;
+            zoneKeyRange(m_igen.data, genFirst, genLast, low, high);
+            bool reachable = false;
+            for (int key = low; key <= high && !reachable; key++) {
+                reachable = (use.keys[key >> 6] >> (key & 63)) & 1;
+            }
+            if (!reachable) {
+                continue;
+            }
+            
+            uint16_t sample = read16(m_igen.data + sampleGen * GEN_SIZE + 2);
+            if (sample + 1u >= m_shdr.count) {
+                return false;
+            }
+            if (sampleMap[sample] < 0) {
+                sampleMap[sample] = (int)sampleOrder.size();
+                sampleOrder.push_back(sample);
+            }
+            instrumentBags[i].push_back(b);
+        }
+    }
+    
+    // 3. Sample data: copy each referenced region, followed by the guard frames
+    std::vector<uint8_t> smpl;
+    std::vector<uint8_t> shdr;
+    size_t totalFrames = 0;
+    for (int sample : sampleOrder) {
+        const uint8_t* header = m_shdr.data + sample * SHDR_SIZE;
+        uint32_t start = read32(header + SHDR_START);
+        uint32_t end = read32(header + SHDR_END);
+        if (start > end || end > m_sampleFrames) {
+            LOGE("Sample %d out of range", sample);
+            return false;
+        }
+        totalFrames += end - start + SAMPLE_GUARD_FRAMES;
+    }
+    smpl.reserve(totalFrames * 2);
+    shdr.reserve((sampleOrder.size() + 1) * SHDR_SIZE);
+    
+    for (size_t s = 0; s < sampleOrder.size(); s++) {
+        const uint8_t* source = m_shdr.data + sampleOrder[s] * SHDR_SIZE;
+        uint32_t start = read32(source + SHDR_START);
+        uint32_t end = read32(source + SHDR_END);
+        uint32_t newStart = (uint32_t)(smpl.size() / 2);
+        uint32_t newEnd = newStart + (end - start);
+        
+        appendBytes(smpl, m_samples + (size_t)start * 2, (size_t)(end - start) * 2);
+        smpl.insert(smpl.end(), SAMPLE_GUARD_FRAMES * 2, 0);
+        
+        uint8_t header[SHDR_SIZE];
+        memcpy(header, source, SHDR_SIZE);
+        auto relocate = [&](uint32_t offset) {
+            uint32_t value = read32(source + offset);
+            value = std::min(std::max(value, start), end) - start + newStart;
+            write32(header + offset, value);
+        };
+        write32(header + SHDR_START, newStart);
+        write32(header + SHDR_END, newEnd);
+        relocate(SHDR_LOOP_START);
+        relocate(SHDR_LOOP_END);
+        
+        uint16_t link = read16(source + SHDR_LINK);
+        write16(header + SHDR_LINK, link < sampleMap.size() && sampleMap[link] >= 0 ? (uint16_t)sampleMap[link] : 0);
+        appendBytes(shdr, header, SHDR_SIZE);
+    }
+    uint8_t terminalSample[SHDR_SIZE] = {};
+    memcpy(terminalSample, "EOS", 3);
+    appendBytes(shdr, terminalSample, SHDR_SIZE);
+    
+    // 4. Zone tables, with instrument and sample references renumbered
+    auto emitZones = [&](const Table& bags, const Table& gens, const Table& mods,
+                         const std::vector<uint32_t>& zoneList, uint16_t refOper,
+                         const std::vector<int>& remap,
+                         std::vector<uint8_t>& bagOut, std::vector<uint8_t>& genOut,
+                         std::vector<uint8_t>& modOut) -> bool {
+        for (uint32_t b : zoneList) {
+            uint8_t bag[BAG_SIZE];
+            write16(bag, (uint16_t)(genOut.size() / GEN_SIZE));
+            write16(bag + 2, (uint16_t)(modOut.size() / MOD_SIZE));
+            appendBytes(bagOut, bag, BAG_SIZE);
+            
+            uint32_t genFirst, genLast, modFirst, modLast;
+            bagGens(bags, b, genFirst, genLast);
+            bagMods(bags, b, modFirst, modLast);
+            if (modFirst > modLast || modLast >= mods.count) {
+                return false;
+            }
+            for (uint32_t g = genFirst; g < genLast; g++) {
+                uint8_t gen[GEN_SIZE];
+                memcpy(gen, gens.data + g * GEN_SIZE, GEN_SIZE);
+                if (read16(gen) == refOper) {
+                    write16(gen + 2, (uint16_t)remap[read16(gen + 2)]);
+                }
+                appendBytes(genOut, gen, GEN_SIZE);
+            }
+            appendBytes(modOut, mods.data + modFirst * MOD_SIZE, (size_t)(modLast - modFirst) * MOD_SIZE);
+        }
+        return true;
+    };
+    
+    std::vector<int> instrumentMap(m_inst.count, -1);
+    for (size_t i = 0; i < instrumentOrder.size(); i++) {
+        instrumentMap[instrumentOrder[i]] = (int)i;
+    }
+    
+    std::vector<uint8_t> phdr, pbag, pmod, pgen;
+    for (size_t r = 0; r < requests.size(); r++) {
+        uint8_t header[PHDR_SIZE];
+        memcpy(header, m_phdr.data + requests[r].presetIndex * PHDR_SIZE, PHDR_SIZE);
+        write16(header + PHDR_BAG_INDEX, (uint16_t)(pbag.size() / BAG_SIZE));
+        appendBytes(phdr, header, PHDR_SIZE);
+        
+        if (!emitZones(m_pbag, m_pgen, m_pmod, presetBags[r], GEN_INSTRUMENT, instrumentMap,
+                       pbag, pgen, pmod)) {
+            return false;
+        }
+    }
+    
+    std::vector<uint8_t> inst, ibag, imod, igen;
+    for (size_t i = 0; i < instrumentOrder.size(); i++) {
+        uint8_t header[INST_SIZE];
+        memcpy(header, m_inst.data + instrumentOrder[i] * INST_SIZE, INST_SIZE);
+        write16(header + INST_BAG_INDEX, (uint16_t)(ibag.size() / BAG_SIZE));
+        appendBytes(inst, header, INST_SIZE);
+        
+        if (!emitZones(m_ibag, m_igen, m_imod, instrumentBags[i], GEN_SAMPLE_ID, sampleMap,
+                       ibag, igen, imod)) {
+            return false;
+        }
+    }
+    
+    // Terminal records
+    uint8_t terminalPreset[PHDR_SIZE] = {};
+    memcpy(terminalPreset, "EOP", 3);
+    write16(terminalPreset + PHDR_BAG_INDEX, (uint16_t)(pbag.size() / BAG_SIZE));
+    appendBytes(phdr, terminalPreset, PHDR_SIZE);
+    
+    uint8_t terminalInst[INST_SIZE] = {};
+    memcpy(terminalInst, "EOI", 3);
+    write16(terminalInst + INST_BAG_INDEX, (uint16_t)(ibag.size() / BAG_SIZE));
+    appendBytes(inst, terminalInst, INST_SIZE);
+    
+    uint8_t terminalBag[BAG_SIZE];
+    write16(terminalBag, (uint16_t)(pgen.size() / GEN_SIZE));
+    write16(terminalBag + 2, (uint16_t)(pmod.size() / MOD_SIZE));
+    appendBytes(pbag, terminalBag, BAG_SIZE);
+    write16(terminalBag, (uint16_t)(igen.size() / GEN_SIZE));
+    write16(terminalBag + 2, (uint16_t)(imod.size() / MOD_SIZE));
+    appendBytes(ibag, terminalBag, BAG_SIZE);
+    pgen.insert(pgen.end(), GEN_SIZE, 0);
+    igen.insert(igen.end(), GEN_SIZE, 0);
+    pmod.insert(pmod.end(), MOD_SIZE, 0);
+    imod.insert(imod.end(), MOD_SIZE, 0);
+    
+    // 5. RIFF container
+    std::vector<uint8_t> info;
+    {
+        std::vector<uint8_t> version(4);
+        write16(version.data(), 2);
+        write16(version.data() + 2, 1);
+        appendChunk(info, "ifil", version);
+        const char engine[] = "EMU8000";
+        appendChunk(info, "isng", std::vector<uint8_t>(engine, engine + sizeof(engine)));
+        const char name[] = "MusiMind subset";
+        appendChunk(info, "INAM", std::vector<uint8_t>(name, name + sizeof(name)));
+    }
+    std::vector<uint8_t> sdta;
+    appendChunk(sdta, "smpl", smpl);
+    std::vector<uint8_t> pdta;
+    appendChunk(pdta, "phdr", phdr);
+    appendChunk(pdta, "pbag", pbag);
+    appendChunk(pdta, "pmod", pmod);
+    appendChunk(pdta, "pgen", pgen);
+    appendChunk(pdta, "inst", inst);
+    appendChunk(pdta, "ibag", ibag);
+    appendChunk(pdta, "imod", imod);
+    appendChunk(pdta, "igen", igen);
+    appendChunk(pdta, "shdr", shdr);
+    
+    std::vector<uint8_t> body(4);
+    memcpy(body.data(), "sfbk", 4);
+    appendList(body, "INFO", info);
+    appendList(body, "sdta", sdta);
+    appendList(body, "pdta", pdta);
+    
+    out.clear();
+    out.reserve(body.size() + 8);
+    appendChunk(out, "RIFF", body);
+    
+    m_lastSampleFrames = totalFrames;
+    return true;
+}
@@ -0,0 +1,67 @@
+/**
+ * SoundFontSubset.h
+ *
+ * SF2 hydra reader and preset-subset builder.
+ * parse() walks the RIFF structure of a (mapped) SoundFont and indexes the
+ * preset, instrument, zone and sample header tables without touching the
+ * sample data. build() then writes a standalone SF2 holding only the
+ * requested presets and the instruments, zones and sample regions they can
+ * reach, optionally limited to a key range. Only those sample regions are
+ * read from the source, so only their pages are faulted in, and TinySoundFont
+ * only converts samples that can actually play.
+ *
+ * Reference: SoundFont 2.04 Technical Specification, sections 6-8
+ */
+
+#ifndef MUSIMIND_SOUNDFONT_SUBSET_H
+#define MUSIMIND_SOUNDFONT_SUBSET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct SoundFontPresetRequest {
+    int presetIndex;   // Preset in file order (see findPreset)
+    int keyLow = 0;    // Zones entirely outside [keyLow, keyHigh] are dropped
+    int keyHigh = 127;
+};
+
+class SoundFontSubset {
+public:
+    // Index the hydra of an SF2 image. data must stay valid for build().
+    bool parse(const uint8_t* data, size_t size);
+    
+    int getPresetCount() const { return m_phdr.count > 0 ? (int)m_phdr.count - 1 : 0; }
+    
+    // Index of the preset with this bank/program, or -1
+    int findPreset(int bank, int preset) const;
+    
+    // Write a standalone SF2. Request i becomes preset index i in the result.
+    bool build(const std::vector<SoundFontPresetRequest>& requests, std::vector<uint8_t>& out) const;
+    
+    // Sample frames referenced by the last successful build()
+    size_t getLastBuildSampleFrames() const { return m_lastSampleFrames; }
+    
+private:
+    // Fixed-size record table inside the pdta chunk (count includes the terminal record)
+    struct Table {
+        const uint8_t* data = nullptr;
+        uint32_t count = 0;
+    };
+    
+    bool readTable(const uint8_t* chunk, uint32_t size, uint32_t recordSize, Table& table);
+    
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    
+    const uint8_t* m_samples = nullptr;  // smpl chunk, 16-bit mono PCM
+    uint32_t m_sampleFrames = 0;
+    
+    Table m_phdr, m_pbag, m_pmod, m_pgen;
+    Table m_inst, m_ibag, m_imod, m_igen;
+    Table m_shdr;
+    
+    mutable size_t m_lastSampleFrames = 0;
+};
+
+#endif // MUSIMIND_SOUNDFONT_SUBSET_H
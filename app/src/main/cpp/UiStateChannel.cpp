@@ -0,0 +1,138 @@
+/**
+ * UiStateChannel.cpp
+ *
+ * Implementation of the shared-memory UI channel.
+ */
+
+#include "UiStateChannel.h"
+#include "NativeMetronome.h"
+#include "OnsetDetector.h"
+#include "YinPitchDetector.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Level meters fall by 1/e over this time after a peak, so a 60 fps reader
+// still sees transients shorter than its frame interval
+constexpr float kMeterReleaseSeconds = 0.3f;
+
+template <typename T>
+inline void put(std::atomic<T>& field, T value) {
+    field.store(value, std::memory_order_relaxed);
+}
+
+} // namespace
+
+void UiStateChannel::reset(int sampleRate) {
+    m_sampleRate = sampleRate > 0 ? sampleRate : 48000;
+    m_inputLevel = 0.0f;
+    m_outputLevel = 0.0f;
+    
+    Layout& l = m_layout;
+    put(l.version, kLayoutVersion);
+    put(l.pitchRingSize, (uint32_t)kPitchRingSize);
+    put(l.sampleRate, (uint32_t)m_sampleRate);
+    put(l.stateSequence, 0u);
+    put(l.engineFrame, (int64_t)0);
+    put(l.pitchFrame, (int64_t)-1);
+    put(l.frequency, 0.0f);
+    put(l.confidence, 0.0f);
+    put(l.centDeviation, 0.0f);
+    put(l.midiNote, 0);
+    put(l.rms, 0.0f);
+    put(l.voiced, 0);
+    put(l.inputLevel, 0.0f);
+    put(l.outputLevel, 0.0f);
+    put(l.beatFrame, (int64_t)-1);
+    put(l.beat, 0);
+    put(l.beatLevel, 0);
+    put(l.onsetFrame, (int64_t)-1);
+    put(l.onsetStrength, 0.0f);
+    put(l.beatSubdivision, 0);
+    put(l.analysisSequence, 0u);
+    std::fill(std::begin(l.reserved), std::end(l.reserved), 0);
+    for (PitchEntry& entry : l.pitch) {
+        put(entry.sequence, 0u);
+        put(entry.midiNote, 0);
+        put(entry.framePosition, (int64_t)0);
+        put(entry.frequency, 0.0f);
+        put(entry.confidence, 0.0f);
+        put(entry.centDeviation, 0.0f);
+        put(entry.rms, 0.0f);
+        put(entry.voiced, 0);
+        put(entry.windowSize, 0);
+    }
+    // Publish the cleared block before the first reader can see it
+    l.pitchCount.store(0, std::memory_order_release);
+}
+
+void UiStateChannel::beginWrite(std::atomic<uint32_t>& sequence) {
+    uint32_t value = sequence.load(std::memory_order_relaxed);
+    sequence.store(value + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void UiStateChannel::endWrite(std::atomic<uint32_t>& sequence) {
+    uint32_t value = sequence.load(std::memory_order_relaxed);
+    sequence.store(value + 1, std::memory_order_release);
+}
+
+void UiStateChannel::publishPitch(const PitchFrame& frame) {
+    Layout& l = m_layout;
+    
+    // Ring entry first, under its own sequence
+    int64_t n = l.pitchCount.load(std::memory_order_relaxed);
+    PitchEntry& entry = l.pitch[n % kPitchRingSize];
+    uint32_t sequence = (uint32_t)n * 2u;
+    entry.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    put(entry.midiNote, frame.midiNote);
+    put(entry.framePosition, frame.framePosition);
+    put(entry.frequency, frame.frequency);
+    put(entry.confidence, frame.confidence);
+    put(entry.centDeviation, frame.centDeviation);
+    put(entry.rms, frame.rms);
+    put(entry.voiced, frame.isVoiced ? 1 : 0);
+    put(entry.windowSize, frame.windowSize);
+    entry.sequence.store(sequence + 2, std::memory_order_release);
+    l.pitchCount.store(n + 1, std::memory_order_release);
+    
+    beginWrite(l.analysisSequence);
+    put(l.pitchFrame, frame.framePosition);
+    put(l.frequency, frame.frequency);
+    put(l.confidence, frame.confidence);
+    put(l.centDeviation, frame.centDeviation);
+    put(l.midiNote, frame.midiNote);
+    put(l.rms, frame.rms);
+    put(l.voiced, frame.isVoiced ? 1 : 0);
+    endWrite(l.analysisSequence);
+}
+
+void UiStateChannel::publishBeat(const BeatEvent& event) {
+    beginWrite(m_layout.stateSequence);
+    put(m_layout.beatFrame, event.frame);
+    put(m_layout.beat, event.beat);
+    put(m_layout.beatSubdivision, event.subdivision);
+    put(m_layout.beatLevel, (int32_t)event.level);
+    endWrite(m_layout.stateSequence);
+}
+
+void UiStateChannel::publishOnset(const OnsetEvent& onset) {
+    beginWrite(m_layout.analysisSequence);
+    put(m_layout.onsetFrame, onset.framePosition);
+    put(m_layout.onsetStrength, onset.strength);
+    endWrite(m_layout.analysisSequence);
+}
+
+void UiStateChannel::publishLevels(int64_t engineFrame, int numFrames, float inputPeak, float outputPeak) {
+    float release = std::exp(-(float)numFrames / (kMeterReleaseSeconds * (float)m_sampleRate));
+    m_inputLevel = std::max(std::min(inputPeak, 1.0f), m_inputLevel * release);
+    m_outputLevel = std::max(std::min(outputPeak, 1.0f), m_outputLevel * release);
+    
+    beginWrite(m_layout.stateSequence);
+    put(m_layout.engineFrame, engineFrame);
+    put(m_layout.inputLevel, m_inputLevel);
+    put(m_layout.outputLevel, m_outputLevel);
+    endWrite(m_layout.stateSequence);
+}
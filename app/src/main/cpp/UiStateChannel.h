@@ -0,0 +1,133 @@
+/**
+ * UiStateChannel.h
+ *
+ * Shared-memory channel from the native audio threads to the Kotlin UI.
+ * A fixed block of memory, exposed to Kotlin as one direct ByteBuffer, holds
+ * the latest state in two seqlocked blocks, followed by a ring of recent
+ * pitch frames whose entries each carry their own sequence number. The UI
+ * polls it every frame with plain memory reads: no JNI call, no copy, no
+ * allocation.
+ *
+ * Each block has exactly one writer: the audio callback owns the engine
+ * block (frame clock, input/output levels, last beat), the analysis worker
+ * owns the analysis block (latest pitch, last onset) and the pitch ring.
+ * Publishing is a handful of relaxed stores between two sequence stores and
+ * never waits for a reader. A reader that overlaps a write sees an odd or
+ * changed sequence and retries; a pitch entry that was overwritten while
+ * being read is skipped.
+ *
+ * The byte layout is part of the contract with NativeUiChannel.kt: offsets
+ * are checked by static_asserts below and bumping kLayoutVersion is required
+ * for any change. All values are in the platform's native byte order.
+ */
+
+#ifndef MUSIMIND_UI_STATE_CHANNEL_H
+#define MUSIMIND_UI_STATE_CHANNEL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+struct PitchFrame;
+struct BeatEvent;
+struct OnsetEvent;
+
+class UiStateChannel {
+public:
+    static constexpr uint32_t kLayoutVersion = 2;
+    static constexpr int kPitchRingSize = 64;
+    
+    // One pitch frame in the ring. sequence is 2n + 1 while frame n is being
+    // written and 2n + 2 once it is complete.
+    struct PitchEntry {
+        std::atomic<uint32_t> sequence;
+        std::atomic<int32_t> midiNote;
+        std::atomic<int64_t> framePosition;
+        std::atomic<float> frequency;
+        std::atomic<float> confidence;
+        std::atomic<float> centDeviation;
+        std::atomic<float> rms;
+        std::atomic<int32_t> voiced;
+        std::atomic<int32_t> windowSize;
+    };
+    
+    struct Layout {
+        // Header, written once by reset()
+        std::atomic<uint32_t> version;
+        std::atomic<uint32_t> pitchRingSize;
+        std::atomic<uint32_t> sampleRate;
+        std::atomic<uint32_t> stateSequence;  // Seqlock over the engine fields: odd while writing
+        
+        // State: engine fields (engineFrame, levels, beat*) under stateSequence,
+        // analysis fields (pitch*, onset*) under analysisSequence
+        std::atomic<int64_t> engineFrame;     // Engine frame at the end of the last callback
+        std::atomic<int64_t> pitchFrame;      // Latest pitch frame, -1 before the first
+        std::atomic<float> frequency;
+        std::atomic<float> confidence;
+        std::atomic<float> centDeviation;
+        std::atomic<int32_t> midiNote;
+        std::atomic<float> rms;
+        std::atomic<int32_t> voiced;
+        std::atomic<float> inputLevel;        // Peak meters with a short release, [0, 1]
+        std::atomic<float> outputLevel;
+        std::atomic<int64_t> beatFrame;       // Latest metronome click, -1 before the first
+        std::atomic<int32_t> beat;
+        std::atomic<int32_t> beatLevel;       // BeatEvent::Level
+        std::atomic<int64_t> onsetFrame;      // Latest input onset, -1 before the first
+        std::atomic<float> onsetStrength;
+        std::atomic<int32_t> beatSubdivision;
+        
+        // Pitch frames published so far; frame n lives at pitch[n % kPitchRingSize]
+        std::atomic<int64_t> pitchCount;
+        std::atomic<uint32_t> analysisSequence;  // Seqlock over the analysis fields
+        uint8_t reserved[20];
+        
+        PitchEntry pitch[kPitchRingSize];
+    };
+    
+    UiStateChannel() { reset(0); }
+    
+    // Clear all state. Not real-time safe; only call while nothing publishes.
+    void reset(int sampleRate);
+    
+    // Analysis block writer (analysis thread only)
+    void publishPitch(const PitchFrame& frame);
+    void publishOnset(const OnsetEvent& onset);
+    
+    // Engine block writer (audio thread only)
+    void publishBeat(const BeatEvent& event);
+    
+    // Once per callback: advance the level meters by numFrames and stamp the engine frame
+    void publishLevels(int64_t engineFrame, int numFrames, float inputPeak, float outputPeak);
+    
+    // Memory handed to Kotlin; valid for the lifetime of the channel
+    void* data() { return &m_layout; }
+    static constexpr size_t size() { return sizeof(Layout); }
+    
+private:
+    static void beginWrite(std::atomic<uint32_t>& sequence);
+    static void endWrite(std::atomic<uint32_t>& sequence);
+    
+    Layout m_layout;
+    
+    // Meter state (audio thread only)
+    float m_inputLevel = 0.0f;
+    float m_outputLevel = 0.0f;
+    int m_sampleRate = 48000;
+};
+
+// Shared with NativeUiChannel.kt
+static_assert(std::atomic<int64_t>::is_always_lock_free, "64-bit atomics must be lock-free to share with Java");
+static_assert(sizeof(UiStateChannel::PitchEntry) == 40, "Pitch entry layout changed");
+static_assert(offsetof(UiStateChannel::PitchEntry, framePosition) == 8, "Pitch entry layout changed");
+static_assert(offsetof(UiStateChannel::PitchEntry, windowSize) == 36, "Pitch entry layout changed");
+static_assert(offsetof(UiStateChannel::Layout, stateSequence) == 12, "Channel layout changed");
+static_assert(offsetof(UiStateChannel::Layout, engineFrame) == 16, "Channel layout changed");
+static_assert(offsetof(UiStateChannel::Layout, inputLevel) == 56, "Channel layout changed");
+static_assert(offsetof(UiStateChannel::Layout, beatFrame) == 64, "Channel layout changed");
+static_assert(offsetof(UiStateChannel::Layout, onsetFrame) == 80, "Channel layout changed");
+static_assert(offsetof(UiStateChannel::Layout, pitchCount) == 96, "Channel layout changed");
+static_assert(offsetof(UiStateChannel::Layout, analysisSequence) == 104, "Channel layout changed");
+static_assert(offsetof(UiStateChannel::Layout, pitch) == 128, "Channel layout changed");
+
+#endif // MUSIMIND_UI_STATE_CHANNEL_H
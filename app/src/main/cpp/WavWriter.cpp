@@ -0,0 +1,88 @@
+/**
+ * WavWriter.cpp
+ *
+ * Implementation of the 16-bit PCM WAV writer.
+ */
+
+#include "WavWriter.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#define LOG_TAG "WavWriter"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+void putU16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+void putU32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+} // namespace
+
+bool WavWriter::write(const char* path, const float* interleaved, size_t frames,
+                      int channels, int sampleRate) {
+    if (!path || channels <= 0 || sampleRate <= 0) {
+        return false;
+    }
+    uint64_t dataBytes = (uint64_t)frames * channels * sizeof(int16_t);
+    if (dataBytes > UINT32_MAX - 36) {
+        LOGE("Render too long for a WAV file: %zu frames", frames);
+        return false;
+    }
+    
+    uint8_t header[44];
+    std::copy_n("RIFF", 4, header);
+    putU32(header + 4, (uint32_t)(36 + dataBytes));
+    std::copy_n("WAVE", 4, header + 8);
+    std::copy_n("fmt ", 4, header + 12);
+    putU32(header + 16, 16);
+    putU16(header + 20, 1);  // PCM
+    putU16(header + 22, (uint16_t)channels);
+    putU32(header + 24, (uint32_t)sampleRate);
+    putU32(header + 28, (uint32_t)(sampleRate * channels * sizeof(int16_t)));
+    putU16(header + 32, (uint16_t)(channels * sizeof(int16_t)));
+    putU16(header + 34, 16);
+    std::copy_n("data", 4, header + 36);
+    putU32(header + 40, (uint32_t)dataBytes);
+    
+    std::string tempPath = std::string(path) + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        LOGE("Cannot create %s", tempPath.c_str());
+        return false;
+    }
+    bool ok = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    
+    // Convert in chunks; samples are little-endian like the header
+    uint8_t chunk[4096 * 2];
+    size_t total = frames * channels;
+    for (size_t done = 0; ok && done < total;) {
+        size_t n = std::min(total - done, sizeof(chunk) / 2);
+        for (size_t i = 0; i < n; i++) {
+            float sample = std::max(-1.0f, std::min(1.0f, interleaved[done + i]));
+            putU16(chunk + i * 2, (uint16_t)(int16_t)std::lrint(sample * 32767.0f));
+        }
+        ok = fwrite(chunk, 2, n, file) == n;
+        done += n;
+    }
+    ok = fclose(file) == 0 && ok;
+    
+    if (!ok || rename(tempPath.c_str(), path) != 0) {
+        LOGE("Failed to write %s", path);
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
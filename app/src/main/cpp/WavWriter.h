@@ -0,0 +1,20 @@
+/**
+ * WavWriter.h
+ *
+ * Minimal RIFF/WAVE writer for offline renders: 16-bit PCM, interleaved.
+ */
+
+#ifndef MUSIMIND_WAV_WRITER_H
+#define MUSIMIND_WAV_WRITER_H
+
+#include <cstddef>
+
+class WavWriter {
+public:
+    // Write float samples in -1..1 (clipped) as 16-bit PCM. Writes to a
+    // temporary file and renames it, so readers never see a partial file.
+    static bool write(const char* path, const float* interleaved, size_t frames,
+                      int channels, int sampleRate);
+};
+
+#endif // MUSIMIND_WAV_WRITER_H
@@ -0,0 +1,172 @@
+/**
+ * YinPitchDetector.cpp
+ *
+ * Implementation of the native YIN pitch detector.
+ */
+
+#include "YinPitchDetector.h"
+#include "DspKernels.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+constexpr float MIN_FREQUENCY = 80.0f;    // ~E2
+constexpr float MAX_FREQUENCY = 1000.0f;  // ~B5
+constexpr float SILENCE_RMS = 0.01f;
+
+YinPitchDetector::YinPitchDetector(int sampleRate, int windowSize, float threshold)
+    : m_sampleRate(sampleRate),
+      m_windowSize(windowSize),
+      m_threshold(threshold),
+      m_hannWindow(windowSize),
+      m_windowed(windowSize),
+      m_yinBuffer(windowSize / 2),
+      m_fft(windowSize),
+      m_halfWindowed(windowSize, 0.0f),
+      m_spectrumA(windowSize + 2),
+      m_spectrumB(windowSize + 2),
+      m_correlation(windowSize),
+      m_energy(windowSize + 1) {
+    for (int i = 0; i < windowSize; i++) {
+        m_hannWindow[i] = 0.5f * (1.0f - std::cos(2.0f * (float)M_PI * i / (windowSize - 1)));
+    }
+    
+    // Period limits (inverse of frequency)
+    m_minPeriod = (int)(sampleRate / MAX_FREQUENCY);
+    m_maxPeriod = std::min((int)(sampleRate / MIN_FREQUENCY), windowSize / 2 - 1);
+}
+
+YinPitchDetector YinPitchDetector::forPreset(Preset preset, int sampleRate) {
+    if (preset == PRESET_INSTRUMENT) {
+        // ~92ms - better frequency resolution
+        return YinPitchDetector(sampleRate, 4096, 0.15f);
+    }
+    // ~46ms @ 44.1kHz - good for voice, lower threshold for better precision
+    return YinPitchDetector(sampleRate, 2048, 0.10f);
+}
+
+PitchFrame YinPitchDetector::silence(int64_t framePosition, float rms) const {
+    PitchFrame frame = {};
+    frame.framePosition = framePosition;
+    frame.windowSize = m_windowSize;
+    frame.rms = rms;
+    return frame;
+}
+
+PitchFrame YinPitchDetector::detect(const float* input, int64_t framePosition) {
+    // Skip silence
+    float sum = DspKernels::sumOfSquares(input, m_windowSize);
+    float rms = std::sqrt(sum / m_windowSize);
+    if (rms < SILENCE_RMS) {
+        return silence(framePosition, rms);
+    }
+    
+    // 1. Hann window
+    DspKernels::multiply(input, m_hannWindow.data(), m_windowed.data(), m_windowSize);
+    
+    // 2. Difference function
+    computeDifference(m_windowed.data());
+    
+    // 3. Cumulative mean normalization
+    cumulativeMeanNormalize();
+    
+    // 4. First minimum below threshold
+    int tauEstimate = absoluteThreshold();
+    if (tauEstimate == -1) {
+        return silence(framePosition, rms);
+    }
+    
+    // 5. Parabolic interpolation for sub-sample precision
+    float betterTau = parabolicInterpolation(tauEstimate);
+    float frequency = m_sampleRate / betterTau;
+    if (frequency < MIN_FREQUENCY || frequency > MAX_FREQUENCY) {
+        return silence(framePosition, rms);
+    }
+    
+    // 6. MIDI note and cent deviation
+    float exactMidi = 69.0f + 12.0f * std::log2(frequency / 440.0f);
+    int midiNote = (int)std::lround(exactMidi);
+    
+    PitchFrame frame = silence(framePosition, rms);
+    frame.frequency = frequency;
+    frame.confidence = std::min(std::max(1.0f - m_yinBuffer[tauEstimate], 0.0f), 1.0f);
+    frame.midiNote = midiNote;
+    frame.centDeviation = (exactMidi - midiNote) * 100.0f;
+    frame.isVoiced = true;
+    return frame;
+}
+
+// d(tau) = sum (x[j] - x[j + tau])^2, j < W
+//        = sum x[j]^2 + sum x[j + tau]^2 - 2 * r(tau)
+// with r(tau) = sum x[j] * x[j + tau] taken from IFFT(conj(FFT(a)) * FFT(x)),
+// where a is the first W samples zero-padded to the window size. Since
+// j + tau <= 2W - 2 the circular correlation never wraps.
+void YinPitchDetector::computeDifference(const float* buffer) {
+    int halfWindow = m_windowSize / 2;
+    
+    std::copy(buffer, buffer + halfWindow, m_halfWindowed.begin());
+    m_fft.forward(m_halfWindowed.data(), m_spectrumA.data());
+    m_fft.forward(buffer, m_spectrumB.data());
+    DspKernels::multiplyConjugate(m_spectrumA.data(), m_spectrumB.data(),
+                                  m_spectrumB.data(), halfWindow + 1);
+    m_fft.inverse(m_spectrumB.data(), m_correlation.data());
+    
+    // Energy prefix sums in double: the differences of large sums lose too
+    // much precision in float for long windows
+    m_energy[0] = 0.0;
+    for (int i = 0; i < m_windowSize; i++) {
+        m_energy[i + 1] = m_energy[i] + (double)buffer[i] * buffer[i];
+    }
+    
+    double headEnergy = m_energy[halfWindow];
+    for (int tau = 0; tau < halfWindow; tau++) {
+        double shiftedEnergy = m_energy[tau + halfWindow] - m_energy[tau];
+        double d = headEnergy + shiftedEnergy - 2.0 * m_correlation[tau];
+        m_yinBuffer[tau] = d > 0.0 ? (float)d : 0.0f;
+    }
+}
+
+// d'(tau) = d(tau) / [(1/tau) * sum d(j)]
+void YinPitchDetector::cumulativeMeanNormalize() {
+    DspKernels::cumulativeMeanNormalize(m_yinBuffer.data(), (int)m_yinBuffer.size());
+}
+
+int YinPitchDetector::absoluteThreshold() const {
+    // Start at the minimum period (maximum frequency)
+    for (int tau = m_minPeriod; tau < m_maxPeriod; tau++) {
+        if (m_yinBuffer[tau] < m_threshold) {
+            // Walk down to the local minimum
+            int minTau = tau;
+            while (minTau + 1 < m_maxPeriod && m_yinBuffer[minTau + 1] < m_yinBuffer[minTau]) {
+                minTau++;
+            }
+            return minTau;
+        }
+    }
+    
+    // Fallback: global minimum, only if reasonably low
+    float minValue = FLT_MAX;
+    int minTau = -1;
+    for (int tau = m_minPeriod; tau < m_maxPeriod; tau++) {
+        if (m_yinBuffer[tau] < minValue) {
+            minValue = m_yinBuffer[tau];
+            minTau = tau;
+        }
+    }
+    return minValue < m_threshold * 2 ? minTau : -1;
+}
+
+float YinPitchDetector::parabolicInterpolation(int tau) const {
+    if (tau <= 0 || tau >= (int)m_yinBuffer.size() - 1) {
+        return (float)tau;
+    }
+    float s0 = m_yinBuffer[tau - 1];
+    float s1 = m_yinBuffer[tau];
+    float s2 = m_yinBuffer[tau + 1];
+    
+    float denominator = 2.0f * s1 - s0 - s2;
+    if (std::fabs(denominator) < 0.0001f) {
+        return (float)tau;
+    }
+    return tau + (s2 - s0) / (2.0f * denominator);
+}
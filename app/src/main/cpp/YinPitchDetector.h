@@ -0,0 +1,81 @@
+/**
+ * YinPitchDetector.h
+ *
+ * Native YIN fundamental-frequency estimator.
+ * Port of the Kotlin YINPitchDetector: Hann window, difference function,
+ * cumulative mean normalization, absolute threshold and parabolic
+ * interpolation. All buffers are allocated in the constructor, so detect()
+ * is safe to call from the audio thread.
+ *
+ * The difference function is computed from an FFT cross-correlation and a
+ * running energy sum, O(W log W) instead of the direct O(W^2) double loop.
+ *
+ * Reference: "YIN, a fundamental frequency estimator for speech and music",
+ * de Cheveigné & Kawahara, 2002
+ */
+
+#ifndef MUSIMIND_YIN_PITCH_DETECTOR_H
+#define MUSIMIND_YIN_PITCH_DETECTOR_H
+
+#include "RealFft.h"
+#include <cstdint>
+#include <vector>
+
+// Result of one analysis window (mirrors Kotlin's PitchFrame)
+struct PitchFrame {
+    int64_t framePosition;  // Stream frame of the first sample in the window
+    int32_t windowSize;
+    float frequency;        // Hz, 0 if unvoiced
+    float confidence;       // [0, 1]
+    int32_t midiNote;       // Nearest MIDI note, 0 if unvoiced
+    float centDeviation;    // Cents from midiNote
+    float rms;              // Window RMS level
+    bool isVoiced;
+};
+
+class YinPitchDetector {
+public:
+    enum Preset {
+        PRESET_VOICE = 0,
+        PRESET_INSTRUMENT = 1
+    };
+    
+    YinPitchDetector(int sampleRate, int windowSize, float threshold);
+    
+    // Detectors matching YINPitchDetector.forVoice / forInstrument
+    static YinPitchDetector forPreset(Preset preset, int sampleRate);
+    
+    // Analyze windowSize samples starting at input
+    PitchFrame detect(const float* input, int64_t framePosition);
+    
+    int getWindowSize() const { return m_windowSize; }
+    int getHopSize() const { return m_windowSize / 4; }  // 75% overlap
+    int getSampleRate() const { return m_sampleRate; }
+    
+private:
+    void computeDifference(const float* buffer);
+    void cumulativeMeanNormalize();
+    int absoluteThreshold() const;
+    float parabolicInterpolation(int tau) const;
+    PitchFrame silence(int64_t framePosition, float rms) const;
+    
+    int m_sampleRate;
+    int m_windowSize;
+    float m_threshold;
+    int m_minPeriod;
+    int m_maxPeriod;
+    
+    std::vector<float> m_hannWindow;
+    std::vector<float> m_windowed;
+    std::vector<float> m_yinBuffer;
+    
+    // Difference function scratch
+    RealFft m_fft;
+    std::vector<float> m_halfWindowed;  // First half of m_windowed, zero-padded
+    std::vector<float> m_spectrumA;
+    std::vector<float> m_spectrumB;
+    std::vector<float> m_correlation;
+    std::vector<double> m_energy;       // m_energy[k] = sum of x[j]^2 for j < k
+};
+
+#endif // MUSIMIND_YIN_PITCH_DETECTOR_H
@@ -0,0 +1,304 @@
+/**
+ * NativeAudioBench.cpp
+ *
+ * On-device microbenchmarks for the native audio path (Google Benchmark).
+ * Built only with -DMUSIMIND_BUILD_BENCHMARKS=ON, outside Gradle:
+ *
+ *   cmake -S app/src/main/cpp -B build-bench \
+ *       -DCMAKE_TOOLCHAIN_FILE=$ANDROID_NDK/build/cmake/android.toolchain.cmake \
+ *       -DANDROID_ABI=arm64-v8a -DANDROID_PLATFORM=android-26 \
+ *       -DANDROID_STL=c++_static -DCMAKE_BUILD_TYPE=Release \
+ *       -DMUSIMIND_BUILD_BENCHMARKS=ON
+ *   cmake --build build-bench --target native-audio-bench
+ *   adb push build-bench/native-audio-bench app/src/main/assets/soundfonts/gm.sf2 /data/local/tmp/
+ *   adb shell /data/local/tmp/native-audio-bench --soundfont=/data/local/tmp/gm.sf2
+ *
+ * Engine benchmarks are skipped without --soundfont. To catch regressions,
+ * save a baseline with --benchmark_out=base.json --benchmark_out_format=json
+ * and compare later runs with Google Benchmark's tools/compare.py.
+ */
+
+#include "../DspKernels.h"
+#include "../InputRing.h"
+#include "../Mixer.h"
+#include "../OnsetDetector.h"
+#include "../RenderArena.h"
+#include "../Resampler.h"
+#include "../SoundFontEngine.h"
+#include "../YinPitchDetector.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int kSampleRate = SoundFontEngine::kSampleRate;
+constexpr int kBurstFrames = 192;  // Typical low-latency burst at 48 kHz
+
+std::string g_soundFontPath;
+
+// One engine per process: loading a full GM bank per benchmark would dominate the run
+SoundFontEngine* sharedEngine() {
+    static std::unique_ptr<SoundFontEngine> engine;
+    static bool attempted = false;
+    if (!attempted) {
+        attempted = true;
+        if (!g_soundFontPath.empty()) {
+            auto candidate = std::make_unique<SoundFontEngine>();
+            candidate->setMaxVoices(256);
+            candidate->prepare(4096);
+            // No asset manager: the path is read from the filesystem, no metronome bank
+            if (candidate->initialize(nullptr, g_soundFontPath.c_str(), "")) {
+                engine = std::move(candidate);
+            }
+        }
+    }
+    return engine.get();
+}
+
+std::vector<float> noise(size_t count, float amplitude, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> distribution(-amplitude, amplitude);
+    std::vector<float> samples(count);
+    for (float& sample : samples) {
+        sample = distribution(random);
+    }
+    return samples;
+}
+
+std::vector<float> sine(size_t count, float frequency, float amplitude) {
+    std::vector<float> samples(count);
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = amplitude * std::sin(2.0f * (float)M_PI * frequency * (float)i / kSampleRate);
+    }
+    return samples;
+}
+
+// Release everything and let the tails die so runs do not leak voices into each other
+void silence(SoundFontEngine& engine, std::vector<float>& buffer) {
+    engine.allNotesOff();
+    for (int i = 0; i < kSampleRate / kBurstFrames; i++) {
+        engine.render(buffer.data(), kBurstFrames);
+    }
+}
+
+// Render throughput with a chord of range(0) held notes, re-struck every second
+void BM_EngineRender(benchmark::State& state) {
+    SoundFontEngine* engine = sharedEngine();
+    if (!engine) {
+        state.SkipWithError("No SoundFont (pass --soundfont=<path>)");
+        return;
+    }
+    const int notes = (int)state.range(0);
+    std::vector<float> buffer(kBurstFrames * 2);
+    silence(*engine, buffer);
+    
+    auto strike = [&] {
+        for (int i = 0; i < notes; i++) {
+            engine->noteOn(0, 36 + (i * 7) % 60, 0.8f);
+        }
+    };
+    strike();
+    int blocks = 0;
+    int peakVoices = 0;
+    for (auto _ : state) {
+        engine->render(buffer.data(), kBurstFrames);
+        benchmark::DoNotOptimize(buffer.data());
+        peakVoices = std::max(peakVoices, engine->getVoiceStats().active);
+        if (++blocks == kSampleRate / kBurstFrames) {
+            blocks = 0;
+            state.PauseTiming();
+            engine->allNotesOff();
+            strike();
+            state.ResumeTiming();
+        }
+    }
+    state.counters["frames/s"] = benchmark::Counter((double)state.iterations() * kBurstFrames,
+                                                    benchmark::Counter::kIsRate);
+    state.counters["realtime_x"] = benchmark::Counter((double)state.iterations() * kBurstFrames / kSampleRate,
+                                                      benchmark::Counter::kIsRate);
+    state.counters["voices"] = peakVoices;
+    silence(*engine, buffer);
+}
+BENCHMARK(BM_EngineRender)->Arg(0)->Arg(1)->Arg(8)->Arg(16)->Arg(32)->Arg(64);
+
+// A note-on pushed through the command queue plus the callback that applies it.
+// The command always starts on the first frame of that callback, so this is
+// the added CPU cost; the audible delay is one buffer at most.
+void BM_NoteOnThroughQueue(benchmark::State& state) {
+    SoundFontEngine* engine = sharedEngine();
+    if (!engine) {
+        state.SkipWithError("No SoundFont (pass --soundfont=<path>)");
+        return;
+    }
+    std::vector<float> buffer(kBurstFrames * 2);
+    silence(*engine, buffer);
+    int note = 0;
+    for (auto _ : state) {
+        engine->noteOn(1, 48 + note, 0.8f);
+        engine->render(buffer.data(), kBurstFrames);
+        engine->noteOff(1, 48 + note);
+        note = (note + 1) % 24;
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.counters["dropped"] = engine->getDroppedCommandCount();
+    silence(*engine, buffer);
+}
+BENCHMARK(BM_NoteOnThroughQueue);
+
+// Batches of scheduled notes (scheduleNotes) drained and sorted into the event heap
+void BM_ScheduleBatch(benchmark::State& state) {
+    SoundFontEngine* engine = sharedEngine();
+    if (!engine) {
+        state.SkipWithError("No SoundFont (pass --soundfont=<path>)");
+        return;
+    }
+    const int count = (int)state.range(0);
+    std::vector<NoteEvent> events(count);
+    for (int i = 0; i < count; i++) {
+        events[i] = NoteEvent{0, 60 + i % 12, 0.7f, kSampleRate + i * 1000, 500};
+    }
+    std::vector<float> buffer(kBurstFrames * 2);
+    for (auto _ : state) {
+        engine->scheduleNotes(events.data(), count, -1);
+        engine->render(buffer.data(), kBurstFrames);
+        state.PauseTiming();
+        silence(*engine, buffer);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ScheduleBatch)->Arg(16)->Arg(128);
+
+// One YIN analysis window per iteration (one hop of the live tracker)
+void BM_YinDetect(benchmark::State& state) {
+    YinPitchDetector detector = YinPitchDetector::forPreset((YinPitchDetector::Preset)state.range(0), kSampleRate);
+    std::vector<float> input = sine(detector.getWindowSize(), 220.0f, 0.5f);
+    for (auto _ : state) {
+        PitchFrame frame = detector.detect(input.data(), 0);
+        benchmark::DoNotOptimize(frame);
+    }
+    // Real-time budget: one detect per hop
+    state.counters["window"] = detector.getWindowSize();
+    state.counters["hop_us"] = detector.getHopSize() * 1e6 / kSampleRate;
+}
+BENCHMARK(BM_YinDetect)->Arg(YinPitchDetector::PRESET_VOICE)->Arg(YinPitchDetector::PRESET_INSTRUMENT);
+
+// Spectral-flux onset detection, one hop of new input per iteration
+void BM_OnsetHop(benchmark::State& state) {
+    OnsetDetector detector;
+    detector.configure(kSampleRate);
+    InputRing ring;
+    ring.configure(detector.getFrameSize() * 4, detector.getHopSize());
+    const int hop = detector.getHopSize();
+    std::vector<float> input = noise((size_t)hop * 64, 0.3f, 7);
+    int64_t frame = 0;
+    size_t offset = 0;
+    for (auto _ : state) {
+        ring.write(input.data() + offset, hop, frame);
+        detector.process(ring);
+        frame += hop;
+        offset = (offset + hop) % (input.size() - hop);
+        OnsetEvent onset;
+        while (detector.pollOnset(onset)) {
+        }
+    }
+    state.counters["hop_us"] = hop * 1e6 / kSampleRate;
+}
+BENCHMARK(BM_OnsetHop);
+
+// Full output mixer: four active buses, ducking and look-ahead limiter
+void BM_Mixer(benchmark::State& state) {
+    const int frames = (int)state.range(0);
+    RenderArena arena;
+    arena.allocate(frames, 2);
+    float* buses[RenderArena::BUS_COUNT];
+    bool active[RenderArena::BUS_COUNT];
+    for (int i = 0; i < RenderArena::BUS_COUNT; i++) {
+        buses[i] = arena.bus((RenderArena::Bus)i);
+        std::vector<float> content = noise((size_t)frames * 2, 0.4f, 11 + i);
+        memcpy(buses[i], content.data(), content.size() * sizeof(float));
+        active[i] = true;
+    }
+    Mixer mixer;
+    mixer.setLimiter(state.range(1) != 0, -0.5f);
+    std::vector<float> output((size_t)frames * 2);
+    for (auto _ : state) {
+        mixer.process(buses, active, output.data(), frames);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.counters["frames/s"] = benchmark::Counter((double)state.iterations() * frames,
+                                                    benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Mixer)->Args({192, 1})->Args({192, 0})->Args({1024, 1});
+
+void BM_MixAddRamped(benchmark::State& state) {
+    const int frames = (int)state.range(0);
+    std::vector<float> source = noise((size_t)frames * 2, 0.5f, 3);
+    std::vector<float> destination((size_t)frames * 2, 0.0f);
+    for (auto _ : state) {
+        DspKernels::mixAddRampedStereo(destination.data(), source.data(), frames, 0.5f, 1e-4f);
+        benchmark::DoNotOptimize(destination.data());
+    }
+    state.SetBytesProcessed(state.iterations() * frames * 2 * (int64_t)sizeof(float));
+}
+BENCHMARK(BM_MixAddRamped)->Arg(192)->Arg(1024);
+
+void BM_FloatToInt16(benchmark::State& state) {
+    const int frames = (int)state.range(0);
+    std::vector<float> source = noise((size_t)frames * 2, 0.9f, 5);
+    std::vector<int16_t> destination((size_t)frames * 2);
+    DspKernels::DitherState dither;
+    for (auto _ : state) {
+        DspKernels::floatToInt16Dithered(source.data(), destination.data(), frames * 2, dither);
+        benchmark::DoNotOptimize(destination.data());
+    }
+    state.SetBytesProcessed(state.iterations() * frames * 2 * (int64_t)sizeof(float));
+}
+BENCHMARK(BM_FloatToInt16)->Arg(192)->Arg(1024);
+
+// Engine rate to a device rate, one output burst per iteration
+void BM_Resampler(benchmark::State& state) {
+    const int outputRate = (int)state.range(0);
+    Resampler resampler;
+    resampler.configure(kSampleRate, outputRate, kBurstFrames);
+    std::vector<float> input = noise((size_t)resampler.getMaxInputFrames() * 2, 0.5f, 9);
+    std::vector<float> output(kBurstFrames * 2);
+    for (auto _ : state) {
+        int needed = resampler.getInputFramesNeeded(kBurstFrames);
+        memcpy(resampler.getInputWritePointer(), input.data(), (size_t)needed * 2 * sizeof(float));
+        resampler.process(needed, output.data(), kBurstFrames);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.counters["frames/s"] = benchmark::Counter((double)state.iterations() * kBurstFrames,
+                                                    benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Resampler)->Arg(44100)->Arg(96000);
+
+} // namespace
+
+int main(int argc, char** argv) {
+    // Take our own flag out before Google Benchmark parses the rest
+    const char* prefix = "--soundfont=";
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], prefix, strlen(prefix)) == 0) {
+            g_soundFontPath = argv[i] + strlen(prefix);
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
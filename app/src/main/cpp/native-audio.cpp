@@ -10,7 +10,10 @@
 #include <android/asset_manager_jni.h>
 #include <android/log.h>
 #include "OboePlayer.h"
+#include "WavWriter.h"
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #define LOG_TAG "NativeAudio"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
@@ -19,17 +22,136 @@
 // Global player instance
 static std::unique_ptr<OboePlayer> g_player;
 
+// Shared with Kotlin as a direct ByteBuffer, so it lives as long as the
+// process: a buffer handed out earlier never outlives its memory
+static UiStateChannel g_uiChannel;
+
+// Shared by the offline render entry points: copies the packed note batch
+// and MIDI bytes out of the Java arrays and renders them
+static bool renderOfflineFromJava(JNIEnv* env, jintArray events, jint count, jbyteArray midi,
+                                  jint sampleRate, std::vector<float>& out) {
+    if (!g_player) {
+        return false;
+    }
+    std::vector<NoteEvent> notes;
+    if (events && count > 0) {
+        constexpr int kIntsPerEvent = sizeof(NoteEvent) / sizeof(jint);
+        count = std::min(count, (jint)(env->GetArrayLength(events) / kIntsPerEvent));
+        notes.resize(count);
+        env->GetIntArrayRegion(events, 0, count * kIntsPerEvent, reinterpret_cast<jint*>(notes.data()));
+    }
+    std::vector<uint8_t> bytes;
+    if (midi) {
+        bytes.resize(env->GetArrayLength(midi));
+        env->GetByteArrayRegion(midi, 0, (jsize)bytes.size(), reinterpret_cast<jbyte*>(bytes.data()));
+    }
+    int rate = sampleRate > 0 ? sampleRate : g_player->getSampleRate();
+    return g_player->getSoundFontEngine().renderOffline(notes.data(), (int)notes.size(),
+                                                        bytes.data(), bytes.size(), rate, out);
+}
+
+// Shared by nativeScheduleNotes and its session variant: queues a packed
+// batch in chunks, all on the same base frame
+static jint scheduleNotesFromJava(JNIEnv* env, SoundFontEngine& engine, jintArray events, jint count,
+                                  jlong startFrame) {
+    if (!events || count <= 0) {
+        return 0;
+    }
+    constexpr int kIntsPerEvent = sizeof(NoteEvent) / sizeof(jint);
+    count = std::min(count, (jint)(env->GetArrayLength(events) / kIntsPerEvent));
+    
+    // The batch base is taken once so every chunk shares the same start frame
+    int64_t base = startFrame < 0 ? engine.getFramePosition() : startFrame;
+    
+    NoteEvent chunk[64];
+    int queued = 0;
+    for (int first = 0; first < count; first += 64) {
+        int n = std::min(64, (int)count - first);
+        env->GetIntArrayRegion(events, first * kIntsPerEvent, n * kIntsPerEvent,
+                               reinterpret_cast<jint*>(chunk));
+        queued += engine.scheduleNotes(chunk, n, base);
+    }
+    return queued;
+}
+
+static MetronomeSettings metronomeSettings(jfloat bpm, jint beatsPerMeasure, jint beatUnit, jint subdivision,
+                                           jint accentMask, jboolean muted) {
+    MetronomeSettings settings;
+    settings.bpm = bpm;
+    settings.beatsPerMeasure = beatsPerMeasure;
+    settings.beatUnit = beatUnit;
+    settings.subdivision = subdivision;
+    settings.accentMask = (uint32_t)accentMask;
+    settings.muted = muted;
+    return settings;
+}
+
+// Drain an engine's metronome beats into out, 4 longs per event
+static jint pollBeatsToJava(JNIEnv* env, SoundFontEngine& engine, jlongArray out) {
+    if (!out) {
+        return 0;
+    }
+    
+    constexpr int kStride = 4;
+    constexpr int kMaxEventsPerPoll = 64;
+    jlong events[kMaxEventsPerPoll * kStride];
+    
+    int capacity = std::min(env->GetArrayLength(out) / kStride, kMaxEventsPerPoll);
+    int count = 0;
+    BeatEvent beat;
+    while (count < capacity && engine.pollMetronomeBeat(beat)) {
+        jlong* e = events + count * kStride;
+        e[0] = beat.frame;
+        e[1] = beat.beat;
+        e[2] = beat.subdivision;
+        e[3] = beat.level;
+        count++;
+    }
+    
+    if (count > 0) {
+        env->SetLongArrayRegion(out, 0, count * kStride, events);
+    }
+    return count;
+}
+
+// Run fn on the engine behind a session handle; false if it is unknown or released
+template <typename Fn>
+static bool withSession(jlong handle, Fn&& fn) {
+    return g_player && g_player->getSessions().with(handle, fn);
+}
+
+// Tracker of a JNI preset id, -1 for the primary; null if that preset is not running
+static PitchTracker* pitchTrackerFor(jint preset) {
+    if (!g_player) {
+        return nullptr;
+    }
+    AnalysisWorker& analysis = g_player->getAnalysisWorker();
+    if (preset < 0) {
+        return &analysis.getPitchTracker();
+    }
+    if (preset >= AnalysisWorker::kPresetCount || !analysis.isPresetEnabled((YinPitchDetector::Preset)preset)) {
+        return nullptr;
+    }
+    return &analysis.getPitchTracker((YinPitchDetector::Preset)preset);
+}
+
 extern "C" {
 
 /**
  * Initialize the audio engine with the SoundFont file.
+ * With async set, the stream starts right away (rendering silence) and the
+ * SoundFonts load on the engine's loader thread; poll nativeGetLoadState.
+ * maxVoices sizes the preallocated piano voice pool.
  */
 JNIEXPORT jboolean JNICALL
 Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeInitialize(
     JNIEnv* env,
     jobject /* this */,
     jobject assetManager,
-    jstring soundFontPath
+    jstring soundFontPath,
+    jstring cacheDirectory,
+    jint maxVoices,
+    jboolean async
 ) {
     LOGI("Initializing native audio engine...");
     
@@ -49,6 +171,31 @@ Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeInitialize(
     
     // Create player
     g_player = std::make_unique<OboePlayer>();
+    g_player->setUiChannel(&g_uiChannel);
+    
+    g_player->getSoundFontEngine().setMaxVoices(maxVoices);
+    
+    // Preset subsets are cached here so later launches skip the full bank
+    if (cacheDirectory) {
+        const char* cacheDir = env->GetStringUTFChars(cacheDirectory, nullptr);
+        if (cacheDir) {
+            g_player->getSoundFontEngine().setCacheDirectory(cacheDir);
+            env->ReleaseStringUTFChars(cacheDirectory, cacheDir);
+        }
+    }
+    
+    if (async) {
+        if (!g_player->start()) {
+            LOGE("Failed to start audio stream");
+            env->ReleaseStringUTFChars(soundFontPath, sfPath);
+            g_player.reset();
+            return JNI_FALSE;
+        }
+        g_player->getSoundFontEngine().initializeAsync(mgr, sfPath);
+        env->ReleaseStringUTFChars(soundFontPath, sfPath);
+        LOGI("Native audio stream started, SoundFonts loading");
+        return JNI_TRUE;
+    }
     
     // Initialize SoundFont engine
     bool sfLoaded = g_player->getSoundFontEngine().initialize(mgr, sfPath);
@@ -102,6 +249,85 @@ Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeNoteOff(
     }
 }
 
+/**
+ * Schedule a note on the stream frame clock.
+ * startFrame < 0 starts the note on the next audio callback.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeScheduleNote(
+    JNIEnv* env,
+    jobject /* this */,
+    jint channel,
+    jint midiNote,
+    jfloat velocity,
+    jlong startFrame,
+    jint durationFrames
+) {
+    if (g_player) {
+        int64_t frame = startFrame < 0 ? AudioCommand::kImmediate : startFrame;
+        g_player->getSoundFontEngine().scheduleNote(channel, midiNote, velocity, frame, durationFrames);
+    }
+}
+
+/**
+ * Schedule a batch of notes with one JNI call.
+ * events holds count records of five ints: channel, note, velocity
+ * (Float.toRawBits), offset from startFrame, duration; all in frames.
+ * A negative startFrame means the current frame position.
+ */
+JNIEXPORT jint JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeScheduleNotes(
+    JNIEnv* env,
+    jobject /* this */,
+    jintArray events,
+    jint count,
+    jlong startFrame
+) {
+    if (!g_player) {
+        return 0;
+    }
+    return scheduleNotesFromJava(env, g_player->getSoundFontEngine(), events, count, startFrame);
+}
+
+/**
+ * Release all piano notes and cancel scheduled ones.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeAllNotesOff(
+    JNIEnv* env,
+    jobject /* this */
+) {
+    if (g_player) {
+        g_player->getSoundFontEngine().allNotesOff();
+    }
+}
+
+/**
+ * Schedule a metronome click on an exact stream frame.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeScheduleMetronome(
+    JNIEnv* env,
+    jobject /* this */,
+    jboolean isAccented,
+    jlong frame
+) {
+    if (g_player) {
+        g_player->getSoundFontEngine().scheduleMetronomeClick(isAccented, frame);
+    }
+}
+
+/**
+ * Get the current stream frame position (frames rendered so far).
+ */
+JNIEXPORT jlong JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeGetFramePosition(
+    JNIEnv* env,
+    jobject /* this */
+) {
+    return g_player ? g_player->getSoundFontEngine().getFramePosition() : 0;
+}
+
 /**
  * Play a metronome click.
  */
@@ -117,20 +343,1239 @@ Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativePlayMetronome(
 }
 
 /**
- * Set the instrument preset for a channel.
+ * Configure the native metronome. Takes effect from the next click.
+ * accentMask: bit n set = beat n (0-based) is accented.
  */
 JNIEXPORT void JNICALL
-Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSetPreset(
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSetMetronome(
+    JNIEnv* env,
+    jobject /* this */,
+    jfloat bpm,
+    jint beatsPerMeasure,
+    jint beatUnit,
+    jint subdivision,
+    jint accentMask,
+    jboolean muted
+) {
+    if (g_player) {
+        g_player->getSoundFontEngine().setMetronomeSettings(
+            metronomeSettings(bpm, beatsPerMeasure, beatUnit, subdivision, accentMask, muted));
+    }
+}
+
+/**
+ * Start the native metronome. startFrame < 0 starts on the next audio callback.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeStartMetronome(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong startFrame
+) {
+    if (g_player) {
+        int64_t frame = startFrame < 0 ? AudioCommand::kImmediate : startFrame;
+        g_player->getSoundFontEngine().startMetronome(frame);
+    }
+}
+
+/**
+ * Stop the native metronome.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeStopMetronome(
+    JNIEnv* env,
+    jobject /* this */
+) {
+    if (g_player) {
+        g_player->getSoundFontEngine().stopMetronome();
+    }
+}
+
+/**
+ * Drain metronome beat events into out, 4 longs per event:
+ * [frame, beat (0-based), subdivision, level (0 = subdivision, 1 = beat, 2 = accent)].
+ * Returns the number of events written.
+ */
+JNIEXPORT jint JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativePollMetronomeBeats(
+    JNIEnv* env,
+    jobject /* this */,
+    jlongArray out
+) {
+    return g_player ? pollBeatsToJava(env, g_player->getSoundFontEngine(), out) : 0;
+}
+
+/**
+ * Create an engine session: its own voices (a pool of maxVoices), channels,
+ * scheduler, metronome and clips over the main engine's SoundFonts, mixed
+ * into the same output stream and clocked by nativeGetFramePosition.
+ * Returns the session handle, or 0 if none could be created.
+ */
+JNIEXPORT jlong JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeCreateSession(
+    JNIEnv* env,
+    jobject /* this */,
+    jint maxVoices
+) {
+    return g_player ? g_player->getSessions().create(maxVoices) : 0;
+}
+
+/**
+ * Release a session; its sounding notes stop at once.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeReleaseSession(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong session
+) {
+    if (g_player) {
+        g_player->getSessions().release(session);
+    }
+}
+
+/**
+ * Linear gain of a session in the output mix, 1.0 = unity.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSetSessionGain(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong session,
+    jfloat gain
+) {
+    return g_player && g_player->getSessions().setGain(session, gain) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Session variant of nativeScheduleNote.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSessionScheduleNote(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong session,
+    jint channel,
+    jint midiNote,
+    jfloat velocity,
+    jlong startFrame,
+    jint durationFrames
+) {
+    int64_t frame = startFrame < 0 ? AudioCommand::kImmediate : startFrame;
+    return withSession(session, [&](SoundFontEngine& engine) {
+        engine.scheduleNote(channel, midiNote, velocity, frame, durationFrames);
+    }) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Session variant of nativeNoteOff.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSessionNoteOff(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong session,
+    jint channel,
+    jint midiNote
+) {
+    withSession(session, [&](SoundFontEngine& engine) {
+        engine.noteOff(channel, midiNote);
+    });
+}
+
+/**
+ * Session variant of nativeScheduleNotes.
+ */
+JNIEXPORT jint JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSessionScheduleNotes(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong session,
+    jintArray events,
+    jint count,
+    jlong startFrame
+) {
+    jint queued = 0;
+    withSession(session, [&](SoundFontEngine& engine) {
+        queued = scheduleNotesFromJava(env, engine, events, count, startFrame);
+    });
+    return queued;
+}
+
+/**
+ * Session variant of nativeAllNotesOff.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSessionAllNotesOff(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong session
+) {
+    withSession(session, [](SoundFontEngine& engine) {
+        engine.allNotesOff();
+    });
+}
+
+/**
+ * Session variants of the channel controls. Programs the shared bank lacks
+ * are added to it for every engine.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSessionSetPreset(
     JNIEnv* env,
     jobject /* this */,
+    jlong session,
     jint channel,
     jint preset
+) {
+    withSession(session, [&](SoundFontEngine& engine) {
+        engine.setPreset(channel, preset);
+    });
+}
+
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSessionSetChannelVolume(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong session,
+    jint channel,
+    jfloat volume
+) {
+    withSession(session, [&](SoundFontEngine& engine) {
+        engine.setChannelVolume(channel, volume);
+    });
+}
+
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSessionSetChannelPan(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong session,
+    jint channel,
+    jfloat pan
+) {
+    withSession(session, [&](SoundFontEngine& engine) {
+        engine.setChannelPan(channel, pan);
+    });
+}
+
+/**
+ * Session variants of the native metronome. Session beats are not published
+ * to the UI channel; poll them with nativeSessionPollMetronomeBeats.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSessionSetMetronome(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong session,
+    jfloat bpm,
+    jint beatsPerMeasure,
+    jint beatUnit,
+    jint subdivision,
+    jint accentMask,
+    jboolean muted
+) {
+    MetronomeSettings settings = metronomeSettings(bpm, beatsPerMeasure, beatUnit, subdivision, accentMask, muted);
+    withSession(session, [&](SoundFontEngine& engine) {
+        engine.setMetronomeSettings(settings);
+    });
+}
+
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSessionStartMetronome(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong session,
+    jlong startFrame
+) {
+    int64_t frame = startFrame < 0 ? AudioCommand::kImmediate : startFrame;
+    withSession(session, [&](SoundFontEngine& engine) {
+        engine.startMetronome(frame);
+    });
+}
+
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSessionStopMetronome(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong session
+) {
+    withSession(session, [](SoundFontEngine& engine) {
+        engine.stopMetronome();
+    });
+}
+
+JNIEXPORT jint JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSessionPollMetronomeBeats(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong session,
+    jlongArray out
+) {
+    jint count = 0;
+    withSession(session, [&](SoundFontEngine& engine) {
+        count = pollBeatsToJava(env, engine, out);
+    });
+    return count;
+}
+
+/**
+ * Open the microphone in full-duplex with the output stream and start native
+ * pitch tracking. preset: 0 = voice, 1 = instrument; it drives scoring and
+ * the UI channel. extraPresets is a mask (1 << preset) of presets tracked
+ * alongside it; polyphonic adds chord detection (nativePollPolyphonicFrames).
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeStartPitchDetection(
+    JNIEnv* env,
+    jobject /* this */,
+    jint preset,
+    jint extraPresets,
+    jboolean polyphonic
+) {
+    if (!g_player) {
+        return JNI_FALSE;
+    }
+    auto detectorPreset = preset == YinPitchDetector::PRESET_INSTRUMENT
+        ? YinPitchDetector::PRESET_INSTRUMENT
+        : YinPitchDetector::PRESET_VOICE;
+    return g_player->startInput(detectorPreset, (uint32_t)extraPresets, polyphonic == JNI_TRUE)
+        ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Turn the primary tracker's frame queue on or off. Off while the UI channel
+ * is the only pitch reader; frames still queued are dropped with it.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSetPitchQueueEnabled(
+    JNIEnv* env,
+    jobject /* this */,
+    jboolean enabled
+) {
+    if (!g_player) {
+        return;
+    }
+    PitchTracker& tracker = g_player->getPitchTracker();
+    tracker.setQueueEnabled(enabled == JNI_TRUE);
+    if (enabled != JNI_TRUE) {
+        PitchFrame stale;
+        while (tracker.pollFrame(stale)) {
+        }
+    }
+}
+
+/**
+ * Stop pitch tracking and close the microphone.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeStopPitchDetection(
+    JNIEnv* env,
+    jobject /* this */
 ) {
     if (g_player) {
-        g_player->getSoundFontEngine().setPreset(channel, preset);
+        g_player->stopInput();
     }
 }
 
+/**
+ * Drain pitch frames of a preset (-1 = primary). For each frame, positions
+ * gets the stream frame of the window start and values gets 6 floats:
+ * [frequency, confidence, midiNote, centDeviation, rms, voiced (0/1)].
+ * Returns the number of frames written.
+ */
+JNIEXPORT jint JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativePollPitchFrames(
+    JNIEnv* env,
+    jobject /* this */,
+    jint preset,
+    jlongArray positions,
+    jfloatArray values
+) {
+    PitchTracker* tracker = pitchTrackerFor(preset);
+    if (!tracker || !positions || !values) {
+        return 0;
+    }
+    
+    constexpr int kStride = 6;
+    constexpr int kMaxFramesPerPoll = 32;
+    jlong framePositions[kMaxFramesPerPoll];
+    jfloat frameValues[kMaxFramesPerPoll * kStride];
+    
+    int capacity = std::min({ (int)env->GetArrayLength(positions),
+                              (int)env->GetArrayLength(values) / kStride,
+                              kMaxFramesPerPoll });
+    int count = 0;
+    PitchFrame frame;
+    while (count < capacity && tracker->pollFrame(frame)) {
+        framePositions[count] = frame.framePosition;
+        jfloat* v = frameValues + count * kStride;
+        v[0] = frame.frequency;
+        v[1] = frame.confidence;
+        v[2] = (jfloat)frame.midiNote;
+        v[3] = frame.centDeviation;
+        v[4] = frame.rms;
+        v[5] = frame.isVoiced ? 1.0f : 0.0f;
+        count++;
+    }
+    
+    if (count > 0) {
+        env->SetLongArrayRegion(positions, 0, count, framePositions);
+        env->SetFloatArrayRegion(values, 0, count * kStride, frameValues);
+    }
+    return count;
+}
+
+/**
+ * Load the exercise timeline for native scoring, before pitch detection starts.
+ * notes holds count triples [startFrame, endFrame, midiNote], frames relative
+ * to the origin later passed to nativeArmScoring.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeLoadScoringTimeline(
+    JNIEnv* env,
+    jobject /* this */,
+    jlongArray notes,
+    jint count,
+    jint octaveOffset
+) {
+    if (!g_player || !notes || count < 0 || count > env->GetArrayLength(notes) / 3) {
+        return JNI_FALSE;
+    }
+    
+    std::vector<jlong> packed(count * 3);
+    env->GetLongArrayRegion(notes, 0, count * 3, packed.data());
+    std::vector<ScoringNote> timeline(count);
+    for (int i = 0; i < count; i++) {
+        timeline[i].startFrame = packed[i * 3];
+        timeline[i].endFrame = packed[i * 3 + 1];
+        timeline[i].midiNote = (int32_t)packed[i * 3 + 2];
+    }
+    return g_player->loadScoringTimeline(timeline.data(), count, octaveOffset) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Start scoring: loaded note frames are relative to this engine frame.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeArmScoring(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong originFrame
+) {
+    if (g_player) {
+        g_player->getNoteScorer().arm(originFrame);
+    }
+}
+
+/**
+ * Score the notes still open, when the exercise timeline has ended.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeFinishScoring(
+    JNIEnv* env,
+    jobject /* this */
+) {
+    if (g_player) {
+        g_player->finishScoring();
+    }
+}
+
+/**
+ * Drain finished note scores. ids receives 4 longs per note
+ * [noteIndex, pitchStatus, timingStatus, attackDeviationFrames], values 8
+ * floats [pitchScore, averageCents, centStdDev, correctRatio, timingScore,
+ * attackScore, durationScore, durationAccuracy].
+ * Returns the number of notes written.
+ */
+JNIEXPORT jint JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativePollNoteScores(
+    JNIEnv* env,
+    jobject /* this */,
+    jlongArray ids,
+    jfloatArray values
+) {
+    if (!g_player || !ids || !values) {
+        return 0;
+    }
+    
+    constexpr int kIdStride = 4;
+    constexpr int kValueStride = 8;
+    constexpr int kMaxScoresPerPoll = 16;
+    jlong scoreIds[kMaxScoresPerPoll * kIdStride];
+    jfloat scoreValues[kMaxScoresPerPoll * kValueStride];
+    
+    int capacity = std::min({ (int)env->GetArrayLength(ids) / kIdStride,
+                              (int)env->GetArrayLength(values) / kValueStride,
+                              kMaxScoresPerPoll });
+    int count = 0;
+    NoteScore score;
+    while (count < capacity && g_player->getNoteScorer().pollScore(score)) {
+        jlong* id = scoreIds + count * kIdStride;
+        id[0] = score.noteIndex;
+        id[1] = score.pitchStatus;
+        id[2] = score.timingStatus;
+        id[3] = score.attackDeviationFrames;
+        jfloat* v = scoreValues + count * kValueStride;
+        v[0] = score.pitchScore;
+        v[1] = score.averageCents;
+        v[2] = score.centStdDev;
+        v[3] = score.correctRatio;
+        v[4] = score.timingScore;
+        v[5] = score.attackScore;
+        v[6] = score.durationScore;
+        v[7] = score.durationAccuracy;
+        count++;
+    }
+    
+    if (count > 0) {
+        env->SetLongArrayRegion(ids, 0, count * kIdStride, scoreIds);
+        env->SetFloatArrayRegion(values, 0, count * kValueStride, scoreValues);
+    }
+    return count;
+}
+
+/**
+ * Index of the expected note the latest pitch frame fell in (-1 outside notes).
+ */
+JNIEXPORT jint JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeGetScoringNote(
+    JNIEnv* env,
+    jobject /* this */
+) {
+    return g_player ? g_player->getNoteScorer().getCurrentNote() : -1;
+}
+
+/**
+ * Get the analysis window size of a preset's pitch detector (-1 = primary;
+ * 0 if it is not running).
+ */
+JNIEXPORT jint JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeGetPitchWindowSize(
+    JNIEnv* env,
+    jobject /* this */,
+    jint preset
+) {
+    PitchTracker* tracker = pitchTrackerFor(preset);
+    return tracker ? tracker->getWindowSize() : 0;
+}
+
+/**
+ * Drain polyphonic note sets. For each frame, notes gets 3 longs
+ * [stream frame of the window start, MIDI notes 0-63 mask, MIDI notes 64-127
+ * mask] and values gets 13 floats [chroma C..B, rms].
+ * Returns the number of frames written.
+ */
+JNIEXPORT jint JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativePollPolyphonicFrames(
+    JNIEnv* env,
+    jobject /* this */,
+    jlongArray notes,
+    jfloatArray values
+) {
+    if (!g_player || !notes || !values || !g_player->getAnalysisWorker().isPolyphonicEnabled()) {
+        return 0;
+    }
+    
+    constexpr int kNoteStride = 3;
+    constexpr int kValueStride = 13;
+    constexpr int kMaxFramesPerPoll = 16;
+    jlong frameNotes[kMaxFramesPerPoll * kNoteStride];
+    jfloat frameValues[kMaxFramesPerPoll * kValueStride];
+    
+    int capacity = std::min({ (int)env->GetArrayLength(notes) / kNoteStride,
+                              (int)env->GetArrayLength(values) / kValueStride,
+                              kMaxFramesPerPoll });
+    int count = 0;
+    PolyphonicFrame frame;
+    MultiPitchDetector& detector = g_player->getAnalysisWorker().getMultiPitchDetector();
+    while (count < capacity && detector.pollFrame(frame)) {
+        jlong* n = frameNotes + count * kNoteStride;
+        n[0] = frame.framePosition;
+        n[1] = (jlong)frame.notes[0];
+        n[2] = (jlong)frame.notes[1];
+        jfloat* v = frameValues + count * kValueStride;
+        std::copy(frame.chroma, frame.chroma + 12, v);
+        v[12] = frame.rms;
+        count++;
+    }
+    
+    if (count > 0) {
+        env->SetLongArrayRegion(notes, 0, count * kNoteStride, frameNotes);
+        env->SetFloatArrayRegion(values, 0, count * kValueStride, frameValues);
+    }
+    return count;
+}
+
+/**
+ * Analysis worker backpressure: out receives [passes, lastBacklogFrames,
+ * maxBacklogFrames, maxPassNanos, skippedSamples, realtime (0/1), cpuMask].
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeGetAnalysisStats(
+    JNIEnv* env,
+    jobject /* this */,
+    jlongArray out
+) {
+    constexpr int kFields = 7;
+    if (!g_player || env->GetArrayLength(out) < kFields) {
+        return;
+    }
+    AnalysisWorker::Stats stats = g_player->getAnalysisWorker().getStats();
+    jlong values[kFields] = {
+        stats.passes, stats.lastBacklogFrames, stats.maxBacklogFrames, stats.maxPassNanos,
+        stats.skippedSamples, stats.realtime ? 1 : 0, (jlong)stats.cpuMask
+    };
+    env->SetLongArrayRegion(out, 0, kFields, values);
+}
+
+/**
+ * Drain onsets detected in the input stream. For each onset, positions gets
+ * its stream frame and strengths its flux-over-threshold ratio.
+ * Returns the number of onsets written.
+ */
+JNIEXPORT jint JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativePollOnsets(
+    JNIEnv* env,
+    jobject /* this */,
+    jlongArray positions,
+    jfloatArray strengths
+) {
+    if (!g_player || !positions || !strengths) {
+        return 0;
+    }
+    
+    constexpr int kMaxOnsetsPerPoll = 32;
+    jlong onsetPositions[kMaxOnsetsPerPoll];
+    jfloat onsetStrengths[kMaxOnsetsPerPoll];
+    
+    int capacity = std::min({ (int)env->GetArrayLength(positions),
+                              (int)env->GetArrayLength(strengths),
+                              kMaxOnsetsPerPoll });
+    int count = 0;
+    OnsetEvent onset;
+    while (count < capacity && g_player->getOnsetDetector().pollOnset(onset)) {
+        onsetPositions[count] = onset.framePosition;
+        onsetStrengths[count] = onset.strength;
+        count++;
+    }
+    
+    if (count > 0) {
+        env->SetLongArrayRegion(positions, 0, count, onsetPositions);
+        env->SetFloatArrayRegion(strengths, 0, count, onsetStrengths);
+    }
+    return count;
+}
+
+/**
+ * Check whether the microphone input stream is running.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeIsInputActive(
+    JNIEnv* env,
+    jobject /* this */
+) {
+    return g_player && g_player->isInputActive() ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Start a round-trip latency calibration. Pitch detection (the input stream)
+ * must be running.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeStartLatencyCalibration(
+    JNIEnv* env,
+    jobject /* this */
+) {
+    return g_player && g_player->startLatencyCalibration() ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Poll the calibration. Once the recording is complete this runs the analysis
+ * on the calling thread. Returns the LatencyCalibrator::State; on STATE_DONE,
+ * out gets [roundTripFrames, detections, quality].
+ */
+JNIEXPORT jint JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativePollLatencyCalibration(
+    JNIEnv* env,
+    jobject /* this */,
+    jfloatArray out
+) {
+    if (!g_player) {
+        return LatencyCalibrator::STATE_IDLE;
+    }
+    
+    LatencyCalibrator& calibrator = g_player->getLatencyCalibrator();
+    LatencyResult result;
+    if (calibrator.analyze(result) && out && env->GetArrayLength(out) >= 3) {
+        jfloat values[3] = { (jfloat)result.roundTripFrames, (jfloat)result.detections, result.quality };
+        env->SetFloatArrayRegion(out, 0, 3, values);
+    }
+    return calibrator.getState();
+}
+
+/**
+ * Abort a running calibration.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeCancelLatencyCalibration(
+    JNIEnv* env,
+    jobject /* this */
+) {
+    if (g_player) {
+        g_player->getLatencyCalibrator().cancel();
+    }
+}
+
+/**
+ * Set the frames subtracted from input stamps (the calibrated round trip).
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSetInputLatencyOffset(
+    JNIEnv* env,
+    jobject /* this */,
+    jint frames
+) {
+    if (g_player) {
+        g_player->setInputLatencyOffset(std::max(0, (int)frames));
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeGetInputLatencyOffset(
+    JNIEnv* env,
+    jobject /* this */
+) {
+    return g_player ? g_player->getInputLatencyOffset() : 0;
+}
+
+/**
+ * Live latency estimates from Oboe: out gets [outputMs, inputMs], -1 where
+ * the stream is closed or the device cannot report it.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeGetLatencyEstimates(
+    JNIEnv* env,
+    jobject /* this */,
+    jdoubleArray out
+) {
+    if (!out || env->GetArrayLength(out) < 2) {
+        return;
+    }
+    jdouble values[2] = { -1.0, -1.0 };
+    if (g_player) {
+        values[0] = g_player->getOutputLatencyMillis();
+        values[1] = g_player->getInputLatencyMillis();
+    }
+    env->SetDoubleArrayRegion(out, 0, 2, values);
+}
+
+/**
+ * Set the instrument preset for a channel.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSetPreset(
+    JNIEnv* env,
+    jobject /* this */,
+    jint channel,
+    jint preset
+) {
+    if (g_player) {
+        g_player->getSoundFontEngine().setPreset(channel, preset);
+    }
+}
+
+/**
+ * Set a channel's volume (0..1).
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSetChannelVolume(
+    JNIEnv* env,
+    jobject /* this */,
+    jint channel,
+    jfloat volume
+) {
+    if (g_player) {
+        g_player->getSoundFontEngine().setChannelVolume(channel, volume);
+    }
+}
+
+/**
+ * Set a channel's pan (0 = left, 0.5 = center, 1 = right).
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSetChannelPan(
+    JNIEnv* env,
+    jobject /* this */,
+    jint channel,
+    jfloat pan
+) {
+    if (g_player) {
+        g_player->getSoundFontEngine().setChannelPan(channel, pan);
+    }
+}
+
+/**
+ * Hold or release a channel's sustain pedal.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSetChannelSustain(
+    JNIEnv* env,
+    jobject /* this */,
+    jint channel,
+    jboolean sustain
+) {
+    if (g_player) {
+        g_player->getSoundFontEngine().setChannelSustain(channel, sustain == JNI_TRUE);
+    }
+}
+
+/**
+ * Load a different piano bank and swap it in without restarting the stream.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSwapSoundFont(
+    JNIEnv* env,
+    jobject /* this */,
+    jobject assetManager,
+    jstring soundFontPath,
+    jint preset
+) {
+    if (!g_player) {
+        return JNI_FALSE;
+    }
+    AAssetManager* mgr = AAssetManager_fromJava(env, assetManager);
+    const char* sfPath = env->GetStringUTFChars(soundFontPath, nullptr);
+    if (!mgr || !sfPath) {
+        if (sfPath) {
+            env->ReleaseStringUTFChars(soundFontPath, sfPath);
+        }
+        return JNI_FALSE;
+    }
+    g_player->getSoundFontEngine().swapSoundFontAsync(mgr, sfPath, preset);
+    env->ReleaseStringUTFChars(soundFontPath, sfPath);
+    return JNI_TRUE;
+}
+
+/**
+ * Piano voice usage: [active, peak, capacity, stolen].
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeGetVoiceStats(
+    JNIEnv* env,
+    jobject /* this */,
+    jintArray out
+) {
+    if (!g_player || env->GetArrayLength(out) < 4) {
+        return;
+    }
+    SoundFontEngine::VoiceStats stats = g_player->getSoundFontEngine().getVoiceStats();
+    jint values[4] = { stats.active, stats.peak, stats.capacity, (jint)stats.stolen };
+    env->SetIntArrayRegion(out, 0, 4, values);
+}
+
+/**
+ * State of the most recent SoundFont load (SoundFontEngine::LoadState).
+ */
+JNIEXPORT jint JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeGetLoadState(
+    JNIEnv* env,
+    jobject /* this */
+) {
+    return g_player ? (jint)g_player->getSoundFontEngine().getLoadState() : (jint)SoundFontEngine::LOAD_IDLE;
+}
+
+/**
+ * Load a Standard MIDI File (format 0 or 1) for native playback.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeLoadMidi(
+    JNIEnv* env,
+    jobject /* this */,
+    jbyteArray data
+) {
+    if (!g_player || !data) {
+        return JNI_FALSE;
+    }
+    std::vector<uint8_t> bytes(env->GetArrayLength(data));
+    env->GetByteArrayRegion(data, 0, (jsize)bytes.size(), reinterpret_cast<jbyte*>(bytes.data()));
+    return g_player->getSoundFontEngine().loadMidi(bytes.data(), bytes.size()) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Start MIDI playback on a stream frame (-1 = next callback).
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativePlayMidi(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong startFrame
+) {
+    if (g_player) {
+        g_player->getSoundFontEngine().playMidi(startFrame);
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeStopMidi(
+    JNIEnv* env,
+    jobject /* this */
+) {
+    if (g_player) {
+        g_player->getSoundFontEngine().stopMidi();
+    }
+}
+
+/**
+ * Seek to a file tick, or to a song position in frames when inFrames is set.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSeekMidi(
+    JNIEnv* env,
+    jobject /* this */,
+    jint position,
+    jboolean inFrames
+) {
+    if (!g_player) {
+        return;
+    }
+    if (inFrames) {
+        g_player->getSoundFontEngine().seekMidiFrame(position);
+    } else {
+        g_player->getSoundFontEngine().seekMidiTick(position);
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSetMidiTempoScale(
+    JNIEnv* env,
+    jobject /* this */,
+    jfloat scale
+) {
+    if (g_player) {
+        g_player->getSoundFontEngine().setMidiTempoScale(scale);
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSetMidiLoop(
+    JNIEnv* env,
+    jobject /* this */,
+    jint startTick,
+    jint endTick
+) {
+    if (g_player) {
+        g_player->getSoundFontEngine().setMidiLoop(startTick, endTick);
+    }
+}
+
+/**
+ * MIDI playback state: [positionTick, lengthTicks, playing, ticksPerQuarter].
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeGetMidiState(
+    JNIEnv* env,
+    jobject /* this */,
+    jlongArray out
+) {
+    if (!g_player || env->GetArrayLength(out) < 4) {
+        return;
+    }
+    SoundFontEngine::MidiState state = g_player->getSoundFontEngine().getMidiState();
+    jlong values[4] = { (jlong)state.positionTick, (jlong)state.lengthTicks,
+                        state.playing ? 1 : 0, (jlong)state.ticksPerQuarter };
+    env->SetLongArrayRegion(out, 0, 4, values);
+}
+
+/**
+ * Render a packed note batch and/or a MIDI file offline.
+ * Returns interleaved stereo floats, or null on failure.
+ */
+JNIEXPORT jfloatArray JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeRenderOffline(
+    JNIEnv* env,
+    jobject /* this */,
+    jintArray events,
+    jint count,
+    jbyteArray midi,
+    jint sampleRate
+) {
+    std::vector<float> pcm;
+    if (!renderOfflineFromJava(env, events, count, midi, sampleRate, pcm)) {
+        return nullptr;
+    }
+    jfloatArray result = env->NewFloatArray((jsize)pcm.size());
+    if (result) {
+        env->SetFloatArrayRegion(result, 0, (jsize)pcm.size(), pcm.data());
+    }
+    return result;
+}
+
+/**
+ * Render offline straight to a 16-bit stereo WAV file.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeRenderOfflineToWav(
+    JNIEnv* env,
+    jobject /* this */,
+    jintArray events,
+    jint count,
+    jbyteArray midi,
+    jint sampleRate,
+    jstring path
+) {
+    std::vector<float> pcm;
+    if (!path || !renderOfflineFromJava(env, events, count, midi, sampleRate, pcm)) {
+        return JNI_FALSE;
+    }
+    const char* wavPath = env->GetStringUTFChars(path, nullptr);
+    if (!wavPath) {
+        return JNI_FALSE;
+    }
+    int rate = sampleRate > 0 ? sampleRate : g_player->getSampleRate();
+    bool ok = WavWriter::write(wavPath, pcm.data(), pcm.size() / 2, 2, rate);
+    env->ReleaseStringUTFChars(path, wavPath);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Play (or with play = false, only pre-render) a cached prompt clip.
+ * A clip not cached yet is rendered offline on this thread first.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativePlayClip(
+    JNIEnv* env,
+    jobject /* this */,
+    jintArray notes,
+    jint program,
+    jint velocity,
+    jint durationFrames,
+    jint spacingFrames,
+    jlong startFrame,
+    jint bus,
+    jboolean play
+) {
+    if (!g_player || !notes) {
+        return JNI_FALSE;
+    }
+    ClipKey key;
+    key.program = program;
+    key.noteCount = std::min((int)env->GetArrayLength(notes), ClipKey::kMaxNotes);
+    env->GetIntArrayRegion(notes, 0, key.noteCount, key.notes);
+    key.velocity = velocity;
+    key.durationFrames = durationFrames;
+    key.spacingFrames = spacingFrames;
+    
+    SoundFontEngine& engine = g_player->getSoundFontEngine();
+    bool ok = play ? engine.playClip(key, startFrame, (RenderArena::Bus)bus) : engine.prepareClip(key);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSetClipCacheBudget(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong bytes
+) {
+    if (g_player) {
+        g_player->getSoundFontEngine().setClipCacheBudget((size_t)std::max<jlong>(0, bytes));
+    }
+}
+
+/**
+ * Clip cache usage: [clips, bytes, budgetBytes, hits, misses].
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeGetClipCacheStats(
+    JNIEnv* env,
+    jobject /* this */,
+    jlongArray out
+) {
+    if (!g_player || env->GetArrayLength(out) < 5) {
+        return;
+    }
+    ClipCache::Stats stats = g_player->getSoundFontEngine().getClipCacheStats();
+    jlong values[5] = { stats.clips, (jlong)stats.bytes, (jlong)stats.budgetBytes,
+                        (jlong)stats.hits, (jlong)stats.misses };
+    env->SetLongArrayRegion(out, 0, 5, values);
+}
+
+/**
+ * Output mix: gain of one bus (RenderArena::Bus), 1.0 = unity.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSetBusGain(
+    JNIEnv* env,
+    jobject /* this */,
+    jint bus,
+    jfloat gain
+) {
+    if (g_player && bus >= 0 && bus < RenderArena::BUS_COUNT) {
+        g_player->getSoundFontEngine().setBusGain((RenderArena::Bus)bus, gain);
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSetDuckingDepth(
+    JNIEnv* env,
+    jobject /* this */,
+    jfloat depth
+) {
+    if (g_player) {
+        g_player->getSoundFontEngine().setDuckingDepth(depth);
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSetLimiter(
+    JNIEnv* env,
+    jobject /* this */,
+    jboolean enabled,
+    jfloat ceilingDb
+) {
+    if (g_player) {
+        g_player->getSoundFontEngine().setLimiter(enabled, ceilingDb);
+    }
+}
+
+/**
+ * Largest limiter gain reduction since the last call, in dB (0 = none).
+ */
+JNIEXPORT jfloat JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeTakeLimiterReduction(
+    JNIEnv* env,
+    jobject /* this */
+) {
+    return g_player ? g_player->getSoundFontEngine().takeLimiterReductionDb() : 0.0f;
+}
+
+/**
+ * Output stream state and outage history:
+ * out = {state, recoveries, attempts, lastOutageMillis, frameAtOutage}.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeGetStreamState(
+    JNIEnv* env,
+    jobject /* this */,
+    jlongArray out
+) {
+    if (!g_player || env->GetArrayLength(out) < 5) {
+        return;
+    }
+    OboePlayer::RecoveryStats stats = g_player->getRecoveryStats();
+    jlong values[5] = { (jlong)stats.state, stats.recoveries, stats.attempts,
+                        (jlong)stats.lastOutageMillis, (jlong)stats.frameAtOutage };
+    env->SetLongArrayRegion(out, 0, 5, values);
+}
+
+/**
+ * Output buffer tuning: out = {bufferFrames, capacityFrames, burstFrames, xruns, tuning}.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeGetBufferStats(
+    JNIEnv* env,
+    jobject /* this */,
+    jlongArray out
+) {
+    if (!g_player || env->GetArrayLength(out) < 5) {
+        return;
+    }
+    BufferTuner::Stats stats = g_player->getBufferTuner().getStats();
+    jlong values[5] = { stats.bufferFrames, stats.capacityFrames, stats.burstFrames,
+                        (jlong)stats.xruns, stats.tuning ? 1 : 0 };
+    env->SetLongArrayRegion(out, 0, 5, values);
+}
+
+/**
+ * Let the output buffer shrink back after long underrun-free stretches.
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSetBufferAutoShrink(
+    JNIEnv* env,
+    jobject /* this */,
+    jboolean enabled
+) {
+    if (g_player) {
+        g_player->getBufferTuner().setShrinkEnabled(enabled == JNI_TRUE);
+    }
+}
+
+/**
+ * Pin the audio callback to the fastest cores when no performance hint
+ * session is available (takes effect at the next stream open).
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeSetAffinityFallback(
+    JNIEnv* env,
+    jobject /* this */,
+    jboolean enabled
+) {
+    if (g_player) {
+        g_player->setAffinityFallback(enabled == JNI_TRUE);
+    }
+}
+
+/**
+ * How the callback's CPU demand reaches the scheduler (OboePlayer::HintMode).
+ */
+JNIEXPORT jint JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeGetPerformanceHintMode(
+    JNIEnv* env,
+    jobject /* this */
+) {
+    return g_player ? (jint)g_player->getHintMode() : (jint)OboePlayer::HINT_NONE;
+}
+
+/**
+ * Audio callback performance snapshot, optionally resetting the counters.
+ * out = {callbacks, overruns, maxNanos, meanNanos, maxLoadPermille,
+ *        meanLoadPermille, maxVoices, xruns, lateEvents, maxLateFrames,
+ *        maxQueueNanos, droppedCommands, histogram[12]...}
+ */
+JNIEXPORT void JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeGetPerfStats(
+    JNIEnv* env,
+    jobject /* this */,
+    jlongArray out,
+    jboolean reset
+) {
+    constexpr int kFields = 12 + PerfCounters::kHistogramBuckets;
+    if (!g_player || env->GetArrayLength(out) < kFields) {
+        return;
+    }
+    PerfCounters::Snapshot perf = g_player->getPerfCounters().snapshot();
+    SoundFontEngine& engine = g_player->getSoundFontEngine();
+    SoundFontEngine::RenderStats render = engine.getRenderStats();
+    jlong values[kFields] = {
+        perf.callbacks, perf.overruns, perf.maxNanos, perf.meanNanos,
+        perf.maxLoadPermille, perf.meanLoadPermille, perf.maxVoices,
+        (jlong)g_player->getBufferTuner().getStats().xruns,
+        render.lateEvents, render.maxLateFrames, render.maxQueueNanos,
+        (jlong)engine.getDroppedCommandCount()
+    };
+    for (int i = 0; i < PerfCounters::kHistogramBuckets; i++) {
+        values[12 + i] = perf.histogram[i];
+    }
+    env->SetLongArrayRegion(out, 0, kFields, values);
+    
+    if (reset == JNI_TRUE) {
+        g_player->getPerfCounters().requestReset();
+        engine.resetRenderStats();
+    }
+}
+
+/**
+ * Direct ByteBuffer over the shared UI channel (layout in UiStateChannel.h).
+ * The memory stays valid for the life of the process.
+ */
+JNIEXPORT jobject JNICALL
+Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeGetUiChannel(
+    JNIEnv* env,
+    jobject /* this */
+) {
+    return env->NewDirectByteBuffer(g_uiChannel.data(), (jlong)UiStateChannel::size());
+}
+
 /**
  * Check if the engine is ready.
  */
@@ -143,7 +1588,7 @@ Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeIsReady(
 }
 
 /**
- * Release all resources.
+ * Release all resources, sessions included.
  */
 JNIEXPORT void JNICALL
 Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeRelease(
@@ -163,7 +1608,7 @@ Java_com_musimind_music_audio_nativeaudio_NativeAudioBridge_nativeGetSampleRate(
     JNIEnv* env,
     jobject /* this */
 ) {
-    return g_player ? g_player->getSampleRate() : 44100;
+    return g_player ? g_player->getSampleRate() : SoundFontEngine::kSampleRate;
 }
 
 } // extern "C"
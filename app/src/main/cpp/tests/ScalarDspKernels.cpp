@@ -0,0 +1,9 @@
+/**
+ * ScalarDspKernels.cpp
+ *
+ * DspKernels.cpp built as ScalarDspKernels with the SIMD paths compiled out.
+ */
+
+#define MUSIMIND_DSP_SCALAR 1
+#define DspKernels ScalarDspKernels
+#include "../DspKernels.cpp"
@@ -0,0 +1,20 @@
+/**
+ * ScalarDspKernels.h
+ *
+ * The DspKernels interface a second time, as ScalarDspKernels: the same
+ * kernels compiled with their scalar paths only (ScalarDspKernels.cpp), so
+ * the tests can hold the NEON and SSE2 paths against them in one binary.
+ */
+
+#ifndef MUSIMIND_SCALAR_DSP_KERNELS_H
+#define MUSIMIND_SCALAR_DSP_KERNELS_H
+
+#include "../DspKernels.h"
+
+// Re-read the header under the other class name
+#undef MUSIMIND_DSP_KERNELS_H
+#define DspKernels ScalarDspKernels
+#include "../DspKernels.h"
+#undef DspKernels
+
+#endif // MUSIMIND_SCALAR_DSP_KERNELS_H
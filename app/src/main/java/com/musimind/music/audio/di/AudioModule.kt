@@ -38,9 +38,10 @@ object AudioModule {
     @Provides
     @Singleton
     fun provideMetronome(
-        @ApplicationContext context: Context
+        @ApplicationContext context: Context,
+        nativeAudioBridge: NativeAudioBridge
     ): Metronome {
-        return Metronome(context)
+        return Metronome(context, nativeAudioBridge)
     }
     
     @Provides
@@ -7,7 +7,11 @@ import android.media.MediaRecorder
 import android.util.Log
 import com.musimind.music.audio.core.*
 import com.musimind.music.audio.midi.MidiPlayer
+import com.musimind.music.audio.nativeaudio.NativeAudioBridge
+import com.musimind.music.audio.nativeaudio.NativeUiChannel
 import com.musimind.music.audio.scoring.AnalysisEngine
+import com.musimind.music.audio.scoring.PitchScoreResult
+import com.musimind.music.audio.scoring.TimingScoreResult
 import kotlinx.coroutines.*
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.StateFlow
@@ -20,8 +24,8 @@ import java.util.concurrent.atomic.AtomicLong
  * Integra:
  * - Clock de áudio sample-accurate
  * - Playback (metrônomo + notas)
- * - Captura de microfone
- * - Análise de pitch
+ * - Captura de microfone (full-duplex nativo, com fallback para AudioRecord)
+ * - Análise de pitch (YIN nativo no callback de áudio quando disponível)
  * - Feedback em tempo real
  * 
  * PRINCÍPIOS:
@@ -31,7 +35,8 @@ import java.util.concurrent.atomic.AtomicLong
  */
 class SolfegeAudioEngine(
     private val context: Context,
-    private val midiPlayer: MidiPlayer
+    private val midiPlayer: MidiPlayer,
+    private val nativeAudio: NativeAudioBridge? = null
 ) {
     companion object {
         private const val TAG = "SolfegeAudioEngine"
@@ -57,6 +62,8 @@ class SolfegeAudioEngine(
     
     // Audio recording
     private var audioRecord: AudioRecord? = null
+    private var isNativeCapture = false
+    @Volatile private var nativeScoringRate = 0  // Taxa do stream nativo enquanto o scorer nativo pontua
     private var recordingJob: Job? = null
     private var analysisJob: Job? = null
     
@@ -328,8 +335,190 @@ class SolfegeAudioEngine(
     
     /**
      * Inicia gravação do microfone (interno).
+     * Prefere o stream full-duplex nativo; usa AudioRecord se indisponível.
      */
     private fun startRecordingInternal(): Boolean {
+        val bridge = nativeAudio
+        if (bridge != null) {
+            // A timeline vai para o scorer nativo antes do microfone abrir
+            val channel = bridge.getUiChannel()
+            val nativeScoring = channel != null && loadNativeScoring(bridge)
+            // Com o canal lendo o pitch, ninguém drena a fila JNI: desligada, não acumula drops
+            bridge.setPitchQueueEnabled(channel == null)
+            if (bridge.startPitchDetection(NativeAudioBridge.PITCH_PRESET_VOICE)) {
+                isNativeCapture = true
+                analysisEngine.enableExternalOnsets()
+                analysisJob = engineScope.launch(Dispatchers.Default) {
+                    if (nativeScoring && channel != null) {
+                        runNativeScoringLoop(bridge, channel)
+                    } else {
+                        runNativeAnalysisLoop(bridge, channel)
+                    }
+                }
+                return true
+            }
+            bridge.setPitchQueueEnabled(true)
+        }
+        return startAudioRecordInternal()
+    }
+    
+    /**
+     * Envia as notas esperadas ao scorer nativo, em frames do stream nativo
+     * relativos ao fim do countdown.
+     */
+    private fun loadNativeScoring(bridge: NativeAudioBridge): Boolean {
+        val nativeRate = bridge.getSampleRate()
+        val stride = NativeAudioBridge.SCORING_NOTE_STRIDE
+        val packed = LongArray(expectedNotes.size * stride)
+        expectedNotes.forEachIndexed { i, note ->
+            packed[i * stride] = note.startSample * nativeRate / SAMPLE_RATE
+            packed[i * stride + 1] = note.endSample * nativeRate / SAMPLE_RATE
+            packed[i * stride + 2] = note.midiNote.toLong()
+        }
+        return bridge.loadScoringTimeline(packed, expectedNotes.size, octaveOffset)
+    }
+    
+    /**
+     * Modo de scoring nativo: o C++ pontua cada nota junto dos detectores,
+     * no mesmo clock do output. Aqui chegam só os resultados por nota e o
+     * pitch ao vivo, lido da memória compartilhada.
+     */
+    private suspend fun runNativeScoringLoop(
+        bridge: NativeAudioBridge,
+        channel: NativeUiChannel
+    ) = withContext(Dispatchers.Default) {
+        val nativeRate = bridge.getSampleRate()
+        val countdownFrames = (audioClock.samplesPerMeasure * nativeRate / SAMPLE_RATE).toLong()
+        val originFrame = bridge.getFramePosition() + countdownFrames
+        
+        fun toExerciseSample(frame: Long): Long = (frame - originFrame) * SAMPLE_RATE / nativeRate
+        
+        analysisEngine.enableNativeScoring()
+        nativeScoringRate = nativeRate
+        bridge.armScoring(originFrame)
+        
+        val state = NativeUiChannel.State()
+        var lastPitchFrame = -1L
+        while (isRunning && isActive) {
+            val scored = drainNativeScores(bridge)
+            // Feedback só quando há pitch novo ou nota pontuada
+            if (channel.readState(state) && state.pitchFrame >= 0 &&
+                (state.pitchFrame != lastPitchFrame || scored > 0)) {
+                lastPitchFrame = state.pitchFrame
+                val start = toExerciseSample(state.pitchFrame)
+                analysisEngine.updateLive(
+                    PitchFrame(
+                        samplePositionStart = start,
+                        samplePositionEnd = start,
+                        windowSizeSamples = 0,
+                        frequency = state.frequency,
+                        confidence = state.confidence,
+                        midiNote = state.midiNote,
+                        centDeviation = state.centDeviation,
+                        isVoiced = state.isVoiced
+                    )
+                )
+            }
+            delay(10) // ~100 Hz de atualização
+        }
+        
+        // Nenhum frame posterior passa da última nota: o scorer a fecha aqui
+        bridge.finishScoring()
+        drainNativeScores(bridge)
+    }
+    
+    /**
+     * Aplica os resultados que o scorer nativo já fechou.
+     * Sincronizado: o fim do loop e stop() podem drenar ao mesmo tempo.
+     */
+    @Synchronized
+    private fun drainNativeScores(bridge: NativeAudioBridge): Int {
+        val nativeRate = nativeScoringRate
+        if (nativeRate <= 0) return 0
+        return bridge.drainNoteScores { score ->
+            analysisEngine.applyNoteScore(
+                score.noteIndex,
+                PitchScoreResult(
+                    score = score.pitchScore,
+                    status = PitchStatus.entries[score.pitchStatus],
+                    avgCentDeviation = score.averageCents,
+                    stdDeviation = score.centStdDev,
+                    correctRatio = score.correctRatio
+                ),
+                TimingScoreResult(
+                    score = score.timingScore,
+                    status = TimingStatus.entries[score.timingStatus],
+                    attackDeviationSamples = score.attackDeviationFrames * SAMPLE_RATE / nativeRate,
+                    attackDeviationMs = score.attackDeviationFrames * 1000f / nativeRate,
+                    durationAccuracy = score.durationAccuracy,
+                    attackScore = score.attackScore,
+                    durationScore = score.durationScore
+                )
+            )
+        }
+    }
+    
+    /**
+     * Consome os pitch frames e onsets do detector nativo.
+     * Os frames vêm no clock do stream nativo; aqui são convertidos para o
+     * clock do exercício (SAMPLE_RATE, posição 0 = fim do countdown).
+     */
+    private suspend fun runNativeAnalysisLoop(
+        bridge: NativeAudioBridge,
+        channel: NativeUiChannel?
+    ) = withContext(Dispatchers.Default) {
+        val nativeRate = bridge.getSampleRate()
+        val countdownFrames = (audioClock.samplesPerMeasure * nativeRate / SAMPLE_RATE).toLong()
+        val originFrame = bridge.getFramePosition() + countdownFrames
+        
+        fun toExerciseSample(frame: Long): Long = (frame - originFrame) * SAMPLE_RATE / nativeRate
+        
+        // Pitch frames lidos direto da memória compartilhada (sem JNI por poll);
+        // a fila JNI fica como fallback
+        val pitchSink = NativeUiChannel.PitchFrameSink { position, windowSize, frequency, confidence, midiNote, cents, rms, voiced ->
+            analysisEngine.processFrame(
+                PitchFrame(
+                    samplePositionStart = toExerciseSample(position),
+                    samplePositionEnd = toExerciseSample(position + windowSize),
+                    windowSizeSamples = (windowSize.toLong() * SAMPLE_RATE / nativeRate).toInt(),
+                    frequency = frequency,
+                    confidence = confidence,
+                    midiNote = midiNote,
+                    centDeviation = cents,
+                    isVoiced = voiced
+                ),
+                rms
+            )
+        }
+        
+        while (isRunning && isActive) {
+            if (channel != null) {
+                channel.drainPitchFrames(pitchSink)
+            } else {
+                bridge.drainPitchFrames { frame, rms ->
+                    val start = toExerciseSample(frame.samplePositionStart)
+                    analysisEngine.processFrame(
+                        frame.copy(
+                            samplePositionStart = start,
+                            samplePositionEnd = toExerciseSample(frame.samplePositionEnd),
+                            windowSizeSamples = (frame.windowSizeSamples.toLong() * SAMPLE_RATE / nativeRate).toInt()
+                        ),
+                        rms
+                    )
+                }
+            }
+            // Onsets nativos: mesmo clock do stream, convertidos igual aos pitch frames
+            bridge.drainOnsets { frame, _ ->
+                analysisEngine.processOnset(toExerciseSample(frame))
+            }
+            delay(10) // ~100 Hz de atualização
+        }
+    }
+    
+    /**
+     * Fallback: captura via AudioRecord e YIN em Kotlin.
+     */
+    private fun startAudioRecordInternal(): Boolean {
         val bufferSize = AudioRecord.getMinBufferSize(
             SAMPLE_RATE,
             AudioFormat.CHANNEL_IN_MONO,
@@ -412,6 +601,17 @@ class SolfegeAudioEngine(
         recordingJob?.cancel()
         analysisJob?.cancel()
         
+        if (isNativeCapture) {
+            // Parar o input fecha as notas em aberto no scorer nativo
+            nativeAudio?.let { bridge ->
+                bridge.stopPitchDetection()
+                drainNativeScores(bridge)
+                bridge.setPitchQueueEnabled(true)
+            }
+            nativeScoringRate = 0
+            isNativeCapture = false
+        }
+        
         audioRecord?.stop()
         audioRecord?.release()
         audioRecord = null
@@ -421,6 +621,14 @@ class SolfegeAudioEngine(
         updateCurrentNote(-1)  // Reset highlight to initial state
     }
     
+    /**
+     * Leitor da memória compartilhada com o detector nativo, para a UI
+     * consultar pitch e níveis a cada frame sem JNI nem alocação.
+     * Null quando a captura usa o fallback AudioRecord.
+     */
+    fun openLiveChannel(): NativeUiChannel? =
+        if (isNativeCapture) nativeAudio?.getUiChannel() else null
+    
     /**
      * Limpa recursos.
      */
@@ -1,8 +1,8 @@
 package com.musimind.music.audio.metronome
 
 import android.content.Context
-import android.media.AudioAttributes
-import android.media.SoundPool
+import android.util.Log
+import com.musimind.music.audio.nativeaudio.NativeAudioBridge
 import kotlinx.coroutines.*
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.StateFlow
@@ -15,74 +15,41 @@ import javax.inject.Singleton
  * 
  * Features:
  * - Configurable BPM (40-240)
- * - Accent on first beat
+ * - Accent on first beat (or a custom accent pattern)
+ * - Subdivisions
  * - Visual beat indicator
  * - Time signature support
+ * 
+ * Clicks are generated sample-accurately inside the native audio callback.
+ * This class only pushes settings and polls the beats the native side
+ * reports, so UI or GC hiccups never shift a click.
  */
 @Singleton
 class Metronome @Inject constructor(
-    private val context: Context
+    private val context: Context,
+    private val nativeAudio: NativeAudioBridge
 ) {
     companion object {
+        private const val TAG = "Metronome"
+        
         const val MIN_BPM = 40
         const val MAX_BPM = 240
         const val DEFAULT_BPM = 100
+        const val MAX_SUBDIVISION = 8
+        
+        // Beat polling only drives the UI; audio timing is native
+        private const val BEAT_POLL_INTERVAL_MS = 8L
+        private const val BEAT_POLL_CAPACITY = 32
     }
     
-    // Sound pool for low-latency audio
-    private var soundPool: SoundPool? = null
-    private var tickSoundId: Int = 0
-    private var tockSoundId: Int = 0
-    private var isSoundLoaded = false
-    
     // Metronome state
     private val _state = MutableStateFlow(MetronomeState())
     val state: StateFlow<MetronomeState> = _state.asStateFlow()
     
-    // Coroutine scope for metronome timing
+    // Coroutine scope for beat polling
     private var metronomeJob: Job? = null
     private val scope = CoroutineScope(Dispatchers.Default + SupervisorJob())
     
-    init {
-        initializeSoundPool()
-    }
-    
-    /**
-     * Initialize sound pool with click sounds
-     */
-    private fun initializeSoundPool() {
-        val attributes = AudioAttributes.Builder()
-            .setUsage(AudioAttributes.USAGE_GAME)
-            .setContentType(AudioAttributes.CONTENT_TYPE_SONIFICATION)
-            .build()
-        
-        soundPool = SoundPool.Builder()
-            .setMaxStreams(2)
-            .setAudioAttributes(attributes)
-            .build()
-            .apply {
-                setOnLoadCompleteListener { _, _, status ->
-                    if (status == 0) {
-                        isSoundLoaded = true
-                    }
-                }
-            }
-        
-        // Load sounds from assets or use synthesized clicks
-        try {
-            context.assets.openFd("sounds/metronome_tick.wav").use { afd ->
-                tickSoundId = soundPool?.load(afd, 1) ?: 0
-            }
-            context.assets.openFd("sounds/metronome_tock.wav").use { afd ->
-                tockSoundId = soundPool?.load(afd, 1) ?: 0
-            }
-        } catch (e: Exception) {
-            // If sounds not found, we'll use synthesized clicks
-            // For now, just mark as loaded so the visual beat works
-            isSoundLoaded = true
-        }
-    }
-    
     /**
      * Start the metronome
      */
@@ -92,41 +59,86 @@ class Metronome @Inject constructor(
         _state.value = _state.value.copy(isPlaying = true, currentBeat = 0)
         
         metronomeJob = scope.launch {
-            var beat = 0
-            val beatsPerMeasure = _state.value.beatsPerMeasure
+            if (!nativeAudio.initialize()) {
+                Log.w(TAG, "Native audio unavailable, running visual-only metronome")
+                runVisualOnly()
+                return@launch
+            }
+            
+            // initialize() can block; a stop() meanwhile already silenced it
+            if (!isActive) return@launch
+            pushSettings()
+            nativeAudio.startMetronome()
             
+            // stop() silences the native side itself; a finally here would run
+            // late, after a quick restart, and stop the new run
+            val events = LongArray(BEAT_POLL_CAPACITY * NativeAudioBridge.BEAT_EVENT_STRIDE)
             while (isActive) {
-                val bpm = _state.value.bpm
-                val intervalMs = (60_000L / bpm)
-                
-                // Update current beat
-                _state.value = _state.value.copy(
-                    currentBeat = beat + 1 // 1-indexed for display
-                )
-                
-                // Play sound
-                if (isSoundLoaded && _state.value.soundEnabled) {
-                    val soundId = if (beat == 0) tickSoundId else tockSoundId
-                    val volume = if (beat == 0) 1.0f else 0.7f
-                    soundPool?.play(soundId, volume, volume, 1, 0, 1.0f)
+                val count = nativeAudio.pollMetronomeBeats(events)
+                for (i in 0 until count) {
+                    val base = i * NativeAudioBridge.BEAT_EVENT_STRIDE
+                    val frame = events[base]
+                    val beat = events[base + 1].toInt()
+                    val subdivision = events[base + 2].toInt()
+                    
+                    // Update current beat (subdivision clicks don't move the beat display)
+                    if (subdivision == 0) {
+                        _state.value = _state.value.copy(
+                            currentBeat = beat + 1, // 1-indexed for display
+                            lastBeatFrame = frame
+                        )
+                    }
                 }
-                
-                // Wait for next beat
-                delay(intervalMs)
-                
-                // Cycle beat
-                beat = (beat + 1) % beatsPerMeasure
+                delay(BEAT_POLL_INTERVAL_MS)
             }
         }
     }
     
+    /**
+     * Fallback when the native engine is missing: beat display only, no sound.
+     */
+    private suspend fun runVisualOnly() = coroutineScope {
+        var beat = 0
+        while (isActive) {
+            _state.value = _state.value.copy(currentBeat = beat + 1)
+            delay(_state.value.intervalMs)
+            beat = (beat + 1) % _state.value.beatsPerMeasure
+        }
+    }
+    
+    /**
+     * Send the current settings to the native metronome
+     */
+    private fun pushSettings() {
+        val current = _state.value
+        nativeAudio.setMetronome(
+            bpm = current.bpm.toFloat(),
+            beatsPerMeasure = current.beatsPerMeasure,
+            beatUnit = current.beatUnit,
+            subdivision = current.subdivision,
+            accentMask = current.accentMask,
+            muted = !current.soundEnabled
+        )
+    }
+    
+    /**
+     * Update state and, if running, the native metronome
+     */
+    private fun updateState(transform: (MetronomeState) -> MetronomeState) {
+        _state.value = transform(_state.value)
+        if (_state.value.isPlaying) {
+            pushSettings()
+        }
+    }
+    
     /**
      * Stop the metronome
      */
     fun stop() {
         metronomeJob?.cancel()
         metronomeJob = null
-        _state.value = _state.value.copy(isPlaying = false, currentBeat = 0)
+        nativeAudio.stopMetronome()
+        _state.value = _state.value.copy(isPlaying = false, currentBeat = 0, lastBeatFrame = -1L)
     }
     
     /**
@@ -141,7 +153,7 @@ class Metronome @Inject constructor(
      */
     fun setBpm(bpm: Int) {
         val clampedBpm = bpm.coerceIn(MIN_BPM, MAX_BPM)
-        _state.value = _state.value.copy(bpm = clampedBpm)
+        updateState { it.copy(bpm = clampedBpm) }
     }
     
     /**
@@ -162,25 +174,42 @@ class Metronome @Inject constructor(
      * Set time signature
      */
     fun setTimeSignature(beatsPerMeasure: Int, beatUnit: Int = 4) {
-        _state.value = _state.value.copy(
-            beatsPerMeasure = beatsPerMeasure,
-            beatUnit = beatUnit,
-            currentBeat = 0
-        )
+        updateState {
+            it.copy(
+                beatsPerMeasure = beatsPerMeasure,
+                beatUnit = beatUnit,
+                currentBeat = 0
+            )
+        }
+    }
+    
+    /**
+     * Set clicks per beat (1 = beats only, 2 = eighths, 4 = sixteenths...)
+     */
+    fun setSubdivision(subdivision: Int) {
+        updateState { it.copy(subdivision = subdivision.coerceIn(1, MAX_SUBDIVISION)) }
+    }
+    
+    /**
+     * Set which beats are accented (0-based beat indexes)
+     */
+    fun setAccentPattern(accentedBeats: Set<Int>) {
+        val mask = accentedBeats.fold(0) { acc, beat -> acc or (1 shl beat) }
+        updateState { it.copy(accentMask = mask) }
     }
     
     /**
      * Toggle sound on/off
      */
     fun toggleSound() {
-        _state.value = _state.value.copy(soundEnabled = !_state.value.soundEnabled)
+        updateState { it.copy(soundEnabled = !it.soundEnabled) }
     }
     
     /**
      * Set sound enabled state
      */
     fun setSoundEnabled(enabled: Boolean) {
-        _state.value = _state.value.copy(soundEnabled = enabled)
+        updateState { it.copy(soundEnabled = enabled) }
     }
     
     /**
@@ -189,8 +218,6 @@ class Metronome @Inject constructor(
     fun release() {
         stop()
         scope.cancel()
-        soundPool?.release()
-        soundPool = null
     }
 }
 
@@ -202,10 +229,13 @@ data class MetronomeState(
     val bpm: Int = Metronome.DEFAULT_BPM,
     val beatsPerMeasure: Int = 4,
     val beatUnit: Int = 4,
+    val subdivision: Int = 1,
+    val accentMask: Int = 0x1, // Bit n set = beat n (0-based) is accented
     val currentBeat: Int = 0, // 0 when stopped, 1-beatsPerMeasure when playing
+    val lastBeatFrame: Long = -1L, // Native stream frame of the last beat, -1 when stopped
     val soundEnabled: Boolean = true
 ) {
-    val isAccentBeat: Boolean get() = currentBeat == 1
+    val isAccentBeat: Boolean get() = currentBeat > 0 && ((accentMask shr (currentBeat - 1)) and 1) == 1
     val intervalMs: Long get() = 60_000L / bpm
     val timeSignatureDisplay: String get() = "$beatsPerMeasure/$beatUnit"
 }
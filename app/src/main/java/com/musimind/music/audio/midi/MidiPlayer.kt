@@ -6,6 +6,7 @@ import android.media.AudioFormat
 import android.media.AudioTrack
 import android.util.Log
 import com.musimind.music.audio.nativeaudio.NativeAudioBridge
+import com.musimind.music.audio.nativeaudio.NoteEventBatch
 import com.musimind.music.notation.model.Pitch
 import dagger.hilt.android.qualifiers.ApplicationContext
 import kotlinx.coroutines.*
@@ -33,6 +34,7 @@ class MidiPlayer @Inject constructor(
         private const val DEFAULT_DURATION_MS = 500
         private const val FADE_DURATION_MS = 20
         private const val A4_FREQUENCY = 440.0f
+        private const val SEQUENCE_GAP_MS = 50
     }
     
     private val _state = MutableStateFlow(MidiPlayerState())
@@ -109,20 +111,39 @@ class MidiPlayer @Inject constructor(
         velocity: Float = 0.8f
     ) {
         currentPlayJob?.cancel()
+        
+        // Native: the whole sequence is scheduled on the frame clock in one call,
+        // the coroutine below only follows it for the UI state
+        val midiNotes = pitches.map { pitchToMidi(it) }
+        val useNative = isNativeReady && nativeAudio.isReady()
+        if (useNative) {
+            nativeAudio.allNotesOff()
+            val batch = NoteEventBatch(midiNotes.size)
+            val stepFrames = nativeAudio.msToFrames(durationMsPerNote + SEQUENCE_GAP_MS)
+            val durationFrames = nativeAudio.msToFrames(durationMsPerNote)
+            midiNotes.forEachIndexed { index, midiNote ->
+                batch.add(midiNote, velocity, index * stepFrames, durationFrames)
+            }
+            nativeAudio.scheduleNotes(batch)
+        }
+        
         currentPlayJob = scope.launch {
-            for (pitch in pitches) {
+            for (midiNote in midiNotes) {
                 if (!isActive) break
                 
-                val midiNote = pitchToMidi(pitch)
                 _state.value = _state.value.copy(
                     isPlaying = true,
                     currentMidiNote = midiNote
                 )
                 
-                val frequency = midiToFrequency(midiNote)
-                playTone(frequency, durationMsPerNote, velocity)
+                if (useNative) {
+                    delay(durationMsPerNote.toLong())
+                } else {
+                    val frequency = midiToFrequency(midiNote)
+                    playTone(frequency, durationMsPerNote, velocity)
+                }
                 
-                delay(50) // Small gap between notes
+                delay(SEQUENCE_GAP_MS.toLong()) // Small gap between notes
             }
             
             _state.value = _state.value.copy(
@@ -148,8 +169,14 @@ class MidiPlayer @Inject constructor(
                     currentMidiNote = pitches.firstOrNull()?.let { pitchToMidi(it) }
                 )
                 
-                val frequencies = pitches.map { midiToFrequency(pitchToMidi(it)) }
-                playMultipleTones(frequencies, durationMs, velocity)
+                if (isNativeReady && nativeAudio.isReady()) {
+                    // All chord tones in one native call
+                    nativeAudio.playChord(pitches.map { pitchToMidi(it) }, velocity, durationMs)
+                    delay(durationMs.toLong())
+                } else {
+                    val frequencies = pitches.map { midiToFrequency(pitchToMidi(it)) }
+                    playMultipleTones(frequencies, durationMs, velocity)
+                }
                 
             } finally {
                 _state.value = _state.value.copy(
@@ -166,6 +193,9 @@ class MidiPlayer @Inject constructor(
     fun stop() {
         currentPlayJob?.cancel()
         currentPlayJob = null
+        if (isNativeReady) {
+            nativeAudio.allNotesOff()
+        }
         _state.value = _state.value.copy(
             isPlaying = false,
             currentMidiNote = null
@@ -0,0 +1,155 @@
+package com.musimind.music.audio.nativeaudio
+
+import android.content.Context
+import android.os.Build
+import android.os.SystemClock
+import android.util.Log
+import androidx.datastore.preferences.core.edit
+import androidx.datastore.preferences.core.intPreferencesKey
+import androidx.datastore.preferences.preferencesDataStore
+import dagger.hilt.android.qualifiers.ApplicationContext
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.flow.first
+import kotlinx.coroutines.withContext
+import javax.inject.Inject
+import javax.inject.Singleton
+
+private val Context.latencyDataStore by preferencesDataStore(name = "audio_latency_preferences")
+
+/**
+ * Latency reported by Oboe for the open streams, -1 when unavailable.
+ */
+data class LatencyEstimate(
+    val outputMillis: Double,
+    val inputMillis: Double
+) {
+    val roundTripMillis: Double
+        get() = if (outputMillis >= 0 && inputMillis >= 0) outputMillis + inputMillis else -1.0
+}
+
+/**
+ * Measured output-to-input round trip of the full-duplex stream.
+ */
+data class LatencyCalibrationResult(
+    val roundTripFrames: Int,
+    val sampleRate: Int,
+    val detections: Int,
+    val quality: Float
+) {
+    val roundTripMillis: Float
+        get() = roundTripFrames * 1000f / sampleRate
+}
+
+/**
+ * Persisted round-trip offsets.
+ * Keys include the device model and sample rate: app data can be restored
+ * onto a different device, and the offset is only valid for the hardware
+ * and stream configuration it was measured on.
+ */
+internal object LatencyOffsetStore {
+    
+    private fun key(sampleRate: Int) =
+        intPreferencesKey("round_trip_frames_${Build.MANUFACTURER}_${Build.MODEL}_$sampleRate")
+    
+    suspend fun load(context: Context, sampleRate: Int): Int? =
+        context.latencyDataStore.data.first()[key(sampleRate)]
+    
+    suspend fun save(context: Context, sampleRate: Int, frames: Int) {
+        context.latencyDataStore.edit { prefs -> prefs[key(sampleRate)] = frames }
+    }
+    
+    suspend fun clear(context: Context, sampleRate: Int) {
+        context.latencyDataStore.edit { prefs -> prefs.remove(key(sampleRate)) }
+    }
+}
+
+/**
+ * Round-trip latency calibration.
+ * 
+ * Plays a chirp train through the native output, finds it in the microphone
+ * input and stores the measured offset for this device. The offset is applied
+ * natively to every input stamp, so pitch frames and onsets land on the same
+ * clock as the scheduled notes and metronome clicks that the user heard.
+ * Requires RECORD_AUDIO; works best on the loudspeaker at normal volume.
+ */
+@Singleton
+class LatencyCalibrator @Inject constructor(
+    @ApplicationContext private val context: Context,
+    private val nativeAudio: NativeAudioBridge
+) {
+    companion object {
+        private const val TAG = "LatencyCalibrator"
+        private const val POLL_INTERVAL_MS = 50L
+        private const val TIMEOUT_MS = 6000L
+    }
+    
+    /**
+     * Run a calibration (about 3 seconds) and apply and persist the result.
+     * 
+     * @return The measurement, or null if the chirps could not be detected
+     */
+    suspend fun calibrate(): LatencyCalibrationResult? = withContext(Dispatchers.Default) {
+        if (!nativeAudio.initialize()) return@withContext null
+        
+        val startedInput = !nativeAudio.isInputActive()
+        if (startedInput && !nativeAudio.startPitchDetection()) {
+            Log.e(TAG, "Could not open the microphone for calibration")
+            return@withContext null
+        }
+        
+        try {
+            if (!nativeAudio.startLatencyCalibration()) return@withContext null
+            
+            val out = FloatArray(3)
+            val deadline = SystemClock.elapsedRealtime() + TIMEOUT_MS
+            while (SystemClock.elapsedRealtime() < deadline) {
+                when (nativeAudio.pollLatencyCalibration(out)) {
+                    NativeAudioBridge.CALIBRATION_DONE -> {
+                        val result = LatencyCalibrationResult(
+                            roundTripFrames = out[0].toInt(),
+                            sampleRate = nativeAudio.getSampleRate(),
+                            detections = out[1].toInt(),
+                            quality = out[2]
+                        )
+                        nativeAudio.setInputLatencyOffset(result.roundTripFrames)
+                        LatencyOffsetStore.save(context, result.sampleRate, result.roundTripFrames)
+                        Log.i(TAG, "Round trip: ${result.roundTripFrames} frames (${result.roundTripMillis} ms)")
+                        return@withContext result
+                    }
+                    NativeAudioBridge.CALIBRATION_FAILED,
+                    NativeAudioBridge.CALIBRATION_IDLE -> return@withContext null
+                }
+                delay(POLL_INTERVAL_MS)
+            }
+            
+            Log.w(TAG, "Calibration timed out")
+            nativeAudio.cancelLatencyCalibration()
+            null
+        } finally {
+            if (startedInput) {
+                nativeAudio.stopPitchDetection()
+            }
+        }
+    }
+    
+    /**
+     * Saved round trip for this device and the current sample rate, in frames.
+     */
+    suspend fun getSavedOffsetFrames(): Int? =
+        LatencyOffsetStore.load(context, nativeAudio.getSampleRate())
+    
+    /**
+     * Forget the saved offset and stop compensating input stamps.
+     */
+    suspend fun clearSavedOffset() {
+        LatencyOffsetStore.clear(context, nativeAudio.getSampleRate())
+        nativeAudio.setInputLatencyOffset(0)
+    }
+    
+    /**
+     * Live estimate from the audio driver, useful as a sanity check against
+     * the measured value (drivers often under-report).
+     */
+    fun getLatencyEstimate(): LatencyEstimate = nativeAudio.getLatencyEstimates()
+}
@@ -3,8 +3,10 @@ package com.musimind.music.audio.nativeaudio
 import android.content.Context
 import android.content.res.AssetManager
 import android.util.Log
+import com.musimind.music.audio.core.PitchFrame
 import dagger.hilt.android.qualifiers.ApplicationContext
 import kotlinx.coroutines.*
+import java.nio.ByteBuffer
 import javax.inject.Inject
 import javax.inject.Singleton
 
@@ -22,6 +24,81 @@ class NativeAudioBridge @Inject constructor(
         private const val TAG = "NativeAudioBridge"
         private const val SOUNDFONT_PATH = "soundfonts/gm.sf2"
         
+        /** Start frame meaning "on the next audio callback" */
+        const val START_IMMEDIATELY = -1L
+        
+        /** Ints per event in a [NoteEventBatch]: channel, note, velocity bits, offset, duration */
+        const val NOTE_EVENT_STRIDE = 5
+        
+        /** Longs per event written by [pollMetronomeBeats]: frame, beat, subdivision, level */
+        const val BEAT_EVENT_STRIDE = 4
+        
+        /** Voice pool of a [Session] unless [createSession] is given another size */
+        const val DEFAULT_SESSION_VOICES = 24
+        
+        /** Beat event levels */
+        const val BEAT_LEVEL_SUBDIVISION = 0
+        const val BEAT_LEVEL_BEAT = 1
+        const val BEAT_LEVEL_ACCENT = 2
+        
+        /** Native pitch detector presets (see YINPitchDetector.forVoice / forInstrument) */
+        const val PITCH_PRESET_VOICE = 0
+        const val PITCH_PRESET_INSTRUMENT = 1
+        
+        /** The preset [startPitchDetection] was started with */
+        const val PITCH_PRESET_PRIMARY = -1
+        
+        /** Floats per frame written by [pollPitchFrames]: frequency, confidence, midi, cents, rms, voiced */
+        const val PITCH_VALUE_STRIDE = 6
+        private const val PITCH_POLL_CAPACITY = 32
+        
+        // nativePollPolyphonicFrames layout: frame + two note masks, 12 chroma + rms
+        private const val POLY_NOTE_STRIDE = 3
+        private const val POLY_VALUE_STRIDE = 13
+        private const val POLY_POLL_CAPACITY = 16
+        private const val ONSET_POLL_CAPACITY = 32
+        
+        /** Longs per note passed to [loadScoringTimeline]: start frame, end frame, MIDI note */
+        const val SCORING_NOTE_STRIDE = 3
+        private const val SCORE_ID_STRIDE = 4
+        private const val SCORE_VALUE_STRIDE = 8
+        private const val SCORE_POLL_CAPACITY = 16
+        
+        /** Latency calibration states returned by [pollLatencyCalibration] */
+        const val CALIBRATION_IDLE = 0
+        const val CALIBRATION_RUNNING = 1
+        const val CALIBRATION_CAPTURED = 2
+        const val CALIBRATION_DONE = 3
+        const val CALIBRATION_FAILED = 4
+        
+        /** SoundFont load states returned by [getSoundFontLoadState] */
+        const val LOAD_IDLE = 0
+        const val LOAD_PENDING = 1
+        const val LOAD_READY = 2
+        const val LOAD_FAILED = 3
+        private const val LOAD_POLL_INTERVAL_MS = 5L
+        
+        /** Performance hint modes returned by [getPerformanceHintMode] */
+        const val HINT_MODE_NONE = 0
+        const val HINT_MODE_SESSION = 1
+        const val HINT_MODE_AFFINITY = 2
+        
+        /** Preallocated piano voices; bounds the render cost of dense passages */
+        const val DEFAULT_MAX_VOICES = 32
+        
+        // Output mixer buses (RenderArena::Bus)
+        const val BUS_INSTRUMENT = 0
+        const val BUS_METRONOME = 1
+        const val BUS_PROMPT = 2
+        const val BUS_SFX = 3
+        
+        // nativeGetPerfStats layout: scalar fields, then the duration histogram
+        private const val PERF_FIELDS = 12
+        private const val PERF_HISTOGRAM_BUCKETS = 12
+        
+        // nativeGetAnalysisStats layout
+        private const val ANALYSIS_FIELDS = 7
+        
         init {
             try {
                 System.loadLibrary("native-audio")
@@ -32,25 +109,106 @@ class NativeAudioBridge @Inject constructor(
         }
     }
     
-    private val scope = CoroutineScope(Dispatchers.Default + SupervisorJob())
     private var isInitialized = false
     
+    // Reused by drainPitchFrames (single consumer)
+    private val pitchPositions = LongArray(PITCH_POLL_CAPACITY)
+    private val pitchValues = FloatArray(PITCH_POLL_CAPACITY * PITCH_VALUE_STRIDE)
+    
+    // Reused by drainPolyphonicFrames (single consumer)
+    private val polyNotes = LongArray(POLY_POLL_CAPACITY * POLY_NOTE_STRIDE)
+    private val polyValues = FloatArray(POLY_POLL_CAPACITY * POLY_VALUE_STRIDE)
+    
+    // Reused by drainOnsets (single consumer)
+    private val onsetPositions = LongArray(ONSET_POLL_CAPACITY)
+    private val onsetStrengths = FloatArray(ONSET_POLL_CAPACITY)
+    
+    // Reused by drainNoteScores (single consumer)
+    private val scoreIds = LongArray(SCORE_POLL_CAPACITY * SCORE_ID_STRIDE)
+    private val scoreValues = FloatArray(SCORE_POLL_CAPACITY * SCORE_VALUE_STRIDE)
+    
     /**
      * Initialize the native audio engine.
      * Should be called once at app startup.
+     * 
+     * The audio stream starts immediately and the SoundFonts load on a native
+     * worker thread, so opening the stream and parsing the banks overlap.
+     * 
+     * @param waitForSoundFonts Suspend until the piano bank is playable. When
+     *        false, returns as soon as the stream runs; [isReady] turns true
+     *        once the banks are in and notes played before that are silent.
      */
-    suspend fun initialize(): Boolean = withContext(Dispatchers.IO) {
-        if (isInitialized) return@withContext true
+    suspend fun initialize(waitForSoundFonts: Boolean = true): Boolean = withContext(Dispatchers.IO) {
+        if (!isInitialized) {
+            try {
+                val assetManager = context.assets
+                // codeCacheDir is cleared on app updates, which also invalidates
+                // the cached SoundFont subsets when the bundled banks change
+                isInitialized = nativeInitialize(
+                    assetManager, SOUNDFONT_PATH, context.codeCacheDir.absolutePath, DEFAULT_MAX_VOICES, true
+                )
+                Log.i(TAG, "Native audio engine initialized: $isInitialized")
+                if (isInitialized) {
+                    // Apply this device's calibrated round trip to input stamps
+                    LatencyOffsetStore.load(context, nativeGetSampleRate())?.let { frames ->
+                        nativeSetInputLatencyOffset(frames)
+                        Log.i(TAG, "Restored input latency offset: $frames frames")
+                    }
+                }
+            } catch (e: Exception) {
+                Log.e(TAG, "Failed to initialize native audio: ${e.message}")
+                return@withContext false
+            }
+        }
+        if (!isInitialized) return@withContext false
+        if (!waitForSoundFonts) return@withContext true
         
+        while (!nativeIsReady() && nativeGetLoadState() == LOAD_PENDING) {
+            delay(LOAD_POLL_INTERVAL_MS)
+        }
+        if (!nativeIsReady()) {
+            Log.e(TAG, "SoundFont loading failed")
+            release()
+            return@withContext false
+        }
+        true
+    }
+    
+    /**
+     * Replace the piano SoundFont while the stream keeps running.
+     * Notes already sounding release on the old bank; new notes use the new one.
+     * 
+     * @param assetPath SoundFont in the APK assets, e.g. "soundfonts/gm.sf2"
+     * @param presetIndex Preset (in file order) to play
+     * @return false if the engine is not running; the load itself is
+     *         reported by [getSoundFontLoadState]
+     */
+    fun swapSoundFont(assetPath: String, presetIndex: Int = 0): Boolean = try {
+        isInitialized && nativeSwapSoundFont(context.assets, assetPath, presetIndex)
+    } catch (e: UnsatisfiedLinkError) {
+        false
+    }
+    
+    /**
+     * Live piano voice usage, for diagnosing dense passages on slow devices.
+     */
+    fun getVoiceStats(): VoiceStats {
+        val out = IntArray(4)
         try {
-            val assetManager = context.assets
-            isInitialized = nativeInitialize(assetManager, SOUNDFONT_PATH)
-            Log.i(TAG, "Native audio engine initialized: $isInitialized")
-            isInitialized
-        } catch (e: Exception) {
-            Log.e(TAG, "Failed to initialize native audio: ${e.message}")
-            false
+            nativeGetVoiceStats(out)
+        } catch (e: UnsatisfiedLinkError) {
+            // Keep zeros
         }
+        return VoiceStats(active = out[0], peak = out[1], capacity = out[2], stolen = out[3])
+    }
+    
+    /**
+     * State of the most recent SoundFont load, one of the LOAD_* constants.
+     */
+    fun getSoundFontLoadState(): Int = try {
+        nativeGetLoadState()
+    } catch (e: UnsatisfiedLinkError) {
+        LOAD_IDLE
     }
     
     /**
@@ -59,23 +217,93 @@ class NativeAudioBridge @Inject constructor(
      * @param midiNote MIDI note number (60 = C4)
      * @param velocity Note velocity (0.0 to 1.0)
      * @param durationMs Duration in milliseconds
+     * @param channel MIDI channel (0-15), each with its own preset (see [setPreset])
      */
-    fun playNote(midiNote: Int, velocity: Float = 0.8f, durationMs: Int = 500) {
+    fun playNote(midiNote: Int, velocity: Float = 0.8f, durationMs: Int = 500, channel: Int = 0) {
         if (!isReady()) {
             Log.w(TAG, "Native audio not ready, skipping playNote")
             return
         }
         
         Log.d(TAG, "Playing note: midi=$midiNote, velocity=$velocity, duration=$durationMs")
-        nativeNoteOn(0, midiNote, velocity)
         
-        // Schedule note off
-        scope.launch {
-            delay(durationMs.toLong())
-            nativeNoteOff(0, midiNote)
+        // Note off is scheduled natively, sample-accurate relative to the note on
+        nativeScheduleNote(channel, midiNote, velocity, START_IMMEDIATELY, msToFrames(durationMs))
+    }
+    
+    /**
+     * Schedule a note on the native stream frame clock.
+     * 
+     * @param startFrame Frame position (see [getFramePosition]); negative plays immediately
+     * @param durationFrames Frames until the note off
+     */
+    fun scheduleNote(
+        midiNote: Int,
+        velocity: Float,
+        startFrame: Long,
+        durationFrames: Int,
+        channel: Int = 0
+    ) {
+        if (isReady()) {
+            nativeScheduleNote(channel, midiNote, velocity, startFrame, durationFrames)
         }
     }
     
+    /**
+     * Schedule a whole batch of notes with a single native call.
+     * 
+     * @param batch Events with offsets relative to [startFrame]
+     * @param startFrame Frame position of offset 0; negative means now
+     * @return Number of events queued (less than [NoteEventBatch.size] if the
+     *         native queue was full)
+     */
+    fun scheduleNotes(batch: NoteEventBatch, startFrame: Long = START_IMMEDIATELY): Int {
+        if (batch.size == 0 || !isReady()) return 0
+        return nativeScheduleNotes(batch.data, batch.size, startFrame)
+    }
+    
+    /**
+     * Play several notes together (one native call).
+     */
+    fun playChord(midiNotes: List<Int>, velocity: Float = 0.8f, durationMs: Int = 500, channel: Int = 0) {
+        val batch = NoteEventBatch(midiNotes.size)
+        val durationFrames = msToFrames(durationMs)
+        midiNotes.forEach { batch.add(it, velocity, 0, durationFrames, channel) }
+        scheduleNotes(batch)
+    }
+    
+    /**
+     * Release every sounding note and cancel those still scheduled.
+     */
+    fun allNotesOff() {
+        if (isReady()) {
+            nativeAllNotesOff()
+        }
+    }
+    
+    /**
+     * Schedule a metronome click on an exact frame of the stream clock.
+     */
+    fun scheduleMetronome(frame: Long, isAccented: Boolean = false) {
+        if (isReady()) {
+            nativeScheduleMetronome(isAccented, frame)
+        }
+    }
+    
+    /**
+     * Current position of the native stream frame clock (frames rendered so far).
+     */
+    fun getFramePosition(): Long = try {
+        nativeGetFramePosition()
+    } catch (e: UnsatisfiedLinkError) {
+        0L
+    }
+    
+    /**
+     * Convert a duration in milliseconds to frames at the native sample rate.
+     */
+    fun msToFrames(durationMs: Int): Int = (durationMs.toLong() * getSampleRate() / 1000).toInt()
+    
     /**
      * Play a metronome click.
      * 
@@ -89,8 +317,375 @@ class NativeAudioBridge @Inject constructor(
         nativePlayMetronome(isAccented)
     }
     
+    /**
+     * Configure the native metronome. Changes take effect from the next click.
+     * 
+     * @param subdivision Clicks per beat (1-8)
+     * @param accentMask Bit n set = beat n (0-based) is accented
+     * @param muted Keep counting and reporting beats without playing clicks
+     */
+    fun setMetronome(
+        bpm: Float,
+        beatsPerMeasure: Int,
+        beatUnit: Int = 4,
+        subdivision: Int = 1,
+        accentMask: Int = 0x1,
+        muted: Boolean = false
+    ) {
+        if (isReady()) {
+            nativeSetMetronome(bpm, beatsPerMeasure, beatUnit, subdivision, accentMask, muted)
+        }
+    }
+    
+    /**
+     * Start the native metronome, clicking on exact frames of the stream clock.
+     * 
+     * @param startFrame Frame of the first click; negative starts on the next callback
+     */
+    fun startMetronome(startFrame: Long = START_IMMEDIATELY) {
+        if (isReady()) {
+            nativeStartMetronome(startFrame)
+        }
+    }
+    
+    /**
+     * Stop the native metronome.
+     */
+    fun stopMetronome() {
+        if (isReady()) {
+            nativeStopMetronome()
+        }
+    }
+    
+    /**
+     * Drain beats reported by the native metronome into [out],
+     * [BEAT_EVENT_STRIDE] longs per event.
+     * 
+     * @return Number of events written
+     */
+    fun pollMetronomeBeats(out: LongArray): Int = try {
+        nativePollMetronomeBeats(out)
+    } catch (e: UnsatisfiedLinkError) {
+        0
+    }
+    
+    /**
+     * Open the microphone in full-duplex with the output stream and start
+     * native YIN pitch tracking and spectral-flux onset detection.
+     * Requires RECORD_AUDIO.
+     * 
+     * Analysis runs on a native worker thread, never in the audio callback;
+     * see [getAnalysisStats] for how well it keeps up.
+     * 
+     * @param preset [PITCH_PRESET_VOICE] or [PITCH_PRESET_INSTRUMENT]; drives native scoring and the UI channel
+     * @param alsoTrack Further presets tracked side by side, polled with their preset id
+     * @param polyphonic Also detect chords (sets of notes), drained with [drainPolyphonicFrames]
+     */
+    fun startPitchDetection(
+        preset: Int = PITCH_PRESET_VOICE,
+        vararg alsoTrack: Int,
+        polyphonic: Boolean = false
+    ): Boolean {
+        if (!isReady()) return false
+        val extraPresets = alsoTrack.fold(0) { mask, extra -> mask or (1 shl extra) }
+        return nativeStartPitchDetection(preset, extraPresets, polyphonic)
+    }
+    
+    /**
+     * Turn the primary preset's JNI frame queue on or off. Turn it off while
+     * [NativeUiChannel] is the only pitch reader, so frames nobody drains are
+     * not counted as drops; frames still queued are discarded.
+     */
+    fun setPitchQueueEnabled(enabled: Boolean) {
+        if (isReady()) {
+            nativeSetPitchQueueEnabled(enabled)
+        }
+    }
+    
+    /**
+     * Stop native pitch tracking and close the microphone.
+     */
+    fun stopPitchDetection() {
+        if (isReady()) {
+            nativeStopPitchDetection()
+        }
+    }
+    
+    /**
+     * Drain native pitch frames. [positions] receives the stream frame of each
+     * window start, [values] receives [PITCH_VALUE_STRIDE] floats per frame.
+     * 
+     * @param preset Tracker to drain; [PITCH_PRESET_PRIMARY] or a preset passed to [startPitchDetection]
+     * @return Number of frames written
+     */
+    fun pollPitchFrames(positions: LongArray, values: FloatArray, preset: Int = PITCH_PRESET_PRIMARY): Int = try {
+        nativePollPitchFrames(preset, positions, values)
+    } catch (e: UnsatisfiedLinkError) {
+        0
+    }
+    
+    /**
+     * Drain native pitch frames as [PitchFrame]s on the stream frame clock.
+     * 
+     * @param preset Tracker to drain; [PITCH_PRESET_PRIMARY] or a preset passed to [startPitchDetection]
+     * @param onFrame Receives each frame and its RMS level
+     * @return Number of frames delivered
+     */
+    fun drainPitchFrames(preset: Int = PITCH_PRESET_PRIMARY, onFrame: (PitchFrame, Float) -> Unit): Int {
+        val windowSize = nativeGetPitchWindowSize(preset)
+        var total = 0
+        while (true) {
+            val count = pollPitchFrames(pitchPositions, pitchValues, preset)
+            for (i in 0 until count) {
+                val base = i * PITCH_VALUE_STRIDE
+                val start = pitchPositions[i]
+                val frame = PitchFrame(
+                    samplePositionStart = start,
+                    samplePositionEnd = start + windowSize,
+                    windowSizeSamples = windowSize,
+                    frequency = pitchValues[base],
+                    confidence = pitchValues[base + 1],
+                    midiNote = pitchValues[base + 2].toInt(),
+                    centDeviation = pitchValues[base + 3],
+                    isVoiced = pitchValues[base + 5] > 0.5f
+                )
+                onFrame(frame, pitchValues[base + 4])
+            }
+            total += count
+            if (count < PITCH_POLL_CAPACITY) return total
+        }
+    }
+    
+    /**
+     * Drain the note sets of polyphonic detection (started with
+     * `polyphonic = true`), one per ~21 ms hop, on the stream frame clock.
+     * 
+     * @param onFrame Receives each hop's notes and chroma
+     * @return Number of frames delivered
+     */
+    fun drainPolyphonicFrames(onFrame: (PolyphonicFrame) -> Unit): Int {
+        var total = 0
+        while (true) {
+            val count = try {
+                nativePollPolyphonicFrames(polyNotes, polyValues)
+            } catch (e: UnsatisfiedLinkError) {
+                0
+            }
+            for (i in 0 until count) {
+                val noteBase = i * POLY_NOTE_STRIDE
+                val valueBase = i * POLY_VALUE_STRIDE
+                val notes = ArrayList<Int>(4)
+                for (word in 0..1) {
+                    val mask = polyNotes[noteBase + 1 + word]
+                    for (bit in 0 until 64) {
+                        if (((mask ushr bit) and 1L) != 0L) notes.add(word * 64 + bit)
+                    }
+                }
+                onFrame(
+                    PolyphonicFrame(
+                        framePosition = polyNotes[noteBase],
+                        midiNotes = notes,
+                        chroma = polyValues.copyOfRange(valueBase, valueBase + 12).toList(),
+                        rms = polyValues[valueBase + 12]
+                    )
+                )
+            }
+            total += count
+            if (count < POLY_POLL_CAPACITY) return total
+        }
+    }
+    
+    /**
+     * Drain onsets detected in the microphone input. [positions] receives the
+     * stream frame of each attack, [strengths] its flux-over-threshold ratio.
+     * 
+     * @return Number of onsets written
+     */
+    fun pollOnsets(positions: LongArray, strengths: FloatArray): Int = try {
+        nativePollOnsets(positions, strengths)
+    } catch (e: UnsatisfiedLinkError) {
+        0
+    }
+    
+    /**
+     * Drain native onsets on the stream frame clock (the same clock as
+     * [scheduleNote] and [getFramePosition]).
+     * 
+     * @param onOnset Receives the stream frame and strength of each onset
+     * @return Number of onsets delivered
+     */
+    fun drainOnsets(onOnset: (Long, Float) -> Unit): Int {
+        var total = 0
+        while (true) {
+            val count = pollOnsets(onsetPositions, onsetStrengths)
+            for (i in 0 until count) {
+                onOnset(onsetPositions[i], onsetStrengths[i])
+            }
+            total += count
+            if (count < ONSET_POLL_CAPACITY) return total
+        }
+    }
+    
+    /**
+     * Load an exercise for native scoring. Must be called before
+     * [startPitchDetection]; scoring starts at [armScoring].
+     * 
+     * @param notes [SCORING_NOTE_STRIDE] longs per note, in start order:
+     *        start and end frame relative to the armed origin, MIDI note
+     * @param octaveOffset Octaves the user sings away from the written notes
+     * @return false if input is already running or the engine is not ready
+     */
+    fun loadScoringTimeline(notes: LongArray, count: Int, octaveOffset: Int = 0): Boolean = try {
+        isReady() && nativeLoadScoringTimeline(notes, count, octaveOffset)
+    } catch (e: UnsatisfiedLinkError) {
+        false
+    }
+    
+    /**
+     * Start scoring the loaded timeline, with note frames relative to
+     * [originFrame] on the stream frame clock.
+     */
+    fun armScoring(originFrame: Long) {
+        if (isReady()) {
+            nativeArmScoring(originFrame)
+        }
+    }
+    
+    /**
+     * Score the notes still open once the exercise timeline has ended; the
+     * last note is otherwise only finished when input stops.
+     * Results arrive through [drainNoteScores].
+     */
+    fun finishScoring() {
+        if (isReady()) {
+            nativeFinishScoring()
+        }
+    }
+    
+    /**
+     * Drain notes the native scorer has finished, one result per note.
+     * 
+     * @return Number of results delivered
+     */
+    fun drainNoteScores(onScore: (NativeNoteScore) -> Unit): Int {
+        var total = 0
+        while (true) {
+            val count = try {
+                nativePollNoteScores(scoreIds, scoreValues)
+            } catch (e: UnsatisfiedLinkError) {
+                0
+            }
+            for (i in 0 until count) {
+                val id = i * SCORE_ID_STRIDE
+                val v = i * SCORE_VALUE_STRIDE
+                onScore(
+                    NativeNoteScore(
+                        noteIndex = scoreIds[id].toInt(),
+                        pitchStatus = scoreIds[id + 1].toInt(),
+                        timingStatus = scoreIds[id + 2].toInt(),
+                        attackDeviationFrames = scoreIds[id + 3],
+                        pitchScore = scoreValues[v],
+                        averageCents = scoreValues[v + 1],
+                        centStdDev = scoreValues[v + 2],
+                        correctRatio = scoreValues[v + 3],
+                        timingScore = scoreValues[v + 4],
+                        attackScore = scoreValues[v + 5],
+                        durationScore = scoreValues[v + 6],
+                        durationAccuracy = scoreValues[v + 7]
+                    )
+                )
+            }
+            total += count
+            if (count < SCORE_POLL_CAPACITY) return total
+        }
+    }
+    
+    /**
+     * Index of the expected note the latest pitch frame fell in, -1 outside notes.
+     */
+    fun getScoringNote(): Int = try {
+        nativeGetScoringNote()
+    } catch (e: UnsatisfiedLinkError) {
+        -1
+    }
+    
+    /**
+     * Check whether the microphone input stream is running.
+     */
+    fun isInputActive(): Boolean = try {
+        nativeIsInputActive()
+    } catch (e: UnsatisfiedLinkError) {
+        false
+    }
+    
+    /**
+     * Start a round-trip latency calibration (chirps on the output, detected
+     * on the input). Pitch detection must already be running.
+     */
+    fun startLatencyCalibration(): Boolean {
+        if (!isReady()) return false
+        return nativeStartLatencyCalibration()
+    }
+    
+    /**
+     * Poll the running calibration. Once the recording is complete the
+     * analysis runs on the calling thread, so call this off the main thread.
+     * 
+     * @param out Receives [roundTripFrames, detections, quality] on [CALIBRATION_DONE]
+     * @return One of the CALIBRATION_* states
+     */
+    fun pollLatencyCalibration(out: FloatArray): Int = try {
+        nativePollLatencyCalibration(out)
+    } catch (e: UnsatisfiedLinkError) {
+        CALIBRATION_IDLE
+    }
+    
+    /**
+     * Abort a running calibration.
+     */
+    fun cancelLatencyCalibration() {
+        if (isReady()) {
+            nativeCancelLatencyCalibration()
+        }
+    }
+    
+    /**
+     * Frames subtracted from input stamps (pitch frames, onsets) so they line
+     * up with the output frames the user heard at that moment.
+     */
+    fun setInputLatencyOffset(frames: Int) {
+        if (isReady()) {
+            nativeSetInputLatencyOffset(frames)
+        }
+    }
+    
+    fun getInputLatencyOffset(): Int = try {
+        nativeGetInputLatencyOffset()
+    } catch (e: UnsatisfiedLinkError) {
+        0
+    }
+    
+    /**
+     * Live latency estimates reported by Oboe for the open streams.
+     * Values are -1 when a stream is closed or the device cannot report it.
+     */
+    fun getLatencyEstimates(): LatencyEstimate {
+        val out = DoubleArray(2) { -1.0 }
+        try {
+            nativeGetLatencyEstimates(out)
+        } catch (e: UnsatisfiedLinkError) {
+            // Keep -1
+        }
+        return LatencyEstimate(outputMillis = out[0], inputMillis = out[1])
+    }
+    
     /**
      * Set the instrument preset (0 = Grand Piano by default).
+     * 
+     * [preset] is a GM program number; channel 9 selects from the drum bank.
+     * Programs not loaded yet are added in the background, and the channel
+     * switches over once they are in (notes played before that use the
+     * previous preset).
      */
     fun setPreset(channel: Int, preset: Int) {
         if (isReady()) {
@@ -98,6 +693,429 @@ class NativeAudioBridge @Inject constructor(
         }
     }
     
+    /**
+     * Channel volume, 0.0 to 1.0.
+     */
+    fun setChannelVolume(channel: Int, volume: Float) {
+        if (isReady()) {
+            nativeSetChannelVolume(channel, volume)
+        }
+    }
+    
+    /**
+     * Channel pan: 0.0 = left, 0.5 = center, 1.0 = right.
+     */
+    fun setChannelPan(channel: Int, pan: Float) {
+        if (isReady()) {
+            nativeSetChannelPan(channel, pan)
+        }
+    }
+    
+    /**
+     * Hold (true) or release (false) the sustain pedal on a channel.
+     */
+    fun setSustain(channel: Int, sustain: Boolean) {
+        if (isReady()) {
+            nativeSetChannelSustain(channel, sustain)
+        }
+    }
+    
+    /**
+     * Load a Standard MIDI File (format 0 or 1) for native playback.
+     * The file is parsed immediately; programs it uses that are not loaded
+     * yet are added in the background. Any file already playing stops.
+     * 
+     * @return false if the engine is not running or the file is invalid
+     */
+    fun loadMidi(bytes: ByteArray): Boolean = try {
+        isInitialized && nativeLoadMidi(bytes)
+    } catch (e: UnsatisfiedLinkError) {
+        false
+    }
+    
+    /**
+     * Load a MIDI file from the APK assets, e.g. "midi/exercise1.mid".
+     */
+    suspend fun loadMidiAsset(assetPath: String): Boolean = withContext(Dispatchers.IO) {
+        try {
+            loadMidi(context.assets.open(assetPath).use { it.readBytes() })
+        } catch (e: java.io.IOException) {
+            Log.e(TAG, "Could not read MIDI asset $assetPath: ${e.message}")
+            false
+        }
+    }
+    
+    /**
+     * Start (or resume) the loaded MIDI file on a stream frame.
+     * Events are timed natively on the frame clock, so playback can be
+     * lined up exactly with [startMetronome] or scheduled notes.
+     */
+    fun playMidi(startFrame: Long = START_IMMEDIATELY) {
+        if (isInitialized) {
+            nativePlayMidi(startFrame)
+        }
+    }
+    
+    /**
+     * Pause MIDI playback, releasing its notes. [playMidi] resumes from here.
+     */
+    fun stopMidi() {
+        if (isInitialized) {
+            nativeStopMidi()
+        }
+    }
+    
+    /**
+     * Jump to a file tick; programs and controllers are restored for that point.
+     */
+    fun seekMidiTick(tick: Int) {
+        if (isInitialized) {
+            nativeSeekMidi(tick, false)
+        }
+    }
+    
+    /**
+     * Jump to a song position in frames (at the original tempo).
+     */
+    fun seekMidiFrame(frame: Int) {
+        if (isInitialized) {
+            nativeSeekMidi(frame, true)
+        }
+    }
+    
+    /**
+     * Playback speed relative to the file's tempo map (0.5 = half speed).
+     * Only event times change; notes keep their pitch.
+     */
+    fun setMidiTempoScale(scale: Float) {
+        if (isInitialized) {
+            nativeSetMidiTempoScale(scale)
+        }
+    }
+    
+    /**
+     * Repeat the ticks [startTick, endTick) while playing; endTick <= startTick clears the loop.
+     */
+    fun setMidiLoop(startTick: Int, endTick: Int) {
+        if (isInitialized) {
+            nativeSetMidiLoop(startTick, endTick)
+        }
+    }
+    
+    fun clearMidiLoop() = setMidiLoop(0, 0)
+    
+    /**
+     * Current MIDI playback position and file info.
+     */
+    fun getMidiState(): MidiPlaybackState {
+        val out = LongArray(4)
+        try {
+            nativeGetMidiState(out)
+        } catch (e: UnsatisfiedLinkError) {
+            // Keep zeros
+        }
+        return MidiPlaybackState(
+            positionTick = out[0],
+            lengthTicks = out[1],
+            isPlaying = out[2] != 0L,
+            ticksPerQuarter = out[3].toInt()
+        )
+    }
+    
+    /**
+     * Render notes offline, faster than realtime, without touching live playback.
+     * Offsets in [batch] count from the start of the render; channels start
+     * on program 0 (the drum kit on channel 9).
+     * 
+     * @param sampleRate Output rate; 0 uses the stream rate
+     * @return Interleaved stereo samples, or null if no SoundFont is loaded
+     */
+    suspend fun renderNotesOffline(batch: NoteEventBatch, sampleRate: Int = 0): FloatArray? =
+        withContext(Dispatchers.Default) {
+            renderOffline(batch.data, batch.size, null, sampleRate)
+        }
+    
+    /**
+     * Render a Standard MIDI File offline into interleaved stereo samples.
+     */
+    suspend fun renderMidiOffline(midi: ByteArray, sampleRate: Int = 0): FloatArray? =
+        withContext(Dispatchers.Default) {
+            renderOffline(null, 0, midi, sampleRate)
+        }
+    
+    /**
+     * Render notes and/or a MIDI file offline to a 16-bit stereo WAV file,
+     * e.g. for caching exercise prompts in [Context.getCacheDir].
+     */
+    suspend fun renderToWav(
+        file: java.io.File,
+        batch: NoteEventBatch? = null,
+        midi: ByteArray? = null,
+        sampleRate: Int = 0
+    ): Boolean = withContext(Dispatchers.Default) {
+        try {
+            isInitialized && nativeRenderOfflineToWav(batch?.data, batch?.size ?: 0, midi, sampleRate, file.absolutePath)
+        } catch (e: UnsatisfiedLinkError) {
+            false
+        }
+    }
+    
+    private fun renderOffline(events: IntArray?, count: Int, midi: ByteArray?, sampleRate: Int): FloatArray? = try {
+        if (isInitialized) nativeRenderOffline(events, count, midi, sampleRate) else null
+    } catch (e: UnsatisfiedLinkError) {
+        null
+    }
+    
+    /**
+     * Play a recurring prompt (interval, chord) from the pre-rendered clip cache.
+     * The first play of a clip renders it offline, which is why this suspends;
+     * replays are mixed as a plain buffer and cost almost no CPU.
+     * 
+     * @param spacingMs 0 plays the notes together; otherwise each note starts this much after the previous
+     * @param bus [BUS_PROMPT], or [BUS_SFX] for feedback sounds
+     */
+    suspend fun playPrompt(
+        midiNotes: List<Int>,
+        program: Int = 0,
+        velocity: Float = 0.8f,
+        durationMs: Int = 1000,
+        spacingMs: Int = 0,
+        startFrame: Long = START_IMMEDIATELY,
+        bus: Int = BUS_PROMPT
+    ): Boolean = clip(midiNotes, program, velocity, durationMs, spacingMs, startFrame, bus, play = true)
+    
+    /**
+     * Render a prompt into the clip cache without playing it, e.g. while an
+     * exercise screen is loading.
+     */
+    suspend fun preparePrompt(
+        midiNotes: List<Int>,
+        program: Int = 0,
+        velocity: Float = 0.8f,
+        durationMs: Int = 1000,
+        spacingMs: Int = 0
+    ): Boolean = clip(midiNotes, program, velocity, durationMs, spacingMs, START_IMMEDIATELY, BUS_PROMPT, play = false)
+    
+    private suspend fun clip(
+        midiNotes: List<Int>,
+        program: Int,
+        velocity: Float,
+        durationMs: Int,
+        spacingMs: Int,
+        startFrame: Long,
+        bus: Int,
+        play: Boolean
+    ): Boolean = withContext(Dispatchers.Default) {
+        try {
+            isInitialized && nativePlayClip(
+                midiNotes.toIntArray(), program, (velocity * 127).toInt(),
+                msToFrames(durationMs), msToFrames(spacingMs), startFrame, bus, play
+            )
+        } catch (e: UnsatisfiedLinkError) {
+            false
+        }
+    }
+    
+    /**
+     * Memory for cached prompt clips (default 8 MB; about 20 one-second clips).
+     */
+    fun setClipCacheBudget(bytes: Long) {
+        if (isInitialized) {
+            nativeSetClipCacheBudget(bytes)
+        }
+    }
+    
+    fun getClipCacheStats(): ClipCacheStats {
+        val out = LongArray(5)
+        try {
+            nativeGetClipCacheStats(out)
+        } catch (e: UnsatisfiedLinkError) {
+            // Keep zeros
+        }
+        return ClipCacheStats(
+            clips = out[0].toInt(),
+            bytes = out[1],
+            budgetBytes = out[2],
+            hits = out[3],
+            misses = out[4]
+        )
+    }
+    
+    /**
+     * Gain of an output bus (BUS_* constants): 1.0 = unity, ramped smoothly.
+     */
+    fun setBusGain(bus: Int, gain: Float) {
+        if (isInitialized) {
+            nativeSetBusGain(bus, gain)
+        }
+    }
+    
+    /**
+     * How far music and prompts dip under metronome clicks: 0 = off,
+     * 0.25 (default) = about -2.5 dB.
+     */
+    fun setDuckingDepth(depth: Float) {
+        if (isInitialized) {
+            nativeSetDuckingDepth(depth)
+        }
+    }
+    
+    /**
+     * Master peak limiter (on by default, -0.5 dBFS ceiling).
+     */
+    fun setLimiter(enabled: Boolean, ceilingDb: Float = -0.5f) {
+        if (isInitialized) {
+            nativeSetLimiter(enabled, ceilingDb)
+        }
+    }
+    
+    /**
+     * Largest limiter gain reduction since the previous call, in dB (0 = none).
+     */
+    fun takeLimiterReductionDb(): Float = try {
+        nativeTakeLimiterReduction()
+    } catch (e: UnsatisfiedLinkError) {
+        0f
+    }
+    
+    /**
+     * Output stream state. After a device switch the native side reopens the
+     * stream on its own thread; the engine clock pauses during the outage, so
+     * scheduled notes and the metronome resume in phase, only late by
+     * [StreamStatus.lastOutageMillis].
+     */
+    fun getStreamStatus(): StreamStatus {
+        val out = LongArray(5)
+        try {
+            nativeGetStreamState(out)
+        } catch (e: UnsatisfiedLinkError) {
+            // Keep zeros (stopped)
+        }
+        return StreamStatus(
+            state = out[0].toInt(),
+            recoveries = out[1].toInt(),
+            failedAttempts = out[2].toInt(),
+            lastOutageMillis = out[3],
+            frameAtOutage = out[4]
+        )
+    }
+    
+    /**
+     * Output buffer size chosen by the underrun tuner, and the underruns seen.
+     * The buffer starts at one burst and grows by a burst per underrun.
+     */
+    fun getBufferStats(): BufferStats {
+        val out = LongArray(5)
+        try {
+            nativeGetBufferStats(out)
+        } catch (e: UnsatisfiedLinkError) {
+            // Keep zeros
+        }
+        return BufferStats(
+            bufferFrames = out[0].toInt(),
+            capacityFrames = out[1].toInt(),
+            burstFrames = out[2].toInt(),
+            xruns = out[3],
+            isTuning = out[4] != 0L
+        )
+    }
+    
+    /**
+     * Shrink the output buffer by a burst after long underrun-free stretches
+     * (off by default).
+     */
+    fun setBufferAutoShrink(enabled: Boolean) {
+        if (isInitialized) {
+            nativeSetBufferAutoShrink(enabled)
+        }
+    }
+    
+    /**
+     * Pin the audio callback to the fastest CPU cores on devices without the
+     * Android 13 performance hint API (off by default: lower latency, more
+     * battery). Takes effect the next time the stream opens.
+     */
+    fun setAffinityFallback(enabled: Boolean) {
+        if (isInitialized) {
+            nativeSetAffinityFallback(enabled)
+        }
+    }
+    
+    /**
+     * How the audio callback's CPU demand reaches the scheduler, one of the
+     * HINT_MODE_* constants.
+     */
+    fun getPerformanceHintMode(): Int = try {
+        nativeGetPerformanceHintMode()
+    } catch (e: UnsatisfiedLinkError) {
+        HINT_MODE_NONE
+    }
+    
+    /**
+     * Audio callback cost counters for analytics. With [reset] the native
+     * counters restart after this snapshot, so each call covers one interval.
+     */
+    fun getPerfStats(reset: Boolean = false): AudioPerfStats {
+        val out = LongArray(PERF_FIELDS + PERF_HISTOGRAM_BUCKETS)
+        try {
+            nativeGetPerfStats(out, reset)
+        } catch (e: UnsatisfiedLinkError) {
+            // Keep zeros
+        }
+        return AudioPerfStats(
+            callbacks = out[0],
+            overruns = out[1],
+            maxCallbackNanos = out[2],
+            meanCallbackNanos = out[3],
+            maxDeadlineLoad = out[4] / 1000f,
+            meanDeadlineLoad = out[5] / 1000f,
+            maxVoices = out[6].toInt(),
+            xruns = out[7],
+            lateEvents = out[8],
+            maxLateFrames = out[9].toInt(),
+            maxQueueNanos = out[10],
+            droppedCommands = out[11],
+            durationHistogram = out.copyOfRange(PERF_FIELDS, PERF_FIELDS + PERF_HISTOGRAM_BUCKETS).toList()
+        )
+    }
+    
+    /**
+     * Backpressure of the native analysis worker since pitch detection started.
+     */
+    fun getAnalysisStats(): AnalysisStats {
+        val out = LongArray(ANALYSIS_FIELDS)
+        try {
+            nativeGetAnalysisStats(out)
+        } catch (e: UnsatisfiedLinkError) {
+            // Keep zeros
+        }
+        return AnalysisStats(
+            passes = out[0],
+            lastBacklogFrames = out[1].toInt(),
+            maxBacklogFrames = out[2].toInt(),
+            maxPassNanos = out[3],
+            skippedSamples = out[4],
+            isRealtime = out[5] != 0L,
+            cpuMask = out[6].toInt()
+        )
+    }
+    
+    /**
+     * Shared-memory view of the live analysis state (pitch, levels, beats,
+     * onsets) for per-frame UI polling without JNI calls. Each call returns a
+     * new reader with its own pitch cursor.
+     * 
+     * @return null if the native library is unavailable or its layout does not match
+     */
+    fun getUiChannel(): NativeUiChannel? = try {
+        nativeGetUiChannel()?.let { NativeUiChannel(it) }
+    } catch (e: UnsatisfiedLinkError) {
+        null
+    } catch (e: IllegalArgumentException) {
+        Log.e(TAG, "UI channel unavailable: ${e.message}")
+        null
+    }
+    
     /**
      * Check if the engine is ready to play.
      */
@@ -108,19 +1126,123 @@ class NativeAudioBridge @Inject constructor(
     }
     
     /**
-     * Get the native sample rate.
+     * Get the native engine sample rate. Frame positions and schedules use
+     * this rate; the device stream may run at another one and is resampled.
      */
     fun getSampleRate(): Int = try {
         nativeGetSampleRate()
     } catch (e: UnsatisfiedLinkError) {
-        44100
+        48000
+    }
+    
+    /**
+     * Open a separate engine context mixed into the same output stream: own
+     * voices, channels, scheduler and metronome over the already loaded
+     * SoundFonts (no second copy of the samples, no second stream). Frames
+     * are on the shared clock of [getFramePosition].
+     * 
+     * Use one per real-time duel player, reference voice or extra metronome,
+     * and [Session.close] it when done; at most four can be open.
+     * 
+     * @return The session, or null if the engine is not running or all are in use
+     */
+    fun createSession(maxVoices: Int = DEFAULT_SESSION_VOICES): Session? {
+        if (!isReady()) return null
+        val handle = try {
+            nativeCreateSession(maxVoices)
+        } catch (e: UnsatisfiedLinkError) {
+            0L
+        }
+        return if (handle != 0L) Session(handle) else null
     }
     
     /**
-     * Release all native resources.
+     * Engine context created by [createSession]. Calls after [close] (or after
+     * [release]) are ignored.
+     */
+    inner class Session internal constructor(val handle: Long) : AutoCloseable {
+        fun playNote(midiNote: Int, velocity: Float = 0.8f, durationMs: Int = 500, channel: Int = 0) {
+            nativeSessionScheduleNote(handle, channel, midiNote, velocity, START_IMMEDIATELY, msToFrames(durationMs))
+        }
+        
+        /**
+         * @param durationFrames Frames until the note off; 0 holds it until [noteOff]
+         * @return False if the session was closed
+         */
+        fun scheduleNote(
+            midiNote: Int,
+            velocity: Float,
+            startFrame: Long,
+            durationFrames: Int,
+            channel: Int = 0
+        ): Boolean = nativeSessionScheduleNote(handle, channel, midiNote, velocity, startFrame, durationFrames)
+        
+        fun noteOff(midiNote: Int, channel: Int = 0) {
+            nativeSessionNoteOff(handle, channel, midiNote)
+        }
+        
+        fun scheduleNotes(batch: NoteEventBatch, startFrame: Long = START_IMMEDIATELY): Int {
+            if (batch.size == 0) return 0
+            return nativeSessionScheduleNotes(handle, batch.data, batch.size, startFrame)
+        }
+        
+        fun allNotesOff() {
+            nativeSessionAllNotesOff(handle)
+        }
+        
+        fun setPreset(channel: Int, preset: Int) {
+            nativeSessionSetPreset(handle, channel, preset)
+        }
+        
+        fun setChannelVolume(channel: Int, volume: Float) {
+            nativeSessionSetChannelVolume(handle, channel, volume)
+        }
+        
+        fun setChannelPan(channel: Int, pan: Float) {
+            nativeSessionSetChannelPan(handle, channel, pan)
+        }
+        
+        /**
+         * Level of this session in the output mix (1.0 = unity). The sum of
+         * all sessions goes through the main engine's limiter (see [setLimiter]).
+         */
+        fun setGain(gain: Float): Boolean = nativeSetSessionGain(handle, gain)
+        
+        /** Same settings as [NativeAudioBridge.setMetronome], for this session's own metronome */
+        fun setMetronome(
+            bpm: Float,
+            beatsPerMeasure: Int,
+            beatUnit: Int = 4,
+            subdivision: Int = 1,
+            accentMask: Int = 0x1,
+            muted: Boolean = false
+        ) {
+            nativeSessionSetMetronome(handle, bpm, beatsPerMeasure, beatUnit, subdivision, accentMask, muted)
+        }
+        
+        fun startMetronome(startFrame: Long = START_IMMEDIATELY) {
+            nativeSessionStartMetronome(handle, startFrame)
+        }
+        
+        fun stopMetronome() {
+            nativeSessionStopMetronome(handle)
+        }
+        
+        /**
+         * Drain this session's metronome beats, [BEAT_EVENT_STRIDE] longs per
+         * event. They are not published to the UI channel.
+         */
+        fun pollMetronomeBeats(out: LongArray): Int = nativeSessionPollMetronomeBeats(handle, out)
+        
+        override fun close() {
+            nativeReleaseSession(handle)
+        }
+    }
+    
+    /**
+     * Release all native resources, open sessions included.
      */
     fun release() {
-        scope.cancel()
         try {
             nativeRelease()
             isInitialized = false
@@ -130,12 +1252,256 @@ class NativeAudioBridge @Inject constructor(
     }
     
     // Native methods
-    private external fun nativeInitialize(assetManager: AssetManager, soundFontPath: String): Boolean
+    private external fun nativeInitialize(assetManager: AssetManager, soundFontPath: String, cacheDirectory: String, maxVoices: Int, async: Boolean): Boolean
+    private external fun nativeSwapSoundFont(assetManager: AssetManager, soundFontPath: String, preset: Int): Boolean
+    private external fun nativeGetLoadState(): Int
+    private external fun nativeGetVoiceStats(out: IntArray)
     private external fun nativeNoteOn(channel: Int, midiNote: Int, velocity: Float)
     private external fun nativeNoteOff(channel: Int, midiNote: Int)
+    private external fun nativeScheduleNote(channel: Int, midiNote: Int, velocity: Float, startFrame: Long, durationFrames: Int)
+    private external fun nativeScheduleNotes(events: IntArray, count: Int, startFrame: Long): Int
+    private external fun nativeAllNotesOff()
+    private external fun nativeScheduleMetronome(isAccented: Boolean, frame: Long)
+    private external fun nativeGetFramePosition(): Long
     private external fun nativePlayMetronome(isAccented: Boolean)
+    private external fun nativeSetMetronome(bpm: Float, beatsPerMeasure: Int, beatUnit: Int, subdivision: Int, accentMask: Int, muted: Boolean)
+    private external fun nativeStartMetronome(startFrame: Long)
+    private external fun nativeStopMetronome()
+    private external fun nativePollMetronomeBeats(out: LongArray): Int
     private external fun nativeSetPreset(channel: Int, preset: Int)
+    private external fun nativeSetChannelVolume(channel: Int, volume: Float)
+    private external fun nativeSetChannelPan(channel: Int, pan: Float)
+    private external fun nativeSetChannelSustain(channel: Int, sustain: Boolean)
+    private external fun nativeStartPitchDetection(preset: Int, extraPresets: Int, polyphonic: Boolean): Boolean
+    private external fun nativeStopPitchDetection()
+    private external fun nativeSetPitchQueueEnabled(enabled: Boolean)
+    private external fun nativePollPitchFrames(preset: Int, positions: LongArray, values: FloatArray): Int
+    private external fun nativeGetPitchWindowSize(preset: Int): Int
+    private external fun nativePollPolyphonicFrames(notes: LongArray, values: FloatArray): Int
+    private external fun nativePollOnsets(positions: LongArray, strengths: FloatArray): Int
+    private external fun nativeLoadScoringTimeline(notes: LongArray, count: Int, octaveOffset: Int): Boolean
+    private external fun nativeArmScoring(originFrame: Long)
+    private external fun nativeFinishScoring()
+    private external fun nativePollNoteScores(ids: LongArray, values: FloatArray): Int
+    private external fun nativeGetScoringNote(): Int
+    private external fun nativeIsInputActive(): Boolean
+    private external fun nativeStartLatencyCalibration(): Boolean
+    private external fun nativePollLatencyCalibration(out: FloatArray): Int
+    private external fun nativeCancelLatencyCalibration()
+    private external fun nativeSetInputLatencyOffset(frames: Int)
+    private external fun nativeGetInputLatencyOffset(): Int
+    private external fun nativeGetLatencyEstimates(out: DoubleArray)
+    private external fun nativeLoadMidi(data: ByteArray): Boolean
+    private external fun nativePlayMidi(startFrame: Long)
+    private external fun nativeStopMidi()
+    private external fun nativeSeekMidi(position: Int, inFrames: Boolean)
+    private external fun nativeSetMidiTempoScale(scale: Float)
+    private external fun nativeSetMidiLoop(startTick: Int, endTick: Int)
+    private external fun nativeGetMidiState(out: LongArray)
+    private external fun nativeRenderOffline(events: IntArray?, count: Int, midi: ByteArray?, sampleRate: Int): FloatArray?
+    private external fun nativeRenderOfflineToWav(events: IntArray?, count: Int, midi: ByteArray?, sampleRate: Int, path: String): Boolean
+    private external fun nativePlayClip(notes: IntArray, program: Int, velocity: Int, durationFrames: Int, spacingFrames: Int, startFrame: Long, bus: Int, play: Boolean): Boolean
+    private external fun nativeSetClipCacheBudget(bytes: Long)
+    private external fun nativeGetClipCacheStats(out: LongArray)
+    private external fun nativeSetBusGain(bus: Int, gain: Float)
+    private external fun nativeSetDuckingDepth(depth: Float)
+    private external fun nativeSetLimiter(enabled: Boolean, ceilingDb: Float)
+    private external fun nativeTakeLimiterReduction(): Float
+    private external fun nativeGetStreamState(out: LongArray)
+    private external fun nativeGetBufferStats(out: LongArray)
+    private external fun nativeSetBufferAutoShrink(enabled: Boolean)
+    private external fun nativeSetAffinityFallback(enabled: Boolean)
+    private external fun nativeGetPerformanceHintMode(): Int
+    private external fun nativeGetPerfStats(out: LongArray, reset: Boolean)
+    private external fun nativeGetAnalysisStats(out: LongArray)
+    private external fun nativeGetUiChannel(): ByteBuffer?
     private external fun nativeIsReady(): Boolean
     private external fun nativeGetSampleRate(): Int
     private external fun nativeRelease()
+    private external fun nativeCreateSession(maxVoices: Int): Long
+    private external fun nativeReleaseSession(session: Long)
+    private external fun nativeSetSessionGain(session: Long, gain: Float): Boolean
+    private external fun nativeSessionScheduleNote(session: Long, channel: Int, midiNote: Int, velocity: Float, startFrame: Long, durationFrames: Int): Boolean
+    private external fun nativeSessionNoteOff(session: Long, channel: Int, midiNote: Int)
+    private external fun nativeSessionScheduleNotes(session: Long, events: IntArray, count: Int, startFrame: Long): Int
+    private external fun nativeSessionAllNotesOff(session: Long)
+    private external fun nativeSessionSetPreset(session: Long, channel: Int, preset: Int)
+    private external fun nativeSessionSetChannelVolume(session: Long, channel: Int, volume: Float)
+    private external fun nativeSessionSetChannelPan(session: Long, channel: Int, pan: Float)
+    private external fun nativeSessionSetMetronome(session: Long, bpm: Float, beatsPerMeasure: Int, beatUnit: Int, subdivision: Int, accentMask: Int, muted: Boolean)
+    private external fun nativeSessionStartMetronome(session: Long, startFrame: Long)
+    private external fun nativeSessionStopMetronome(session: Long)
+    private external fun nativeSessionPollMetronomeBeats(session: Long, out: LongArray): Int
+}
+
+/**
+ * Packed note events for [NativeAudioBridge.scheduleNotes].
+ * Reusable: [clear] it and add the next batch; grows as needed.
+ */
+class NoteEventBatch(capacity: Int = 16) {
+    internal var data = IntArray(capacity * NativeAudioBridge.NOTE_EVENT_STRIDE)
+        private set
+    
+    var size = 0
+        private set
+    
+    /**
+     * @param offsetFrames Start, in frames after the batch start frame
+     * @param durationFrames Frames until the note off
+     */
+    fun add(
+        midiNote: Int,
+        velocity: Float,
+        offsetFrames: Int,
+        durationFrames: Int,
+        channel: Int = 0
+    ): NoteEventBatch {
+        val stride = NativeAudioBridge.NOTE_EVENT_STRIDE
+        if ((size + 1) * stride > data.size) {
+            data = data.copyOf(maxOf(data.size * 2, (size + 1) * stride))
+        }
+        val base = size * stride
+        data[base] = channel
+        data[base + 1] = midiNote
+        data[base + 2] = velocity.toRawBits()
+        data[base + 3] = offsetFrames
+        data[base + 4] = durationFrames
+        size++
+        return this
+    }
+    
+    fun clear() {
+        size = 0
+    }
+}
+
+/**
+ * Piano voice pool usage reported by the native engine.
+ */
+data class VoiceStats(
+    val active: Int,
+    val peak: Int,
+    val capacity: Int,
+    val stolen: Int
+)
+
+/**
+ * Native MIDI file playback state. Ticks are file ticks; ticksPerQuarter
+ * is 0 for SMPTE-timed files.
+ */
+data class MidiPlaybackState(
+    val positionTick: Long,
+    val lengthTicks: Long,
+    val isPlaying: Boolean,
+    val ticksPerQuarter: Int
+)
+
+/**
+ * Native output stream state and outage history.
+ */
+data class StreamStatus(
+    val state: Int,
+    val recoveries: Int,
+    val failedAttempts: Int,
+    val lastOutageMillis: Long,
+    val frameAtOutage: Long
+) {
+    val isRecovering: Boolean get() = state == STATE_RECOVERING
+    
+    companion object {
+        const val STATE_STOPPED = 0
+        const val STATE_RUNNING = 1
+        const val STATE_RECOVERING = 2
+    }
 }
+
+/**
+ * One note scored by the native scorer. Statuses use the ordinals of
+ * PitchStatus / TimingStatus; attack deviation is in stream frames
+ * (positive = late).
+ */
+data class NativeNoteScore(
+    val noteIndex: Int,
+    val pitchStatus: Int,
+    val timingStatus: Int,
+    val attackDeviationFrames: Long,
+    val pitchScore: Float,
+    val averageCents: Float,
+    val centStdDev: Float,
+    val correctRatio: Float,
+    val timingScore: Float,
+    val attackScore: Float,
+    val durationScore: Float,
+    val durationAccuracy: Float
+)
+
+/**
+ * Native output buffer tuning state. [isTuning] is false on streams that
+ * cannot report underruns (the buffer is then left at its default).
+ */
+data class BufferStats(
+    val bufferFrames: Int,
+    val capacityFrames: Int,
+    val burstFrames: Int,
+    val xruns: Long,
+    val isTuning: Boolean
+)
+
+/**
+ * Native audio callback costs. Deadline load is callback time over the
+ * audio it produced (1.0 = no headroom). Histogram bucket 0 counts
+ * callbacks under 64 µs, each next one doubles, the last is open-ended.
+ */
+data class AudioPerfStats(
+    val callbacks: Long,
+    val overruns: Long,
+    val maxCallbackNanos: Long,
+    val meanCallbackNanos: Long,
+    val maxDeadlineLoad: Float,
+    val meanDeadlineLoad: Float,
+    val maxVoices: Int,
+    val xruns: Long,
+    val lateEvents: Long,
+    val maxLateFrames: Int,
+    val maxQueueNanos: Long,
+    val droppedCommands: Long,
+    val durationHistogram: List<Long>
+)
+
+/**
+ * One hop of native polyphonic detection: the MIDI notes sounding (ascending)
+ * and a 12-bin chroma (C..B, strongest = 1) for lenient harmony checks.
+ */
+data class PolyphonicFrame(
+    val framePosition: Long,
+    val midiNotes: List<Int>,
+    val chroma: List<Float>,
+    val rms: Float
+)
+
+/**
+ * Native analysis worker backpressure. A pass analyzes whatever input
+ * arrived since the previous one ([lastBacklogFrames]); a growing backlog
+ * means the worker is falling behind, and [skippedSamples] is input the
+ * ring overwrote before it could be analyzed.
+ */
+data class AnalysisStats(
+    val passes: Long,
+    val lastBacklogFrames: Int,
+    val maxBacklogFrames: Int,
+    val maxPassNanos: Long,
+    val skippedSamples: Long,
+    val isRealtime: Boolean,
+    val cpuMask: Int
+)
+
+/**
+ * Prompt clip cache usage reported by the native engine.
+ */
+data class ClipCacheStats(
+    val clips: Int,
+    val bytes: Long,
+    val budgetBytes: Long,
+    val hits: Long,
+    val misses: Long
+)
@@ -0,0 +1,233 @@
+package com.musimind.music.audio.nativeaudio
+
+import android.os.Build
+import java.lang.invoke.VarHandle
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import kotlin.math.max
+
+/**
+ * Reader over the native UI channel (UiStateChannel.h): live pitch, levels,
+ * beats and onsets published by the audio thread into shared memory.
+ * 
+ * Every read is a handful of plain loads from a direct ByteBuffer, with no
+ * JNI call, no copy, and no allocation, so it is safe to run every UI frame.
+ * The state is two seqlocked blocks, one per native writer (audio callback
+ * and analysis worker): [readState] retries each if it overlaps a write.
+ * Pitch frames also go into a short ring that [drainPitchFrames] walks;
+ * frames overwritten before they were read count as [droppedPitchFrames].
+ * 
+ * Each instance keeps its own pitch cursor, so give every consumer its own
+ * channel from [NativeAudioBridge.getUiChannel]. One instance is not thread-safe.
+ */
+class NativeUiChannel internal constructor(buffer: ByteBuffer) {
+    
+    companion object {
+        /** Must match UiStateChannel::kLayoutVersion */
+        const val LAYOUT_VERSION = 2
+        
+        private const val OFFSET_VERSION = 0
+        private const val OFFSET_RING_SIZE = 4
+        private const val OFFSET_SAMPLE_RATE = 8
+        private const val OFFSET_SEQUENCE = 12
+        private const val OFFSET_ENGINE_FRAME = 16
+        private const val OFFSET_PITCH_FRAME = 24
+        private const val OFFSET_FREQUENCY = 32
+        private const val OFFSET_CONFIDENCE = 36
+        private const val OFFSET_CENTS = 40
+        private const val OFFSET_MIDI = 44
+        private const val OFFSET_RMS = 48
+        private const val OFFSET_VOICED = 52
+        private const val OFFSET_INPUT_LEVEL = 56
+        private const val OFFSET_OUTPUT_LEVEL = 60
+        private const val OFFSET_BEAT_FRAME = 64
+        private const val OFFSET_BEAT = 72
+        private const val OFFSET_BEAT_LEVEL = 76
+        private const val OFFSET_ONSET_FRAME = 80
+        private const val OFFSET_ONSET_STRENGTH = 88
+        private const val OFFSET_BEAT_SUBDIVISION = 92
+        private const val OFFSET_PITCH_COUNT = 96
+        private const val OFFSET_ANALYSIS_SEQUENCE = 104
+        private const val OFFSET_PITCH_RING = 128
+        
+        // UiStateChannel::PitchEntry
+        private const val PITCH_ENTRY_SIZE = 40
+        private const val ENTRY_SEQUENCE = 0
+        private const val ENTRY_MIDI = 4
+        private const val ENTRY_POSITION = 8
+        private const val ENTRY_FREQUENCY = 16
+        private const val ENTRY_CONFIDENCE = 20
+        private const val ENTRY_CENTS = 24
+        private const val ENTRY_RMS = 28
+        private const val ENTRY_VOICED = 32
+        private const val ENTRY_WINDOW = 36
+        
+        // A write is a few stores; this many collisions in a row means a busy writer, not a bug
+        private const val MAX_READ_ATTEMPTS = 8
+    }
+    
+    /**
+     * Latest published state. Reused across [readState] calls; frames are on
+     * the native engine clock ([sampleRate]), -1 before the first event.
+     */
+    class State {
+        var engineFrame = 0L
+        var pitchFrame = -1L
+        var frequency = 0f
+        var confidence = 0f
+        var centDeviation = 0f
+        var midiNote = 0
+        var rms = 0f
+        var isVoiced = false
+        var inputLevel = 0f
+        var outputLevel = 0f
+        var beatFrame = -1L
+        var beat = 0
+        var beatSubdivision = 0
+        var beatLevel = 0
+        var onsetFrame = -1L
+        var onsetStrength = 0f
+    }
+    
+    /**
+     * Receives ring entries from [drainPitchFrames] as primitives.
+     */
+    fun interface PitchFrameSink {
+        fun onPitchFrame(
+            framePosition: Long,
+            windowSize: Int,
+            frequency: Float,
+            confidence: Float,
+            midiNote: Int,
+            centDeviation: Float,
+            rms: Float,
+            isVoiced: Boolean
+        )
+    }
+    
+    private val memory: ByteBuffer = buffer.duplicate().order(ByteOrder.nativeOrder())
+    private val ringSize = memory.getInt(OFFSET_RING_SIZE)
+    
+    /** Native engine sample rate of every published frame position */
+    val sampleRate: Int = memory.getInt(OFFSET_SAMPLE_RATE)
+    
+    /** Ring entries this reader missed because the writer lapped it */
+    var droppedPitchFrames = 0L
+        private set
+    
+    // Only frames published after this reader was created are drained
+    private var nextPitch = memory.getLong(OFFSET_PITCH_COUNT)
+    
+    @Volatile private var fenceField = 0
+    private var fenceSink = 0
+    
+    init {
+        val version = memory.getInt(OFFSET_VERSION)
+        require(version == LAYOUT_VERSION) { "UI channel layout $version, expected $LAYOUT_VERSION" }
+    }
+    
+    /**
+     * Copy the latest state into [into]. Each block is consistent on its own;
+     * the engine and analysis halves may be a callback apart.
+     * 
+     * @return false if a writer kept a block busy for every attempt; [into] then holds a torn mix
+     */
+    fun readState(into: State): Boolean {
+        val engine = readBlock(OFFSET_SEQUENCE) {
+            into.engineFrame = memory.getLong(OFFSET_ENGINE_FRAME)
+            into.inputLevel = memory.getFloat(OFFSET_INPUT_LEVEL)
+            into.outputLevel = memory.getFloat(OFFSET_OUTPUT_LEVEL)
+            into.beatFrame = memory.getLong(OFFSET_BEAT_FRAME)
+            into.beat = memory.getInt(OFFSET_BEAT)
+            into.beatSubdivision = memory.getInt(OFFSET_BEAT_SUBDIVISION)
+            into.beatLevel = memory.getInt(OFFSET_BEAT_LEVEL)
+        }
+        val analysis = readBlock(OFFSET_ANALYSIS_SEQUENCE) {
+            into.pitchFrame = memory.getLong(OFFSET_PITCH_FRAME)
+            into.frequency = memory.getFloat(OFFSET_FREQUENCY)
+            into.confidence = memory.getFloat(OFFSET_CONFIDENCE)
+            into.centDeviation = memory.getFloat(OFFSET_CENTS)
+            into.midiNote = memory.getInt(OFFSET_MIDI)
+            into.rms = memory.getFloat(OFFSET_RMS)
+            into.isVoiced = memory.getInt(OFFSET_VOICED) != 0
+            into.onsetFrame = memory.getLong(OFFSET_ONSET_FRAME)
+            into.onsetStrength = memory.getFloat(OFFSET_ONSET_STRENGTH)
+        }
+        return engine && analysis
+    }
+    
+    /**
+     * Run [read] inside the seqlock at [sequenceOffset] until it saw no write.
+     */
+    private inline fun readBlock(sequenceOffset: Int, read: () -> Unit): Boolean {
+        repeat(MAX_READ_ATTEMPTS) {
+            val before = memory.getInt(sequenceOffset)
+            if ((before and 1) != 0) return@repeat
+            loadFence()
+            read()
+            loadFence()
+            if (memory.getInt(sequenceOffset) == before) return true
+        }
+        return false
+    }
+    
+    /**
+     * Deliver every pitch frame published since the last call, oldest first.
+     * 
+     * @return Number of frames delivered
+     */
+    fun drainPitchFrames(sink: PitchFrameSink): Int {
+        val count = memory.getLong(OFFSET_PITCH_COUNT)
+        loadFence()
+        if (count < nextPitch) {
+            // The native engine was recreated; its ring starts over
+            nextPitch = 0
+        }
+        var n = max(nextPitch, count - ringSize)
+        droppedPitchFrames += n - nextPitch
+        var delivered = 0
+        while (n < count) {
+            val base = OFFSET_PITCH_RING + (n % ringSize).toInt() * PITCH_ENTRY_SIZE
+            // Low 32 bits of 2n + 2, as the native side writes it
+            val complete = (n * 2 + 2).toInt()
+            if (memory.getInt(base + ENTRY_SEQUENCE) == complete) {
+                loadFence()
+                val position = memory.getLong(base + ENTRY_POSITION)
+                val windowSize = memory.getInt(base + ENTRY_WINDOW)
+                val frequency = memory.getFloat(base + ENTRY_FREQUENCY)
+                val confidence = memory.getFloat(base + ENTRY_CONFIDENCE)
+                val midiNote = memory.getInt(base + ENTRY_MIDI)
+                val cents = memory.getFloat(base + ENTRY_CENTS)
+                val rms = memory.getFloat(base + ENTRY_RMS)
+                val voiced = memory.getInt(base + ENTRY_VOICED) != 0
+                loadFence()
+                if (memory.getInt(base + ENTRY_SEQUENCE) == complete) {
+                    sink.onPitchFrame(position, windowSize, frequency, confidence, midiNote, cents, rms, voiced)
+                    delivered++
+                } else {
+                    droppedPitchFrames++
+                }
+            } else {
+                droppedPitchFrames++
+            }
+            n++
+        }
+        nextPitch = count
+        return delivered
+    }
+    
+    /**
+     * Keep the loads before this call ahead of the loads after it. ByteBuffer
+     * reads are plain loads, so the seqlock needs an explicit fence.
+     */
+    private fun loadFence() {
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.TIRAMISU) {
+            VarHandle.acquireFence()
+        } else {
+            // A volatile store then load: nothing earlier passes the store,
+            // nothing later passes the load
+            fenceField = 0
+            fenceSink = fenceField
+        }
+    }
+}
@@ -48,8 +48,18 @@ class OnsetDetector(
         samplePosition: Long
     ): TimingFrame {
         // 1. Calcula energia RMS
-        val energy = calculateRMS(frame)
-        
+        return analyzeEnergy(calculateRMS(frame), pitchResult, samplePosition)
+    }
+    
+    /**
+     * Analisa um frame cuja energia RMS já foi calculada
+     * (ex.: frames do detector nativo, que já trazem o RMS).
+     */
+    fun analyzeEnergy(
+        energy: Float,
+        pitchResult: PitchFrame,
+        samplePosition: Long
+    ): TimingFrame {
         // Smoothing da energia
         energyHistory[historyIndex] = energy
         historyIndex = (historyIndex + 1) % energyHistory.size
@@ -15,6 +15,26 @@ class AnalysisEngine(
     private val sampleRate: Int = 44100,
     private val onFeedbackUpdate: (SolfegeFeedbackState) -> Unit
 ) {
+    private companion object {
+        // Nota ainda sem resultado do scorer nativo
+        val PENDING_PITCH = PitchScoreResult(
+            score = 0f,
+            status = PitchStatus.NOT_EVALUATED,
+            avgCentDeviation = 0f,
+            stdDeviation = 0f,
+            correctRatio = 0f
+        )
+        val PENDING_TIMING = TimingScoreResult(
+            score = 0f,
+            status = TimingStatus.NOT_PLAYED,
+            attackDeviationSamples = 0,
+            attackDeviationMs = 0f,
+            durationAccuracy = 0f,
+            attackScore = 0f,
+            durationScore = 0f
+        )
+    }
+    
     // Detectores
     private val pitchDetector = YINPitchDetector.forVoice(sampleRate)
     private val onsetDetector = OnsetDetector(sampleRate = sampleRate)
@@ -36,6 +56,15 @@ class AnalysisEngine(
     private val onsetSamplePerNote = mutableMapOf<Int, Long?>()
     private val offsetSamplePerNote = mutableMapOf<Int, Long?>()
     
+    // Quando o detector nativo de onsets está ativo, os ataques vêm dele
+    // (precisos ao frame) e o OnsetDetector por energia só marca offsets
+    private var useExternalOnsets = false
+    
+    // Com o scorer nativo ativo, cada nota chega pontuada do C++ uma única vez;
+    // aqui só se monta o estado de feedback (sem reavaliar frames a cada update)
+    private var useNativeScoring = false
+    private val nativeResults = mutableMapOf<Int, Pair<PitchScoreResult, TimingScoreResult>>()
+    
     // Octave offset for transposition (-1, 0, +1 = -12, 0, +12 MIDI semitones)
     private var octaveOffset = 0
     
@@ -77,6 +106,9 @@ class AnalysisEngine(
         onsetSamplePerNote.clear()
         offsetSamplePerNote.clear()
         onsetDetector.reset()
+        useExternalOnsets = false
+        useNativeScoring = false
+        nativeResults.clear()
         lastPitchFrame = PitchFrame.SILENCE
         phase = SolfegePhase.IDLE
     }
@@ -100,6 +132,77 @@ class AnalysisEngine(
         // 2. Detecção de Onset/Offset
         val timingFrame = onsetDetector.analyze(analysisBuffer, pitchFrame, samplePosition)
         
+        handleAnalyzedFrame(pitchFrame, timingFrame, samplePosition)
+    }
+    
+    /**
+     * Processa um frame de pitch já detectado (ex.: pelo detector nativo).
+     * 
+     * @param pitchFrame Resultado do YIN, com posições no clock do exercício
+     * @param energy RMS da janela analisada
+     */
+    fun processFrame(pitchFrame: PitchFrame, energy: Float) {
+        val samplePosition = pitchFrame.samplePositionStart
+        val timingFrame = onsetDetector.analyzeEnergy(energy, pitchFrame, samplePosition)
+        handleAnalyzedFrame(pitchFrame, timingFrame, samplePosition)
+    }
+    
+    /**
+     * Registra um onset vindo do detector nativo (spectral flux).
+     * A posição já está no clock do exercício, o mesmo das notas esperadas,
+     * então o TimingScorer compara ataque e início da nota sem compensação extra.
+     * 
+     * @param samplePosition Sample do ataque no clock do exercício
+     */
+    fun processOnset(samplePosition: Long) {
+        if (samplePosition < 0) return
+        
+        val noteIndex = expectedNotes.indexOfFirst { it.containsSample(samplePosition) }
+        if (noteIndex >= 0 && onsetSamplePerNote[noteIndex] == null) {
+            onsetSamplePerNote[noteIndex] = samplePosition
+        }
+    }
+    
+    /**
+     * Passa a usar os onsets nativos de [processOnset], desde o início da
+     * captura: um ataque anterior ao primeiro onset nativo não deve vir do
+     * detector por energia. Vale até o próximo [reset].
+     */
+    fun enableExternalOnsets() {
+        useExternalOnsets = true
+    }
+    
+    /**
+     * Passa a usar o scorer nativo: as notas vêm de [applyNoteScore] e o pitch
+     * ao vivo de [updateLive]. Vale até o próximo [reset].
+     */
+    fun enableNativeScoring() {
+        useNativeScoring = true
+    }
+    
+    /**
+     * Registra o resultado final de uma nota pontuada pelo scorer nativo.
+     * Posições de timing já no clock do exercício.
+     */
+    fun applyNoteScore(noteIndex: Int, pitch: PitchScoreResult, timing: TimingScoreResult) {
+        if (noteIndex in expectedNotes.indices) {
+            nativeResults[noteIndex] = pitch to timing
+        }
+    }
+    
+    /**
+     * Atualiza o pitch ao vivo e publica o feedback (modo nativo).
+     * 
+     * @param pitchFrame Último frame de pitch, com posições no clock do exercício
+     */
+    fun updateLive(pitchFrame: PitchFrame) {
+        val samplePosition = pitchFrame.samplePositionStart
+        lastPitchFrame = pitchFrame
+        updateCurrentNoteIndex(samplePosition)
+        onFeedbackUpdate(buildFeedbackState(samplePosition))
+    }
+    
+    private fun handleAnalyzedFrame(pitchFrame: PitchFrame, timingFrame: TimingFrame, samplePosition: Long) {
         // Atualiza pitch frame com informação de onset/offset
         val updatedPitchFrame = pitchFrame.copy(
             isOnset = timingFrame.isOnset,
@@ -118,7 +221,7 @@ class AnalysisEngine(
             noteFrames.add(updatedPitchFrame)
             
             // Registra onset
-            if (timingFrame.isOnset && onsetSamplePerNote[currentNoteIndex] == null) {
+            if (!useExternalOnsets && timingFrame.isOnset && onsetSamplePerNote[currentNoteIndex] == null) {
                 onsetSamplePerNote[currentNoteIndex] = samplePosition
             }
             
@@ -199,23 +302,27 @@ class AnalysisEngine(
         note: ExpectedNote,
         currentSample: Long
     ): NoteFeedbackState {
-        val pitchFrames = pitchFramesPerNote[index] ?: emptyList()
-        val onsetSample = onsetSamplePerNote[index]
-        val offsetSample = offsetSamplePerNote[index]
-        
-        // Scoring de pitch (with octave offset for transposition)
-        val pitchResult = PitchScorer.score(pitchFrames, note.midiNote, octaveOffset)
-        
-        // Scoring de timing
-        val timingResult = TimingScorer.score(
-            detectedOnsetSample = onsetSample,
-            detectedOffsetSample = offsetSample,
-            expectedStartSample = note.startSample,
-            expectedEndSample = note.endSample,
-            sampleRate = sampleRate
-        )
+        val (pitchResult, timingResult) = if (useNativeScoring) {
+            nativeResults[index] ?: (PENDING_PITCH to PENDING_TIMING)
+        } else {
+            val pitchFrames = pitchFramesPerNote[index] ?: emptyList()
+            
+            // Scoring de pitch (with octave offset for transposition)
+            val pitch = PitchScorer.score(pitchFrames, note.midiNote, octaveOffset)
+            
+            // Scoring de timing
+            val timing = TimingScorer.score(
+                detectedOnsetSample = onsetSamplePerNote[index],
+                detectedOffsetSample = offsetSamplePerNote[index],
+                expectedStartSample = note.startSample,
+                expectedEndSample = note.endSample,
+                sampleRate = sampleRate
+            )
+            pitch to timing
+        }
         
-        val isCompleted = currentSample >= note.endSample
+        // No modo nativo a nota só está completa quando o resultado chegou
+        val isCompleted = if (useNativeScoring) index in nativeResults else currentSample >= note.endSample
         val isPending = currentSample < note.startSample
         val isCurrent = index == currentNoteIndex
         
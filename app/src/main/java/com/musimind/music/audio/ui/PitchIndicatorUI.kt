@@ -18,10 +18,12 @@ import androidx.compose.ui.graphics.Color
 import androidx.compose.ui.graphics.StrokeCap
 import androidx.compose.ui.unit.dp
 import androidx.compose.ui.unit.sp
+import com.musimind.music.audio.nativeaudio.NativeUiChannel
 import com.musimind.music.audio.pitch.PitchResult
 import com.musimind.music.audio.pitch.PitchUtils
 import com.musimind.ui.theme.*
 import kotlin.math.abs
+import kotlin.math.roundToInt
 
 /**
  * Pitch indicator component for solfege exercises
@@ -122,6 +124,65 @@ fun PitchIndicator(
     }
 }
 
+/**
+ * Pitch indicator fed straight from the native UI channel.
+ * Polls shared memory once per display frame (no JNI call, no allocation
+ * while the pitch holds) and recomposes only when a new pitch frame lands.
+ */
+@Composable
+fun LivePitchIndicator(
+    channel: NativeUiChannel,
+    targetNote: String?,
+    modifier: Modifier = Modifier
+) {
+    PitchIndicator(
+        pitchResult = rememberLivePitchResult(channel),
+        targetNote = targetNote,
+        isListening = true,
+        modifier = modifier
+    )
+}
+
+/**
+ * Latest pitch on the native UI channel as a [PitchResult], for any pitch
+ * display. Same polling as [LivePitchIndicator].
+ */
+@Composable
+fun rememberLivePitchResult(channel: NativeUiChannel): PitchResult {
+    val state = remember(channel) { NativeUiChannel.State() }
+    var pitchFrame by remember(channel) { mutableLongStateOf(-1L) }
+    var frequency by remember(channel) { mutableFloatStateOf(0f) }
+    var cents by remember(channel) { mutableIntStateOf(0) }
+    var level by remember(channel) { mutableFloatStateOf(0f) }
+    var isVoiced by remember(channel) { mutableStateOf(false) }
+    
+    LaunchedEffect(channel) {
+        while (true) {
+            withFrameNanos { }
+            if (channel.readState(state) && state.pitchFrame != pitchFrame) {
+                pitchFrame = state.pitchFrame
+                frequency = state.frequency
+                cents = state.centDeviation.roundToInt()
+                level = state.rms
+                isVoiced = state.isVoiced
+            }
+        }
+    }
+    
+    return remember(pitchFrame, isVoiced) {
+        if (isVoiced && frequency > 0f) {
+            PitchResult.Detected(
+                frequency = frequency,
+                amplitude = level,
+                note = PitchUtils.frequencyToNoteName(frequency),
+                cents = cents
+            )
+        } else {
+            PitchResult.NoSound
+        }
+    }
+}
+
 /**
  * Cents deviation meter
  */
@@ -25,6 +25,7 @@ import androidx.compose.ui.graphics.Brush
 import androidx.compose.ui.graphics.Color
 import com.musimind.music.audio.core.SolfegeFeedbackState
 import com.musimind.music.audio.core.SolfegePhase
+import com.musimind.music.audio.nativeaudio.NativeUiChannel
 import com.musimind.music.notation.smufl.SMuFLGlyphs
 import androidx.compose.ui.graphics.nativeCanvas
 import androidx.compose.ui.platform.LocalContext
@@ -55,6 +56,7 @@ fun SolfegeExerciseScreen(
 ) {
     val state by viewModel.state.collectAsState()
     val audioFeedback by viewModel.audioFeedbackState.collectAsState()
+    val liveChannel by viewModel.liveChannel.collectAsState()
     val context = LocalContext.current
     
     // Force landscape orientation for better score visualization
@@ -104,6 +106,7 @@ fun SolfegeExerciseScreen(
                 SolfegeExerciseContent(
                     state = state,
                     audioFeedback = audioFeedback,
+                    liveChannel = liveChannel,
                     onBack = onBack,
                     onStartListening = { 
                         if (viewModel.hasPermission()) {
@@ -132,6 +135,7 @@ fun SolfegeExerciseScreen(
 private fun SolfegeExerciseContent(
     state: SolfegeState,
     audioFeedback: SolfegeFeedbackState,
+    liveChannel: NativeUiChannel?,
     onBack: () -> Unit,
     onStartListening: () -> Unit,
     onStopListening: () -> Unit,
@@ -202,8 +206,9 @@ private fun SolfegeExerciseContent(
             enter = fadeIn() + slideInVertically(),
             exit = fadeOut() + slideOutVertically()
         ) {
+            // Native capture: pitch polled from shared memory every display frame
             CompactPitchDisplay(
-                pitchResult = state.currentPitchResult,
+                pitchResult = liveChannel?.let { rememberLivePitchResult(it) } ?: state.currentPitchResult,
                 targetNote = state.currentNote?.pitch?.let {
                     com.musimind.music.audio.pitch.PitchUtils.pitchToDisplayString(it)
                 }
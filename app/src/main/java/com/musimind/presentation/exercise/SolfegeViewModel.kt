@@ -11,6 +11,8 @@ import com.musimind.domain.model.SolfegeNote
 import com.musimind.music.audio.core.*
 import com.musimind.music.audio.engine.SolfegeAudioEngine
 import com.musimind.music.audio.midi.MidiPlayer
+import com.musimind.music.audio.nativeaudio.NativeAudioBridge
+import com.musimind.music.audio.nativeaudio.NativeUiChannel
 import com.musimind.music.audio.pitch.PitchDetector
 import com.musimind.music.audio.pitch.PitchResult
 import com.musimind.music.audio.pitch.PitchUtils
@@ -32,6 +34,7 @@ import kotlin.math.abs
 class SolfegeViewModel @Inject constructor(
     private val pitchDetector: PitchDetector,
     private val midiPlayer: MidiPlayer,
+    private val nativeAudio: NativeAudioBridge,
     private val exerciseRepository: ExerciseRepository,
     @ApplicationContext private val context: Context
 ) : ViewModel() {
@@ -40,11 +43,16 @@ class SolfegeViewModel @Inject constructor(
     val state: StateFlow<SolfegeState> = _state.asStateFlow()
     
     // New: Audio Engine for sample-accurate playback and analysis
-    private val audioEngine = SolfegeAudioEngine(context, midiPlayer)
+    private val audioEngine = SolfegeAudioEngine(context, midiPlayer, nativeAudio)
     
     // Expose feedback state from audio engine
     val audioFeedbackState: StateFlow<SolfegeFeedbackState> = audioEngine.feedbackState
     
+    // Live pitch straight from native shared memory while listening with the
+    // native capture; null on the AudioRecord fallback
+    private val _liveChannel = MutableStateFlow<NativeUiChannel?>(null)
+    val liveChannel: StateFlow<NativeUiChannel?> = _liveChannel.asStateFlow()
+    
     private var pitchListeningJob: kotlinx.coroutines.Job? = null
     private var consecutiveMatches = 0
     private val requiredMatches = 5
@@ -471,6 +479,7 @@ class SolfegeViewModel @Inject constructor(
         }
         
         consecutiveMatches = 0
+        _liveChannel.value = audioEngine.openLiveChannel()
         
         _state.update { 
             it.copy(
@@ -483,6 +492,7 @@ class SolfegeViewModel @Inject constructor(
     
     fun stopListening() {
         audioEngine.stop()
+        _liveChannel.value = null
         pitchListeningJob?.cancel()
         pitchListeningJob = null
         pitchDetector.stopListening()
@@ -10,6 +10,7 @@ import com.musimind.domain.games.*
 import com.musimind.music.audio.core.*
 import com.musimind.music.audio.engine.SolfegeAudioEngine
 import com.musimind.music.audio.midi.MidiPlayer
+import com.musimind.music.audio.nativeaudio.NativeAudioBridge
 import dagger.hilt.android.lifecycle.HiltViewModel
 import dagger.hilt.android.qualifiers.ApplicationContext
 import kotlinx.coroutines.delay
@@ -34,6 +35,7 @@ import javax.inject.Inject
 class SolfegeSingViewModel @Inject constructor(
     private val gamesRepository: GamesRepository,
     private val midiPlayer: MidiPlayer,
+    private val nativeAudio: NativeAudioBridge,
     @ApplicationContext private val context: Context
 ) : ViewModel() {
     
@@ -41,7 +43,7 @@ class SolfegeSingViewModel @Inject constructor(
     val state: StateFlow<SolfegeSingState> = _state.asStateFlow()
     
     // Engine de áudio com detecção de pitch real
-    private val audioEngine = SolfegeAudioEngine(context, midiPlayer)
+    private val audioEngine = SolfegeAudioEngine(context, midiPlayer, nativeAudio)
     
     // Expose feedback state from audio engine for real-time pitch visualization
     val audioFeedbackState: StateFlow<SolfegeFeedbackState> = audioEngine.feedbackState